@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Benchmark.h"
+#include "ThreadPool.h"
+
+namespace core {
+namespace bench {
+
+// Each module adds its benchmarks to the suite. Names are "<module>/<kernel>/<variant>" so that
+// --filter can pick a module or a kernel. Inputs are allocated on first use, so filtered-out
+// benchmarks cost nothing; GPU benchmarks throw when no device is found and the suite skips them.
+void RegisterMatBenchmarks(BenchmarkSuite& suite, ThreadPool& pool);
+void RegisterThreadPoolBenchmarks(BenchmarkSuite& suite, ThreadPool& pool);
+void RegisterVulkanBenchmarks(BenchmarkSuite& suite);
+void RegisterCLBenchmarks(BenchmarkSuite& suite);
+
+}  // namespace bench
+}  // namespace core
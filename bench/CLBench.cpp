@@ -0,0 +1,90 @@
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include "Benchmarks.h"
+#include "CLBuffer.h"
+#include "CLCommandQueue.h"
+#include "CLContext.h"
+#include "CLKernel.h"
+#include "CLLoader.h"
+#include "CLProgram.h"
+#include "Mat.h"
+
+namespace core {
+namespace bench {
+
+namespace {
+
+constexpr int kRows = 3000;
+constexpr int kCols = 4000;
+constexpr std::uint64_t kPixels = std::uint64_t{kRows} * kCols;
+
+int InitLoader() {
+  if (opencl::cl_init()) throw std::runtime_error("Failed to initialize OpenCL loader");
+  return 0;
+}
+
+Mat<float, 1> RandomImage() {
+  Mat<float, 1> image(kRows, kCols, kMatNoPadding);
+  image.Random();
+  return image;
+}
+
+// The 3x3 gaussian_blur kernel of tests/shaders on a 12MP float image, set up by the first
+// OpenCL benchmark that runs.
+struct CLBlur {
+  CLBlur()
+      : loader(InitLoader()),
+        src(RandomImage()),
+        program(&context, std::string(CORE_BENCH_CL_KERNEL_DIR) + "gaussian_blur.cl"),
+        kernel(&program, "gaussian_blur"),
+        queue(&context, CL_QUEUE_PROFILING_ENABLE),
+        input(&context, kPixels * sizeof(float), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+              src.data()),
+        output(&context, kPixels * sizeof(float), CL_MEM_WRITE_ONLY) {
+    kernel.SetArgs(input, output, kCols, kRows, 1, 2.0f);
+  }
+
+  // Enqueues one blur and waits for it; returns the kernel time from the event profile.
+  std::chrono::nanoseconds Run() {
+    cl_event event = nullptr;
+    queue.Submit(kernel, 2, global_size, nullptr, &event);
+    clWaitForEvents(1, &event);
+    cl_ulong start = 0, end = 0;
+    clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(start), &start, nullptr);
+    clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(end), &end, nullptr);
+    clReleaseEvent(event);
+    return std::chrono::nanoseconds(end - start);
+  }
+
+  int loader;
+  Mat<float, 1> src;
+  opencl::CLContext context;
+  opencl::CLProgram program;
+  opencl::CLKernel kernel;
+  opencl::CLCommandQueue queue;
+  opencl::CLBuffer input;
+  opencl::CLBuffer output;
+  size_t global_size[2] = {static_cast<size_t>(kCols), static_cast<size_t>(kRows)};
+};
+
+CLBlur& GetBlur() {
+  static CLBlur blur;
+  return blur;
+}
+
+}  // namespace
+
+void RegisterCLBenchmarks(BenchmarkSuite& suite) {
+  // "wall" includes enqueueing and the wait, "gpu" only the kernel
+  suite.add("opencl/gaussian_blur/f32_12mp_3x3/wall", [] { GetBlur().Run(); })
+      .bytes(2 * kPixels * sizeof(float))
+      .items(kPixels, "pixels");
+  suite.add("opencl/gaussian_blur/f32_12mp_3x3/gpu", [] { return GetBlur().Run(); })
+      .bytes(2 * kPixels * sizeof(float))
+      .items(kPixels, "pixels");
+}
+
+}  // namespace bench
+}  // namespace core
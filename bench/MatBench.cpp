@@ -0,0 +1,133 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "Benchmarks.h"
+#include "Mat.h"
+#include "MatFilter.h"
+#include "MatOps.h"
+#include "MatReduce.h"
+#include "MatResample.h"
+
+namespace core {
+namespace bench {
+
+namespace {
+
+// 12MP camera frames, like the tests, and 4K video frames
+constexpr int kRows = 3000;
+constexpr int kCols = 4000;
+constexpr int k4KRows = 2160;
+constexpr int k4KCols = 3840;
+constexpr std::uint64_t kPixels = std::uint64_t{kRows} * kCols;
+constexpr std::uint64_t k4KPixels = std::uint64_t{k4KRows} * k4KCols;
+constexpr double kPi = 3.14159265358979323846;
+
+struct Images {
+  Images()
+      : a(kRows, kCols),
+        b(kRows, kCols),
+        dst(kRows, kCols, kMatUninitialized),
+        gray(kRows, kCols),
+        rgba(k4KRows, k4KCols),
+        rgba_dst(k4KRows, k4KCols, kMatUninitialized),
+        half(k4KRows / 2, k4KCols / 2, kMatUninitialized) {
+    a.Random(1);
+    b.Random(2);
+    gray.Random(3);
+    rgba.Random(4);
+  }
+
+  Mat<float, 1> a;
+  Mat<float, 1> b;
+  Mat<float, 1> dst;
+  Mat<uint8_t, 1> gray;
+  Mat<uint8_t, 4> rgba;
+  Mat<uint8_t, 4> rgba_dst;
+  Mat<uint8_t, 4> half;
+};
+
+// Built by the first benchmark that runs.
+Images& GetImages() {
+  static Images images;
+  return images;
+}
+
+// Rotation by degrees about (cx, cy) combined with a scale, mapping destination to source.
+std::array<double, 6> Rotation(double degrees, double scale, double cx, double cy) {
+  const double c = std::cos(degrees * kPi / 180.0) * scale;
+  const double s = std::sin(degrees * kPi / 180.0) * scale;
+  return {c, -s, cx - c * cx + s * cy, s, c, cy - s * cx - c * cy};
+}
+
+}  // namespace
+
+void RegisterMatBenchmarks(BenchmarkSuite& suite, ThreadPool& pool) {
+  const std::string isa = SimdIsaName(GetSimdIsa());
+
+  suite.add("mat/add/f32_12mp/" + isa, [] {
+         Images& im = GetImages();
+         Add(im.a, im.b, im.dst);
+       })
+      .bytes(3 * kPixels * sizeof(float))
+      .items(kPixels, "pixels");
+
+  suite.add("mat/convert/u8_to_f32_12mp/" + isa, [] {
+         Images& im = GetImages();
+         ConvertTo(im.gray, im.dst, 1.0f / 255.0f);
+       })
+      .bytes(kPixels * (sizeof(uint8_t) + sizeof(float)))
+      .items(kPixels, "pixels");
+
+  // Single-threaded and on the pool
+  for (ThreadPool* p : {static_cast<ThreadPool*>(nullptr), &pool}) {
+    const std::string threads = p != nullptr ? "pool_" + std::to_string(p->size()) + "t" : "serial";
+
+    suite.add("mat/gaussian_blur/f32_12mp_r2/" + threads, [p] {
+           Images& im = GetImages();
+           GaussianBlur(im.a, im.dst, 2, 1.5f, BorderMode::Clamp, p);
+         })
+        .bytes(2 * kPixels * sizeof(float))
+        .items(kPixels, "pixels");
+
+    suite.add("mat/warp_affine/rgba8_4k_linear/" + threads, [p] {
+           Images& im = GetImages();
+           WarpAffine(im.rgba, im.rgba_dst, Rotation(10.0, 1.0, k4KCols / 2.0, k4KRows / 2.0),
+                      Interpolation::Linear, BorderMode::Constant, 0.0f, p);
+         })
+        .bytes(2 * k4KPixels * 4)
+        .items(k4KPixels, "pixels");
+
+    suite.add("mat/resize/rgba8_4k_to_1080p/" + threads, [p] {
+           Images& im = GetImages();
+           Resize(im.rgba, im.half, Interpolation::Linear, p);
+         })
+        .bytes(k4KPixels * 4 + k4KPixels)
+        .items(k4KPixels / 4, "pixels");
+
+    suite.add("mat/mean_stddev/f32_12mp/" + threads, [p] {
+           const MeanStdDevResult<1> result = MeanStdDev(GetImages().a, p);
+           do_not_optimize(result.mean[0]);
+         })
+        .bytes(kPixels * sizeof(float))
+        .items(kPixels, "pixels");
+
+    suite.add("mat/min_max/f32_12mp/" + threads, [p] {
+           const std::array<MinMaxLoc, 1> result = MinMax(GetImages().a, p);
+           do_not_optimize(result[0].max);
+         })
+        .bytes(kPixels * sizeof(float))
+        .items(kPixels, "pixels");
+
+    suite.add("mat/sum/rgba8_4k/" + threads, [p] {
+           const std::array<double, 4> result = Sum(GetImages().rgba, p);
+           do_not_optimize(result[0]);
+         })
+        .bytes(k4KPixels * 4)
+        .items(k4KPixels, "pixels");
+  }
+}
+
+}  // namespace bench
+}  // namespace core
@@ -0,0 +1,127 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "BoundedQueue.h"
+#include "Task.h"
+#include "TaskGraph.h"
+
+namespace core {
+namespace bench {
+
+namespace {
+
+constexpr std::uint64_t kTasks = 1000;
+
+core::Task<void> Hop(ThreadPool& pool) { co_await pool.schedule(); }
+
+constexpr auto kIdleGap = std::chrono::microseconds(20);
+constexpr auto kPollingBudget = std::chrono::microseconds(200);
+
+// Two workers that park as soon as they run out of tasks, or that first poll for kPollingBudget.
+// Created on first use.
+ThreadPool& GetLatencyPool(bool polling) {
+  auto options = [](std::chrono::nanoseconds spin_budget) {
+    ThreadPoolOptions pool_options;
+    pool_options.thread_count = 2;
+    pool_options.spin_budget = spin_budget;
+    pool_options.yield_count = spin_budget.count() != 0 ? 4 : 0;
+    return pool_options;
+  };
+  if (polling) {
+    static ThreadPool pool(options(kPollingBudget));
+    return pool;
+  }
+  static ThreadPool pool(options(std::chrono::nanoseconds(0)));
+  return pool;
+}
+
+// Leaves the workers idle for kIdleGap, then times one task from post() to its start.
+std::chrono::nanoseconds StartLatency(ThreadPool& pool) {
+  using Clock = std::chrono::steady_clock;
+  const auto resume = Clock::now() + kIdleGap;
+  while (Clock::now() < resume) std::this_thread::yield();
+  std::atomic<Clock::rep> started{-1};
+  const auto submitted = Clock::now();
+  pool.post([&started, submitted] { started = (Clock::now() - submitted).count(); });
+  Clock::rep latency;
+  while ((latency = started.load()) < 0) std::this_thread::yield();
+  return Clock::duration(latency);
+}
+
+}  // namespace
+
+void RegisterThreadPoolBenchmarks(BenchmarkSuite& suite, ThreadPool& pool) {
+  suite.add("threadpool/post/empty_x1000", [&pool] {
+         for (std::uint64_t i = 0; i < kTasks; ++i) pool.post([] {});
+         pool.wait_idle();
+       })
+      .items(kTasks, "tasks");
+
+  suite.add("threadpool/submit/empty_x1000", [&pool] {
+         std::vector<std::future<void>> futures;
+         futures.reserve(kTasks);
+         for (std::uint64_t i = 0; i < kTasks; ++i) futures.push_back(pool.submit([] {}));
+         for (auto& future : futures) future.get();
+       })
+      .items(kTasks, "tasks");
+
+  // Round trip of one task: the latency a single frame job pays
+  suite.add("threadpool/submit/round_trip", [&pool] { pool.submit([] {}).get(); })
+      .items(1, "tasks");
+
+  // Submit-to-start latency after a short idle gap: parked workers need a wakeup, polling ones
+  // still spin within their budget and pick the task up themselves
+  for (const bool polling : {false, true}) {
+    suite.add(std::string("threadpool/submit/start_latency_") + (polling ? "polling" : "parked"),
+              [polling] { return StartLatency(GetLatencyPool(polling)); })
+        .items(1, "tasks");
+  }
+
+  suite.add("threadpool/parallel_for/1m_indices", [&pool] {
+         std::atomic<std::uint64_t> sum{0};
+         pool.parallel_for(0, 1 << 20, 0, [&sum](std::size_t begin, std::size_t end) {
+           std::uint64_t local = 0;
+           for (std::size_t i = begin; i < end; ++i) local += i;
+           sum.fetch_add(local, std::memory_order_relaxed);
+         });
+         do_not_optimize(sum.load());
+       })
+      .items(1 << 20, "indices");
+
+  // A 1 -> 64 -> 1 fan-out and fan-in, built once and run per iteration
+  auto graph = std::make_shared<TaskGraph>();
+  const TaskGraph::NodeId source = graph->add([] {});
+  const TaskGraph::NodeId sink = graph->add([] {});
+  for (int i = 0; i < 64; ++i) {
+    const TaskGraph::NodeId node = graph->add([] {});
+    graph->precede(source, node);
+    graph->precede(node, sink);
+  }
+  suite.add("threadpool/task_graph/fan_64", [&pool, graph] { graph->run(pool); })
+      .items(graph->size(), "nodes");
+
+  suite.add("threadpool/schedule/coroutine_hop", [&pool] { sync_wait(Hop(pool)); })
+      .items(1, "hops");
+
+  // Handing items to a worker through a BoundedQueue, as between pipeline stages
+  suite.add("threadpool/bounded_queue/spsc_x1000", [&pool] {
+         BoundedQueue<std::uint64_t> queue(256);
+         pool.post([&queue] {
+           std::uint64_t value = 0;
+           for (std::uint64_t i = 0; i < kTasks; ++i) queue.pop(&value);
+         });
+         for (std::uint64_t i = 0; i < kTasks; ++i) queue.push(i);
+         pool.wait_idle();
+       })
+      .items(kTasks, "items");
+}
+
+}  // namespace bench
+}  // namespace core
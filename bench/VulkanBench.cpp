@@ -0,0 +1,130 @@
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "Benchmarks.h"
+#include "ComputeGaussianBlur.h"
+#include "ComputeSum.h"
+#include "Mat.h"
+#include "VulkanBuffer.h"
+#include "VulkanCommandBuffer.h"
+#include "VulkanContext.h"
+#include "VulkanQueryPool.h"
+#include "VulkanSync.h"
+
+namespace core {
+namespace bench {
+
+namespace {
+
+using vulkan::VulkanBuffer;
+
+constexpr int kSumRows = 6000;
+constexpr int kSumCols = 6000;
+constexpr int kBlurRows = 3000;
+constexpr int kBlurCols = 4000;
+constexpr VkMemoryPropertyFlags kHostVisible =
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+// A compute pipeline of vulkan/tests with its buffers, command buffer, fence and timestamps.
+template <class Compute>
+struct Dispatcher {
+  Dispatcher(vulkan::VulkanContext* context, VkDeviceSize src_bytes, VkDeviceSize dst_bytes,
+             int cols, int rows)
+      : context_(context),
+        command_buffer_(context),
+        fence_(context),
+        query_pool_(context, VK_QUERY_TYPE_TIMESTAMP),
+        src_(context, src_bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, kHostVisible),
+        dst_(context, dst_bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, kHostVisible),
+        compute_(context, src_, dst_, cols, rows) {
+    src_.MapData([src_bytes](void* data) { std::memset(data, 1, src_bytes); });
+    dst_.MapData([dst_bytes](void* data) { std::memset(data, 0, dst_bytes); });
+    compute_.Init();
+  }
+
+  // Records, submits and waits for one dispatch between two timestamps; returns the GPU time.
+  // Throws when the timestamps cannot be read, so that the suite skips the benchmark.
+  std::chrono::nanoseconds Run() {
+    fence_.Reset();
+    vkResetCommandBuffer(command_buffer_.buffer(), 0);
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(command_buffer_.buffer(), &begin_info);
+    query_pool_.Reset(command_buffer_.buffer());
+    query_pool_.Query(command_buffer_.buffer(), 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    compute_.Run(command_buffer_.buffer());
+    query_pool_.Query(command_buffer_.buffer(), 1, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    VkSubmitInfo submit_info{};
+    command_buffer_.Submit(fence_.fence, submit_info);
+    fence_.Wait();
+    if (!query_pool_.GetQueryResults()) {
+      throw std::runtime_error("Failed to read the Vulkan timestamp queries");
+    }
+    return query_pool_.GetElapsed(0, 1);
+  }
+
+ private:
+  vulkan::VulkanContext* context_;
+  vulkan::VulkanCommandBuffer command_buffer_;
+  vulkan::VulkanFence fence_;
+  vulkan::VulkanQueryPool query_pool_;
+  VulkanBuffer src_;
+  VulkanBuffer dst_;
+  Compute compute_;
+};
+
+struct VulkanBench {
+  VulkanBench() : context(false, vulkan::QueueFamilyType::Compute, VK_NULL_HANDLE) {
+    context.Init();
+  }
+
+  vulkan::VulkanContext context;
+};
+
+// Set up by the first Vulkan benchmark that runs; throws, and is retried by the next one, when
+// there is no device.
+VulkanBench& GetVulkan() {
+  static VulkanBench bench;
+  return bench;
+}
+
+Dispatcher<vulkan::ComputeSum>& GetSum() {
+  static Dispatcher<vulkan::ComputeSum> sum(&GetVulkan().context,
+                                            VkDeviceSize{kSumRows} * kSumCols * sizeof(int),
+                                            sizeof(int), kSumCols, kSumRows);
+  return sum;
+}
+
+Dispatcher<vulkan::ComputeGaussianBlur>& GetBlur() {
+  static constexpr VkDeviceSize kBytes = VkDeviceSize{kBlurRows} * kBlurCols * sizeof(float);
+  static Dispatcher<vulkan::ComputeGaussianBlur> blur(&GetVulkan().context, kBytes, kBytes,
+                                                      kBlurCols, kBlurRows);
+  return blur;
+}
+
+}  // namespace
+
+void RegisterVulkanBenchmarks(BenchmarkSuite& suite) {
+  constexpr std::uint64_t kSumPixels = std::uint64_t{kSumRows} * kSumCols;
+  constexpr std::uint64_t kBlurPixels = std::uint64_t{kBlurRows} * kBlurCols;
+
+  // "wall" includes recording, submission and the fence wait, "gpu" only the dispatch
+  suite.add("vulkan/compute_sum/i32_6000x6000/wall", [] { GetSum().Run(); })
+      .bytes(kSumPixels * sizeof(int))
+      .items(kSumPixels, "pixels");
+  suite.add("vulkan/compute_sum/i32_6000x6000/gpu", [] { return GetSum().Run(); })
+      .bytes(kSumPixels * sizeof(int))
+      .items(kSumPixels, "pixels");
+
+  suite.add("vulkan/gaussian_blur/f32_12mp_3x3/wall", [] { GetBlur().Run(); })
+      .bytes(2 * kBlurPixels * sizeof(float))
+      .items(kBlurPixels, "pixels");
+  suite.add("vulkan/gaussian_blur/f32_12mp_3x3/gpu", [] { return GetBlur().Run(); })
+      .bytes(2 * kBlurPixels * sizeof(float))
+      .items(kBlurPixels, "pixels");
+}
+
+}  // namespace bench
+}  // namespace core
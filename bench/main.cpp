@@ -0,0 +1,109 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "MatOps.h"
+
+// core-bench: runs the registered benchmarks and reports robust statistics.
+//
+//   core-bench [--filter=<substring>] [--json=<file>] [--csv=<file>] [--samples=<n>]
+//              [--sample-time-ms=<ms>] [--warmup-ms=<ms>] [--iterations=<n>] [--threads=<n>]
+//              [--list]
+
+namespace {
+
+bool ParseFlag(const std::string& arg, const std::string& flag, std::string* value) {
+  const std::string prefix = "--" + flag + "=";
+  if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+  *value = arg.substr(prefix.size());
+  return true;
+}
+
+int Usage(const char* program) {
+  std::cerr << "usage: " << program
+            << " [--filter=<substring>] [--json=<file>] [--csv=<file>] [--samples=<n>]"
+               " [--sample-time-ms=<ms>] [--warmup-ms=<ms>] [--iterations=<n>]"
+               " [--threads=<n>] [--list]"
+            << std::endl;
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  core::BenchmarkOptions options;
+  std::string filter, json_path, csv_path, value;
+  std::size_t threads = std::thread::hardware_concurrency();
+  bool list = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (ParseFlag(arg, "filter", &value)) {
+      filter = value;
+    } else if (ParseFlag(arg, "json", &value)) {
+      json_path = value;
+    } else if (ParseFlag(arg, "csv", &value)) {
+      csv_path = value;
+    } else if (ParseFlag(arg, "samples", &value)) {
+      options.samples = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (ParseFlag(arg, "sample-time-ms", &value)) {
+      options.sample_time = std::chrono::milliseconds(std::strtoll(value.c_str(), nullptr, 10));
+    } else if (ParseFlag(arg, "warmup-ms", &value)) {
+      options.warmup = std::chrono::milliseconds(std::strtoll(value.c_str(), nullptr, 10));
+    } else if (ParseFlag(arg, "iterations", &value)) {
+      options.iterations = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (ParseFlag(arg, "threads", &value)) {
+      threads = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (arg == "--list") {
+      list = true;
+    } else {
+      return Usage(argv[0]);
+    }
+  }
+  if (options.samples == 0 || threads == 0) return Usage(argv[0]);
+
+  core::ThreadPool pool(threads);
+  core::BenchmarkSuite suite;
+  core::bench::RegisterMatBenchmarks(suite, pool);
+  core::bench::RegisterThreadPoolBenchmarks(suite, pool);
+  core::bench::RegisterVulkanBenchmarks(suite);
+  core::bench::RegisterCLBenchmarks(suite);
+
+  if (list) {
+    for (const core::Benchmark& benchmark : suite.benchmarks()) {
+      if (benchmark.name().find(filter) != std::string::npos) std::cout << benchmark.name() << "\n";
+    }
+    return 0;
+  }
+
+  const std::vector<core::BenchmarkResult> results = suite.run(options, filter, &std::cout);
+
+  // Enough context to tell two result files apart when comparing them
+  const std::map<std::string, std::string> context = {
+      {"simd", core::SimdIsaName(core::GetSimdIsa())},
+      {"threads", std::to_string(pool.size())},
+      {"compiler", __VERSION__},
+  };
+  if (!json_path.empty()) {
+    std::ofstream out(json_path);
+    core::write_benchmark_json(out, results, context);
+    if (!out) {
+      std::cerr << "failed to write " << json_path << std::endl;
+      return 1;
+    }
+  }
+  if (!csv_path.empty()) {
+    std::ofstream out(csv_path);
+    core::write_benchmark_csv(out, results);
+    if (!out) {
+      std::cerr << "failed to write " << csv_path << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
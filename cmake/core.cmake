@@ -19,4 +19,5 @@ endif()
 add_subdirectory(io)
 add_subdirectory(threadpool)
 add_subdirectory(tests)
+add_subdirectory(bench)
 add_subdirectory(examples)
\ No newline at end of file
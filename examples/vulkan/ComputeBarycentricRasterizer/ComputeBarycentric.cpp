@@ -28,7 +28,7 @@ void ComputeBarycentric::Init() {
   rasterized.MapData([this](void* data) {
     core::Mat<int, 1> mat(uniform_data_.height, uniform_data_.width);
     mat.Fill(0);
-    memcpy(data, mat.data(), mat.total() * sizeof(int));
+    mat.CopyTo(data);
   });
 
   CreateUniformBufferDescriptorSet(0, uniform_buffer_);
@@ -44,16 +44,15 @@ int main() {
   VkSubmitInfo submit_info{};
   command_buffer.Submit(fence.fence, submit_info);
 
-  vkWaitForFences(context.logical_device, 1, &fence.fence, VK_TRUE, UINT64_MAX);
+  fence.Wait();
 
   query_pool.GetQueryResults();
-  const auto timestamps = query_pool.GetTimeStamps();
-  const auto runtime_ms = (timestamps[1] - timestamps[0]) * (context.timestamp_period / 1000000.0);
+  const double runtime_ms =
+      std::chrono::duration<double, std::milli>(query_pool.GetElapsed(0, 1)).count();
   printf("GPU time: %fms\n", runtime_ms);
 
-  core::Mat<int, 1> result(kHeight, kWidth);
-  barycentric->rasterized.MapData(
-      [&result](void* data) { memcpy(result.data(), data, result.total() * sizeof(int)); });
+  core::Mat<int, 1> result(kHeight, kWidth, core::kMatUninitialized);
+  barycentric->rasterized.MapData([&result](void* data) { result.CopyFrom(data); });
 
   printf("rasterization at (1, 1): %d\n", *result(1, 1));
   printf("rasterization at (500, 600): %d\n", *result(500, 600));
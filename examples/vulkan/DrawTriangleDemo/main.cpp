@@ -61,7 +61,7 @@ int main() {
   while (!glfwWindowShouldClose(window)) {
     glfwPollEvents();
     // draw process
-    vkWaitForFences(context.logical_device, 1, &(in_flight_fence.fence), VK_TRUE, UINT64_MAX);
+    in_flight_fence.Wait();
     in_flight_fence.Reset();
 
     uint32_t image_index;
@@ -72,7 +72,7 @@ int main() {
     glfwPollEvents();
     process_inputs(window);
     // draw process
-    vkWaitForFences(context.logical_device, 1, &(in_flight_fence.fence), VK_TRUE, UINT64_MAX);
+    in_flight_fence.Wait();
     in_flight_fence.Reset();
     uint32_t image_index;
     vkAcquireNextImageKHR(context.logical_device, swap_chain->swapchain, UINT64_MAX,
@@ -16,7 +16,7 @@ void WriteTextureToFile(const GLint texture, const int width, const int height,
     throw std::invalid_argument("Invalid write texture to file parameters");
   }
 
-  core::Mat<unsigned char, 4> pixels(height, width);
+  core::Mat<unsigned char, 4> pixels(height, width, core::kMatUninitialized, core::kMatNoPadding);
   GLuint fbo = 0;
   glGenFramebuffers(1, &fbo);
   glBindFramebuffer(GL_FRAMEBUFFER, fbo);
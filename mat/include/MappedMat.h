@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "Mat.h"
+
+namespace core {
+
+// Element type tag stored in MappedMat files.
+enum class MatDepth : std::uint32_t { U8, S8, U16, S16, S32, F32, F64 };
+
+template <typename T>
+constexpr MatDepth MatDepthOf() {
+  using U = std::remove_cv_t<T>;
+  if constexpr (std::is_same_v<U, std::uint8_t>) {
+    return MatDepth::U8;
+  } else if constexpr (std::is_same_v<U, std::int8_t>) {
+    return MatDepth::S8;
+  } else if constexpr (std::is_same_v<U, std::uint16_t>) {
+    return MatDepth::U16;
+  } else if constexpr (std::is_same_v<U, std::int16_t>) {
+    return MatDepth::S16;
+  } else if constexpr (std::is_same_v<U, std::int32_t>) {
+    return MatDepth::S32;
+  } else if constexpr (std::is_same_v<U, float>) {
+    return MatDepth::F32;
+  } else {
+    static_assert(std::is_same_v<U, double>, "MatDepthOf: unsupported element type");
+    return MatDepth::F64;
+  }
+}
+
+const char* MatDepthName(MatDepth depth);
+
+enum class MapMode {
+  ReadOnly,     // PROT_READ, shared: writing to the pixels faults
+  CopyOnWrite,  // private mapping: writes stay in memory and never reach the file
+  ReadWrite,    // shared mapping: writes go to the file (see Sync())
+};
+
+// On-disk layout of a MappedMat file: this header, then rows * step bytes of pixels starting at
+// data_offset (a page boundary, so that rows keep their alignment in memory).
+struct MappedMatHeader {
+  char magic[4];  // "CMAT"
+  std::uint32_t version;
+  std::int32_t rows;
+  std::int32_t cols;
+  std::int32_t channels;
+  MatDepth depth;
+  std::uint64_t step;
+  std::uint64_t data_offset;
+};
+
+namespace detail {
+
+// Owns the mapping of a whole MappedMat file.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  // Creates (or truncates) path, writes the header and maps it read-write.
+  static MappedFile Create(const std::string& path, int rows, int cols, int channels,
+                           MatDepth depth, std::size_t step);
+  // Maps an existing file and validates its header.
+  static MappedFile Open(const std::string& path, MapMode mode);
+
+  const MappedMatHeader& header() const {
+    return *reinterpret_cast<const MappedMatHeader*>(base_);
+  }
+  std::uint8_t* data() const { return base_ + header().data_offset; }
+  MapMode mode() const { return mode_; }
+
+  // madvise(MADV_WILLNEED) over [offset, offset + length) of the pixel data.
+  void Prefetch(std::size_t offset, std::size_t length) const;
+  // msync of the whole mapping. No-op unless mode is ReadWrite.
+  void Sync() const;
+
+ private:
+  std::uint8_t* base_ = nullptr;
+  std::size_t size_ = 0;
+  MapMode mode_ = MapMode::ReadOnly;
+};
+
+}  // namespace detail
+
+// Mat backed by a memory-mapped file, for images and stacks larger than RAM: opening is instant
+// and the OS pages rows in on first touch. It is a MatView, so it works with every function
+// taking one (ROIs, MatOps, filters...).
+template <typename T, int C>
+class MappedMat : public MatView<T, C> {
+ public:
+  // Creates a zero-filled file of rows x cols pixels, mapped read-write.
+  static MappedMat Create(const std::string& path, int rows, int cols,
+                          std::size_t row_align = kMatRowAlign) {
+    assert(row_align > 0 && (row_align & (row_align - 1)) == 0);
+    const std::size_t step = AlignUp(static_cast<std::size_t>(cols) * C * sizeof(T),
+                                     std::max(row_align, sizeof(T)));
+    return MappedMat(detail::MappedFile::Create(path, rows, cols, C, MatDepthOf<T>(), step));
+  }
+
+  // Throws std::runtime_error when the file cannot be mapped or does not hold a T x C image.
+  static MappedMat Open(const std::string& path, MapMode mode = MapMode::ReadOnly) {
+    detail::MappedFile file = detail::MappedFile::Open(path, mode);
+    const MappedMatHeader& header = file.header();
+    if (header.depth != MatDepthOf<T>() || header.channels != C) {
+      throw std::runtime_error("MappedMat: " + path + " holds " + MatDepthName(header.depth) +
+                               " x " + std::to_string(header.channels) + ", expected " +
+                               MatDepthName(MatDepthOf<T>()) + " x " + std::to_string(C));
+    }
+    if (header.step % sizeof(T) != 0) {
+      throw std::runtime_error("MappedMat: " + path + " has a misaligned row pitch");
+    }
+    return MappedMat(std::move(file));
+  }
+
+  MappedMat(MappedMat&& other) noexcept : MatView<T, C>(other), file_(std::move(other.file_)) {
+    other.Release();
+  }
+
+  MappedMat& operator=(MappedMat&& other) noexcept {
+    if (this == &other) return *this;
+    MatView<T, C>::operator=(other);
+    file_ = std::move(other.file_);
+    other.Release();
+    return *this;
+  }
+
+  MapMode mode() const { return file_.mode(); }
+
+  // Hints the OS to start reading rows [row_begin, row_end) in the background.
+  void Prefetch(int row_begin, int row_end) const {
+    assert(row_begin >= 0 && row_begin <= row_end && row_end <= this->rows_);
+    file_.Prefetch(static_cast<std::size_t>(row_begin) * this->step_,
+                   static_cast<std::size_t>(row_end - row_begin) * this->step_);
+  }
+
+  // Flushes the pages written through a ReadWrite mapping to the file.
+  void Sync() const { file_.Sync(); }
+
+ private:
+  explicit MappedMat(detail::MappedFile file)
+      : MatView<T, C>(reinterpret_cast<T*>(file.data()), file.header().rows, file.header().cols,
+                      file.header().step),
+        file_(std::move(file)) {}
+
+  void Release() {
+    this->data_ = nullptr;
+    this->rows_ = 0;
+    this->cols_ = 0;
+    this->step_ = 0;
+  }
+
+  detail::MappedFile file_;
+};
+
+}  // namespace core
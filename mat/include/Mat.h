@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+#include "MatAllocator.h"
+#include "MatRandom.h"
+
+namespace core {
+
+// Default row alignment (bytes) of Mat. Every row starts on a cache line so vectorized row loops
+// never straddle a line at the row head.
+inline constexpr std::size_t kMatRowAlign = 64;
+
+// Pass as row alignment to get a tightly packed Mat (step == cols * C * sizeof(T)), e.g. for APIs
+// that expect a contiguous buffer without a row pitch.
+inline constexpr std::size_t kMatNoPadding = 1;
+
+// Tag selecting the Mat constructor that leaves the pixels uninitialized, for buffers that are
+// about to be overwritten anyway (readbacks, memcpy targets, filter outputs).
+struct MatUninitializedTag {};
+inline constexpr MatUninitializedTag kMatUninitialized{};
+
+inline constexpr std::size_t AlignUp(const std::size_t value, const std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Non-owning view over an image with an arbitrary row pitch. step() is the distance in bytes
+// between the starts of two consecutive rows; a step of 0 passed to the constructor means the
+// rows are tightly packed.
+template <typename T, int C>
+class MatView {
+ public:
+  MatView() = default;
+  MatView(T* data, int rows, int cols, std::size_t step = 0)
+      : data_(data),
+        rows_(rows),
+        cols_(cols),
+        step_(step ? step : static_cast<std::size_t>(cols) * C * sizeof(T)) {
+    assert(step_ >= static_cast<std::size_t>(cols) * C * sizeof(T));
+    assert(step_ % sizeof(T) == 0);
+  }
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  int channels() const { return C; }
+  // Number of elements inside the view (padding excluded).
+  int total() const { return rows_ * cols_ * C; }
+  // Row pitch in bytes.
+  std::size_t step() const { return step_; }
+  // Size in bytes of one row without padding.
+  std::size_t row_bytes() const { return static_cast<std::size_t>(cols_) * C * sizeof(T); }
+  // True when there is no padding between rows, i.e. data() can be treated as one flat array.
+  bool isContinuous() const { return rows_ <= 1 || step_ == row_bytes(); }
+
+  T* row(int r) {
+    assert(r >= 0 && r < rows_);
+    return reinterpret_cast<T*>(reinterpret_cast<std::uint8_t*>(data_) + r * step_);
+  }
+
+  const T* row(int r) const {
+    assert(r >= 0 && r < rows_);
+    return reinterpret_cast<const T*>(reinterpret_cast<const std::uint8_t*>(data_) + r * step_);
+  }
+
+  T* operator()(int r, int c) {
+    assert(r >= 0 && r < rows_ && c >= 0 && c < cols_);
+    return row(r) + c * C;
+  }
+
+  const T* operator()(int r, int c) const {
+    assert(r >= 0 && r < rows_ && c >= 0 && c < cols_);
+    return row(r) + c * C;
+  }
+
+  T* operator()(int row, int col, int ch) {
+    assert(row >= 0 && row < rows_ && col >= 0 && col < cols_ && ch >= 0 && ch < C);
+    return this->row(row) + col * C + ch;
+  }
+
+  const T* operator()(int row, int col, int ch) const {
+    assert(row >= 0 && row < rows_ && col >= 0 && col < cols_ && ch >= 0 && ch < C);
+    return this->row(row) + col * C + ch;
+  }
+
+  // Zero-copy region of interest. The returned view shares memory and row pitch with this one.
+  MatView Roi(int x, int y, int w, int h) const {
+    assert(x >= 0 && y >= 0 && w >= 0 && h >= 0 && x + w <= cols_ && y + h <= rows_);
+    T* origin = reinterpret_cast<T*>(reinterpret_cast<std::uint8_t*>(data_) + y * step_) + x * C;
+    return MatView(origin, h, w, step_);
+  }
+
+  void Fill(const T value) {
+    for (int r = 0; r < rows_; ++r) std::fill_n(row(r), cols_ * C, value);
+  }
+
+  // Fills the view with values uniform in [0, 1) for floating point T and in [0, max()] for
+  // integral T, other types get T{}. Element i (in row-major order, padding excluded) is drawn
+  // from the counter-based Philox4x32 stream of seed at index i, so the result depends on the seed
+  // and the view size only: it is the same with or without pool, for any thread count, any
+  // instruction set and any row pitch.
+  void Random(std::uint64_t seed = 0, ThreadPool* pool = nullptr) {
+    if constexpr (std::is_arithmetic_v<T>) {
+      detail::RandomRows(data_, step_, rows_, static_cast<std::size_t>(cols_) * C,
+                         Philox4x32(seed), detail::RandomSpan<T>, pool);
+    } else {
+      Fill(T{});
+    }
+  }
+
+  // Copy the view into dst, whose rows are dst_step bytes apart (0 means tightly packed).
+  void CopyTo(void* dst, std::size_t dst_step = 0) const {
+    static_assert(std::is_trivially_copyable_v<T>, "CopyTo requires trivially copyable T");
+    const std::size_t bytes = row_bytes();
+    if (dst_step == 0) dst_step = bytes;
+    if (dst_step == step_ && isContinuous()) {
+      std::memcpy(dst, data_, bytes * rows_);
+      return;
+    }
+    for (int r = 0; r < rows_; ++r) {
+      std::memcpy(static_cast<std::uint8_t*>(dst) + r * dst_step, row(r), bytes);
+    }
+  }
+
+  // Copy src, whose rows are src_step bytes apart (0 means tightly packed), into the view.
+  void CopyFrom(const void* src, std::size_t src_step = 0) {
+    static_assert(std::is_trivially_copyable_v<T>, "CopyFrom requires trivially copyable T");
+    const std::size_t bytes = row_bytes();
+    if (src_step == 0) src_step = bytes;
+    if (src_step == step_ && isContinuous()) {
+      std::memcpy(data_, src, bytes * rows_);
+      return;
+    }
+    for (int r = 0; r < rows_; ++r) {
+      std::memcpy(row(r), static_cast<const std::uint8_t*>(src) + r * src_step, bytes);
+    }
+  }
+
+ protected:
+  T* data_ = nullptr;
+  int rows_ = 0;
+  int cols_ = 0;
+  std::size_t step_ = 0;
+};
+
+template <typename T, int C>
+class Mat : public MatView<T, C> {
+ public:
+  // Rows are padded to a multiple of row_align bytes (a power of two). The default aligns every
+  // row to a cache line; use kMatNoPadding for a tightly packed buffer. The buffer comes from
+  // allocator, or from the thread's default allocator (see MatAllocator.h) when it is nullptr.
+  Mat(int rows, int cols, std::size_t row_align = kMatRowAlign, MatAllocator* allocator = nullptr)
+      : MatView<T, C>(nullptr, rows, cols, ComputeStep(cols, row_align)),
+        allocator_(allocator != nullptr ? allocator : GetDefaultMatAllocator()) {
+    Allocate();
+    std::uninitialized_value_construct_n(this->data_, size());
+  }
+
+  // Same as above without zero-filling the buffer: trivial types are left indeterminate.
+  Mat(int rows, int cols, MatUninitializedTag, std::size_t row_align = kMatRowAlign,
+      MatAllocator* allocator = nullptr)
+      : MatView<T, C>(nullptr, rows, cols, ComputeStep(cols, row_align)),
+        allocator_(allocator != nullptr ? allocator : GetDefaultMatAllocator()) {
+    Allocate();
+    std::uninitialized_default_construct_n(this->data_, size());
+  }
+
+  // Copies share the allocator of the source.
+  Mat(const Mat& other)
+      : MatView<T, C>(nullptr, other.rows_, other.cols_, other.step_),
+        allocator_(other.allocator_) {
+    Allocate();
+    std::uninitialized_copy_n(other.data_, size(), this->data_);
+  }
+
+  Mat(Mat&& other) noexcept
+      : MatView<T, C>(other.data_, other.rows_, other.cols_, other.step_),
+        allocator_(other.allocator_) {
+    other.Release();
+  }
+
+  Mat& operator=(const Mat& other) {
+    if (this == &other) return *this;
+    if (allocator_ != other.allocator_ || bytes() != other.bytes()) {
+      *this = Mat(other);
+      return *this;
+    }
+    // Same buffer size: reuse the buffer instead of going through the allocator
+    std::copy_n(other.data_, other.size(), this->data_);
+    this->rows_ = other.rows_;
+    this->cols_ = other.cols_;
+    this->step_ = other.step_;
+    return *this;
+  }
+
+  Mat& operator=(Mat&& other) noexcept {
+    if (this == &other) return *this;
+    Free();
+    this->data_ = other.data_;
+    this->rows_ = other.rows_;
+    this->cols_ = other.cols_;
+    this->step_ = other.step_;
+    allocator_ = other.allocator_;
+    other.Release();
+    return *this;
+  }
+
+  ~Mat() { Free(); }
+
+  // Deep copy; keeps the row pitch and the allocator of the source.
+  [[nodiscard]] Mat clone() const { return Mat(*this); }
+
+  MatAllocator* allocator() const { return allocator_; }
+
+  void Fill(const T value) { std::fill_n(this->data_, size(), value); }
+
+ private:
+  static std::size_t ComputeStep(int cols, std::size_t row_align) {
+    assert(row_align > 0 && (row_align & (row_align - 1)) == 0);
+    const std::size_t bytes = static_cast<std::size_t>(cols) * C * sizeof(T);
+    return AlignUp(bytes, std::max(row_align, sizeof(T)));
+  }
+
+  // Number of T in the buffer, row padding included.
+  std::size_t size() const { return this->rows_ * this->step_ / sizeof(T); }
+  std::size_t bytes() const { return this->rows_ * this->step_; }
+
+  void Allocate() {
+    this->data_ = bytes() ? static_cast<T*>(allocator_->Allocate(bytes())) : nullptr;
+  }
+
+  void Free() noexcept {
+    if (this->data_ == nullptr) return;
+    std::destroy_n(this->data_, size());
+    allocator_->Deallocate(this->data_, bytes());
+    this->data_ = nullptr;
+  }
+
+  // Leaves a moved-from Mat empty.
+  void Release() noexcept {
+    this->data_ = nullptr;
+    this->rows_ = 0;
+    this->cols_ = 0;
+    this->step_ = 0;
+  }
+
+  MatAllocator* allocator_;
+};
+
+}  // namespace core
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace core {
+
+// Alignment (bytes) of every buffer handed out by a MatAllocator.
+inline constexpr std::size_t kMatBufferAlign = 64;
+
+// Source of the pixel buffers of Mat. Implementations must be thread-safe: a Mat may be destroyed
+// on a different thread than the one that created it. Every allocator must outlive the Mats that
+// were allocated from it.
+class MatAllocator {
+ public:
+  virtual ~MatAllocator() = default;
+
+  // Returns a kMatBufferAlign aligned block of at least bytes bytes. Throws std::bad_alloc.
+  virtual void* Allocate(std::size_t bytes) = 0;
+  // bytes is the size that was passed to Allocate.
+  virtual void Deallocate(void* p, std::size_t bytes) noexcept = 0;
+};
+
+// Process-wide counters of the heap (and mmap) allocations made on behalf of Mat buffers, by any
+// allocator in this file. Steady-state code running on a MatBufferPool or MatArena should leave
+// allocations unchanged.
+struct MatHeapStats {
+  std::uint64_t allocations = 0;
+  std::uint64_t deallocations = 0;
+  std::uint64_t bytes_allocated = 0;  // cumulative
+  std::uint64_t bytes_in_use = 0;
+};
+
+MatHeapStats GetMatHeapStats();
+
+// Plain aligned operator new / delete. This is what Mat uses unless told otherwise.
+class HeapMatAllocator : public MatAllocator {
+ public:
+  void* Allocate(std::size_t bytes) override;
+  void Deallocate(void* p, std::size_t bytes) noexcept override;
+
+  static HeapMatAllocator* Instance();
+};
+
+// Backs buffers of at least min_bytes with transparent huge pages: they are mapped 2 MiB aligned
+// with mmap and flagged with madvise(MADV_HUGEPAGE), which cuts TLB misses when sweeping
+// multi-megapixel images. Smaller buffers, and platforms without THP, go to the heap. Fresh
+// mappings are zero-filled lazily by the kernel, so this pairs well with kMatUninitialized.
+class HugePageMatAllocator : public MatAllocator {
+ public:
+  static constexpr std::size_t kHugePageSize = 2 << 20;
+
+  explicit HugePageMatAllocator(std::size_t min_bytes = kHugePageSize);
+
+  void* Allocate(std::size_t bytes) override;
+  void Deallocate(void* p, std::size_t bytes) noexcept override;
+
+  static HugePageMatAllocator* Instance();
+
+ private:
+  const std::size_t min_bytes_;
+};
+
+// Recycling pool. Requests are rounded up to a size class (4 classes per power of two, so at
+// most 25% slack) and freed buffers are kept on a per-class free list instead of going back to
+// upstream (the heap when nullptr). Once every size a pipeline needs has been seen, constructing
+// and destroying Mats costs a mutex and a vector push/pop.
+class MatBufferPool : public MatAllocator {
+ public:
+  struct Stats {
+    std::uint64_t hits = 0;    // served from a free list
+    std::uint64_t misses = 0;  // had to go to upstream
+    std::size_t cached_bytes = 0;
+    std::size_t outstanding = 0;  // buffers currently handed out
+  };
+
+  // Freed buffers beyond max_cached_bytes go back to upstream.
+  explicit MatBufferPool(std::size_t max_cached_bytes = std::numeric_limits<std::size_t>::max(),
+                         MatAllocator* upstream = nullptr);
+  ~MatBufferPool() override;
+
+  MatBufferPool(const MatBufferPool&) = delete;
+  MatBufferPool& operator=(const MatBufferPool&) = delete;
+
+  void* Allocate(std::size_t bytes) override;
+  void Deallocate(void* p, std::size_t bytes) noexcept override;
+
+  // Returns every cached buffer to upstream.
+  void Trim();
+  Stats stats() const;
+
+  static std::size_t SizeClass(std::size_t bytes);
+
+ private:
+  const std::size_t max_cached_bytes_;
+  MatAllocator* const upstream_;
+  mutable std::mutex m_;
+  std::map<std::size_t, std::vector<void*>> free_;
+  Stats stats_;
+};
+
+// Per-frame bump allocator. Allocation is a pointer increment inside a retained chunk and
+// Deallocate only does bookkeeping; Reset() rewinds everything at once, typically at the end of
+// a frame. Chunks are kept across Reset(), so a frame that allocates the same sequence of sizes
+// as the previous one performs no heap allocation. Chunks come from upstream (the heap when
+// nullptr).
+class MatArena : public MatAllocator {
+ public:
+  struct Stats {
+    std::size_t chunks = 0;
+    std::size_t capacity = 0;  // bytes over all chunks
+    std::size_t used = 0;      // bytes handed out since the last Reset()
+    std::size_t peak = 0;      // largest used seen
+    std::size_t live = 0;      // allocations not yet deallocated
+  };
+
+  explicit MatArena(std::size_t chunk_bytes = 64 << 20, MatAllocator* upstream = nullptr);
+  ~MatArena() override;
+
+  MatArena(const MatArena&) = delete;
+  MatArena& operator=(const MatArena&) = delete;
+
+  void* Allocate(std::size_t bytes) override;
+  void Deallocate(void* p, std::size_t bytes) noexcept override;
+
+  // Rewinds the arena. Throws std::runtime_error if Mats allocated from it are still alive.
+  void Reset();
+  Stats stats() const;
+
+ private:
+  struct Chunk {
+    std::uint8_t* data;
+    std::size_t size;
+  };
+
+  const std::size_t chunk_bytes_;
+  MatAllocator* const upstream_;
+  mutable std::mutex m_;
+  std::vector<Chunk> chunks_;
+  std::size_t current_ = 0;  // chunk being bumped
+  std::size_t offset_ = 0;   // bump offset inside chunks_[current_]
+  Stats stats_;
+};
+
+// Allocator used by Mats constructed without an explicit one, per thread. nullptr restores the
+// heap allocator.
+MatAllocator* GetDefaultMatAllocator();
+void SetDefaultMatAllocator(MatAllocator* allocator);
+
+// Makes allocator the default of the current thread for the lifetime of the scope.
+class ScopedMatAllocator {
+ public:
+  explicit ScopedMatAllocator(MatAllocator* allocator) : previous_(GetDefaultMatAllocator()) {
+    SetDefaultMatAllocator(allocator);
+  }
+  ~ScopedMatAllocator() { SetDefaultMatAllocator(previous_); }
+
+  ScopedMatAllocator(const ScopedMatAllocator&) = delete;
+  ScopedMatAllocator& operator=(const ScopedMatAllocator&) = delete;
+
+ private:
+  MatAllocator* previous_;
+};
+
+}  // namespace core
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include "Mat.h"
+
+namespace core {
+
+class ThreadPool;
+
+// How pixels outside the image are synthesized.
+enum class BorderMode {
+  Clamp,     // aaa|abcd|ddd
+  Reflect,   // cb|abcd|cb   (mirror without repeating the edge pixel)
+  Constant,  // vv|abcd|vv   (border_value)
+};
+
+namespace detail {
+
+// Maps a coordinate outside [0, n) back into the image. Not used for BorderMode::Constant.
+inline int BorderIndex(int i, const int n, const BorderMode border) {
+  if (i >= 0 && i < n) return i;
+  if (border == BorderMode::Clamp || n == 1) return i < 0 ? 0 : n - 1;
+  const int period = 2 * (n - 1);
+  i %= period;
+  if (i < 0) i += period;
+  return i < n ? i : period - i;
+}
+
+struct FilterImage {
+  const float* src;
+  std::size_t src_step;
+  float* dst;
+  std::size_t dst_step;
+  int rows;
+  int cols;
+  int channels;
+};
+
+void SepFilter2D(const FilterImage& image, const std::vector<float>& kernel_x,
+                 const std::vector<float>& kernel_y, BorderMode border, float border_value,
+                 ThreadPool* pool);
+
+void Filter2D(const FilterImage& image, const std::vector<float>& kernel, int kernel_cols,
+              BorderMode border, float border_value, ThreadPool* pool);
+
+template <int C>
+FilterImage MakeFilterImage(const MatView<float, C>& src, MatView<float, C>& dst) {
+  if (src.rows() != dst.rows() || src.cols() != dst.cols()) {
+    throw std::invalid_argument("Filter: src and dst sizes differ");
+  }
+  return {src.data(), src.step(), dst.data(), dst.step(), src.rows(), src.cols(), C};
+}
+
+}  // namespace detail
+
+// CPU convolution engine (correlation, i.e. kernels are not flipped). Kernel sizes must be odd and
+// are centered on the output pixel; any radius is supported. Images are processed in row bands
+// and column tiles whose intermediate rows live in a small ring buffer that stays in L1/L2, and
+// the inner loops use the SIMD kernels of MatOps. When pool is given the tiles run on it. dst must
+// have the same size as src and must not alias it.
+
+// Separable filter: kernel_x is applied along rows, then kernel_y along columns.
+template <int C>
+void SepFilter2D(const MatView<float, C>& src, MatView<float, C> dst,
+                 const std::vector<float>& kernel_x, const std::vector<float>& kernel_y,
+                 BorderMode border = BorderMode::Clamp, float border_value = 0.0f,
+                 ThreadPool* pool = nullptr) {
+  detail::SepFilter2D(detail::MakeFilterImage(src, dst), kernel_x, kernel_y, border, border_value,
+                      pool);
+}
+
+// Non-separable filter. kernel is row-major with kernel_cols columns.
+template <int C>
+void Filter2D(const MatView<float, C>& src, MatView<float, C> dst, const std::vector<float>& kernel,
+              int kernel_cols, BorderMode border = BorderMode::Clamp, float border_value = 0.0f,
+              ThreadPool* pool = nullptr) {
+  detail::Filter2D(detail::MakeFilterImage(src, dst), kernel, kernel_cols, border, border_value,
+                   pool);
+}
+
+// Normalized 1D Gaussian of 2 * radius + 1 taps.
+std::vector<float> GaussianKernel(int radius, float sigma);
+
+template <int C>
+void GaussianBlur(const MatView<float, C>& src, MatView<float, C> dst, int radius, float sigma,
+                  BorderMode border = BorderMode::Clamp, ThreadPool* pool = nullptr) {
+  const std::vector<float> kernel = GaussianKernel(radius, sigma);
+  SepFilter2D(src, dst, kernel, kernel, border, 0.0f, pool);
+}
+
+}  // namespace core
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "Mat.h"
+
+namespace core {
+
+// Instruction set used by the Mat kernels. The best one supported by the CPU is selected on first
+// use; SetSimdIsa() can force a narrower one (tests, benchmarks).
+enum class SimdIsa { Scalar, SSE4, AVX2, NEON };
+
+SimdIsa GetSimdIsa();
+
+// Returns false and keeps the current selection when isa is not available on this CPU/build.
+bool SetSimdIsa(SimdIsa isa);
+
+const char* SimdIsaName(SimdIsa isa);
+
+namespace detail {
+
+// Flat-span entry points, dispatched to the selected instruction set. float and uint8_t have SIMD
+// kernels (uint8_t arithmetic saturates); other types fall back to the templates below.
+void Add(const float* a, const float* b, float* dst, std::size_t n);
+void Sub(const float* a, const float* b, float* dst, std::size_t n);
+void Mul(const float* a, const float* b, float* dst, std::size_t n);
+void Min(const float* a, const float* b, float* dst, std::size_t n);
+void Max(const float* a, const float* b, float* dst, std::size_t n);
+void AbsDiff(const float* a, const float* b, float* dst, std::size_t n);
+
+void Add(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n);
+void Sub(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n);
+void Mul(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n);
+void Min(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n);
+void Max(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n);
+void AbsDiff(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n);
+
+void Convert(const float* src, float* dst, std::size_t n, float scale, float offset);
+void Convert(const uint8_t* src, float* dst, std::size_t n, float scale, float offset);
+void Convert(const float* src, uint8_t* dst, std::size_t n, float scale, float offset);
+
+template <typename T>
+void Add(const T* a, const T* b, T* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = static_cast<T>(a[i] + b[i]);
+}
+
+template <typename T>
+void Sub(const T* a, const T* b, T* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = static_cast<T>(a[i] - b[i]);
+}
+
+template <typename T>
+void Mul(const T* a, const T* b, T* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = static_cast<T>(a[i] * b[i]);
+}
+
+template <typename T>
+void Min(const T* a, const T* b, T* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] < b[i] ? a[i] : b[i];
+}
+
+template <typename T>
+void Max(const T* a, const T* b, T* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+template <typename T>
+void AbsDiff(const T* a, const T* b, T* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+}
+
+template <typename T, typename U>
+void Convert(const T* src, U* dst, std::size_t n, float scale, float offset) {
+  for (std::size_t i = 0; i < n; ++i) {
+    const float v = static_cast<float>(src[i]) * scale + offset;
+    if constexpr (std::is_integral_v<U>) {
+      const double lo = static_cast<double>(std::numeric_limits<U>::lowest());
+      const double hi = static_cast<double>(std::numeric_limits<U>::max());
+      const double c = static_cast<double>(v);
+      dst[i] = static_cast<U>(std::llrint(c < lo ? lo : (c > hi ? hi : c)));
+    } else {
+      dst[i] = static_cast<U>(v);
+    }
+  }
+}
+
+// Calls fn(a_row, b_row, dst_row, n) once for the whole image when all views are continuous and
+// once per row otherwise.
+template <typename TA, typename TB, typename TD, int C, typename Fn>
+void ForEachRow(const MatView<TA, C>& a, const MatView<TB, C>& b, MatView<TD, C> dst, Fn&& fn) {
+  assert(a.rows() == dst.rows() && a.cols() == dst.cols());
+  assert(b.rows() == dst.rows() && b.cols() == dst.cols());
+  if (a.isContinuous() && b.isContinuous() && dst.isContinuous()) {
+    fn(a.data(), b.data(), dst.data(), static_cast<std::size_t>(dst.total()));
+    return;
+  }
+  const std::size_t n = static_cast<std::size_t>(dst.cols()) * C;
+  for (int r = 0; r < dst.rows(); ++r) fn(a.row(r), b.row(r), dst.row(r), n);
+}
+
+template <typename T, typename U, int C, typename Fn>
+void ForEachRow(const MatView<T, C>& src, MatView<U, C> dst, Fn&& fn) {
+  assert(src.rows() == dst.rows() && src.cols() == dst.cols());
+  if (src.isContinuous() && dst.isContinuous()) {
+    fn(src.data(), dst.data(), static_cast<std::size_t>(dst.total()));
+    return;
+  }
+  const std::size_t n = static_cast<std::size_t>(dst.cols()) * C;
+  for (int r = 0; r < dst.rows(); ++r) fn(src.row(r), dst.row(r), n);
+}
+
+}  // namespace detail
+
+// Element-wise kernels over MatView. dst is taken by value like any view (a Mat or a temporary
+// Roi() both bind); it must have the same size as the inputs and may alias them. Row pitches are
+// independent, so ROIs can be mixed with whole images. For uint8_t the arithmetic saturates to
+// [0, 255].
+
+template <typename T, int C>
+void Add(const MatView<T, C>& a, const MatView<T, C>& b, MatView<T, C> dst) {
+  detail::ForEachRow(a, b, dst, [](const T* x, const T* y, T* d, std::size_t n) {
+    detail::Add(x, y, d, n);
+  });
+}
+
+template <typename T, int C>
+void Sub(const MatView<T, C>& a, const MatView<T, C>& b, MatView<T, C> dst) {
+  detail::ForEachRow(a, b, dst, [](const T* x, const T* y, T* d, std::size_t n) {
+    detail::Sub(x, y, d, n);
+  });
+}
+
+template <typename T, int C>
+void Mul(const MatView<T, C>& a, const MatView<T, C>& b, MatView<T, C> dst) {
+  detail::ForEachRow(a, b, dst, [](const T* x, const T* y, T* d, std::size_t n) {
+    detail::Mul(x, y, d, n);
+  });
+}
+
+template <typename T, int C>
+void Min(const MatView<T, C>& a, const MatView<T, C>& b, MatView<T, C> dst) {
+  detail::ForEachRow(a, b, dst, [](const T* x, const T* y, T* d, std::size_t n) {
+    detail::Min(x, y, d, n);
+  });
+}
+
+template <typename T, int C>
+void Max(const MatView<T, C>& a, const MatView<T, C>& b, MatView<T, C> dst) {
+  detail::ForEachRow(a, b, dst, [](const T* x, const T* y, T* d, std::size_t n) {
+    detail::Max(x, y, d, n);
+  });
+}
+
+template <typename T, int C>
+void AbsDiff(const MatView<T, C>& a, const MatView<T, C>& b, MatView<T, C> dst) {
+  detail::ForEachRow(a, b, dst, [](const T* x, const T* y, T* d, std::size_t n) {
+    detail::AbsDiff(x, y, d, n);
+  });
+}
+
+// dst = src * scale + offset, computed in float. Conversions to integer types round to nearest
+// even and saturate.
+template <typename U, typename T, int C>
+void ConvertTo(const MatView<T, C>& src, MatView<U, C> dst, float scale = 1.0f,
+               float offset = 0.0f) {
+  detail::ForEachRow(src, dst, [scale, offset](const T* s, U* d, std::size_t n) {
+    detail::Convert(s, d, n, scale, offset);
+  });
+}
+
+// dst = src * scale + offset
+template <typename T, int C>
+void Scale(const MatView<T, C>& src, MatView<T, C> dst, float scale, float offset = 0.0f) {
+  ConvertTo(src, dst, scale, offset);
+}
+
+}  // namespace core
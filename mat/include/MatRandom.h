@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace core {
+
+class ThreadPool;
+
+// Counter-based random generator Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy
+// as 1, 2, 3", SC 2011). The stream of a seed is a sequence of 128-bit blocks where block n is a
+// pure function of (seed, n), so any part of it can be generated on its own, in any order and on
+// any thread. It passes TestU01's BigCrush.
+class Philox4x32 {
+ public:
+  explicit Philox4x32(std::uint64_t seed)
+      : key_{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)} {}
+
+  std::uint64_t seed() const { return key_[0] | static_cast<std::uint64_t>(key_[1]) << 32; }
+
+  // The four words of block n.
+  std::array<std::uint32_t, 4> operator()(std::uint64_t n) const;
+
+  // Words [first, first + n) of the stream, word w being word w % 4 of block w / 4. Uses the SIMD
+  // kernels selected by SetSimdIsa(); every instruction set produces the same words.
+  void Generate(std::uint64_t first, std::uint32_t* dst, std::size_t n) const;
+
+ private:
+  std::uint32_t key_[2];
+};
+
+namespace detail {
+
+// Value of type T drawn from the words at w (two words for 64-bit types): floating point types
+// are uniform in [0, 1), integral types uniform in [0, max()].
+template <typename T>
+T RandomValue(const std::uint32_t* w) {
+  if constexpr (std::is_same_v<T, float>) {
+    return static_cast<float>(w[0] >> 8) * 0x1p-24f;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    const std::uint64_t bits = static_cast<std::uint64_t>(w[0]) << 32 | w[1];
+    return static_cast<T>(static_cast<double>(bits >> 11) * 0x1p-53);
+  } else {
+    static_assert(std::is_integral_v<T>, "RandomValue: arithmetic types only");
+    std::uint64_t bits = w[0];
+    if constexpr (sizeof(T) > 4) bits = bits << 32 | w[1];
+    return static_cast<T>(bits & static_cast<std::uint64_t>(std::numeric_limits<T>::max()));
+  }
+}
+
+// Fills n values of type T at dst with elements [first, first + n) of the stream of gen.
+template <typename T>
+void RandomSpan(void* dst, std::size_t n, const Philox4x32& gen, std::uint64_t first) {
+  constexpr std::size_t kWords = sizeof(T) > 4 ? 2 : 1;
+  constexpr std::size_t kChunk = 1024;
+  std::uint32_t words[kChunk * kWords];
+  T* out = static_cast<T*>(dst);
+  for (std::size_t i = 0; i < n; i += kChunk) {
+    const std::size_t m = std::min(kChunk, n - i);
+    gen.Generate((first + i) * kWords, words, m * kWords);
+    for (std::size_t j = 0; j < m; ++j) out[i + j] = RandomValue<T>(words + j * kWords);
+  }
+}
+
+using RandomSpanFn = void (*)(void* dst, std::size_t n, const Philox4x32& gen,
+                              std::uint64_t first);
+
+// Calls fill on every row of an image of rows x row_elements elements, passing the row-major index
+// of the first element of the row, in row bands on pool when given.
+void RandomRows(void* data, std::size_t step, int rows, std::size_t row_elements,
+                const Philox4x32& gen, RandomSpanFn fill, ThreadPool* pool);
+
+}  // namespace detail
+}  // namespace core
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Mat.h"
+
+namespace core {
+
+class ThreadPool;
+
+// Extrema of one channel and the first pixel (in row-major order) holding each of them.
+struct MinMaxLoc {
+  double min;
+  double max;
+  int min_x;
+  int min_y;
+  int max_x;
+  int max_y;
+};
+
+template <int C>
+struct MeanStdDevResult {
+  std::array<double, C> mean;
+  std::array<double, C> stddev;  // population standard deviation
+};
+
+namespace detail {
+
+struct ReduceImage {
+  const void* data;
+  std::size_t step;
+  int rows;
+  int cols;
+  int channels;
+};
+
+template <typename T, int C>
+ReduceImage MakeReduceImage(const MatView<T, C>& src) {
+  return {src.data(), src.step(), src.rows(), src.cols(), C};
+}
+
+// The uint8_t and float entry points below handle 1 to 4 channels; outputs hold one entry per
+// channel (histograms: channels consecutive tables of bins counters).
+void SumF32(const ReduceImage& image, double* sum, ThreadPool* pool);
+void SumU8(const ReduceImage& image, double* sum, ThreadPool* pool);
+void MinMaxF32(const ReduceImage& image, MinMaxLoc* result, ThreadPool* pool);
+void MinMaxU8(const ReduceImage& image, MinMaxLoc* result, ThreadPool* pool);
+void MeanStdDevF32(const ReduceImage& image, double* mean, double* stddev, ThreadPool* pool);
+void HistogramU8(const ReduceImage& image, std::uint64_t* hist, ThreadPool* pool);
+void HistogramF32(const ReduceImage& image, int bins, float lo, float hi, std::uint64_t* hist,
+                  ThreadPool* pool);
+
+template <typename T, int C>
+constexpr bool kHasReduceKernels =
+    (std::is_same_v<T, float> || std::is_same_v<T, std::uint8_t>) && C >= 1 && C <= 4;
+
+template <typename T, int C>
+void CheckNotEmpty(const MatView<T, C>& src, const char* what) {
+  if (src.rows() == 0 || src.cols() == 0) {
+    throw std::invalid_argument(std::string(what) + ": empty image");
+  }
+}
+
+}  // namespace detail
+
+// Reductions over all pixels, per channel. uint8_t and float images of up to 4 channels use the
+// SIMD kernels of MatOps; other types fall back to a serial loop. When pool is given, the image is
+// split in row bands whose boundaries do not depend on the pool size and whose partial results
+// are combined in band order, so results are identical with and without a pool. Float sums are
+// accumulated in float lanes over short blocks, then in double.
+
+template <typename T, int C>
+std::array<double, C> Sum(const MatView<T, C>& src, ThreadPool* pool = nullptr) {
+  std::array<double, C> sum{};
+  if constexpr (detail::kHasReduceKernels<T, C>) {
+    if constexpr (std::is_same_v<T, float>) {
+      detail::SumF32(detail::MakeReduceImage(src), sum.data(), pool);
+    } else {
+      detail::SumU8(detail::MakeReduceImage(src), sum.data(), pool);
+    }
+  } else {
+    for (int r = 0; r < src.rows(); ++r) {
+      const T* row = src.row(r);
+      for (int c = 0; c < src.cols(); ++c) {
+        for (int ch = 0; ch < C; ++ch) sum[ch] += static_cast<double>(row[c * C + ch]);
+      }
+    }
+  }
+  return sum;
+}
+
+// Throws std::invalid_argument on an empty image.
+template <typename T, int C>
+std::array<double, C> Mean(const MatView<T, C>& src, ThreadPool* pool = nullptr) {
+  detail::CheckNotEmpty(src, "Mean");
+  std::array<double, C> mean = Sum(src, pool);
+  const double count = static_cast<double>(src.rows()) * src.cols();
+  for (double& m : mean) m /= count;
+  return mean;
+}
+
+// Throws std::invalid_argument on an empty image. NaNs are not supported.
+template <typename T, int C>
+std::array<MinMaxLoc, C> MinMax(const MatView<T, C>& src, ThreadPool* pool = nullptr) {
+  detail::CheckNotEmpty(src, "MinMax");
+  std::array<MinMaxLoc, C> result;
+  if constexpr (detail::kHasReduceKernels<T, C>) {
+    if constexpr (std::is_same_v<T, float>) {
+      detail::MinMaxF32(detail::MakeReduceImage(src), result.data(), pool);
+    } else {
+      detail::MinMaxU8(detail::MakeReduceImage(src), result.data(), pool);
+    }
+  } else {
+    for (int ch = 0; ch < C; ++ch) {
+      const double first = static_cast<double>(src.row(0)[ch]);
+      result[ch] = {first, first, 0, 0, 0, 0};
+    }
+    for (int r = 0; r < src.rows(); ++r) {
+      const T* row = src.row(r);
+      for (int c = 0; c < src.cols(); ++c) {
+        for (int ch = 0; ch < C; ++ch) {
+          const double v = static_cast<double>(row[c * C + ch]);
+          MinMaxLoc& m = result[ch];
+          if (v < m.min) m = {v, m.max, c, r, m.max_x, m.max_y};
+          if (v > m.max) m = {m.min, v, m.min_x, m.min_y, c, r};
+        }
+      }
+    }
+  }
+  return result;
+}
+
+// Single pass; the float version accumulates around the first pixel to avoid the cancellation of
+// the naive E[x^2] - E[x]^2, the uint8_t one derives both moments exactly from the histogram.
+// Throws std::invalid_argument on an empty image.
+template <typename T, int C>
+MeanStdDevResult<C> MeanStdDev(const MatView<T, C>& src, ThreadPool* pool = nullptr);
+
+// 256-bin histogram of every channel of an 8-bit image.
+template <int C>
+std::array<std::vector<std::uint64_t>, C> Histogram(const MatView<std::uint8_t, C>& src,
+                                                    ThreadPool* pool = nullptr) {
+  static_assert(C >= 1 && C <= 4, "Histogram: 1 to 4 channels");
+  std::vector<std::uint64_t> hist(static_cast<std::size_t>(C) * 256);
+  detail::HistogramU8(detail::MakeReduceImage(src), hist.data(), pool);
+  std::array<std::vector<std::uint64_t>, C> result;
+  for (int ch = 0; ch < C; ++ch) {
+    result[ch].assign(hist.begin() + ch * 256, hist.begin() + (ch + 1) * 256);
+  }
+  return result;
+}
+
+// bins equal-width bins over [lo, hi], hi falling in the last bin. Values outside the range and
+// NaNs are not counted. Throws std::invalid_argument unless bins > 0 and lo < hi.
+template <int C>
+std::array<std::vector<std::uint64_t>, C> Histogram(const MatView<float, C>& src, int bins,
+                                                    float lo, float hi,
+                                                    ThreadPool* pool = nullptr) {
+  static_assert(C >= 1 && C <= 4, "Histogram: 1 to 4 channels");
+  if (bins <= 0 || !(lo < hi)) {
+    throw std::invalid_argument("Histogram: needs bins > 0 and lo < hi");
+  }
+  std::vector<std::uint64_t> hist(static_cast<std::size_t>(C) * bins);
+  detail::HistogramF32(detail::MakeReduceImage(src), bins, lo, hi, hist.data(), pool);
+  std::array<std::vector<std::uint64_t>, C> result;
+  for (int ch = 0; ch < C; ++ch) {
+    result[ch].assign(hist.begin() + ch * bins, hist.begin() + (ch + 1) * bins);
+  }
+  return result;
+}
+
+template <typename T, int C>
+MeanStdDevResult<C> MeanStdDev(const MatView<T, C>& src, ThreadPool* pool) {
+  detail::CheckNotEmpty(src, "MeanStdDev");
+  MeanStdDevResult<C> result;
+  if constexpr (detail::kHasReduceKernels<T, C> && std::is_same_v<T, float>) {
+    detail::MeanStdDevF32(detail::MakeReduceImage(src), result.mean.data(), result.stddev.data(),
+                          pool);
+  } else if constexpr (detail::kHasReduceKernels<T, C>) {
+    const std::array<std::vector<std::uint64_t>, C> hist = Histogram(src, pool);
+    const double count = static_cast<double>(src.rows()) * src.cols();
+    for (int ch = 0; ch < C; ++ch) {
+      std::uint64_t s1 = 0;
+      std::uint64_t s2 = 0;
+      for (std::uint64_t v = 0; v < 256; ++v) {
+        s1 += v * hist[ch][v];
+        s2 += v * v * hist[ch][v];
+      }
+      const double mean = static_cast<double>(s1) / count;
+      result.mean[ch] = mean;
+      result.stddev[ch] = std::sqrt(std::max(0.0, static_cast<double>(s2) / count - mean * mean));
+    }
+  } else {
+    // Welford's update, numerically stable in one pass
+    std::array<double, C> m2{};
+    result.mean.fill(0.0);
+    double n = 0.0;
+    for (int r = 0; r < src.rows(); ++r) {
+      const T* row = src.row(r);
+      for (int c = 0; c < src.cols(); ++c) {
+        n += 1.0;
+        for (int ch = 0; ch < C; ++ch) {
+          const double v = static_cast<double>(row[c * C + ch]);
+          const double delta = v - result.mean[ch];
+          result.mean[ch] += delta / n;
+          m2[ch] += delta * (v - result.mean[ch]);
+        }
+      }
+    }
+    for (int ch = 0; ch < C; ++ch) result.stddev[ch] = std::sqrt(m2[ch] / n);
+  }
+  return result;
+}
+
+}  // namespace core
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Mat.h"
+#include "MatFilter.h"
+
+namespace core {
+
+class ThreadPool;
+
+enum class Interpolation {
+  Nearest,  // closest pixel
+  Linear,   // bilinear over 2x2 pixels
+  Cubic,    // bicubic over 4x4 pixels (Keys, a = -0.75)
+  Area,     // average over the covered source area when shrinking, bilinear when enlarging.
+            // Resize only.
+};
+
+// Remap coordinates converted once to fixed point: for every destination pixel, the top-left
+// pixel of the source neighbourhood it samples and the sub-pixel offset, quantized to
+// 1 / kSubpixels, that selects its precomputed interpolation weights. Building a table costs
+// about as much as one Remap, reusing it for every frame saves that work.
+class RemapTable {
+ public:
+  static constexpr int kSubpixels = 32;
+
+  // map_x and map_y hold the source coordinates of each destination pixel (pixel centers at
+  // integer coordinates) and must have the same size. NaN coordinates are treated as lying far
+  // outside the image.
+  // Throws std::invalid_argument on mismatched maps or Interpolation::Area.
+  RemapTable(const MatView<float, 1>& map_x, const MatView<float, 1>& map_y,
+             Interpolation interpolation = Interpolation::Linear);
+
+  int rows() const { return origin_.rows(); }
+  int cols() const { return origin_.cols(); }
+  Interpolation interpolation() const { return interpolation_; }
+  // (x, y) of the top-left sampled pixel.
+  const Mat<int32_t, 2>& origin() const { return origin_; }
+  // fy * kSubpixels + fx.
+  const Mat<uint16_t, 1>& fraction() const { return fraction_; }
+
+ private:
+  Mat<int32_t, 2> origin_;
+  Mat<uint16_t, 1> fraction_;
+  Interpolation interpolation_;
+};
+
+namespace detail {
+
+struct ResampleImage {
+  const void* src;
+  std::size_t src_step;
+  int src_rows;
+  int src_cols;
+  void* dst;
+  std::size_t dst_step;
+  int dst_rows;
+  int dst_cols;
+  int channels;
+  bool is_float;
+};
+
+template <typename T, int C>
+ResampleImage MakeResampleImage(const MatView<T, C>& src, MatView<T, C>& dst) {
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, std::uint8_t>,
+                "Resampling supports float and uint8_t images");
+  static_assert(C >= 1 && C <= 4, "Resampling supports 1 to 4 channels");
+  if (src.data() == dst.data() && src.rows() > 0 && src.cols() > 0) {
+    throw std::invalid_argument("Resample: dst must not alias src");
+  }
+  return {src.data(), src.step(), src.rows(), src.cols(), dst.data(), dst.step(),
+          dst.rows(), dst.cols(), C,          std::is_same_v<T, float>};
+}
+
+void Resize(const ResampleImage& image, Interpolation interpolation, ThreadPool* pool);
+void WarpAffine(const ResampleImage& image, const std::array<double, 6>& m,
+                Interpolation interpolation, BorderMode border, float border_value,
+                ThreadPool* pool);
+void WarpPerspective(const ResampleImage& image, const std::array<double, 9>& m,
+                     Interpolation interpolation, BorderMode border, float border_value,
+                     ThreadPool* pool);
+void Remap(const ResampleImage& image, const RemapTable& table, BorderMode border,
+           float border_value, ThreadPool* pool);
+
+}  // namespace detail
+
+// CPU resampling of float and uint8_t images of 1 to 4 channels. Pixel centers sit at integer
+// coordinates. Rows are processed in bands, on pool when given, with the same result either way.
+// uint8_t images are interpolated in fixed point (14-bit weights, rounded and saturated), except
+// by Resize which goes through float like MatFilter. The border value is given in the units of
+// the image (0-255 for uint8_t). dst must not alias src.
+
+// Scales src to the size of dst. Border pixels are clamped.
+template <typename T, int C>
+void Resize(const MatView<T, C>& src, MatView<T, C> dst,
+            Interpolation interpolation = Interpolation::Linear, ThreadPool* pool = nullptr) {
+  detail::Resize(detail::MakeResampleImage(src, dst), interpolation, pool);
+}
+
+// m maps destination pixels to source positions: dst(x, y) samples src at
+// (m[0] x + m[1] y + m[2], m[3] x + m[4] y + m[5]). To apply a forward transform, pass
+// InvertAffine() of it.
+template <typename T, int C>
+void WarpAffine(const MatView<T, C>& src, MatView<T, C> dst, const std::array<double, 6>& m,
+                Interpolation interpolation = Interpolation::Linear,
+                BorderMode border = BorderMode::Constant, float border_value = 0.0f,
+                ThreadPool* pool = nullptr) {
+  detail::WarpAffine(detail::MakeResampleImage(src, dst), m, interpolation, border, border_value,
+                     pool);
+}
+
+// Row-major 3x3 homography from destination pixels to source positions. Destination pixels whose
+// source position is at infinity or behind the projection center (w <= 0) are treated as lying
+// far outside the image.
+template <typename T, int C>
+void WarpPerspective(const MatView<T, C>& src, MatView<T, C> dst, const std::array<double, 9>& m,
+                     Interpolation interpolation = Interpolation::Linear,
+                     BorderMode border = BorderMode::Constant, float border_value = 0.0f,
+                     ThreadPool* pool = nullptr) {
+  detail::WarpPerspective(detail::MakeResampleImage(src, dst), m, interpolation, border,
+                          border_value, pool);
+}
+
+// dst(x, y) samples src at the position stored in table, which must have the size of dst.
+template <typename T, int C>
+void Remap(const MatView<T, C>& src, MatView<T, C> dst, const RemapTable& table,
+           BorderMode border = BorderMode::Constant, float border_value = 0.0f,
+           ThreadPool* pool = nullptr) {
+  detail::Remap(detail::MakeResampleImage(src, dst), table, border, border_value, pool);
+}
+
+// One-off remap; prefer building a RemapTable once when the maps are reused.
+template <typename T, int C>
+void Remap(const MatView<T, C>& src, MatView<T, C> dst, const MatView<float, 1>& map_x,
+           const MatView<float, 1>& map_y, Interpolation interpolation = Interpolation::Linear,
+           BorderMode border = BorderMode::Constant, float border_value = 0.0f,
+           ThreadPool* pool = nullptr) {
+  Remap(src, dst, RemapTable(map_x, map_y, interpolation), border, border_value, pool);
+}
+
+// Inverse of the affine transform m (same layout as WarpAffine). Throws std::invalid_argument
+// when m is singular.
+std::array<double, 6> InvertAffine(const std::array<double, 6>& m);
+
+}  // namespace core
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Mat.h"
+
+namespace core {
+
+// Non-owning view over a planar (structure of arrays) image: channel ch of every pixel lives in
+// plane ch, itself a single-channel image with row pitch step(). Planes are plane_step() bytes
+// apart. The accessors mirror MatView, with operator()(r, c, ch) addressing into the planes.
+template <typename T, int C>
+class PlanarView {
+ public:
+  PlanarView() = default;
+  // step 0 means tightly packed rows, plane_step 0 means planes directly follow each other.
+  PlanarView(T* data, int rows, int cols, std::size_t step = 0, std::size_t plane_step = 0)
+      : data_(data),
+        rows_(rows),
+        cols_(cols),
+        step_(step ? step : static_cast<std::size_t>(cols) * sizeof(T)),
+        plane_step_(plane_step ? plane_step : rows * step_) {
+    assert(step_ >= static_cast<std::size_t>(cols) * sizeof(T));
+    assert(step_ % sizeof(T) == 0 && plane_step_ % sizeof(T) == 0);
+  }
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+  int channels() const { return C; }
+  int total() const { return rows_ * cols_ * C; }
+  // Row pitch of every plane, in bytes.
+  std::size_t step() const { return step_; }
+  // Distance between the starts of two planes, in bytes.
+  std::size_t plane_step() const { return plane_step_; }
+  // True when every plane is free of row padding.
+  bool isContinuous() const {
+    return rows_ <= 1 || step_ == static_cast<std::size_t>(cols_) * sizeof(T);
+  }
+
+  // Single-channel view of channel ch, sharing memory.
+  MatView<T, 1> plane(int ch) const {
+    assert(ch >= 0 && ch < C);
+    return MatView<T, 1>(
+        reinterpret_cast<T*>(reinterpret_cast<std::uint8_t*>(data_) + ch * plane_step_), rows_,
+        cols_, step_);
+  }
+
+  T* row(int ch, int r) {
+    assert(ch >= 0 && ch < C && r >= 0 && r < rows_);
+    return reinterpret_cast<T*>(reinterpret_cast<std::uint8_t*>(data_) + ch * plane_step_ +
+                                r * step_);
+  }
+
+  const T* row(int ch, int r) const {
+    assert(ch >= 0 && ch < C && r >= 0 && r < rows_);
+    return reinterpret_cast<const T*>(reinterpret_cast<const std::uint8_t*>(data_) +
+                                      ch * plane_step_ + r * step_);
+  }
+
+  T* operator()(int row, int col, int ch) {
+    assert(col >= 0 && col < cols_);
+    return this->row(ch, row) + col;
+  }
+
+  const T* operator()(int row, int col, int ch) const {
+    assert(col >= 0 && col < cols_);
+    return this->row(ch, row) + col;
+  }
+
+  // Zero-copy region of interest of all planes.
+  PlanarView Roi(int x, int y, int w, int h) const {
+    assert(x >= 0 && y >= 0 && w >= 0 && h >= 0 && x + w <= cols_ && y + h <= rows_);
+    T* origin = reinterpret_cast<T*>(reinterpret_cast<std::uint8_t*>(data_) + y * step_) + x;
+    return PlanarView(origin, h, w, step_, plane_step_);
+  }
+
+  void Fill(const T value) {
+    for (int ch = 0; ch < C; ++ch) plane(ch).Fill(value);
+  }
+
+ protected:
+  T* data_ = nullptr;
+  int rows_ = 0;
+  int cols_ = 0;
+  std::size_t step_ = 0;
+  std::size_t plane_step_ = 0;
+};
+
+// Owning planar image. The C planes are stacked in one buffer obtained like the one of Mat (same
+// row alignment, allocators and kMatUninitialized option), each row starting row-aligned.
+template <typename T, int C>
+class PlanarMat : public PlanarView<T, C> {
+ public:
+  PlanarMat(int rows, int cols, std::size_t row_align = kMatRowAlign,
+            MatAllocator* allocator = nullptr)
+      : storage_(rows * C, cols, row_align, allocator) {
+    Attach();
+  }
+
+  PlanarMat(int rows, int cols, MatUninitializedTag, std::size_t row_align = kMatRowAlign,
+            MatAllocator* allocator = nullptr)
+      : storage_(rows * C, cols, kMatUninitialized, row_align, allocator) {
+    Attach();
+  }
+
+  PlanarMat(const PlanarMat& other) : PlanarView<T, C>(other), storage_(other.storage_) {
+    Attach();
+  }
+
+  PlanarMat(PlanarMat&& other) noexcept
+      : PlanarView<T, C>(other), storage_(std::move(other.storage_)) {
+    Attach();
+    other.Attach();
+  }
+
+  PlanarMat& operator=(const PlanarMat& other) {
+    if (this == &other) return *this;
+    PlanarView<T, C>::operator=(other);
+    storage_ = other.storage_;
+    Attach();
+    return *this;
+  }
+
+  PlanarMat& operator=(PlanarMat&& other) noexcept {
+    if (this == &other) return *this;
+    PlanarView<T, C>::operator=(other);
+    storage_ = std::move(other.storage_);
+    Attach();
+    other.Attach();
+    return *this;
+  }
+
+  [[nodiscard]] PlanarMat clone() const { return PlanarMat(*this); }
+
+  MatAllocator* allocator() const { return storage_.allocator(); }
+
+ private:
+  // Points the view at storage_, whose rows are the rows of plane 0, then plane 1, ...
+  void Attach() {
+    this->data_ = storage_.data();
+    this->rows_ = storage_.rows() / C;
+    this->cols_ = storage_.cols();
+    this->step_ = storage_.step();
+    this->plane_step_ = this->rows_ * this->step_;
+  }
+
+  Mat<T, 1> storage_;
+};
+
+namespace detail {
+
+// SIMD conversions for the common layouts (RGBA8 and RGB f32) on n pixels.
+void Deinterleave4(const uint8_t* src, uint8_t* const* planes, std::size_t n);
+void Interleave4(const uint8_t* const* planes, uint8_t* dst, std::size_t n);
+void Deinterleave3(const float* src, float* const* planes, std::size_t n);
+void Interleave3(const float* const* planes, float* dst, std::size_t n);
+
+template <typename T, int C>
+void Deinterleave(const T* src, T* const* planes, std::size_t n) {
+  if constexpr (std::is_same_v<T, uint8_t> && C == 4) {
+    Deinterleave4(src, planes, n);
+  } else if constexpr (std::is_same_v<T, float> && C == 3) {
+    Deinterleave3(src, planes, n);
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      for (int ch = 0; ch < C; ++ch) planes[ch][i] = src[i * C + ch];
+    }
+  }
+}
+
+template <typename T, int C>
+void Interleave(const T* const* planes, T* dst, std::size_t n) {
+  if constexpr (std::is_same_v<T, uint8_t> && C == 4) {
+    Interleave4(planes, dst, n);
+  } else if constexpr (std::is_same_v<T, float> && C == 3) {
+    Interleave3(planes, dst, n);
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      for (int ch = 0; ch < C; ++ch) dst[i * C + ch] = planes[ch][i];
+    }
+  }
+}
+
+template <typename T, int C>
+void CheckPlanarSize(const MatView<T, C>& interleaved, const PlanarView<T, C>& planar) {
+  if (interleaved.rows() != planar.rows() || interleaved.cols() != planar.cols()) {
+    throw std::invalid_argument("Interleave/Deinterleave: sizes differ");
+  }
+}
+
+}  // namespace detail
+
+// Splits an interleaved image into planes. uint8_t x 4 and float x 3 use SIMD kernels.
+template <typename T, int C>
+void Deinterleave(const MatView<T, C>& src, PlanarView<T, C> dst) {
+  detail::CheckPlanarSize(src, dst);
+  if (src.rows() == 0 || src.cols() == 0) return;
+  T* planes[C];
+  if (src.isContinuous() && dst.isContinuous()) {
+    for (int ch = 0; ch < C; ++ch) planes[ch] = dst.row(ch, 0);
+    detail::Deinterleave<T, C>(src.data(), planes,
+                               static_cast<std::size_t>(src.rows()) * src.cols());
+    return;
+  }
+  for (int r = 0; r < src.rows(); ++r) {
+    for (int ch = 0; ch < C; ++ch) planes[ch] = dst.row(ch, r);
+    detail::Deinterleave<T, C>(src.row(r), planes, src.cols());
+  }
+}
+
+// Merges planes into an interleaved image. uint8_t x 4 and float x 3 use SIMD kernels.
+template <typename T, int C>
+void Interleave(const PlanarView<T, C>& src, MatView<T, C> dst) {
+  detail::CheckPlanarSize(dst, src);
+  if (dst.rows() == 0 || dst.cols() == 0) return;
+  const T* planes[C];
+  if (src.isContinuous() && dst.isContinuous()) {
+    for (int ch = 0; ch < C; ++ch) planes[ch] = src.row(ch, 0);
+    detail::Interleave<T, C>(planes, dst.data(),
+                             static_cast<std::size_t>(dst.rows()) * dst.cols());
+    return;
+  }
+  for (int r = 0; r < dst.rows(); ++r) {
+    for (int ch = 0; ch < C; ++ch) planes[ch] = src.row(ch, r);
+    detail::Interleave<T, C>(planes, dst.row(r), dst.cols());
+  }
+}
+
+}  // namespace core
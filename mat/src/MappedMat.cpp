@@ -0,0 +1,185 @@
+#include "MappedMat.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace core {
+namespace {
+
+constexpr char kMagic[4] = {'C', 'M', 'A', 'T'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kDataOffset = 4096;
+
+static_assert(sizeof(MappedMatHeader) <= kDataOffset);
+
+[[noreturn]] void ThrowErrno(const std::string& what, const std::string& path) {
+  throw std::runtime_error("MappedMat: " + what + " " + path + ": " + std::strerror(errno));
+}
+
+std::size_t DepthSize(const MatDepth depth) {
+  switch (depth) {
+    case MatDepth::U8:
+    case MatDepth::S8:
+      return 1;
+    case MatDepth::U16:
+    case MatDepth::S16:
+      return 2;
+    case MatDepth::S32:
+    case MatDepth::F32:
+      return 4;
+    case MatDepth::F64:
+      return 8;
+  }
+  return 0;
+}
+
+// Closes the descriptor once the mapping is established (or failed).
+struct FileDescriptor {
+  int fd;
+  ~FileDescriptor() {
+    if (fd >= 0) close(fd);
+  }
+};
+
+}  // namespace
+
+const char* MatDepthName(const MatDepth depth) {
+  switch (depth) {
+    case MatDepth::U8:
+      return "u8";
+    case MatDepth::S8:
+      return "s8";
+    case MatDepth::U16:
+      return "u16";
+    case MatDepth::S16:
+      return "s16";
+    case MatDepth::S32:
+      return "s32";
+    case MatDepth::F32:
+      return "f32";
+    case MatDepth::F64:
+      return "f64";
+  }
+  return "unknown";
+}
+
+namespace detail {
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : base_(std::exchange(other.base_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      mode_(other.mode_) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this == &other) return *this;
+  if (base_ != nullptr) munmap(base_, size_);
+  base_ = std::exchange(other.base_, nullptr);
+  size_ = std::exchange(other.size_, 0);
+  mode_ = other.mode_;
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (base_ != nullptr) munmap(base_, size_);
+}
+
+MappedFile MappedFile::Create(const std::string& path, int rows, int cols, int channels,
+                              MatDepth depth, std::size_t step) {
+  if (rows < 0 || cols < 0) {
+    throw std::invalid_argument("MappedMat: negative size");
+  }
+  FileDescriptor file{open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+  if (file.fd < 0) ThrowErrno("cannot create", path);
+  const std::size_t size = kDataOffset + static_cast<std::size_t>(rows) * step;
+  // ftruncate extends the file with zeros without writing them (sparse where supported)
+  if (ftruncate(file.fd, static_cast<off_t>(size)) != 0) ThrowErrno("cannot resize", path);
+
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+  if (base == MAP_FAILED) ThrowErrno("cannot map", path);
+
+  MappedFile mapped;
+  mapped.base_ = static_cast<std::uint8_t*>(base);
+  mapped.size_ = size;
+  mapped.mode_ = MapMode::ReadWrite;
+
+  MappedMatHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.rows = rows;
+  header.cols = cols;
+  header.channels = channels;
+  header.depth = depth;
+  header.step = step;
+  header.data_offset = kDataOffset;
+  std::memcpy(mapped.base_, &header, sizeof(header));
+  return mapped;
+}
+
+MappedFile MappedFile::Open(const std::string& path, MapMode mode) {
+  const int access = mode == MapMode::ReadWrite ? O_RDWR : O_RDONLY;
+  FileDescriptor file{open(path.c_str(), access | O_CLOEXEC)};
+  if (file.fd < 0) ThrowErrno("cannot open", path);
+  struct stat st;
+  if (fstat(file.fd, &st) != 0) ThrowErrno("cannot stat", path);
+  const std::size_t size = static_cast<std::size_t>(st.st_size);
+  if (size < sizeof(MappedMatHeader)) {
+    throw std::runtime_error("MappedMat: " + path + " is too small");
+  }
+
+  const int prot = mode == MapMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+  const int flags = mode == MapMode::CopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+  void* base = mmap(nullptr, size, prot, flags, file.fd, 0);
+  if (base == MAP_FAILED) ThrowErrno("cannot map", path);
+
+  MappedFile mapped;
+  mapped.base_ = static_cast<std::uint8_t*>(base);
+  mapped.size_ = size;
+  mapped.mode_ = mode;
+
+  const MappedMatHeader& header = mapped.header();
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+    throw std::runtime_error("MappedMat: " + path + " is not a MappedMat file");
+  }
+  const std::size_t depth_size = DepthSize(header.depth);
+  bool valid = header.rows >= 0 && header.cols >= 0 && header.channels > 0 && depth_size != 0 &&
+               header.data_offset >= sizeof(MappedMatHeader) && header.data_offset % 64 == 0 &&
+               header.data_offset <= size;
+  if (valid) {
+    // Compared by division: a corrupt step or size must not wrap around past the mapping
+    const std::uint64_t elements = static_cast<std::uint64_t>(header.cols) *
+                                   static_cast<std::uint64_t>(header.channels);
+    const std::uint64_t rows = static_cast<std::uint64_t>(header.rows);
+    valid = elements <= UINT64_MAX / depth_size && header.step >= elements * depth_size &&
+            (rows == 0 || header.step <= (size - header.data_offset) / rows);
+  }
+  if (!valid) {
+    throw std::runtime_error("MappedMat: " + path + " has a corrupt header");
+  }
+  return mapped;
+}
+
+void MappedFile::Prefetch(std::size_t offset, std::size_t length) const {
+  if (base_ == nullptr || length == 0) return;
+  static const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+  const auto begin = reinterpret_cast<std::uintptr_t>(data() + offset) / page * page;
+  const auto end = reinterpret_cast<std::uintptr_t>(data() + offset + length);
+  // Only a hint, failures are harmless
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
+void MappedFile::Sync() const {
+  if (base_ == nullptr || mode_ != MapMode::ReadWrite) return;
+  if (msync(base_, size_, MS_SYNC) != 0) {
+    throw std::runtime_error(std::string("MappedMat: msync failed: ") + std::strerror(errno));
+  }
+}
+
+}  // namespace detail
+}  // namespace core
@@ -0,0 +1,274 @@
+#include "MatAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "Mat.h"
+
+namespace core {
+namespace {
+
+std::atomic<std::uint64_t> g_allocations{0};
+std::atomic<std::uint64_t> g_deallocations{0};
+std::atomic<std::uint64_t> g_bytes_allocated{0};
+std::atomic<std::uint64_t> g_bytes_in_use{0};
+
+thread_local MatAllocator* t_default_allocator = nullptr;
+
+void CountAllocation(const std::size_t bytes) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+  g_bytes_in_use.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void CountDeallocation(const std::size_t bytes) {
+  g_deallocations.fetch_add(1, std::memory_order_relaxed);
+  g_bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void* HeapAllocate(const std::size_t bytes) {
+  void* p = ::operator new(bytes, std::align_val_t(kMatBufferAlign));
+  CountAllocation(bytes);
+  return p;
+}
+
+void HeapFree(void* p, const std::size_t bytes) noexcept {
+  ::operator delete(p, std::align_val_t(kMatBufferAlign));
+  CountDeallocation(bytes);
+}
+
+MatAllocator* OrHeap(MatAllocator* allocator) {
+  return allocator != nullptr ? allocator : HeapMatAllocator::Instance();
+}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+constexpr bool kHasHugePages = true;
+
+void* MapHugePages(const std::size_t bytes) {
+  constexpr std::size_t kPage = HugePageMatAllocator::kHugePageSize;
+  const std::size_t size = AlignUp(bytes, kPage);
+  // Over-reserve by one huge page so that the mapping can be trimmed to a 2 MiB boundary
+  const std::size_t reserve = size + kPage;
+  void* p = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) throw std::bad_alloc();
+  const auto begin = reinterpret_cast<std::uintptr_t>(p);
+  const std::uintptr_t aligned = AlignUp(begin, kPage);
+  if (aligned != begin) munmap(p, aligned - begin);
+  const std::size_t tail = begin + reserve - (aligned + size);
+  if (tail != 0) munmap(reinterpret_cast<void*>(aligned + size), tail);
+  // Only a hint: with THP disabled the mapping simply keeps 4 KiB pages
+  madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+  CountAllocation(size);
+  return reinterpret_cast<void*>(aligned);
+}
+
+void UnmapHugePages(void* p, const std::size_t bytes) noexcept {
+  const std::size_t size = AlignUp(bytes, HugePageMatAllocator::kHugePageSize);
+  munmap(p, size);
+  CountDeallocation(size);
+}
+#else
+constexpr bool kHasHugePages = false;
+
+void* MapHugePages(const std::size_t bytes) { return HeapAllocate(bytes); }
+
+void UnmapHugePages(void* p, const std::size_t bytes) noexcept { HeapFree(p, bytes); }
+#endif
+
+constexpr std::size_t kMinSizeClass = 4096;
+
+}  // namespace
+
+MatHeapStats GetMatHeapStats() {
+  MatHeapStats stats;
+  stats.allocations = g_allocations.load(std::memory_order_relaxed);
+  stats.deallocations = g_deallocations.load(std::memory_order_relaxed);
+  stats.bytes_allocated = g_bytes_allocated.load(std::memory_order_relaxed);
+  stats.bytes_in_use = g_bytes_in_use.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void* HeapMatAllocator::Allocate(std::size_t bytes) { return HeapAllocate(bytes); }
+
+void HeapMatAllocator::Deallocate(void* p, std::size_t bytes) noexcept { HeapFree(p, bytes); }
+
+HeapMatAllocator* HeapMatAllocator::Instance() {
+  static HeapMatAllocator instance;
+  return &instance;
+}
+
+// HugePageMatAllocator
+
+HugePageMatAllocator::HugePageMatAllocator(std::size_t min_bytes) : min_bytes_(min_bytes) {}
+
+void* HugePageMatAllocator::Allocate(std::size_t bytes) {
+  if (!kHasHugePages || bytes < min_bytes_) return HeapAllocate(bytes);
+  return MapHugePages(bytes);
+}
+
+void HugePageMatAllocator::Deallocate(void* p, std::size_t bytes) noexcept {
+  if (!kHasHugePages || bytes < min_bytes_) {
+    HeapFree(p, bytes);
+  } else {
+    UnmapHugePages(p, bytes);
+  }
+}
+
+HugePageMatAllocator* HugePageMatAllocator::Instance() {
+  static HugePageMatAllocator instance;
+  return &instance;
+}
+
+// MatBufferPool
+
+MatBufferPool::MatBufferPool(std::size_t max_cached_bytes, MatAllocator* upstream)
+    : max_cached_bytes_(max_cached_bytes), upstream_(OrHeap(upstream)) {}
+
+MatBufferPool::~MatBufferPool() {
+  assert(stats_.outstanding == 0 && "MatBufferPool destroyed while Mats still use it");
+  Trim();
+}
+
+std::size_t MatBufferPool::SizeClass(const std::size_t bytes) {
+  if (bytes <= kMinSizeClass) return kMinSizeClass;
+  // Four classes per power of two: round up to a quarter of the enclosing power of two
+  std::size_t octave = kMinSizeClass;
+  while (octave * 2 < bytes) octave *= 2;
+  return AlignUp(bytes, octave / 4);
+}
+
+void* MatBufferPool::Allocate(std::size_t bytes) {
+  const std::size_t size = SizeClass(bytes);
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    auto it = free_.find(size);
+    if (it != free_.end() && !it->second.empty()) {
+      void* p = it->second.back();
+      it->second.pop_back();
+      stats_.cached_bytes -= size;
+      ++stats_.hits;
+      ++stats_.outstanding;
+      return p;
+    }
+    ++stats_.misses;
+    ++stats_.outstanding;
+  }
+  try {
+    return upstream_->Allocate(size);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(m_);
+    --stats_.outstanding;
+    throw;
+  }
+}
+
+void MatBufferPool::Deallocate(void* p, std::size_t bytes) noexcept {
+  const std::size_t size = SizeClass(bytes);
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    --stats_.outstanding;
+    if (stats_.cached_bytes + size <= max_cached_bytes_) {
+      try {
+        free_[size].push_back(p);
+        stats_.cached_bytes += size;
+        return;
+      } catch (const std::bad_alloc&) {
+        // Could not grow the free list, hand the buffer back instead
+      }
+    }
+  }
+  upstream_->Deallocate(p, size);
+}
+
+void MatBufferPool::Trim() {
+  std::map<std::size_t, std::vector<void*>> released;
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    released.swap(free_);
+    stats_.cached_bytes = 0;
+  }
+  for (auto& [size, blocks] : released) {
+    for (void* p : blocks) upstream_->Deallocate(p, size);
+  }
+}
+
+MatBufferPool::Stats MatBufferPool::stats() const {
+  std::lock_guard<std::mutex> lock(m_);
+  return stats_;
+}
+
+// MatArena
+
+MatArena::MatArena(std::size_t chunk_bytes, MatAllocator* upstream)
+    : chunk_bytes_(AlignUp(chunk_bytes, kMatBufferAlign)), upstream_(OrHeap(upstream)) {
+  if (chunk_bytes == 0) {
+    throw std::invalid_argument("MatArena: chunk_bytes must be > 0");
+  }
+}
+
+MatArena::~MatArena() {
+  assert(stats_.live == 0 && "MatArena destroyed while Mats still use it");
+  for (const Chunk& chunk : chunks_) upstream_->Deallocate(chunk.data, chunk.size);
+}
+
+void* MatArena::Allocate(std::size_t bytes) {
+  const std::size_t size = AlignUp(std::max<std::size_t>(bytes, 1), kMatBufferAlign);
+  std::lock_guard<std::mutex> lock(m_);
+  // Move on to the next retained chunk that fits, allocating a new one at the end if none does
+  while (current_ < chunks_.size() && offset_ + size > chunks_[current_].size) {
+    stats_.used += chunks_[current_].size - offset_;  // the tail of a chunk is lost until Reset
+    ++current_;
+    offset_ = 0;
+  }
+  if (current_ == chunks_.size()) {
+    const std::size_t chunk_size = std::max(chunk_bytes_, size);
+    chunks_.reserve(chunks_.size() + 1);  // push_back cannot throw and leak the chunk
+    chunks_.push_back({static_cast<std::uint8_t*>(upstream_->Allocate(chunk_size)), chunk_size});
+    ++stats_.chunks;
+    stats_.capacity += chunk_size;
+  }
+  void* p = chunks_[current_].data + offset_;
+  offset_ += size;
+  stats_.used += size;
+  stats_.peak = std::max(stats_.peak, stats_.used);
+  ++stats_.live;
+  return p;
+}
+
+void MatArena::Deallocate(void*, std::size_t) noexcept {
+  std::lock_guard<std::mutex> lock(m_);
+  assert(stats_.live > 0);
+  --stats_.live;
+}
+
+void MatArena::Reset() {
+  std::lock_guard<std::mutex> lock(m_);
+  if (stats_.live != 0) {
+    throw std::runtime_error("MatArena::Reset: " + std::to_string(stats_.live) +
+                             " allocations are still alive");
+  }
+  current_ = 0;
+  offset_ = 0;
+  stats_.used = 0;
+}
+
+MatArena::Stats MatArena::stats() const {
+  std::lock_guard<std::mutex> lock(m_);
+  return stats_;
+}
+
+MatAllocator* GetDefaultMatAllocator() {
+  return t_default_allocator != nullptr ? t_default_allocator : HeapMatAllocator::Instance();
+}
+
+void SetDefaultMatAllocator(MatAllocator* allocator) { t_default_allocator = allocator; }
+
+}  // namespace core
@@ -0,0 +1,222 @@
+#include "MatFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "MatKernels.h"
+#include "ThreadPool.h"
+
+namespace core {
+namespace {
+
+// Target working set of one tile (ring buffer + padded row), sized to stay in L2.
+constexpr std::size_t kTileBytes = 256 * 1024;
+constexpr int kMinTileCols = 64;
+constexpr int kMinBandRows = 16;
+
+struct Tile {
+  int y0;
+  int y1;
+  int x0;
+  int x1;
+};
+
+// Everything a tile needs, shared read-only between the workers.
+struct FilterJob {
+  detail::FilterImage image;
+  BorderMode border;
+  float border_value;
+  // Separable: kernel_x (1 x kx) and kernel_y (ky x 1). Non-separable: kernel_x is the full
+  // ky x kx kernel and kernel_y is empty.
+  const float* kernel_x;
+  const float* kernel_y;
+  int kx;
+  int ky;
+  bool separable;
+};
+
+// Writes source columns [x0 - rx, x1 + rx) of source row sy into out, synthesizing the pixels
+// that fall outside the image.
+void LoadPaddedRow(const FilterJob& job, int sy, const int x0, const int x1, const int rx,
+                   float* out) {
+  const detail::FilterImage& image = job.image;
+  const int c = image.channels;
+  const int width = x1 - x0 + 2 * rx;
+  if (sy < 0 || sy >= image.rows) {
+    if (job.border == BorderMode::Constant) {
+      std::fill_n(out, static_cast<std::size_t>(width) * c, job.border_value);
+      return;
+    }
+    sy = detail::BorderIndex(sy, image.rows, job.border);
+  }
+  const float* row = reinterpret_cast<const float*>(
+      reinterpret_cast<const uint8_t*>(image.src) + static_cast<std::size_t>(sy) * image.src_step);
+
+  const int begin = std::max(x0 - rx, 0);
+  const int end = std::min(x1 + rx, image.cols);
+  std::memcpy(out + (begin - (x0 - rx)) * c, row + begin * c,
+              static_cast<std::size_t>(end - begin) * c * sizeof(float));
+
+  auto put_border = [&](const int px) {
+    float* d = out + (px - (x0 - rx)) * c;
+    if (job.border == BorderMode::Constant) {
+      std::fill_n(d, c, job.border_value);
+    } else {
+      const int sx = detail::BorderIndex(px, image.cols, job.border);
+      std::memcpy(d, row + sx * c, c * sizeof(float));
+    }
+  };
+  for (int px = x0 - rx; px < begin; ++px) put_border(px);
+  for (int px = end; px < x1 + rx; ++px) put_border(px);
+}
+
+// Runs one tile with a sliding ring of ky rows: every source row is loaded (and, when separable,
+// filtered horizontally) exactly once, then each output row combines the ky rows of its window.
+void RunTile(const FilterJob& job, const Tile& tile) {
+  const detail::MatKernels& kernels = detail::GetMatKernels();
+  const int c = job.image.channels;
+  const int rx = job.kx / 2;
+  const int ry = job.ky / 2;
+  const std::size_t n = static_cast<std::size_t>(tile.x1 - tile.x0) * c;
+  const std::size_t padded = n + static_cast<std::size_t>(2 * rx) * c;
+  // Separable ring rows hold horizontally filtered rows (n floats), non-separable ones hold
+  // padded source rows.
+  const std::size_t ring_row = job.separable ? n : padded;
+
+  thread_local std::vector<float> scratch;
+  thread_local std::vector<const float*> window;
+  scratch.resize(ring_row * job.ky + (job.separable ? padded : 0));
+  window.resize(job.ky);
+  float* ring = scratch.data();
+  float* line = ring + ring_row * job.ky;
+
+  const int first = tile.y0 - ry;
+  for (int s = first; s < tile.y1 + ry; ++s) {
+    const int t = s - first;
+    float* slot = ring + (t % job.ky) * ring_row;
+    if (job.separable) {
+      LoadPaddedRow(job, s, tile.x0, tile.x1, rx, line);
+      const float* src = line;
+      kernels.filter_f32(&src, 1, job.kernel_x, job.kx, c, slot, n);
+    } else {
+      LoadPaddedRow(job, s, tile.x0, tile.x1, rx, slot);
+    }
+    if (t < 2 * ry) continue;
+
+    // Output row y = s - ry uses source rows s - 2 * ry .. s
+    for (int j = 0; j < job.ky; ++j) window[j] = ring + ((t - 2 * ry + j) % job.ky) * ring_row;
+    const int y = s - ry;
+    float* dst = reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(job.image.dst) +
+                                          static_cast<std::size_t>(y) * job.image.dst_step) +
+                 tile.x0 * c;
+    if (job.separable) {
+      kernels.filter_f32(window.data(), job.ky, job.kernel_y, 1, 0, dst, n);
+    } else {
+      kernels.filter_f32(window.data(), job.ky, job.kernel_x, job.kx, c, dst, n);
+    }
+  }
+}
+
+void Run(const FilterJob& job, ThreadPool* pool) {
+  const detail::FilterImage& image = job.image;
+  if (image.src == image.dst) {
+    throw std::invalid_argument("Filter: dst must not alias src");
+  }
+  if (image.rows <= 0 || image.cols <= 0) return;
+
+  // Column tiles keep the ring buffer of a tile inside kTileBytes
+  const int rx = job.kx / 2;
+  const int ry = job.ky / 2;
+  const std::size_t rows_held = static_cast<std::size_t>(job.ky) + 1;
+  const std::size_t budget = kTileBytes / (sizeof(float) * image.channels * rows_held);
+  int tile_cols = static_cast<int>(std::min<std::size_t>(budget, image.cols));
+  tile_cols = std::max(tile_cols - 2 * rx, std::min(kMinTileCols, image.cols));
+  const int tiles_x = (image.cols + tile_cols - 1) / tile_cols;
+  tile_cols = (image.cols + tiles_x - 1) / tiles_x;
+
+  // Row bands only when running in parallel: every band re-reads 2 * ry halo rows
+  int band_rows = image.rows;
+  if (pool != nullptr && pool->size() > 1) {
+    const int wanted_bands =
+        std::max<int>(1, (4 * static_cast<int>(pool->size()) + tiles_x - 1) / tiles_x);
+    band_rows = std::max((image.rows + wanted_bands - 1) / wanted_bands,
+                         std::max(kMinBandRows, 4 * ry));
+  }
+
+  std::vector<Tile> tiles;
+  for (int y0 = 0; y0 < image.rows; y0 += band_rows) {
+    for (int x0 = 0; x0 < image.cols; x0 += tile_cols) {
+      tiles.push_back(
+          {y0, std::min(y0 + band_rows, image.rows), x0, std::min(x0 + tile_cols, image.cols)});
+    }
+  }
+
+  if (pool == nullptr || tiles.size() == 1) {
+    for (const Tile& tile : tiles) RunTile(job, tile);
+    return;
+  }
+  pool->parallel_for(0, tiles.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) RunTile(job, tiles[i]);
+  });
+}
+
+void CheckKernelSize(const std::size_t size, const char* what) {
+  if (size == 0 || size % 2 == 0) {
+    throw std::invalid_argument(std::string("Filter: ") + what + " size must be odd");
+  }
+}
+
+}  // namespace
+
+namespace detail {
+
+void SepFilter2D(const FilterImage& image, const std::vector<float>& kernel_x,
+                 const std::vector<float>& kernel_y, BorderMode border, float border_value,
+                 ThreadPool* pool) {
+  CheckKernelSize(kernel_x.size(), "kernel_x");
+  CheckKernelSize(kernel_y.size(), "kernel_y");
+  const FilterJob job{image,
+                      border,
+                      border_value,
+                      kernel_x.data(),
+                      kernel_y.data(),
+                      static_cast<int>(kernel_x.size()),
+                      static_cast<int>(kernel_y.size()),
+                      true};
+  Run(job, pool);
+}
+
+void Filter2D(const FilterImage& image, const std::vector<float>& kernel, int kernel_cols,
+              BorderMode border, float border_value, ThreadPool* pool) {
+  if (kernel_cols <= 0 || kernel.size() % kernel_cols != 0) {
+    throw std::invalid_argument("Filter2D: kernel size is not a multiple of kernel_cols");
+  }
+  const int kernel_rows = static_cast<int>(kernel.size()) / kernel_cols;
+  CheckKernelSize(kernel_cols, "kernel width");
+  CheckKernelSize(kernel_rows, "kernel height");
+  const FilterJob job{image,       border,      border_value, kernel.data(), nullptr,
+                      kernel_cols, kernel_rows, false};
+  Run(job, pool);
+}
+
+}  // namespace detail
+
+std::vector<float> GaussianKernel(int radius, float sigma) {
+  if (radius < 0 || sigma <= 0.0f) {
+    throw std::invalid_argument("GaussianKernel: radius must be >= 0 and sigma > 0");
+  }
+  std::vector<float> kernel(2 * radius + 1);
+  double sum = 0.0;
+  for (int i = -radius; i <= radius; ++i) {
+    const double w = std::exp(-(i * i) / (2.0 * sigma * sigma));
+    kernel[i + radius] = static_cast<float>(w);
+    sum += w;
+  }
+  for (float& w : kernel) w = static_cast<float>(w / sum);
+  return kernel;
+}
+
+}  // namespace core
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+namespace detail {
+
+// Table of flat-span kernels used by MatOps. Every entry works on n contiguous elements; row
+// iteration and pitch handling stay in the callers. The scalar table is always complete, the SIMD
+// initializers only override the entries they accelerate.
+struct MatKernels {
+  using BinaryF32 = void (*)(const float* a, const float* b, float* dst, std::size_t n);
+  using BinaryU8 = void (*)(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n);
+
+  BinaryF32 add_f32 = nullptr;
+  BinaryF32 sub_f32 = nullptr;
+  BinaryF32 mul_f32 = nullptr;
+  BinaryF32 min_f32 = nullptr;
+  BinaryF32 max_f32 = nullptr;
+  BinaryF32 absdiff_f32 = nullptr;
+
+  // u8 arithmetic saturates to [0, 255]
+  BinaryU8 add_u8 = nullptr;
+  BinaryU8 sub_u8 = nullptr;
+  BinaryU8 mul_u8 = nullptr;
+  BinaryU8 min_u8 = nullptr;
+  BinaryU8 max_u8 = nullptr;
+  BinaryU8 absdiff_u8 = nullptr;
+
+  // dst = src * scale + offset; conversions to u8 round to nearest even and saturate
+  void (*scale_f32)(const float* src, float* dst, std::size_t n, float scale,
+                    float offset) = nullptr;
+  void (*convert_u8_f32)(const uint8_t* src, float* dst, std::size_t n, float scale,
+                         float offset) = nullptr;
+  void (*convert_f32_u8)(const float* src, uint8_t* dst, std::size_t n, float scale,
+                         float offset) = nullptr;
+
+  // Correlation of kernel_rows source rows with a kernel_rows x kernel_cols kernel:
+  // dst[i] = sum_j sum_k kernel[j * kernel_cols + k] * rows[j][i + k * stride]
+  // Rows are pre-padded by the caller, so no border handling happens here. A 1 x N kernel is the
+  // horizontal pass of a separable filter and an N x 1 kernel the vertical one.
+  void (*filter_f32)(const float* const* rows, int kernel_rows, const float* kernel,
+                     int kernel_cols, int stride, float* dst, std::size_t n) = nullptr;
+
+  // Interleaved <-> planar for n pixels; planes[ch] points at the n values of channel ch.
+  void (*deinterleave_u8x4)(const uint8_t* src, uint8_t* const* planes, std::size_t n) = nullptr;
+  void (*interleave_u8x4)(const uint8_t* const* planes, uint8_t* dst, std::size_t n) = nullptr;
+  void (*deinterleave_f32x3)(const float* src, float* const* planes, std::size_t n) = nullptr;
+  void (*interleave_f32x3)(const float* const* planes, float* dst, std::size_t n) = nullptr;
+
+  // Per-channel reductions over n interleaved elements of 1 to 4 channels (n is a multiple of
+  // channels). Results are accumulated into the outputs, which hold one entry per channel.
+  // sum[ch] += sum(x - shift[ch]) and, unless sqsum is null, sqsum[ch] += sum((x - shift[ch])^2).
+  void (*moments_f32)(const float* src, std::size_t n, int channels, const float* shift,
+                      double* sum, double* sqsum) = nullptr;
+  void (*sum_u8)(const uint8_t* src, std::size_t n, int channels, uint64_t* sum) = nullptr;
+  // NaNs are not supported by the f32 version.
+  void (*minmax_f32)(const float* src, std::size_t n, int channels, float* min,
+                     float* max) = nullptr;
+  void (*minmax_u8)(const uint8_t* src, std::size_t n, int channels, uint8_t* min,
+                    uint8_t* max) = nullptr;
+
+  // Philox4x32-10 blocks [block, block + blocks) of key[0..1], counter (low, high, 0, 0): the four
+  // words of block b go to dst[4 * (b - block)], in order.
+  void (*philox4x32)(const uint32_t* key, uint64_t block, uint32_t* dst,
+                     std::size_t blocks) = nullptr;
+
+  // Bilinear sampling of n RGBA8 pixels: pixel i reads the 2x2 block whose top-left pixel is
+  // (origin[2 * i], origin[2 * i + 1]) in src, entirely inside the image, with the four 14-bit
+  // fixed-point weights table[4 * fraction[i]] (top-left, top-right, bottom-left, bottom-right,
+  // summing to 1 << 14). dst = (sum + (1 << 13)) >> 14.
+  void (*remap_linear_u8x4)(const uint8_t* src, std::size_t step, const int32_t* origin,
+                            const uint16_t* fraction, const int16_t* table, uint8_t* dst,
+                            std::size_t n) = nullptr;
+};
+
+void InitMatKernelsScalar(MatKernels* kernels);
+
+// Return false when the instruction set was not compiled in for this target.
+bool InitMatKernelsSSE4(MatKernels* kernels);
+bool InitMatKernelsAVX2(MatKernels* kernels);
+bool InitMatKernelsNEON(MatKernels* kernels);
+
+// Kernels of the instruction set currently selected by the dispatcher.
+const MatKernels& GetMatKernels();
+
+}  // namespace detail
+}  // namespace core
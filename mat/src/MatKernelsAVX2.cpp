@@ -0,0 +1,580 @@
+#include "MatKernels.h"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#include <climits>
+#include <type_traits>
+
+#include "MatKernelsScalar.h"
+
+namespace core {
+namespace detail {
+namespace {
+
+template <typename VecOp, typename ScalarOp>
+void BinaryF32(const float* a, const float* b, float* dst, std::size_t n, VecOp vec_op,
+               ScalarOp scalar_op) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i, vec_op(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+  }
+  scalar_op(a + i, b + i, dst + i, n - i);
+}
+
+template <typename VecOp, typename ScalarOp>
+void BinaryU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n, VecOp vec_op,
+              ScalarOp scalar_op) {
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), vec_op(va, vb));
+  }
+  scalar_op(a + i, b + i, dst + i, n - i);
+}
+
+void AddF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m256 x, __m256 y) { return _mm256_add_ps(x, y); }, scalar::AddF32);
+}
+
+void SubF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m256 x, __m256 y) { return _mm256_sub_ps(x, y); }, scalar::SubF32);
+}
+
+void MulF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m256 x, __m256 y) { return _mm256_mul_ps(x, y); }, scalar::MulF32);
+}
+
+void MinF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m256 x, __m256 y) { return _mm256_min_ps(x, y); }, scalar::MinF32);
+}
+
+void MaxF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m256 x, __m256 y) { return _mm256_max_ps(x, y); }, scalar::MaxF32);
+}
+
+void AbsDiffF32(const float* a, const float* b, float* dst, std::size_t n) {
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  BinaryF32(
+      a, b, dst, n,
+      [sign](__m256 x, __m256 y) { return _mm256_andnot_ps(sign, _mm256_sub_ps(x, y)); },
+      scalar::AbsDiffF32);
+}
+
+void AddU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](__m256i x, __m256i y) { return _mm256_adds_epu8(x, y); }, scalar::AddU8);
+}
+
+void SubU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](__m256i x, __m256i y) { return _mm256_subs_epu8(x, y); }, scalar::SubU8);
+}
+
+void MulU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max_u8 = _mm256_set1_epi16(255);
+  BinaryU8(
+      a, b, dst, n,
+      [zero, max_u8](__m256i x, __m256i y) {
+        // Unpack and pack both work per 128-bit lane, so the element order is preserved
+        __m256i lo =
+            _mm256_mullo_epi16(_mm256_unpacklo_epi8(x, zero), _mm256_unpacklo_epi8(y, zero));
+        __m256i hi =
+            _mm256_mullo_epi16(_mm256_unpackhi_epi8(x, zero), _mm256_unpackhi_epi8(y, zero));
+        lo = _mm256_min_epu16(lo, max_u8);
+        hi = _mm256_min_epu16(hi, max_u8);
+        return _mm256_packus_epi16(lo, hi);
+      },
+      scalar::MulU8);
+}
+
+void MinU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](__m256i x, __m256i y) { return _mm256_min_epu8(x, y); }, scalar::MinU8);
+}
+
+void MaxU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](__m256i x, __m256i y) { return _mm256_max_epu8(x, y); }, scalar::MaxU8);
+}
+
+void AbsDiffU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n,
+      [](__m256i x, __m256i y) {
+        return _mm256_or_si256(_mm256_subs_epu8(x, y), _mm256_subs_epu8(y, x));
+      },
+      scalar::AbsDiffU8);
+}
+
+void ScaleF32(const float* src, float* dst, std::size_t n, float scale, float offset) {
+  const __m256 vscale = _mm256_set1_ps(scale);
+  const __m256 voffset = _mm256_set1_ps(offset);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 v = _mm256_loadu_ps(src + i);
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(v, vscale), voffset));
+  }
+  scalar::ScaleF32(src + i, dst + i, n - i, scale, offset);
+}
+
+void ConvertU8F32(const uint8_t* src, float* dst, std::size_t n, float scale, float offset) {
+  const __m256 vscale = _mm256_set1_ps(scale);
+  const __m256 voffset = _mm256_set1_ps(offset);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+    const __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(packed));
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(v, vscale), voffset));
+  }
+  scalar::ConvertU8F32(src + i, dst + i, n - i, scale, offset);
+}
+
+void ConvertF32U8(const float* src, uint8_t* dst, std::size_t n, float scale, float offset) {
+  const __m256 vscale = _mm256_set1_ps(scale);
+  const __m256 voffset = _mm256_set1_ps(offset);
+  const __m256 vmin = _mm256_setzero_ps();
+  const __m256 vmax = _mm256_set1_ps(255.0f);
+  auto convert8 = [&](const float* p) {
+    __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(p), vscale), voffset);
+    v = _mm256_min_ps(_mm256_max_ps(v, vmin), vmax);
+    return _mm256_cvtps_epi32(v);
+  };
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i v0 = convert8(src + i);
+    const __m256i v1 = convert8(src + i + 8);
+    // Narrow in 128-bit halves to avoid the lane interleaving of the 256-bit packs
+    const __m128i lo = _mm_packs_epi32(_mm256_castsi256_si128(v0), _mm256_extracti128_si256(v0, 1));
+    const __m128i hi = _mm_packs_epi32(_mm256_castsi256_si128(v1), _mm256_extracti128_si256(v1, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+  }
+  scalar::ConvertF32U8(src + i, dst + i, n - i, scale, offset);
+}
+
+void FilterF32(const float* const* rows, int kernel_rows, const float* kernel, int kernel_cols,
+               int stride, float* dst, std::size_t n) {
+  std::size_t i = 0;
+  // Four independent accumulators per iteration to hide the add latency
+  for (; i + 32 <= n; i += 32) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    for (int j = 0; j < kernel_rows; ++j) {
+      const float* src = rows[j] + i;
+      const float* k = kernel + j * kernel_cols;
+      for (int x = 0; x < kernel_cols; ++x) {
+        const __m256 w = _mm256_set1_ps(k[x]);
+        const float* p = src + x * stride;
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(w, _mm256_loadu_ps(p)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(w, _mm256_loadu_ps(p + 8)));
+        acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(w, _mm256_loadu_ps(p + 16)));
+        acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(w, _mm256_loadu_ps(p + 24)));
+      }
+    }
+    _mm256_storeu_ps(dst + i, acc0);
+    _mm256_storeu_ps(dst + i + 8, acc1);
+    _mm256_storeu_ps(dst + i + 16, acc2);
+    _mm256_storeu_ps(dst + i + 24, acc3);
+  }
+  for (; i + 8 <= n; i += 8) {
+    __m256 acc = _mm256_setzero_ps();
+    for (int j = 0; j < kernel_rows; ++j) {
+      const float* src = rows[j] + i;
+      const float* k = kernel + j * kernel_cols;
+      for (int x = 0; x < kernel_cols; ++x) {
+        const __m256 w = _mm256_set1_ps(k[x]);
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(w, _mm256_loadu_ps(src + x * stride)));
+      }
+    }
+    _mm256_storeu_ps(dst + i, acc);
+  }
+  scalar::FilterF32Range(rows, kernel_rows, kernel, kernel_cols, stride, dst, i, n);
+}
+
+// Offsets every plane pointer by i, for the scalar tails.
+template <typename T, int C>
+struct PlanePtrs {
+  PlanePtrs(T* const* planes, std::size_t i) {
+    for (int ch = 0; ch < C; ++ch) p[ch] = planes[ch] + i;
+  }
+  T* p[C];
+};
+
+void DeinterleaveU8x4(const uint8_t* src, uint8_t* const* planes, std::size_t n) {
+  // Per 128-bit lane: group the bytes of 4 pixels by channel, then gather the 32-bit groups so
+  // that every register holds 8 r, 8 g, 8 b and 8 a in its four 64-bit quarters.
+  const __m256i group = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15, 0,
+                                         4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+  const __m256i gather = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  auto load = [&](const uint8_t* p) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, group), gather);
+  };
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i v0 = load(src + 4 * i);
+    const __m256i v1 = load(src + 4 * i + 32);
+    const __m256i v2 = load(src + 4 * i + 64);
+    const __m256i v3 = load(src + 4 * i + 96);
+    const __m256i rb01 = _mm256_unpacklo_epi64(v0, v1);  // r(v0) r(v1) | b(v0) b(v1)
+    const __m256i ga01 = _mm256_unpackhi_epi64(v0, v1);  // g(v0) g(v1) | a(v0) a(v1)
+    const __m256i rb23 = _mm256_unpacklo_epi64(v2, v3);
+    const __m256i ga23 = _mm256_unpackhi_epi64(v2, v3);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(planes[0] + i),
+                        _mm256_permute2x128_si256(rb01, rb23, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(planes[1] + i),
+                        _mm256_permute2x128_si256(ga01, ga23, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(planes[2] + i),
+                        _mm256_permute2x128_si256(rb01, rb23, 0x31));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(planes[3] + i),
+                        _mm256_permute2x128_si256(ga01, ga23, 0x31));
+  }
+  scalar::DeinterleaveU8x4(src + 4 * i, PlanePtrs<uint8_t, 4>(planes, i).p, n - i);
+}
+
+void InterleaveU8x4(const uint8_t* const* planes, uint8_t* dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(planes[0] + i));
+    const __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(planes[1] + i));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(planes[2] + i));
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(planes[3] + i));
+    // The unpacks work per lane: lane 0 holds pixels 0-15, lane 1 pixels 16-31
+    const __m256i rg_lo = _mm256_unpacklo_epi8(r, g);
+    const __m256i rg_hi = _mm256_unpackhi_epi8(r, g);
+    const __m256i ba_lo = _mm256_unpacklo_epi8(b, a);
+    const __m256i ba_hi = _mm256_unpackhi_epi8(b, a);
+    const __m256i p0 = _mm256_unpacklo_epi16(rg_lo, ba_lo);  // pixels 0-3 | 16-19
+    const __m256i p1 = _mm256_unpackhi_epi16(rg_lo, ba_lo);  // pixels 4-7 | 20-23
+    const __m256i p2 = _mm256_unpacklo_epi16(rg_hi, ba_hi);  // pixels 8-11 | 24-27
+    const __m256i p3 = _mm256_unpackhi_epi16(rg_hi, ba_hi);  // pixels 12-15 | 28-31
+    __m256i* p = reinterpret_cast<__m256i*>(dst + 4 * i);
+    _mm256_storeu_si256(p, _mm256_permute2x128_si256(p0, p1, 0x20));
+    _mm256_storeu_si256(p + 1, _mm256_permute2x128_si256(p2, p3, 0x20));
+    _mm256_storeu_si256(p + 2, _mm256_permute2x128_si256(p0, p1, 0x31));
+    _mm256_storeu_si256(p + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+  }
+  scalar::InterleaveU8x4(PlanePtrs<const uint8_t, 4>(planes, i).p, dst + 4 * i, n - i);
+}
+
+__m256i LoadU8(const uint8_t* p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+void StoreU8(uint8_t* p, __m256i v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+
+// Reductions use one vector accumulator per lane group: lane j of accumulator k always holds
+// channel (k * kLanes + j) % kChannels, because every iteration consumes a block of
+// kAccumulators * kLanes elements, a multiple of the channel count. Three channels use three
+// accumulators, the others four.
+template <int kChannels>
+constexpr int kAccumulators = kChannels == 3 ? 3 : 4;
+
+// Float lanes are flushed into the double sums every kFlushBlocks blocks to bound their rounding
+// error (a two-level pairwise summation).
+constexpr std::size_t kFlushBlocks = 256;
+
+template <int kChannels, bool kSquares>
+void MomentsF32Impl(const float* src, std::size_t n, const float* shift, double* sum,
+                    double* sqsum) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 8;
+  alignas(32) float lanes[kAccs * 8];
+  for (std::size_t j = 0; j < kBlock; ++j) lanes[j] = shift[j % kChannels];
+  __m256 vshift[kAccs];
+  for (int k = 0; k < kAccs; ++k) vshift[k] = _mm256_load_ps(lanes + 8 * k);
+
+  std::size_t i = 0;
+  while (n - i >= kBlock) {
+    __m256 s[kAccs];
+    __m256 q[kAccs];
+    for (int k = 0; k < kAccs; ++k) s[k] = q[k] = _mm256_setzero_ps();
+    const std::size_t blocks = (n - i) / kBlock < kFlushBlocks ? (n - i) / kBlock : kFlushBlocks;
+    for (std::size_t b = 0; b < blocks; ++b, i += kBlock) {
+      for (int k = 0; k < kAccs; ++k) {
+        const __m256 v = _mm256_sub_ps(_mm256_loadu_ps(src + i + 8 * k), vshift[k]);
+        s[k] = _mm256_add_ps(s[k], v);
+        if constexpr (kSquares) q[k] = _mm256_add_ps(q[k], _mm256_mul_ps(v, v));
+      }
+    }
+    for (int k = 0; k < kAccs; ++k) _mm256_store_ps(lanes + 8 * k, s[k]);
+    for (std::size_t j = 0; j < kBlock; ++j) sum[j % kChannels] += lanes[j];
+    if constexpr (kSquares) {
+      for (int k = 0; k < kAccs; ++k) _mm256_store_ps(lanes + 8 * k, q[k]);
+      for (std::size_t j = 0; j < kBlock; ++j) sqsum[j % kChannels] += lanes[j];
+    }
+  }
+  scalar::MomentsF32(src + i, n - i, kChannels, shift, sum, kSquares ? sqsum : nullptr);
+}
+
+template <int kChannels>
+void MinMaxF32Impl(const float* src, std::size_t n, float* min, float* max) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 8;
+  if (n < kBlock) {
+    scalar::MinMaxF32(src, n, kChannels, min, max);
+    return;
+  }
+  __m256 lo[kAccs];
+  __m256 hi[kAccs];
+  for (int k = 0; k < kAccs; ++k) lo[k] = hi[k] = _mm256_loadu_ps(src + 8 * k);
+  std::size_t i = kBlock;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const __m256 v = _mm256_loadu_ps(src + i + 8 * k);
+      lo[k] = _mm256_min_ps(lo[k], v);
+      hi[k] = _mm256_max_ps(hi[k], v);
+    }
+  }
+  alignas(32) float lanes[kBlock];
+  for (int k = 0; k < kAccs; ++k) _mm256_store_ps(lanes + 8 * k, lo[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    min[j % kChannels] = lanes[j] < min[j % kChannels] ? lanes[j] : min[j % kChannels];
+  }
+  for (int k = 0; k < kAccs; ++k) _mm256_store_ps(lanes + 8 * k, hi[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    max[j % kChannels] = lanes[j] > max[j % kChannels] ? lanes[j] : max[j % kChannels];
+  }
+  scalar::MinMaxF32(src + i, n - i, kChannels, min, max);
+}
+
+template <int kChannels>
+void MinMaxU8Impl(const uint8_t* src, std::size_t n, uint8_t* min, uint8_t* max) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 32;
+  if (n < kBlock) {
+    scalar::MinMaxU8(src, n, kChannels, min, max);
+    return;
+  }
+  __m256i lo[kAccs];
+  __m256i hi[kAccs];
+  for (int k = 0; k < kAccs; ++k) lo[k] = hi[k] = LoadU8(src + 32 * k);
+  std::size_t i = kBlock;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const __m256i v = LoadU8(src + i + 32 * k);
+      lo[k] = _mm256_min_epu8(lo[k], v);
+      hi[k] = _mm256_max_epu8(hi[k], v);
+    }
+  }
+  alignas(32) uint8_t lanes[kBlock];
+  for (int k = 0; k < kAccs; ++k) StoreU8(lanes + 32 * k, lo[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    min[j % kChannels] = lanes[j] < min[j % kChannels] ? lanes[j] : min[j % kChannels];
+  }
+  for (int k = 0; k < kAccs; ++k) StoreU8(lanes + 32 * k, hi[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    max[j % kChannels] = lanes[j] > max[j % kChannels] ? lanes[j] : max[j % kChannels];
+  }
+  scalar::MinMaxU8(src + i, n - i, kChannels, min, max);
+}
+
+template <int kChannels>
+void SumU8Impl(const uint8_t* src, std::size_t n, uint64_t* sum) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 32;
+  // psadbw against zero sums 8 bytes into a 64-bit lane; with several channels the bytes of the
+  // other channels are masked out first.
+  alignas(32) uint8_t bytes[kBlock];
+  __m256i mask[kAccs][kChannels];
+  for (int ch = 0; ch < kChannels; ++ch) {
+    for (std::size_t j = 0; j < kBlock; ++j) bytes[j] = j % kChannels == std::size_t(ch) ? 0xff : 0;
+    for (int k = 0; k < kAccs; ++k) mask[k][ch] = LoadU8(bytes + 32 * k);
+  }
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc[kChannels];
+  for (int ch = 0; ch < kChannels; ++ch) acc[ch] = zero;
+  std::size_t i = 0;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const __m256i v = LoadU8(src + i + 32 * k);
+      if constexpr (kChannels == 1) {
+        acc[0] = _mm256_add_epi64(acc[0], _mm256_sad_epu8(v, zero));
+      } else {
+        for (int ch = 0; ch < kChannels; ++ch) {
+          const __m256i masked = _mm256_and_si256(v, mask[k][ch]);
+          acc[ch] = _mm256_add_epi64(acc[ch], _mm256_sad_epu8(masked, zero));
+        }
+      }
+    }
+  }
+  alignas(32) uint64_t lanes[4];
+  for (int ch = 0; ch < kChannels; ++ch) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc[ch]);
+    sum[ch] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  }
+  scalar::SumU8(src + i, n - i, kChannels, sum);
+}
+
+template <typename Fn>
+void DispatchChannels(int channels, Fn&& fn) {
+  switch (channels) {
+    case 1:
+      return fn(std::integral_constant<int, 1>());
+    case 2:
+      return fn(std::integral_constant<int, 2>());
+    case 3:
+      return fn(std::integral_constant<int, 3>());
+    default:
+      return fn(std::integral_constant<int, 4>());
+  }
+}
+
+void MomentsF32(const float* src, std::size_t n, int channels, const float* shift, double* sum,
+                double* sqsum) {
+  DispatchChannels(channels, [&](auto c) {
+    if (sqsum != nullptr) {
+      MomentsF32Impl<c(), true>(src, n, shift, sum, sqsum);
+    } else {
+      MomentsF32Impl<c(), false>(src, n, shift, sum, sqsum);
+    }
+  });
+}
+
+void SumU8(const uint8_t* src, std::size_t n, int channels, uint64_t* sum) {
+  DispatchChannels(channels, [&](auto c) { SumU8Impl<c()>(src, n, sum); });
+}
+
+void MinMaxF32(const float* src, std::size_t n, int channels, float* min, float* max) {
+  DispatchChannels(channels, [&](auto c) { MinMaxF32Impl<c()>(src, n, min, max); });
+}
+
+void MinMaxU8(const uint8_t* src, std::size_t n, int channels, uint8_t* min, uint8_t* max) {
+  DispatchChannels(channels, [&](auto c) { MinMaxU8Impl<c()>(src, n, min, max); });
+}
+
+// 32 x 32 -> 64 bit products of the eight lanes of a with m, split into low and high words.
+void MulHiLo(__m256i a, __m256i m, __m256i* lo, __m256i* hi) {
+  const __m256i even = _mm256_mul_epu32(a, m);
+  const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+  *hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+}
+
+// Counter words of eight blocks, one block per lane.
+struct PhiloxLanes {
+  __m256i c0;
+  __m256i c1;
+  __m256i c2;
+  __m256i c3;
+};
+
+// Counters of blocks first to first + 7.
+PhiloxLanes PhiloxCounters(uint64_t first) {
+  const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+  const __m256i base = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(first)));
+  const __m256i low = _mm256_add_epi32(base, _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  // Carry into the high word in the lanes where the low word wrapped around
+  const __m256i carry =
+      _mm256_cmpgt_epi32(_mm256_xor_si256(base, sign), _mm256_xor_si256(low, sign));
+  const __m256i high =
+      _mm256_sub_epi32(_mm256_set1_epi32(static_cast<int>(first >> 32)), carry);
+  return {low, high, _mm256_setzero_si256(), _mm256_setzero_si256()};
+}
+
+void PhiloxRound(PhiloxLanes* x, __m256i m0, __m256i m1, __m256i k0, __m256i k1) {
+  __m256i lo0, hi0, lo1, hi1;
+  MulHiLo(x->c0, m0, &lo0, &hi0);
+  MulHiLo(x->c2, m1, &lo1, &hi1);
+  x->c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x->c1), k0);
+  x->c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x->c3), k1);
+  x->c1 = lo1;
+  x->c3 = lo0;
+}
+
+// Transposes the lanes back to block order: 4x4 transposes within each 128-bit half, where half 0
+// holds blocks 0-3 and half 1 blocks 4-7.
+void StorePhiloxBlocks(const PhiloxLanes& x, uint32_t* dst) {
+  const __m256i t0 = _mm256_unpacklo_epi32(x.c0, x.c1);
+  const __m256i t1 = _mm256_unpacklo_epi32(x.c2, x.c3);
+  const __m256i t2 = _mm256_unpackhi_epi32(x.c0, x.c1);
+  const __m256i t3 = _mm256_unpackhi_epi32(x.c2, x.c3);
+  const __m256i r0 = _mm256_unpacklo_epi64(t0, t1);
+  const __m256i r1 = _mm256_unpackhi_epi64(t0, t1);
+  const __m256i r2 = _mm256_unpacklo_epi64(t2, t3);
+  const __m256i r3 = _mm256_unpackhi_epi64(t2, t3);
+  __m256i* out = reinterpret_cast<__m256i*>(dst);
+  _mm256_storeu_si256(out, _mm256_permute2x128_si256(r0, r1, 0x20));
+  _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(r2, r3, 0x20));
+  _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(r0, r1, 0x31));
+  _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(r2, r3, 0x31));
+}
+
+// Sixteen blocks at a time, one per lane of two independent sets of vectors so that the latency
+// of the multiplications of one set is hidden behind the other.
+void Philox4x32(const uint32_t* key, uint64_t block, uint32_t* dst, std::size_t blocks) {
+  const __m256i m0 = _mm256_set1_epi32(static_cast<int>(scalar::kPhiloxM0));
+  const __m256i m1 = _mm256_set1_epi32(static_cast<int>(scalar::kPhiloxM1));
+  const __m256i w0 = _mm256_set1_epi32(static_cast<int>(scalar::kPhiloxW0));
+  const __m256i w1 = _mm256_set1_epi32(static_cast<int>(scalar::kPhiloxW1));
+  std::size_t b = 0;
+  for (; b + 16 <= blocks; b += 16) {
+    PhiloxLanes x = PhiloxCounters(block + b);
+    PhiloxLanes y = PhiloxCounters(block + b + 8);
+    __m256i k0 = _mm256_set1_epi32(static_cast<int>(key[0]));
+    __m256i k1 = _mm256_set1_epi32(static_cast<int>(key[1]));
+    for (int round = 0; round < scalar::kPhiloxRounds; ++round) {
+      PhiloxRound(&x, m0, m1, k0, k1);
+      PhiloxRound(&y, m0, m1, k0, k1);
+      k0 = _mm256_add_epi32(k0, w0);
+      k1 = _mm256_add_epi32(k1, w1);
+    }
+    StorePhiloxBlocks(x, dst + 4 * b);
+    StorePhiloxBlocks(y, dst + 4 * b + 32);
+  }
+  scalar::Philox4x32(key, block + b, dst + 4 * b, blocks - b);
+}
+
+}  // namespace
+
+bool InitMatKernelsAVX2(MatKernels* kernels) {
+  kernels->add_f32 = AddF32;
+  kernels->sub_f32 = SubF32;
+  kernels->mul_f32 = MulF32;
+  kernels->min_f32 = MinF32;
+  kernels->max_f32 = MaxF32;
+  kernels->absdiff_f32 = AbsDiffF32;
+
+  kernels->add_u8 = AddU8;
+  kernels->sub_u8 = SubU8;
+  kernels->mul_u8 = MulU8;
+  kernels->min_u8 = MinU8;
+  kernels->max_u8 = MaxU8;
+  kernels->absdiff_u8 = AbsDiffU8;
+
+  kernels->scale_f32 = ScaleF32;
+  kernels->convert_u8_f32 = ConvertU8F32;
+  kernels->convert_f32_u8 = ConvertF32U8;
+
+  kernels->filter_f32 = FilterF32;
+
+  // f32x3 keeps the SSE4 version: it is bound by memory bandwidth, not shuffles
+  kernels->deinterleave_u8x4 = DeinterleaveU8x4;
+  kernels->interleave_u8x4 = InterleaveU8x4;
+  kernels->moments_f32 = MomentsF32;
+  kernels->sum_u8 = SumU8;
+  kernels->minmax_f32 = MinMaxF32;
+  kernels->minmax_u8 = MinMaxU8;
+  kernels->philox4x32 = Philox4x32;
+  return true;
+}
+
+}  // namespace detail
+}  // namespace core
+
+#else
+
+namespace core {
+namespace detail {
+
+bool InitMatKernelsAVX2(MatKernels*) { return false; }
+
+}  // namespace detail
+}  // namespace core
+
+#endif  // __AVX2__
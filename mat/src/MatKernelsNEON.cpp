@@ -0,0 +1,538 @@
+#include "MatKernels.h"
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#include <type_traits>
+
+#include "MatKernelsScalar.h"
+
+namespace core {
+namespace detail {
+namespace {
+
+template <typename VecOp, typename ScalarOp>
+void BinaryF32(const float* a, const float* b, float* dst, std::size_t n, VecOp vec_op,
+               ScalarOp scalar_op) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(dst + i, vec_op(vld1q_f32(a + i), vld1q_f32(b + i)));
+  }
+  scalar_op(a + i, b + i, dst + i, n - i);
+}
+
+template <typename VecOp, typename ScalarOp>
+void BinaryU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n, VecOp vec_op,
+              ScalarOp scalar_op) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    vst1q_u8(dst + i, vec_op(vld1q_u8(a + i), vld1q_u8(b + i)));
+  }
+  scalar_op(a + i, b + i, dst + i, n - i);
+}
+
+void AddF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(
+      a, b, dst, n, [](float32x4_t x, float32x4_t y) { return vaddq_f32(x, y); }, scalar::AddF32);
+}
+
+void SubF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(
+      a, b, dst, n, [](float32x4_t x, float32x4_t y) { return vsubq_f32(x, y); }, scalar::SubF32);
+}
+
+void MulF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(
+      a, b, dst, n, [](float32x4_t x, float32x4_t y) { return vmulq_f32(x, y); }, scalar::MulF32);
+}
+
+void MinF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(
+      a, b, dst, n, [](float32x4_t x, float32x4_t y) { return vminq_f32(x, y); }, scalar::MinF32);
+}
+
+void MaxF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(
+      a, b, dst, n, [](float32x4_t x, float32x4_t y) { return vmaxq_f32(x, y); }, scalar::MaxF32);
+}
+
+void AbsDiffF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(
+      a, b, dst, n, [](float32x4_t x, float32x4_t y) { return vabdq_f32(x, y); },
+      scalar::AbsDiffF32);
+}
+
+void AddU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](uint8x16_t x, uint8x16_t y) { return vqaddq_u8(x, y); }, scalar::AddU8);
+}
+
+void SubU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](uint8x16_t x, uint8x16_t y) { return vqsubq_u8(x, y); }, scalar::SubU8);
+}
+
+void MulU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n,
+      [](uint8x16_t x, uint8x16_t y) {
+        // Widening multiply to u16, then saturating narrow
+        const uint16x8_t lo = vmull_u8(vget_low_u8(x), vget_low_u8(y));
+        const uint16x8_t hi = vmull_u8(vget_high_u8(x), vget_high_u8(y));
+        return vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi));
+      },
+      scalar::MulU8);
+}
+
+void MinU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](uint8x16_t x, uint8x16_t y) { return vminq_u8(x, y); }, scalar::MinU8);
+}
+
+void MaxU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](uint8x16_t x, uint8x16_t y) { return vmaxq_u8(x, y); }, scalar::MaxU8);
+}
+
+void AbsDiffU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n, [](uint8x16_t x, uint8x16_t y) { return vabdq_u8(x, y); }, scalar::AbsDiffU8);
+}
+
+void ScaleF32(const float* src, float* dst, std::size_t n, float scale, float offset) {
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  const float32x4_t voffset = vdupq_n_f32(offset);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    // Separate multiply and add (no vfma) to match the scalar rounding exactly
+    vst1q_f32(dst + i, vaddq_f32(vmulq_f32(vld1q_f32(src + i), vscale), voffset));
+  }
+  scalar::ScaleF32(src + i, dst + i, n - i, scale, offset);
+}
+
+void ConvertU8F32(const uint8_t* src, float* dst, std::size_t n, float scale, float offset) {
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  const float32x4_t voffset = vdupq_n_f32(offset);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const uint16x8_t v16 = vmovl_u8(vld1_u8(src + i));
+    const float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v16)));
+    const float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v16)));
+    vst1q_f32(dst + i, vaddq_f32(vmulq_f32(lo, vscale), voffset));
+    vst1q_f32(dst + i + 4, vaddq_f32(vmulq_f32(hi, vscale), voffset));
+  }
+  scalar::ConvertU8F32(src + i, dst + i, n - i, scale, offset);
+}
+
+void ConvertF32U8(const float* src, uint8_t* dst, std::size_t n, float scale, float offset) {
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  const float32x4_t voffset = vdupq_n_f32(offset);
+  const float32x4_t vmin = vdupq_n_f32(0.0f);
+  const float32x4_t vmax = vdupq_n_f32(255.0f);
+  auto convert4 = [&](const float* p) {
+    float32x4_t v = vaddq_f32(vmulq_f32(vld1q_f32(p), vscale), voffset);
+    v = vminq_f32(vmaxq_f32(v, vmin), vmax);
+    return vqmovun_s32(vcvtnq_s32_f32(v));
+  };
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const uint16x8_t lo = vcombine_u16(convert4(src + i), convert4(src + i + 4));
+    const uint16x8_t hi = vcombine_u16(convert4(src + i + 8), convert4(src + i + 12));
+    vst1q_u8(dst + i, vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi)));
+  }
+  scalar::ConvertF32U8(src + i, dst + i, n - i, scale, offset);
+}
+
+void FilterF32(const float* const* rows, int kernel_rows, const float* kernel, int kernel_cols,
+               int stride, float* dst, std::size_t n) {
+  std::size_t i = 0;
+  // Four independent accumulators per iteration to hide the add latency
+  for (; i + 16 <= n; i += 16) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    float32x4_t acc2 = vdupq_n_f32(0.0f);
+    float32x4_t acc3 = vdupq_n_f32(0.0f);
+    for (int j = 0; j < kernel_rows; ++j) {
+      const float* src = rows[j] + i;
+      const float* k = kernel + j * kernel_cols;
+      for (int x = 0; x < kernel_cols; ++x) {
+        const float32x4_t w = vdupq_n_f32(k[x]);
+        const float* p = src + x * stride;
+        acc0 = vaddq_f32(acc0, vmulq_f32(w, vld1q_f32(p)));
+        acc1 = vaddq_f32(acc1, vmulq_f32(w, vld1q_f32(p + 4)));
+        acc2 = vaddq_f32(acc2, vmulq_f32(w, vld1q_f32(p + 8)));
+        acc3 = vaddq_f32(acc3, vmulq_f32(w, vld1q_f32(p + 12)));
+      }
+    }
+    vst1q_f32(dst + i, acc0);
+    vst1q_f32(dst + i + 4, acc1);
+    vst1q_f32(dst + i + 8, acc2);
+    vst1q_f32(dst + i + 12, acc3);
+  }
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int j = 0; j < kernel_rows; ++j) {
+      const float* src = rows[j] + i;
+      const float* k = kernel + j * kernel_cols;
+      for (int x = 0; x < kernel_cols; ++x) {
+        acc = vaddq_f32(acc, vmulq_f32(vdupq_n_f32(k[x]), vld1q_f32(src + x * stride)));
+      }
+    }
+    vst1q_f32(dst + i, acc);
+  }
+  scalar::FilterF32Range(rows, kernel_rows, kernel, kernel_cols, stride, dst, i, n);
+}
+
+// Offsets every plane pointer by i, for the scalar tails.
+template <typename T, int C>
+struct PlanePtrs {
+  PlanePtrs(T* const* planes, std::size_t i) {
+    for (int ch = 0; ch < C; ++ch) p[ch] = planes[ch] + i;
+  }
+  T* p[C];
+};
+
+void DeinterleaveU8x4(const uint8_t* src, uint8_t* const* planes, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16x4_t v = vld4q_u8(src + 4 * i);
+    vst1q_u8(planes[0] + i, v.val[0]);
+    vst1q_u8(planes[1] + i, v.val[1]);
+    vst1q_u8(planes[2] + i, v.val[2]);
+    vst1q_u8(planes[3] + i, v.val[3]);
+  }
+  scalar::DeinterleaveU8x4(src + 4 * i, PlanePtrs<uint8_t, 4>(planes, i).p, n - i);
+}
+
+void InterleaveU8x4(const uint8_t* const* planes, uint8_t* dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16x4_t v;
+    v.val[0] = vld1q_u8(planes[0] + i);
+    v.val[1] = vld1q_u8(planes[1] + i);
+    v.val[2] = vld1q_u8(planes[2] + i);
+    v.val[3] = vld1q_u8(planes[3] + i);
+    vst4q_u8(dst + 4 * i, v);
+  }
+  scalar::InterleaveU8x4(PlanePtrs<const uint8_t, 4>(planes, i).p, dst + 4 * i, n - i);
+}
+
+void DeinterleaveF32x3(const float* src, float* const* planes, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const float32x4x3_t v = vld3q_f32(src + 3 * i);
+    vst1q_f32(planes[0] + i, v.val[0]);
+    vst1q_f32(planes[1] + i, v.val[1]);
+    vst1q_f32(planes[2] + i, v.val[2]);
+  }
+  scalar::DeinterleaveF32x3(src + 3 * i, PlanePtrs<float, 3>(planes, i).p, n - i);
+}
+
+void InterleaveF32x3(const float* const* planes, float* dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4x3_t v;
+    v.val[0] = vld1q_f32(planes[0] + i);
+    v.val[1] = vld1q_f32(planes[1] + i);
+    v.val[2] = vld1q_f32(planes[2] + i);
+    vst3q_f32(dst + 3 * i, v);
+  }
+  scalar::InterleaveF32x3(PlanePtrs<const float, 3>(planes, i).p, dst + 3 * i, n - i);
+}
+
+// Reductions use one vector accumulator per lane group: lane j of accumulator k always holds
+// channel (k * kLanes + j) % kChannels, because every iteration consumes a block of
+// kAccumulators * kLanes elements, a multiple of the channel count. Three channels use three
+// accumulators, the others four.
+template <int kChannels>
+constexpr int kAccumulators = kChannels == 3 ? 3 : 4;
+
+// Float lanes are flushed into the double sums every kFlushBlocks blocks to bound their rounding
+// error (a two-level pairwise summation).
+constexpr std::size_t kFlushBlocks = 256;
+
+template <int kChannels, bool kSquares>
+void MomentsF32Impl(const float* src, std::size_t n, const float* shift, double* sum,
+                    double* sqsum) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 4;
+  alignas(32) float lanes[kAccs * 4];
+  for (std::size_t j = 0; j < kBlock; ++j) lanes[j] = shift[j % kChannels];
+  float32x4_t vshift[kAccs];
+  for (int k = 0; k < kAccs; ++k) vshift[k] = vld1q_f32(lanes + 4 * k);
+
+  std::size_t i = 0;
+  while (n - i >= kBlock) {
+    float32x4_t s[kAccs];
+    float32x4_t q[kAccs];
+    for (int k = 0; k < kAccs; ++k) s[k] = q[k] = vdupq_n_f32(0.0f);
+    const std::size_t blocks = (n - i) / kBlock < kFlushBlocks ? (n - i) / kBlock : kFlushBlocks;
+    for (std::size_t b = 0; b < blocks; ++b, i += kBlock) {
+      for (int k = 0; k < kAccs; ++k) {
+        const float32x4_t v = vsubq_f32(vld1q_f32(src + i + 4 * k), vshift[k]);
+        s[k] = vaddq_f32(s[k], v);
+        if constexpr (kSquares) q[k] = vaddq_f32(q[k], vmulq_f32(v, v));
+      }
+    }
+    for (int k = 0; k < kAccs; ++k) vst1q_f32(lanes + 4 * k, s[k]);
+    for (std::size_t j = 0; j < kBlock; ++j) sum[j % kChannels] += lanes[j];
+    if constexpr (kSquares) {
+      for (int k = 0; k < kAccs; ++k) vst1q_f32(lanes + 4 * k, q[k]);
+      for (std::size_t j = 0; j < kBlock; ++j) sqsum[j % kChannels] += lanes[j];
+    }
+  }
+  scalar::MomentsF32(src + i, n - i, kChannels, shift, sum, kSquares ? sqsum : nullptr);
+}
+
+template <int kChannels>
+void MinMaxF32Impl(const float* src, std::size_t n, float* min, float* max) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 4;
+  if (n < kBlock) {
+    scalar::MinMaxF32(src, n, kChannels, min, max);
+    return;
+  }
+  float32x4_t lo[kAccs];
+  float32x4_t hi[kAccs];
+  for (int k = 0; k < kAccs; ++k) lo[k] = hi[k] = vld1q_f32(src + 4 * k);
+  std::size_t i = kBlock;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const float32x4_t v = vld1q_f32(src + i + 4 * k);
+      lo[k] = vminq_f32(lo[k], v);
+      hi[k] = vmaxq_f32(hi[k], v);
+    }
+  }
+  alignas(32) float lanes[kBlock];
+  for (int k = 0; k < kAccs; ++k) vst1q_f32(lanes + 4 * k, lo[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    min[j % kChannels] = lanes[j] < min[j % kChannels] ? lanes[j] : min[j % kChannels];
+  }
+  for (int k = 0; k < kAccs; ++k) vst1q_f32(lanes + 4 * k, hi[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    max[j % kChannels] = lanes[j] > max[j % kChannels] ? lanes[j] : max[j % kChannels];
+  }
+  scalar::MinMaxF32(src + i, n - i, kChannels, min, max);
+}
+
+template <int kChannels>
+void MinMaxU8Impl(const uint8_t* src, std::size_t n, uint8_t* min, uint8_t* max) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 16;
+  if (n < kBlock) {
+    scalar::MinMaxU8(src, n, kChannels, min, max);
+    return;
+  }
+  uint8x16_t lo[kAccs];
+  uint8x16_t hi[kAccs];
+  for (int k = 0; k < kAccs; ++k) lo[k] = hi[k] = vld1q_u8(src + 16 * k);
+  std::size_t i = kBlock;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const uint8x16_t v = vld1q_u8(src + i + 16 * k);
+      lo[k] = vminq_u8(lo[k], v);
+      hi[k] = vmaxq_u8(hi[k], v);
+    }
+  }
+  alignas(32) uint8_t lanes[kBlock];
+  for (int k = 0; k < kAccs; ++k) vst1q_u8(lanes + 16 * k, lo[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    min[j % kChannels] = lanes[j] < min[j % kChannels] ? lanes[j] : min[j % kChannels];
+  }
+  for (int k = 0; k < kAccs; ++k) vst1q_u8(lanes + 16 * k, hi[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    max[j % kChannels] = lanes[j] > max[j % kChannels] ? lanes[j] : max[j % kChannels];
+  }
+  scalar::MinMaxU8(src + i, n - i, kChannels, min, max);
+}
+
+template <int kChannels>
+void SumU8Impl(const uint8_t* src, std::size_t n, uint64_t* sum) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 16;
+  // Pairwise widening adds up to 64-bit lanes; with several channels the bytes of the other
+  // channels are masked out first.
+  uint8_t bytes[kBlock];
+  uint8x16_t mask[kAccs][kChannels];
+  for (int ch = 0; ch < kChannels; ++ch) {
+    for (std::size_t j = 0; j < kBlock; ++j) bytes[j] = j % kChannels == std::size_t(ch) ? 0xff : 0;
+    for (int k = 0; k < kAccs; ++k) mask[k][ch] = vld1q_u8(bytes + 16 * k);
+  }
+  uint64x2_t acc[kChannels];
+  for (int ch = 0; ch < kChannels; ++ch) acc[ch] = vdupq_n_u64(0);
+  std::size_t i = 0;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const uint8x16_t v = vld1q_u8(src + i + 16 * k);
+      for (int ch = 0; ch < kChannels; ++ch) {
+        const uint8x16_t masked = kChannels == 1 ? v : vandq_u8(v, mask[k][ch]);
+        acc[ch] = vpadalq_u32(acc[ch], vpaddlq_u16(vpaddlq_u8(masked)));
+      }
+    }
+  }
+  for (int ch = 0; ch < kChannels; ++ch) sum[ch] += vaddvq_u64(acc[ch]);
+  scalar::SumU8(src + i, n - i, kChannels, sum);
+}
+
+template <typename Fn>
+void DispatchChannels(int channels, Fn&& fn) {
+  switch (channels) {
+    case 1:
+      return fn(std::integral_constant<int, 1>());
+    case 2:
+      return fn(std::integral_constant<int, 2>());
+    case 3:
+      return fn(std::integral_constant<int, 3>());
+    default:
+      return fn(std::integral_constant<int, 4>());
+  }
+}
+
+void MomentsF32(const float* src, std::size_t n, int channels, const float* shift, double* sum,
+                double* sqsum) {
+  DispatchChannels(channels, [&](auto c) {
+    if (sqsum != nullptr) {
+      MomentsF32Impl<c(), true>(src, n, shift, sum, sqsum);
+    } else {
+      MomentsF32Impl<c(), false>(src, n, shift, sum, sqsum);
+    }
+  });
+}
+
+void SumU8(const uint8_t* src, std::size_t n, int channels, uint64_t* sum) {
+  DispatchChannels(channels, [&](auto c) { SumU8Impl<c()>(src, n, sum); });
+}
+
+void MinMaxF32(const float* src, std::size_t n, int channels, float* min, float* max) {
+  DispatchChannels(channels, [&](auto c) { MinMaxF32Impl<c()>(src, n, min, max); });
+}
+
+void MinMaxU8(const uint8_t* src, std::size_t n, int channels, uint8_t* min, uint8_t* max) {
+  DispatchChannels(channels, [&](auto c) { MinMaxU8Impl<c()>(src, n, min, max); });
+}
+
+// 32 x 32 -> 64 bit products of the four lanes of a with m, split into low and high words.
+void MulHiLo(uint32x4_t a, uint32x4_t m, uint32x4_t* lo, uint32x4_t* hi) {
+  const uint32x4_t p0 = vreinterpretq_u32_u64(vmull_u32(vget_low_u32(a), vget_low_u32(m)));
+  const uint32x4_t p1 = vreinterpretq_u32_u64(vmull_high_u32(a, m));
+  *lo = vuzp1q_u32(p0, p1);
+  *hi = vuzp2q_u32(p0, p1);
+}
+
+// Counters of blocks first to first + 3, one block per lane.
+uint32x4x4_t PhiloxCounters(uint64_t first) {
+  const uint32_t offsets[4] = {0, 1, 2, 3};
+  const uint32x4_t base = vdupq_n_u32(static_cast<uint32_t>(first));
+  const uint32x4_t low = vaddq_u32(base, vld1q_u32(offsets));
+  uint32x4x4_t x;
+  x.val[0] = low;
+  // Carry into the high word in the lanes where the low word wrapped around (the mask is -1)
+  x.val[1] = vsubq_u32(vdupq_n_u32(static_cast<uint32_t>(first >> 32)), vcltq_u32(low, base));
+  x.val[2] = vdupq_n_u32(0);
+  x.val[3] = vdupq_n_u32(0);
+  return x;
+}
+
+void PhiloxRound(uint32x4x4_t* x, uint32x4_t m0, uint32x4_t m1, uint32x4_t k0, uint32x4_t k1) {
+  uint32x4_t lo0, hi0, lo1, hi1;
+  MulHiLo(x->val[0], m0, &lo0, &hi0);
+  MulHiLo(x->val[2], m1, &lo1, &hi1);
+  x->val[0] = veorq_u32(veorq_u32(hi1, x->val[1]), k0);
+  x->val[2] = veorq_u32(veorq_u32(hi0, x->val[3]), k1);
+  x->val[1] = lo1;
+  x->val[3] = lo0;
+}
+
+// Eight blocks at a time, one per lane of two independent sets of vectors so that the latency of
+// the multiplications of one set is hidden behind the other. vst4q stores them in block order.
+void Philox4x32(const uint32_t* key, uint64_t block, uint32_t* dst, std::size_t blocks) {
+  const uint32x4_t m0 = vdupq_n_u32(scalar::kPhiloxM0);
+  const uint32x4_t m1 = vdupq_n_u32(scalar::kPhiloxM1);
+  std::size_t b = 0;
+  for (; b + 8 <= blocks; b += 8) {
+    uint32x4x4_t x = PhiloxCounters(block + b);
+    uint32x4x4_t y = PhiloxCounters(block + b + 4);
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round < scalar::kPhiloxRounds; ++round) {
+      PhiloxRound(&x, m0, m1, vdupq_n_u32(k0), vdupq_n_u32(k1));
+      PhiloxRound(&y, m0, m1, vdupq_n_u32(k0), vdupq_n_u32(k1));
+      k0 += scalar::kPhiloxW0;
+      k1 += scalar::kPhiloxW1;
+    }
+    vst4q_u32(dst + 4 * b, x);
+    vst4q_u32(dst + 4 * b + 16, y);
+  }
+  scalar::Philox4x32(key, block + b, dst + 4 * b, blocks - b);
+}
+
+// Per pixel, both source rows are widened to 16 bits and the four weighted products of each
+// channel are accumulated with widening multiply-adds.
+void RemapLinearU8x4(const uint8_t* src, std::size_t step, const int32_t* origin,
+                     const uint16_t* fraction, const int16_t* table, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    const uint8_t* p0 = src + origin[2 * i + 1] * step + origin[2 * i] * 4;
+    const int16_t* w = table + 4 * fraction[i];
+    const uint16x8_t top = vmovl_u8(vld1_u8(p0));
+    const uint16x8_t bottom = vmovl_u8(vld1_u8(p0 + step));
+    uint32x4_t sum = vmull_n_u16(vget_low_u16(top), static_cast<uint16_t>(w[0]));
+    sum = vmlal_n_u16(sum, vget_high_u16(top), static_cast<uint16_t>(w[1]));
+    sum = vmlal_n_u16(sum, vget_low_u16(bottom), static_cast<uint16_t>(w[2]));
+    sum = vmlal_n_u16(sum, vget_high_u16(bottom), static_cast<uint16_t>(w[3]));
+    const uint16x4_t narrow = vrshrn_n_u32(sum, 14);
+    const uint8x8_t packed = vqmovn_u16(vcombine_u16(narrow, narrow));
+    vst1_lane_u32(reinterpret_cast<uint32_t*>(dst + 4 * i), vreinterpret_u32_u8(packed), 0);
+  }
+}
+
+}  // namespace
+
+bool InitMatKernelsNEON(MatKernels* kernels) {
+  kernels->add_f32 = AddF32;
+  kernels->sub_f32 = SubF32;
+  kernels->mul_f32 = MulF32;
+  kernels->min_f32 = MinF32;
+  kernels->max_f32 = MaxF32;
+  kernels->absdiff_f32 = AbsDiffF32;
+
+  kernels->add_u8 = AddU8;
+  kernels->sub_u8 = SubU8;
+  kernels->mul_u8 = MulU8;
+  kernels->min_u8 = MinU8;
+  kernels->max_u8 = MaxU8;
+  kernels->absdiff_u8 = AbsDiffU8;
+
+  kernels->scale_f32 = ScaleF32;
+  kernels->convert_u8_f32 = ConvertU8F32;
+  kernels->convert_f32_u8 = ConvertF32U8;
+
+  kernels->filter_f32 = FilterF32;
+
+  kernels->deinterleave_u8x4 = DeinterleaveU8x4;
+  kernels->interleave_u8x4 = InterleaveU8x4;
+  kernels->deinterleave_f32x3 = DeinterleaveF32x3;
+  kernels->interleave_f32x3 = InterleaveF32x3;
+  kernels->moments_f32 = MomentsF32;
+  kernels->sum_u8 = SumU8;
+  kernels->minmax_f32 = MinMaxF32;
+  kernels->minmax_u8 = MinMaxU8;
+  kernels->philox4x32 = Philox4x32;
+  kernels->remap_linear_u8x4 = RemapLinearU8x4;
+  return true;
+}
+
+}  // namespace detail
+}  // namespace core
+
+#else
+
+namespace core {
+namespace detail {
+
+bool InitMatKernelsNEON(MatKernels*) { return false; }
+
+}  // namespace detail
+}  // namespace core
+
+#endif  // __ARM_NEON && __aarch64__
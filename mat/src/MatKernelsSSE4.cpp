@@ -0,0 +1,606 @@
+#include "MatKernels.h"
+
+#if defined(__SSE4_1__)
+
+#include <smmintrin.h>
+
+#include <climits>
+#include <cstring>
+
+#include <type_traits>
+
+#include "MatKernelsScalar.h"
+
+namespace core {
+namespace detail {
+namespace {
+
+template <typename VecOp, typename ScalarOp>
+void BinaryF32(const float* a, const float* b, float* dst, std::size_t n, VecOp vec_op,
+               ScalarOp scalar_op) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(dst + i, vec_op(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  scalar_op(a + i, b + i, dst + i, n - i);
+}
+
+template <typename VecOp, typename ScalarOp>
+void BinaryU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n, VecOp vec_op,
+              ScalarOp scalar_op) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), vec_op(va, vb));
+  }
+  scalar_op(a + i, b + i, dst + i, n - i);
+}
+
+void AddF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m128 x, __m128 y) { return _mm_add_ps(x, y); }, scalar::AddF32);
+}
+
+void SubF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m128 x, __m128 y) { return _mm_sub_ps(x, y); }, scalar::SubF32);
+}
+
+void MulF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m128 x, __m128 y) { return _mm_mul_ps(x, y); }, scalar::MulF32);
+}
+
+void MinF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m128 x, __m128 y) { return _mm_min_ps(x, y); }, scalar::MinF32);
+}
+
+void MaxF32(const float* a, const float* b, float* dst, std::size_t n) {
+  BinaryF32(a, b, dst, n, [](__m128 x, __m128 y) { return _mm_max_ps(x, y); }, scalar::MaxF32);
+}
+
+void AbsDiffF32(const float* a, const float* b, float* dst, std::size_t n) {
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  BinaryF32(
+      a, b, dst, n, [sign](__m128 x, __m128 y) { return _mm_andnot_ps(sign, _mm_sub_ps(x, y)); },
+      scalar::AbsDiffF32);
+}
+
+void AddU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(a, b, dst, n, [](__m128i x, __m128i y) { return _mm_adds_epu8(x, y); }, scalar::AddU8);
+}
+
+void SubU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(a, b, dst, n, [](__m128i x, __m128i y) { return _mm_subs_epu8(x, y); }, scalar::SubU8);
+}
+
+void MulU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max_u8 = _mm_set1_epi16(255);
+  BinaryU8(
+      a, b, dst, n,
+      [zero, max_u8](__m128i x, __m128i y) {
+        // Widen to u16, multiply, clamp to 255 and narrow back
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(y, zero));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(y, zero));
+        lo = _mm_min_epu16(lo, max_u8);
+        hi = _mm_min_epu16(hi, max_u8);
+        return _mm_packus_epi16(lo, hi);
+      },
+      scalar::MulU8);
+}
+
+void MinU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(a, b, dst, n, [](__m128i x, __m128i y) { return _mm_min_epu8(x, y); }, scalar::MinU8);
+}
+
+void MaxU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(a, b, dst, n, [](__m128i x, __m128i y) { return _mm_max_epu8(x, y); }, scalar::MaxU8);
+}
+
+void AbsDiffU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  BinaryU8(
+      a, b, dst, n,
+      [](__m128i x, __m128i y) { return _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x)); },
+      scalar::AbsDiffU8);
+}
+
+void ScaleF32(const float* src, float* dst, std::size_t n, float scale, float offset) {
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128 voffset = _mm_set1_ps(offset);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), vscale), voffset));
+  }
+  scalar::ScaleF32(src + i, dst + i, n - i, scale, offset);
+}
+
+void ConvertU8F32(const uint8_t* src, float* dst, std::size_t n, float scale, float offset) {
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128 voffset = _mm_set1_ps(offset);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    int32_t packed;
+    std::memcpy(&packed, src + i, sizeof(packed));
+    const __m128 v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(v, vscale), voffset));
+  }
+  scalar::ConvertU8F32(src + i, dst + i, n - i, scale, offset);
+}
+
+void ConvertF32U8(const float* src, uint8_t* dst, std::size_t n, float scale, float offset) {
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128 voffset = _mm_set1_ps(offset);
+  const __m128 vmin = _mm_setzero_ps();
+  const __m128 vmax = _mm_set1_ps(255.0f);
+  auto convert4 = [&](const float* p) {
+    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(p), vscale), voffset);
+    v = _mm_min_ps(_mm_max_ps(v, vmin), vmax);
+    return _mm_cvtps_epi32(v);
+  };
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i lo = _mm_packs_epi32(convert4(src + i), convert4(src + i + 4));
+    const __m128i hi = _mm_packs_epi32(convert4(src + i + 8), convert4(src + i + 12));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+  }
+  scalar::ConvertF32U8(src + i, dst + i, n - i, scale, offset);
+}
+
+void FilterF32(const float* const* rows, int kernel_rows, const float* kernel, int kernel_cols,
+               int stride, float* dst, std::size_t n) {
+  std::size_t i = 0;
+  // Four independent accumulators per iteration to hide the add latency
+  for (; i + 16 <= n; i += 16) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+    for (int j = 0; j < kernel_rows; ++j) {
+      const float* src = rows[j] + i;
+      const float* k = kernel + j * kernel_cols;
+      for (int x = 0; x < kernel_cols; ++x) {
+        const __m128 w = _mm_set1_ps(k[x]);
+        const float* p = src + x * stride;
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(w, _mm_loadu_ps(p)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(w, _mm_loadu_ps(p + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(w, _mm_loadu_ps(p + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(w, _mm_loadu_ps(p + 12)));
+      }
+    }
+    _mm_storeu_ps(dst + i, acc0);
+    _mm_storeu_ps(dst + i + 4, acc1);
+    _mm_storeu_ps(dst + i + 8, acc2);
+    _mm_storeu_ps(dst + i + 12, acc3);
+  }
+  for (; i + 4 <= n; i += 4) {
+    __m128 acc = _mm_setzero_ps();
+    for (int j = 0; j < kernel_rows; ++j) {
+      const float* src = rows[j] + i;
+      const float* k = kernel + j * kernel_cols;
+      for (int x = 0; x < kernel_cols; ++x) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k[x]), _mm_loadu_ps(src + x * stride)));
+      }
+    }
+    _mm_storeu_ps(dst + i, acc);
+  }
+  scalar::FilterF32Range(rows, kernel_rows, kernel, kernel_cols, stride, dst, i, n);
+}
+
+// Offsets every plane pointer by i, for the scalar tails.
+template <typename T, int C>
+struct PlanePtrs {
+  PlanePtrs(T* const* planes, std::size_t i) {
+    for (int ch = 0; ch < C; ++ch) p[ch] = planes[ch] + i;
+  }
+  T* p[C];
+};
+
+void DeinterleaveU8x4(const uint8_t* src, uint8_t* const* planes, std::size_t n) {
+  // Groups the bytes of 4 pixels by channel: r0 r1 r2 r3 g0 .. a3
+  const __m128i group = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i* p = reinterpret_cast<const __m128i*>(src + 4 * i);
+    const __m128i v0 = _mm_shuffle_epi8(_mm_loadu_si128(p), group);
+    const __m128i v1 = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), group);
+    const __m128i v2 = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), group);
+    const __m128i v3 = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), group);
+    // 4x4 transpose of 32-bit channel groups
+    const __m128i t0 = _mm_unpacklo_epi32(v0, v1);  // r(v0) r(v1) g(v0) g(v1)
+    const __m128i t1 = _mm_unpacklo_epi32(v2, v3);
+    const __m128i t2 = _mm_unpackhi_epi32(v0, v1);  // b(v0) b(v1) a(v0) a(v1)
+    const __m128i t3 = _mm_unpackhi_epi32(v2, v3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[0] + i), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[1] + i), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[2] + i), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[3] + i), _mm_unpackhi_epi64(t2, t3));
+  }
+  scalar::DeinterleaveU8x4(src + 4 * i, PlanePtrs<uint8_t, 4>(planes, i).p, n - i);
+}
+
+void InterleaveU8x4(const uint8_t* const* planes, uint8_t* dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[0] + i));
+    const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[1] + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[2] + i));
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes[3] + i));
+    const __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+    const __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+    const __m128i ba_lo = _mm_unpacklo_epi8(b, a);
+    const __m128i ba_hi = _mm_unpackhi_epi8(b, a);
+    __m128i* p = reinterpret_cast<__m128i*>(dst + 4 * i);
+    _mm_storeu_si128(p, _mm_unpacklo_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(p + 1, _mm_unpackhi_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(p + 2, _mm_unpacklo_epi16(rg_hi, ba_hi));
+    _mm_storeu_si128(p + 3, _mm_unpackhi_epi16(rg_hi, ba_hi));
+  }
+  scalar::InterleaveU8x4(PlanePtrs<const uint8_t, 4>(planes, i).p, dst + 4 * i, n - i);
+}
+
+void DeinterleaveF32x3(const float* src, float* const* planes, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 a = _mm_loadu_ps(src + 3 * i);      // r0 g0 b0 r1
+    const __m128 b = _mm_loadu_ps(src + 3 * i + 4);  // g1 b1 r2 g2
+    const __m128 c = _mm_loadu_ps(src + 3 * i + 8);  // b2 r3 g3 b3
+    const __m128 r = _mm_blend_ps(_mm_blend_ps(a, b, 0x4), c, 0x2);  // r0 r3 r2 r1
+    const __m128 g = _mm_blend_ps(_mm_blend_ps(a, b, 0x9), c, 0x4);  // g1 g0 g3 g2
+    const __m128 bl = _mm_blend_ps(_mm_blend_ps(a, b, 0x2), c, 0x9);  // b2 b1 b0 b3
+    _mm_storeu_ps(planes[0] + i, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 2, 3, 0)));
+    _mm_storeu_ps(planes[1] + i, _mm_shuffle_ps(g, g, _MM_SHUFFLE(2, 3, 0, 1)));
+    _mm_storeu_ps(planes[2] + i, _mm_shuffle_ps(bl, bl, _MM_SHUFFLE(3, 0, 1, 2)));
+  }
+  scalar::DeinterleaveF32x3(src + 3 * i, PlanePtrs<float, 3>(planes, i).p, n - i);
+}
+
+void InterleaveF32x3(const float* const* planes, float* dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    // Inverse of the deinterleave: the same lane permutations, then the blends
+    __m128 r = _mm_loadu_ps(planes[0] + i);
+    __m128 g = _mm_loadu_ps(planes[1] + i);
+    __m128 b = _mm_loadu_ps(planes[2] + i);
+    r = _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 2, 3, 0));  // r0 r3 r2 r1
+    g = _mm_shuffle_ps(g, g, _MM_SHUFFLE(2, 3, 0, 1));  // g1 g0 g3 g2
+    b = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 1, 2));  // b2 b1 b0 b3
+    _mm_storeu_ps(dst + 3 * i, _mm_blend_ps(_mm_blend_ps(r, g, 0x2), b, 0x4));
+    _mm_storeu_ps(dst + 3 * i + 4, _mm_blend_ps(_mm_blend_ps(g, b, 0x2), r, 0x4));
+    _mm_storeu_ps(dst + 3 * i + 8, _mm_blend_ps(_mm_blend_ps(b, r, 0x2), g, 0x4));
+  }
+  scalar::InterleaveF32x3(PlanePtrs<const float, 3>(planes, i).p, dst + 3 * i, n - i);
+}
+
+__m128i LoadU8(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+
+void StoreU8(uint8_t* p, __m128i v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+
+// Reductions use one vector accumulator per lane group: lane j of accumulator k always holds
+// channel (k * kLanes + j) % kChannels, because every iteration consumes a block of
+// kAccumulators * kLanes elements, a multiple of the channel count. Three channels use three
+// accumulators, the others four.
+template <int kChannels>
+constexpr int kAccumulators = kChannels == 3 ? 3 : 4;
+
+// Float lanes are flushed into the double sums every kFlushBlocks blocks to bound their rounding
+// error (a two-level pairwise summation).
+constexpr std::size_t kFlushBlocks = 256;
+
+template <int kChannels, bool kSquares>
+void MomentsF32Impl(const float* src, std::size_t n, const float* shift, double* sum,
+                    double* sqsum) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 4;
+  alignas(32) float lanes[kAccs * 4];
+  for (std::size_t j = 0; j < kBlock; ++j) lanes[j] = shift[j % kChannels];
+  __m128 vshift[kAccs];
+  for (int k = 0; k < kAccs; ++k) vshift[k] = _mm_load_ps(lanes + 4 * k);
+
+  std::size_t i = 0;
+  while (n - i >= kBlock) {
+    __m128 s[kAccs];
+    __m128 q[kAccs];
+    for (int k = 0; k < kAccs; ++k) s[k] = q[k] = _mm_setzero_ps();
+    const std::size_t blocks = (n - i) / kBlock < kFlushBlocks ? (n - i) / kBlock : kFlushBlocks;
+    for (std::size_t b = 0; b < blocks; ++b, i += kBlock) {
+      for (int k = 0; k < kAccs; ++k) {
+        const __m128 v = _mm_sub_ps(_mm_loadu_ps(src + i + 4 * k), vshift[k]);
+        s[k] = _mm_add_ps(s[k], v);
+        if constexpr (kSquares) q[k] = _mm_add_ps(q[k], _mm_mul_ps(v, v));
+      }
+    }
+    for (int k = 0; k < kAccs; ++k) _mm_store_ps(lanes + 4 * k, s[k]);
+    for (std::size_t j = 0; j < kBlock; ++j) sum[j % kChannels] += lanes[j];
+    if constexpr (kSquares) {
+      for (int k = 0; k < kAccs; ++k) _mm_store_ps(lanes + 4 * k, q[k]);
+      for (std::size_t j = 0; j < kBlock; ++j) sqsum[j % kChannels] += lanes[j];
+    }
+  }
+  scalar::MomentsF32(src + i, n - i, kChannels, shift, sum, kSquares ? sqsum : nullptr);
+}
+
+template <int kChannels>
+void MinMaxF32Impl(const float* src, std::size_t n, float* min, float* max) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 4;
+  if (n < kBlock) {
+    scalar::MinMaxF32(src, n, kChannels, min, max);
+    return;
+  }
+  __m128 lo[kAccs];
+  __m128 hi[kAccs];
+  for (int k = 0; k < kAccs; ++k) lo[k] = hi[k] = _mm_loadu_ps(src + 4 * k);
+  std::size_t i = kBlock;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const __m128 v = _mm_loadu_ps(src + i + 4 * k);
+      lo[k] = _mm_min_ps(lo[k], v);
+      hi[k] = _mm_max_ps(hi[k], v);
+    }
+  }
+  alignas(32) float lanes[kBlock];
+  for (int k = 0; k < kAccs; ++k) _mm_store_ps(lanes + 4 * k, lo[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    min[j % kChannels] = lanes[j] < min[j % kChannels] ? lanes[j] : min[j % kChannels];
+  }
+  for (int k = 0; k < kAccs; ++k) _mm_store_ps(lanes + 4 * k, hi[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    max[j % kChannels] = lanes[j] > max[j % kChannels] ? lanes[j] : max[j % kChannels];
+  }
+  scalar::MinMaxF32(src + i, n - i, kChannels, min, max);
+}
+
+template <int kChannels>
+void MinMaxU8Impl(const uint8_t* src, std::size_t n, uint8_t* min, uint8_t* max) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 16;
+  if (n < kBlock) {
+    scalar::MinMaxU8(src, n, kChannels, min, max);
+    return;
+  }
+  __m128i lo[kAccs];
+  __m128i hi[kAccs];
+  for (int k = 0; k < kAccs; ++k) lo[k] = hi[k] = LoadU8(src + 16 * k);
+  std::size_t i = kBlock;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const __m128i v = LoadU8(src + i + 16 * k);
+      lo[k] = _mm_min_epu8(lo[k], v);
+      hi[k] = _mm_max_epu8(hi[k], v);
+    }
+  }
+  alignas(32) uint8_t lanes[kBlock];
+  for (int k = 0; k < kAccs; ++k) StoreU8(lanes + 16 * k, lo[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    min[j % kChannels] = lanes[j] < min[j % kChannels] ? lanes[j] : min[j % kChannels];
+  }
+  for (int k = 0; k < kAccs; ++k) StoreU8(lanes + 16 * k, hi[k]);
+  for (std::size_t j = 0; j < kBlock; ++j) {
+    max[j % kChannels] = lanes[j] > max[j % kChannels] ? lanes[j] : max[j % kChannels];
+  }
+  scalar::MinMaxU8(src + i, n - i, kChannels, min, max);
+}
+
+template <int kChannels>
+void SumU8Impl(const uint8_t* src, std::size_t n, uint64_t* sum) {
+  constexpr int kAccs = kAccumulators<kChannels>;
+  constexpr std::size_t kBlock = kAccs * 16;
+  // psadbw against zero sums 8 bytes into a 64-bit lane; with several channels the bytes of the
+  // other channels are masked out first.
+  alignas(16) uint8_t bytes[kBlock];
+  __m128i mask[kAccs][kChannels];
+  for (int ch = 0; ch < kChannels; ++ch) {
+    for (std::size_t j = 0; j < kBlock; ++j) bytes[j] = j % kChannels == std::size_t(ch) ? 0xff : 0;
+    for (int k = 0; k < kAccs; ++k) mask[k][ch] = LoadU8(bytes + 16 * k);
+  }
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc[kChannels];
+  for (int ch = 0; ch < kChannels; ++ch) acc[ch] = zero;
+  std::size_t i = 0;
+  for (; i + kBlock <= n; i += kBlock) {
+    for (int k = 0; k < kAccs; ++k) {
+      const __m128i v = LoadU8(src + i + 16 * k);
+      if constexpr (kChannels == 1) {
+        acc[0] = _mm_add_epi64(acc[0], _mm_sad_epu8(v, zero));
+      } else {
+        for (int ch = 0; ch < kChannels; ++ch) {
+          acc[ch] = _mm_add_epi64(acc[ch], _mm_sad_epu8(_mm_and_si128(v, mask[k][ch]), zero));
+        }
+      }
+    }
+  }
+  for (int ch = 0; ch < kChannels; ++ch) {
+    sum[ch] += static_cast<uint64_t>(_mm_cvtsi128_si64(acc[ch])) +
+               static_cast<uint64_t>(_mm_extract_epi64(acc[ch], 1));
+  }
+  scalar::SumU8(src + i, n - i, kChannels, sum);
+}
+
+template <typename Fn>
+void DispatchChannels(int channels, Fn&& fn) {
+  switch (channels) {
+    case 1:
+      return fn(std::integral_constant<int, 1>());
+    case 2:
+      return fn(std::integral_constant<int, 2>());
+    case 3:
+      return fn(std::integral_constant<int, 3>());
+    default:
+      return fn(std::integral_constant<int, 4>());
+  }
+}
+
+void MomentsF32(const float* src, std::size_t n, int channels, const float* shift, double* sum,
+                double* sqsum) {
+  DispatchChannels(channels, [&](auto c) {
+    if (sqsum != nullptr) {
+      MomentsF32Impl<c(), true>(src, n, shift, sum, sqsum);
+    } else {
+      MomentsF32Impl<c(), false>(src, n, shift, sum, sqsum);
+    }
+  });
+}
+
+void SumU8(const uint8_t* src, std::size_t n, int channels, uint64_t* sum) {
+  DispatchChannels(channels, [&](auto c) { SumU8Impl<c()>(src, n, sum); });
+}
+
+void MinMaxF32(const float* src, std::size_t n, int channels, float* min, float* max) {
+  DispatchChannels(channels, [&](auto c) { MinMaxF32Impl<c()>(src, n, min, max); });
+}
+
+void MinMaxU8(const uint8_t* src, std::size_t n, int channels, uint8_t* min, uint8_t* max) {
+  DispatchChannels(channels, [&](auto c) { MinMaxU8Impl<c()>(src, n, min, max); });
+}
+
+// 32 x 32 -> 64 bit products of the four lanes of a with m, split into low and high words.
+void MulHiLo(__m128i a, __m128i m, __m128i* lo, __m128i* hi) {
+  const __m128i even = _mm_mul_epu32(a, m);
+  const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+  *lo = _mm_blend_epi16(even, _mm_slli_epi64(odd, 32), 0xcc);
+  *hi = _mm_blend_epi16(_mm_srli_epi64(even, 32), odd, 0xcc);
+}
+
+// Counter words of four blocks, one block per lane.
+struct PhiloxLanes {
+  __m128i c0;
+  __m128i c1;
+  __m128i c2;
+  __m128i c3;
+};
+
+// Counters of blocks first to first + 3.
+PhiloxLanes PhiloxCounters(uint64_t first) {
+  const __m128i sign = _mm_set1_epi32(INT32_MIN);
+  const __m128i base = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(first)));
+  const __m128i low = _mm_add_epi32(base, _mm_setr_epi32(0, 1, 2, 3));
+  // Carry into the high word in the lanes where the low word wrapped around
+  const __m128i carry = _mm_cmpgt_epi32(_mm_xor_si128(base, sign), _mm_xor_si128(low, sign));
+  const __m128i high = _mm_sub_epi32(_mm_set1_epi32(static_cast<int>(first >> 32)), carry);
+  return {low, high, _mm_setzero_si128(), _mm_setzero_si128()};
+}
+
+void PhiloxRound(PhiloxLanes* x, __m128i m0, __m128i m1, __m128i k0, __m128i k1) {
+  __m128i lo0, hi0, lo1, hi1;
+  MulHiLo(x->c0, m0, &lo0, &hi0);
+  MulHiLo(x->c2, m1, &lo1, &hi1);
+  x->c0 = _mm_xor_si128(_mm_xor_si128(hi1, x->c1), k0);
+  x->c2 = _mm_xor_si128(_mm_xor_si128(hi0, x->c3), k1);
+  x->c1 = lo1;
+  x->c3 = lo0;
+}
+
+// 4x4 transpose back to block order.
+void StorePhiloxBlocks(const PhiloxLanes& x, uint32_t* dst) {
+  const __m128i t0 = _mm_unpacklo_epi32(x.c0, x.c1);
+  const __m128i t1 = _mm_unpacklo_epi32(x.c2, x.c3);
+  const __m128i t2 = _mm_unpackhi_epi32(x.c0, x.c1);
+  const __m128i t3 = _mm_unpackhi_epi32(x.c2, x.c3);
+  __m128i* out = reinterpret_cast<__m128i*>(dst);
+  _mm_storeu_si128(out, _mm_unpacklo_epi64(t0, t1));
+  _mm_storeu_si128(out + 1, _mm_unpackhi_epi64(t0, t1));
+  _mm_storeu_si128(out + 2, _mm_unpacklo_epi64(t2, t3));
+  _mm_storeu_si128(out + 3, _mm_unpackhi_epi64(t2, t3));
+}
+
+// Eight blocks at a time, one per lane of two independent sets of vectors so that the latency of
+// the multiplications of one set is hidden behind the other.
+void Philox4x32(const uint32_t* key, uint64_t block, uint32_t* dst, std::size_t blocks) {
+  const __m128i m0 = _mm_set1_epi32(static_cast<int>(scalar::kPhiloxM0));
+  const __m128i m1 = _mm_set1_epi32(static_cast<int>(scalar::kPhiloxM1));
+  const __m128i w0 = _mm_set1_epi32(static_cast<int>(scalar::kPhiloxW0));
+  const __m128i w1 = _mm_set1_epi32(static_cast<int>(scalar::kPhiloxW1));
+  std::size_t b = 0;
+  for (; b + 8 <= blocks; b += 8) {
+    PhiloxLanes x = PhiloxCounters(block + b);
+    PhiloxLanes y = PhiloxCounters(block + b + 4);
+    __m128i k0 = _mm_set1_epi32(static_cast<int>(key[0]));
+    __m128i k1 = _mm_set1_epi32(static_cast<int>(key[1]));
+    for (int round = 0; round < scalar::kPhiloxRounds; ++round) {
+      PhiloxRound(&x, m0, m1, k0, k1);
+      PhiloxRound(&y, m0, m1, k0, k1);
+      k0 = _mm_add_epi32(k0, w0);
+      k1 = _mm_add_epi32(k1, w1);
+    }
+    StorePhiloxBlocks(x, dst + 4 * b);
+    StorePhiloxBlocks(y, dst + 4 * b + 16);
+  }
+  scalar::Philox4x32(key, block + b, dst + 4 * b, blocks - b);
+}
+
+// Per pixel, the two source rows are widened to 16 bits with the right neighbour interleaved
+// next to each channel, so that one pmaddwd per row applies both horizontal weights.
+void RemapLinearU8x4(const uint8_t* src, std::size_t step, const int32_t* origin,
+                     const uint16_t* fraction, const int16_t* table, uint8_t* dst, std::size_t n) {
+  const __m128i round = _mm_set1_epi32(1 << 13);
+  for (std::size_t i = 0; i < n; ++i) {
+    const uint8_t* p0 = src + origin[2 * i + 1] * step + origin[2 * i] * 4;
+    const int16_t* w = table + 4 * fraction[i];
+    const __m128i top = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p0)));
+    const __m128i bottom =
+        _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p0 + step)));
+    // [a0 b0 a1 b1 a2 b2 a3 b3]: left and right pixel of each channel side by side
+    const __m128i top_pairs = _mm_unpacklo_epi16(top, _mm_srli_si128(top, 8));
+    const __m128i bottom_pairs = _mm_unpacklo_epi16(bottom, _mm_srli_si128(bottom, 8));
+    const __m128i w_top = _mm_set1_epi32(static_cast<int>(static_cast<uint16_t>(w[0]) |
+                                                          static_cast<uint32_t>(w[1]) << 16));
+    const __m128i w_bottom = _mm_set1_epi32(static_cast<int>(static_cast<uint16_t>(w[2]) |
+                                                             static_cast<uint32_t>(w[3]) << 16));
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(top_pairs, w_top),
+                                _mm_madd_epi16(bottom_pairs, w_bottom));
+    sum = _mm_srai_epi32(_mm_add_epi32(sum, round), 14);
+    const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(sum, sum), sum);
+    const int pixel = _mm_cvtsi128_si32(packed);
+    std::memcpy(dst + 4 * i, &pixel, 4);
+  }
+}
+
+}  // namespace
+
+bool InitMatKernelsSSE4(MatKernels* kernels) {
+  kernels->add_f32 = AddF32;
+  kernels->sub_f32 = SubF32;
+  kernels->mul_f32 = MulF32;
+  kernels->min_f32 = MinF32;
+  kernels->max_f32 = MaxF32;
+  kernels->absdiff_f32 = AbsDiffF32;
+
+  kernels->add_u8 = AddU8;
+  kernels->sub_u8 = SubU8;
+  kernels->mul_u8 = MulU8;
+  kernels->min_u8 = MinU8;
+  kernels->max_u8 = MaxU8;
+  kernels->absdiff_u8 = AbsDiffU8;
+
+  kernels->scale_f32 = ScaleF32;
+  kernels->convert_u8_f32 = ConvertU8F32;
+  kernels->convert_f32_u8 = ConvertF32U8;
+
+  kernels->filter_f32 = FilterF32;
+
+  kernels->deinterleave_u8x4 = DeinterleaveU8x4;
+  kernels->interleave_u8x4 = InterleaveU8x4;
+  kernels->deinterleave_f32x3 = DeinterleaveF32x3;
+  kernels->interleave_f32x3 = InterleaveF32x3;
+  kernels->moments_f32 = MomentsF32;
+  kernels->sum_u8 = SumU8;
+  kernels->minmax_f32 = MinMaxF32;
+  kernels->minmax_u8 = MinMaxU8;
+  kernels->philox4x32 = Philox4x32;
+  kernels->remap_linear_u8x4 = RemapLinearU8x4;
+  return true;
+}
+
+}  // namespace detail
+}  // namespace core
+
+#else
+
+namespace core {
+namespace detail {
+
+bool InitMatKernelsSSE4(MatKernels*) { return false; }
+
+}  // namespace detail
+}  // namespace core
+
+#endif  // __SSE4_1__
@@ -0,0 +1,44 @@
+#include "MatKernels.h"
+#include "MatKernelsScalar.h"
+
+namespace core {
+namespace detail {
+
+void InitMatKernelsScalar(MatKernels* kernels) {
+  kernels->add_f32 = scalar::AddF32;
+  kernels->sub_f32 = scalar::SubF32;
+  kernels->mul_f32 = scalar::MulF32;
+  kernels->min_f32 = scalar::MinF32;
+  kernels->max_f32 = scalar::MaxF32;
+  kernels->absdiff_f32 = scalar::AbsDiffF32;
+
+  kernels->add_u8 = scalar::AddU8;
+  kernels->sub_u8 = scalar::SubU8;
+  kernels->mul_u8 = scalar::MulU8;
+  kernels->min_u8 = scalar::MinU8;
+  kernels->max_u8 = scalar::MaxU8;
+  kernels->absdiff_u8 = scalar::AbsDiffU8;
+
+  kernels->scale_f32 = scalar::ScaleF32;
+  kernels->convert_u8_f32 = scalar::ConvertU8F32;
+  kernels->convert_f32_u8 = scalar::ConvertF32U8;
+
+  kernels->filter_f32 = scalar::FilterF32;
+
+  kernels->deinterleave_u8x4 = scalar::DeinterleaveU8x4;
+  kernels->interleave_u8x4 = scalar::InterleaveU8x4;
+  kernels->deinterleave_f32x3 = scalar::DeinterleaveF32x3;
+  kernels->interleave_f32x3 = scalar::InterleaveF32x3;
+
+  kernels->moments_f32 = scalar::MomentsF32;
+  kernels->sum_u8 = scalar::SumU8;
+  kernels->minmax_f32 = scalar::MinMaxF32;
+  kernels->minmax_u8 = scalar::MinMaxU8;
+
+  kernels->philox4x32 = scalar::Philox4x32;
+
+  kernels->remap_linear_u8x4 = scalar::RemapLinearU8x4;
+}
+
+}  // namespace detail
+}  // namespace core
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace core {
+namespace detail {
+namespace scalar {
+
+// Scalar reference kernels. They define the exact results the SIMD paths must reproduce and
+// serve as the tail loops of those paths. They are static so that each kernel translation unit,
+// built with its own -m flags, keeps a private copy instead of sharing an ODR-merged one that may
+// have been compiled for a wider instruction set. For the same reason no std:: templates are used.
+
+static inline uint8_t SaturateU8(int v) {
+  return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline uint8_t SaturateU8(float v) {
+  // Clamp before rounding so out-of-range values saturate like the SIMD pack instructions.
+  v = v > 0.0f ? v : 0.0f;
+  v = v < 255.0f ? v : 255.0f;
+  return static_cast<uint8_t>(std::lrint(v));
+}
+
+static inline void AddF32(const float* a, const float* b, float* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] + b[i];
+}
+
+static inline void SubF32(const float* a, const float* b, float* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] - b[i];
+}
+
+static inline void MulF32(const float* a, const float* b, float* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] * b[i];
+}
+
+static inline void MinF32(const float* a, const float* b, float* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] < b[i] ? a[i] : b[i];
+}
+
+static inline void MaxF32(const float* a, const float* b, float* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+static inline void AbsDiffF32(const float* a, const float* b, float* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = std::fabs(a[i] - b[i]);
+}
+
+static inline void AddU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = SaturateU8(a[i] + b[i]);
+}
+
+static inline void SubU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = SaturateU8(a[i] - b[i]);
+}
+
+static inline void MulU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = SaturateU8(a[i] * b[i]);
+}
+
+static inline void MinU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] < b[i] ? a[i] : b[i];
+}
+
+static inline void MaxU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+static inline void AbsDiffU8(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = static_cast<uint8_t>(std::abs(a[i] - b[i]));
+}
+
+static inline void ScaleF32(const float* src, float* dst, std::size_t n, float scale,
+                             float offset) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = src[i] * scale + offset;
+}
+
+static inline void ConvertU8F32(const uint8_t* src, float* dst, std::size_t n, float scale,
+                                float offset) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = static_cast<float>(src[i]) * scale + offset;
+}
+
+static inline void ConvertF32U8(const float* src, uint8_t* dst, std::size_t n, float scale,
+                                float offset) {
+  for (std::size_t i = 0; i < n; ++i) dst[i] = SaturateU8(src[i] * scale + offset);
+}
+
+// Computes dst[i] for i in [begin, end); SIMD paths use it for their tails.
+static inline void FilterF32Range(const float* const* rows, int kernel_rows, const float* kernel,
+                                  int kernel_cols, int stride, float* dst, std::size_t begin,
+                                  std::size_t end) {
+  for (std::size_t i = begin; i < end; ++i) {
+    float acc = 0.0f;
+    for (int j = 0; j < kernel_rows; ++j) {
+      const float* src = rows[j] + i;
+      const float* k = kernel + j * kernel_cols;
+      for (int x = 0; x < kernel_cols; ++x) acc = acc + k[x] * src[x * stride];
+    }
+    dst[i] = acc;
+  }
+}
+
+static inline void FilterF32(const float* const* rows, int kernel_rows, const float* kernel,
+                             int kernel_cols, int stride, float* dst, std::size_t n) {
+  FilterF32Range(rows, kernel_rows, kernel, kernel_cols, stride, dst, 0, n);
+}
+
+static inline void DeinterleaveU8x4(const uint8_t* src, uint8_t* const* planes, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    planes[0][i] = src[4 * i];
+    planes[1][i] = src[4 * i + 1];
+    planes[2][i] = src[4 * i + 2];
+    planes[3][i] = src[4 * i + 3];
+  }
+}
+
+static inline void InterleaveU8x4(const uint8_t* const* planes, uint8_t* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    dst[4 * i] = planes[0][i];
+    dst[4 * i + 1] = planes[1][i];
+    dst[4 * i + 2] = planes[2][i];
+    dst[4 * i + 3] = planes[3][i];
+  }
+}
+
+static inline void DeinterleaveF32x3(const float* src, float* const* planes, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    planes[0][i] = src[3 * i];
+    planes[1][i] = src[3 * i + 1];
+    planes[2][i] = src[3 * i + 2];
+  }
+}
+
+static inline void InterleaveF32x3(const float* const* planes, float* dst, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    dst[3 * i] = planes[0][i];
+    dst[3 * i + 1] = planes[1][i];
+    dst[3 * i + 2] = planes[2][i];
+  }
+}
+
+static inline void MomentsF32(const float* src, std::size_t n, int channels, const float* shift,
+                              double* sum, double* sqsum) {
+  for (std::size_t i = 0; i < n; i += channels) {
+    for (int ch = 0; ch < channels; ++ch) {
+      const double v = static_cast<double>(src[i + ch] - shift[ch]);
+      sum[ch] += v;
+      if (sqsum != nullptr) sqsum[ch] += v * v;
+    }
+  }
+}
+
+static inline void SumU8(const uint8_t* src, std::size_t n, int channels, uint64_t* sum) {
+  for (std::size_t i = 0; i < n; i += channels) {
+    for (int ch = 0; ch < channels; ++ch) sum[ch] += src[i + ch];
+  }
+}
+
+static inline void MinMaxF32(const float* src, std::size_t n, int channels, float* min,
+                             float* max) {
+  for (std::size_t i = 0; i < n; i += channels) {
+    for (int ch = 0; ch < channels; ++ch) {
+      const float v = src[i + ch];
+      min[ch] = v < min[ch] ? v : min[ch];
+      max[ch] = v > max[ch] ? v : max[ch];
+    }
+  }
+}
+
+static inline void MinMaxU8(const uint8_t* src, std::size_t n, int channels, uint8_t* min,
+                            uint8_t* max) {
+  for (std::size_t i = 0; i < n; i += channels) {
+    for (int ch = 0; ch < channels; ++ch) {
+      const uint8_t v = src[i + ch];
+      min[ch] = v < min[ch] ? v : min[ch];
+      max[ch] = v > max[ch] ? v : max[ch];
+    }
+  }
+}
+
+// Philox4x32-10 constants (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+static constexpr uint32_t kPhiloxM0 = 0xD2511F53u;
+static constexpr uint32_t kPhiloxM1 = 0xCD9E8D57u;
+static constexpr uint32_t kPhiloxW0 = 0x9E3779B9u;
+static constexpr uint32_t kPhiloxW1 = 0xBB67AE85u;
+static constexpr int kPhiloxRounds = 10;
+
+static inline void Philox4x32Block(const uint32_t* key, uint64_t counter, uint32_t* out) {
+  uint32_t c0 = static_cast<uint32_t>(counter);
+  uint32_t c1 = static_cast<uint32_t>(counter >> 32);
+  uint32_t c2 = 0;
+  uint32_t c3 = 0;
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  for (int round = 0; round < kPhiloxRounds; ++round) {
+    const uint64_t p0 = static_cast<uint64_t>(kPhiloxM0) * c0;
+    const uint64_t p1 = static_cast<uint64_t>(kPhiloxM1) * c2;
+    const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c1 = static_cast<uint32_t>(p1);
+    c3 = static_cast<uint32_t>(p0);
+    c0 = n0;
+    c2 = n2;
+    k0 += kPhiloxW0;
+    k1 += kPhiloxW1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+static inline void Philox4x32(const uint32_t* key, uint64_t block, uint32_t* dst,
+                              std::size_t blocks) {
+  for (std::size_t b = 0; b < blocks; ++b) Philox4x32Block(key, block + b, dst + 4 * b);
+}
+
+static inline void RemapLinearU8x4(const uint8_t* src, std::size_t step, const int32_t* origin,
+                                   const uint16_t* fraction, const int16_t* table, uint8_t* dst,
+                                   std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    const uint8_t* p0 = src + origin[2 * i + 1] * step + origin[2 * i] * 4;
+    const uint8_t* p1 = p0 + step;
+    const int16_t* w = table + 4 * fraction[i];
+    for (int ch = 0; ch < 4; ++ch) {
+      const int sum = w[0] * p0[ch] + w[1] * p0[4 + ch] + w[2] * p1[ch] + w[3] * p1[4 + ch];
+      dst[4 * i + ch] = static_cast<uint8_t>((sum + (1 << 13)) >> 14);
+    }
+  }
+}
+
+}  // namespace scalar
+}  // namespace detail
+}  // namespace core
@@ -0,0 +1,141 @@
+#include "MatOps.h"
+
+#include <atomic>
+
+#include "MatKernels.h"
+
+namespace core {
+namespace {
+
+struct KernelRegistry {
+  KernelRegistry() {
+    for (auto& table : tables) detail::InitMatKernelsScalar(&table);
+    supported[static_cast<int>(SimdIsa::Scalar)] = true;
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+      supported[static_cast<int>(SimdIsa::SSE4)] =
+          detail::InitMatKernelsSSE4(&tables[static_cast<int>(SimdIsa::SSE4)]);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      // SSE4 first so that entries without an AVX2 version still get the next best kernel
+      detail::InitMatKernelsSSE4(&tables[static_cast<int>(SimdIsa::AVX2)]);
+      supported[static_cast<int>(SimdIsa::AVX2)] =
+          detail::InitMatKernelsAVX2(&tables[static_cast<int>(SimdIsa::AVX2)]);
+    }
+#endif
+    supported[static_cast<int>(SimdIsa::NEON)] =
+        detail::InitMatKernelsNEON(&tables[static_cast<int>(SimdIsa::NEON)]);
+
+    for (SimdIsa isa : {SimdIsa::SSE4, SimdIsa::AVX2, SimdIsa::NEON}) {
+      if (supported[static_cast<int>(isa)]) current.store(&tables[static_cast<int>(isa)]);
+    }
+  }
+
+  static constexpr int kIsaCount = 4;
+  detail::MatKernels tables[kIsaCount];
+  bool supported[kIsaCount] = {};
+  std::atomic<const detail::MatKernels*> current{&tables[0]};
+};
+
+KernelRegistry& Registry() {
+  static KernelRegistry registry;
+  return registry;
+}
+
+}  // namespace
+
+SimdIsa GetSimdIsa() {
+  KernelRegistry& registry = Registry();
+  return static_cast<SimdIsa>(registry.current.load() - registry.tables);
+}
+
+bool SetSimdIsa(SimdIsa isa) {
+  KernelRegistry& registry = Registry();
+  const int index = static_cast<int>(isa);
+  if (index < 0 || index >= KernelRegistry::kIsaCount || !registry.supported[index]) return false;
+  registry.current.store(&registry.tables[index]);
+  return true;
+}
+
+const char* SimdIsaName(SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::Scalar:
+      return "scalar";
+    case SimdIsa::SSE4:
+      return "sse4.1";
+    case SimdIsa::AVX2:
+      return "avx2";
+    case SimdIsa::NEON:
+      return "neon";
+  }
+  return "unknown";
+}
+
+namespace detail {
+
+const MatKernels& GetMatKernels() { return *Registry().current.load(std::memory_order_relaxed); }
+
+void Add(const float* a, const float* b, float* dst, std::size_t n) {
+  GetMatKernels().add_f32(a, b, dst, n);
+}
+
+void Sub(const float* a, const float* b, float* dst, std::size_t n) {
+  GetMatKernels().sub_f32(a, b, dst, n);
+}
+
+void Mul(const float* a, const float* b, float* dst, std::size_t n) {
+  GetMatKernels().mul_f32(a, b, dst, n);
+}
+
+void Min(const float* a, const float* b, float* dst, std::size_t n) {
+  GetMatKernels().min_f32(a, b, dst, n);
+}
+
+void Max(const float* a, const float* b, float* dst, std::size_t n) {
+  GetMatKernels().max_f32(a, b, dst, n);
+}
+
+void AbsDiff(const float* a, const float* b, float* dst, std::size_t n) {
+  GetMatKernels().absdiff_f32(a, b, dst, n);
+}
+
+void Add(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  GetMatKernels().add_u8(a, b, dst, n);
+}
+
+void Sub(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  GetMatKernels().sub_u8(a, b, dst, n);
+}
+
+void Mul(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  GetMatKernels().mul_u8(a, b, dst, n);
+}
+
+void Min(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  GetMatKernels().min_u8(a, b, dst, n);
+}
+
+void Max(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  GetMatKernels().max_u8(a, b, dst, n);
+}
+
+void AbsDiff(const uint8_t* a, const uint8_t* b, uint8_t* dst, std::size_t n) {
+  GetMatKernels().absdiff_u8(a, b, dst, n);
+}
+
+void Convert(const float* src, float* dst, std::size_t n, float scale, float offset) {
+  GetMatKernels().scale_f32(src, dst, n, scale, offset);
+}
+
+void Convert(const uint8_t* src, float* dst, std::size_t n, float scale, float offset) {
+  GetMatKernels().convert_u8_f32(src, dst, n, scale, offset);
+}
+
+void Convert(const float* src, uint8_t* dst, std::size_t n, float scale, float offset) {
+  GetMatKernels().convert_f32_u8(src, dst, n, scale, offset);
+}
+
+}  // namespace detail
+}  // namespace core
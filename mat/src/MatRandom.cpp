@@ -0,0 +1,66 @@
+#include "MatRandom.h"
+
+#include <algorithm>
+
+#include "MatKernels.h"
+#include "ThreadPool.h"
+
+namespace core {
+namespace {
+
+// Elements per band when filling on a pool. Any split gives the same values; this one only keeps
+// the tasks large enough to amortize submitting them.
+constexpr std::size_t kBandElements = std::size_t(1) << 18;
+
+}  // namespace
+
+std::array<std::uint32_t, 4> Philox4x32::operator()(std::uint64_t n) const {
+  std::array<std::uint32_t, 4> block;
+  detail::GetMatKernels().philox4x32(key_, n, block.data(), 1);
+  return block;
+}
+
+void Philox4x32::Generate(std::uint64_t first, std::uint32_t* dst, std::size_t n) const {
+  const detail::MatKernels& kernels = detail::GetMatKernels();
+  std::uint32_t block[4];
+  // Partial first block
+  const std::size_t skip = first % 4;
+  if (skip != 0 && n != 0) {
+    kernels.philox4x32(key_, first / 4, block, 1);
+    const std::size_t m = std::min(n, 4 - skip);
+    std::copy_n(block + skip, m, dst);
+    first += m;
+    dst += m;
+    n -= m;
+  }
+  kernels.philox4x32(key_, first / 4, dst, n / 4);
+  // Partial last block
+  if (n % 4 != 0) {
+    kernels.philox4x32(key_, first / 4 + n / 4, block, 1);
+    std::copy_n(block, n % 4, dst + n / 4 * 4);
+  }
+}
+
+namespace detail {
+
+void RandomRows(void* data, std::size_t step, int rows, std::size_t row_elements,
+                const Philox4x32& gen, RandomSpanFn fill, ThreadPool* pool) {
+  auto fill_rows = [=, &gen](int y0, int y1) {
+    for (int r = y0; r < y1; ++r) {
+      fill(static_cast<std::uint8_t*>(data) + r * step, row_elements, gen,
+           static_cast<std::uint64_t>(r) * row_elements);
+    }
+  };
+  const int band_rows = static_cast<int>(
+      std::max<std::size_t>(1, kBandElements / std::max<std::size_t>(1, row_elements)));
+  if (pool == nullptr || band_rows >= rows) {
+    fill_rows(0, rows);
+    return;
+  }
+  pool->parallel_for(0, rows, band_rows, [&](std::size_t y0, std::size_t y1) {
+    fill_rows(static_cast<int>(y0), static_cast<int>(y1));
+  });
+}
+
+}  // namespace detail
+}  // namespace core
@@ -0,0 +1,273 @@
+#include "MatReduce.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "MatKernels.h"
+#include "ThreadPool.h"
+
+namespace core {
+namespace {
+
+// Elements per band. Bands are cut from the image size only, never from the pool size, so that
+// the partial results and the order they are combined in do not depend on the thread count.
+constexpr std::size_t kBandElements = std::size_t(1) << 18;
+
+constexpr int kMaxChannels = 4;
+
+struct Band {
+  int y0;
+  int y1;
+};
+
+std::vector<Band> SplitBands(const detail::ReduceImage& image) {
+  const std::size_t row_elements = static_cast<std::size_t>(image.cols) * image.channels;
+  const int band_rows = static_cast<int>(
+      std::max<std::size_t>(1, kBandElements / std::max<std::size_t>(1, row_elements)));
+  std::vector<Band> bands;
+  for (int y0 = 0; y0 < image.rows; y0 += band_rows) {
+    bands.push_back({y0, std::min(y0 + band_rows, image.rows)});
+  }
+  return bands;
+}
+
+// Runs fn(band, partial) over every band, on pool when given, and returns the partials in band
+// order.
+template <typename Partial, typename Fn>
+std::vector<Partial> RunBands(const detail::ReduceImage& image, ThreadPool* pool, Fn&& fn) {
+  const std::vector<Band> bands = SplitBands(image);
+  std::vector<Partial> partials(bands.size());
+  if (pool == nullptr || bands.size() == 1) {
+    for (std::size_t i = 0; i < bands.size(); ++i) fn(bands[i], partials[i]);
+    return partials;
+  }
+  pool->parallel_for(0, bands.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) fn(bands[i], partials[i]);
+  });
+  return partials;
+}
+
+template <typename T>
+const T* Row(const detail::ReduceImage& image, int r) {
+  return reinterpret_cast<const T*>(static_cast<const std::uint8_t*>(image.data) +
+                                    r * image.step);
+}
+
+// Calls fn(span, n) over rows [y0, y1) as one span when they are contiguous, row by row otherwise.
+template <typename T, typename Fn>
+void ForEachSpan(const detail::ReduceImage& image, int y0, int y1, Fn&& fn) {
+  const std::size_t row_elements = static_cast<std::size_t>(image.cols) * image.channels;
+  if (image.step == row_elements * sizeof(T)) {
+    fn(Row<T>(image, y0), row_elements * (y1 - y0));
+    return;
+  }
+  for (int r = y0; r < y1; ++r) fn(Row<T>(image, r), row_elements);
+}
+
+struct Moments {
+  double sum[kMaxChannels] = {};
+  double sqsum[kMaxChannels] = {};
+};
+
+// Per channel sum of (x - shift) and, when squares is set, of (x - shift)^2.
+Moments MomentsF32(const detail::ReduceImage& image, const float* shift, bool squares,
+                   ThreadPool* pool) {
+  const detail::MatKernels& kernels = detail::GetMatKernels();
+  const std::vector<Moments> partials =
+      RunBands<Moments>(image, pool, [&](const Band& band, Moments& partial) {
+        ForEachSpan<float>(image, band.y0, band.y1, [&](const float* src, std::size_t n) {
+          kernels.moments_f32(src, n, image.channels, shift, partial.sum,
+                              squares ? partial.sqsum : nullptr);
+        });
+      });
+  Moments total;
+  for (const Moments& partial : partials) {
+    for (int ch = 0; ch < image.channels; ++ch) {
+      total.sum[ch] += partial.sum[ch];
+      total.sqsum[ch] += partial.sqsum[ch];
+    }
+  }
+  return total;
+}
+
+// Extrema of a band and the first row they were seen in.
+template <typename T>
+struct Extrema {
+  T min[kMaxChannels];
+  T max[kMaxChannels];
+  int min_row[kMaxChannels];
+  int max_row[kMaxChannels];
+};
+
+template <typename T, typename Kernel>
+void MinMax(const detail::ReduceImage& image, Kernel kernel, MinMaxLoc* result, ThreadPool* pool) {
+  const int channels = image.channels;
+  const std::size_t row_elements = static_cast<std::size_t>(image.cols) * channels;
+  // Row by row: the kernel finds the extrema of a row, the row of the first strict improvement is
+  // kept and only that row is scanned again for the column at the end.
+  const std::vector<Extrema<T>> partials =
+      RunBands<Extrema<T>>(image, pool, [&](const Band& band, Extrema<T>& partial) {
+        const T* first = Row<T>(image, band.y0);
+        for (int ch = 0; ch < channels; ++ch) {
+          partial.min[ch] = partial.max[ch] = first[ch];
+          partial.min_row[ch] = partial.max_row[ch] = band.y0;
+        }
+        for (int r = band.y0; r < band.y1; ++r) {
+          T row_min[kMaxChannels];
+          T row_max[kMaxChannels];
+          std::copy(partial.min, partial.min + channels, row_min);
+          std::copy(partial.max, partial.max + channels, row_max);
+          kernel(Row<T>(image, r), row_elements, channels, row_min, row_max);
+          for (int ch = 0; ch < channels; ++ch) {
+            if (row_min[ch] < partial.min[ch]) {
+              partial.min[ch] = row_min[ch];
+              partial.min_row[ch] = r;
+            }
+            if (row_max[ch] > partial.max[ch]) {
+              partial.max[ch] = row_max[ch];
+              partial.max_row[ch] = r;
+            }
+          }
+        }
+      });
+
+  Extrema<T> total = partials[0];
+  for (std::size_t i = 1; i < partials.size(); ++i) {
+    for (int ch = 0; ch < channels; ++ch) {
+      if (partials[i].min[ch] < total.min[ch]) {
+        total.min[ch] = partials[i].min[ch];
+        total.min_row[ch] = partials[i].min_row[ch];
+      }
+      if (partials[i].max[ch] > total.max[ch]) {
+        total.max[ch] = partials[i].max[ch];
+        total.max_row[ch] = partials[i].max_row[ch];
+      }
+    }
+  }
+  for (int ch = 0; ch < channels; ++ch) {
+    const T* min_row = Row<T>(image, total.min_row[ch]);
+    const T* max_row = Row<T>(image, total.max_row[ch]);
+    int min_x = 0;
+    int max_x = 0;
+    while (min_row[min_x * channels + ch] != total.min[ch]) ++min_x;
+    while (max_row[max_x * channels + ch] != total.max[ch]) ++max_x;
+    result[ch] = {static_cast<double>(total.min[ch]),
+                  static_cast<double>(total.max[ch]),
+                  min_x,
+                  total.min_row[ch],
+                  max_x,
+                  total.max_row[ch]};
+  }
+}
+
+}  // namespace
+
+namespace detail {
+
+void SumF32(const ReduceImage& image, double* sum, ThreadPool* pool) {
+  const float shift[kMaxChannels] = {};
+  const Moments moments = MomentsF32(image, shift, false, pool);
+  for (int ch = 0; ch < image.channels; ++ch) sum[ch] = moments.sum[ch];
+}
+
+void SumU8(const ReduceImage& image, double* sum, ThreadPool* pool) {
+  struct Sums {
+    std::uint64_t sum[kMaxChannels] = {};
+  };
+  const MatKernels& kernels = GetMatKernels();
+  const std::vector<Sums> partials = RunBands<Sums>(image, pool, [&](const Band& band, Sums& p) {
+    ForEachSpan<std::uint8_t>(image, band.y0, band.y1, [&](const std::uint8_t* src, std::size_t n) {
+      kernels.sum_u8(src, n, image.channels, p.sum);
+    });
+  });
+  std::uint64_t total[kMaxChannels] = {};
+  for (const Sums& partial : partials) {
+    for (int ch = 0; ch < image.channels; ++ch) total[ch] += partial.sum[ch];
+  }
+  for (int ch = 0; ch < image.channels; ++ch) sum[ch] = static_cast<double>(total[ch]);
+}
+
+void MinMaxF32(const ReduceImage& image, MinMaxLoc* result, ThreadPool* pool) {
+  MinMax<float>(image, GetMatKernels().minmax_f32, result, pool);
+}
+
+void MinMaxU8(const ReduceImage& image, MinMaxLoc* result, ThreadPool* pool) {
+  MinMax<std::uint8_t>(image, GetMatKernels().minmax_u8, result, pool);
+}
+
+void MeanStdDevF32(const ReduceImage& image, double* mean, double* stddev, ThreadPool* pool) {
+  // Shifting by a sample brings the data close to zero mean, which keeps the single pass
+  // variance S2/N - (S1/N)^2 free of catastrophic cancellation.
+  const float* shift = Row<float>(image, 0);
+  const Moments moments = MomentsF32(image, shift, true, pool);
+  const double count = static_cast<double>(image.rows) * image.cols;
+  for (int ch = 0; ch < image.channels; ++ch) {
+    const double m = moments.sum[ch] / count;
+    mean[ch] = shift[ch] + m;
+    stddev[ch] = std::sqrt(std::max(0.0, moments.sqsum[ch] / count - m * m));
+  }
+}
+
+void HistogramU8(const ReduceImage& image, std::uint64_t* hist, ThreadPool* pool) {
+  const int channels = image.channels;
+  const std::vector<std::vector<std::uint64_t>> partials = RunBands<std::vector<std::uint64_t>>(
+      image, pool, [&](const Band& band, std::vector<std::uint64_t>& partial) {
+        partial.assign(static_cast<std::size_t>(channels) * 256, 0);
+        if (channels > 1) {
+          ForEachSpan<std::uint8_t>(
+              image, band.y0, band.y1, [&](const std::uint8_t* src, std::size_t n) {
+                for (std::size_t i = 0; i < n; i += channels) {
+                  for (int ch = 0; ch < channels; ++ch) ++partial[ch * 256 + src[i + ch]];
+                }
+              });
+          return;
+        }
+        // Four sub-tables break the store-to-load dependency on runs of equal pixels. A band
+        // holds fewer than 2^32 pixels, so 32-bit counters do.
+        std::uint32_t sub[4][256] = {};
+        ForEachSpan<std::uint8_t>(
+            image, band.y0, band.y1, [&](const std::uint8_t* src, std::size_t n) {
+              std::size_t i = 0;
+              for (; i + 4 <= n; i += 4) {
+                ++sub[0][src[i]];
+                ++sub[1][src[i + 1]];
+                ++sub[2][src[i + 2]];
+                ++sub[3][src[i + 3]];
+              }
+              for (; i < n; ++i) ++sub[0][src[i]];
+            });
+        for (int v = 0; v < 256; ++v) {
+          partial[v] = std::uint64_t(sub[0][v]) + sub[1][v] + sub[2][v] + sub[3][v];
+        }
+      });
+  for (const std::vector<std::uint64_t>& partial : partials) {
+    for (std::size_t i = 0; i < partial.size(); ++i) hist[i] += partial[i];
+  }
+}
+
+void HistogramF32(const ReduceImage& image, int bins, float lo, float hi, std::uint64_t* hist,
+                  ThreadPool* pool) {
+  const int channels = image.channels;
+  const double scale = bins / (static_cast<double>(hi) - lo);
+  const std::vector<std::vector<std::uint64_t>> partials = RunBands<std::vector<std::uint64_t>>(
+      image, pool, [&](const Band& band, std::vector<std::uint64_t>& partial) {
+        partial.assign(static_cast<std::size_t>(channels) * bins, 0);
+        ForEachSpan<float>(image, band.y0, band.y1, [&](const float* src, std::size_t n) {
+          for (std::size_t i = 0; i < n; i += channels) {
+            for (int ch = 0; ch < channels; ++ch) {
+              const float v = src[i + ch];
+              if (!(v >= lo && v <= hi)) continue;  // also drops NaN
+              const int bin = std::min(bins - 1, static_cast<int>((v - lo) * scale));
+              ++partial[static_cast<std::size_t>(ch) * bins + bin];
+            }
+          }
+        });
+      });
+  for (const std::vector<std::uint64_t>& partial : partials) {
+    for (std::size_t i = 0; i < partial.size(); ++i) hist[i] += partial[i];
+  }
+}
+
+}  // namespace detail
+}  // namespace core
@@ -0,0 +1,600 @@
+#include "MatResample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "MatKernels.h"
+#include "ThreadPool.h"
+
+namespace core {
+namespace {
+
+constexpr int kSubpixels = RemapTable::kSubpixels;
+constexpr int kFractions = kSubpixels * kSubpixels;
+constexpr int kWeightBits = 14;
+constexpr int kWeightOne = 1 << kWeightBits;
+constexpr int kMinBandRows = 16;
+// Coordinates are clamped to this range before going to fixed point, which keeps x * kSubpixels
+// and the tap offsets inside int while leaving such pixels far outside any image.
+constexpr double kCoordinateLimit = 1 << 22;
+// Destination pixels per block of warp coordinates.
+constexpr int kWarpBlock = 256;
+
+int Taps(Interpolation interpolation) {
+  switch (interpolation) {
+    case Interpolation::Nearest:
+      return 1;
+    case Interpolation::Linear:
+      return 2;
+    case Interpolation::Cubic:
+      return 4;
+    case Interpolation::Area:
+      break;
+  }
+  throw std::invalid_argument("Resample: Interpolation::Area is only supported by Resize");
+}
+
+// Keys cubic convolution weights of the four taps around an offset t in [0, 1).
+void CubicWeights(double t, double* w) {
+  constexpr double a = -0.75;
+  const double t1 = t + 1.0;
+  const double u = 1.0 - t;
+  w[0] = ((a * t1 - 5.0 * a) * t1 + 8.0 * a) * t1 - 4.0 * a;
+  w[1] = ((a + 2.0) * t - (a + 3.0)) * t * t + 1.0;
+  w[2] = ((a + 2.0) * u - (a + 3.0)) * u * u + 1.0;
+  w[3] = 1.0 - w[0] - w[1] - w[2];
+}
+
+void AxisWeights(int taps, double t, double* w) {
+  if (taps == 2) {
+    w[0] = 1.0 - t;
+    w[1] = t;
+  } else {
+    CubicWeights(t, w);
+  }
+}
+
+// 2D interpolation weights of every fraction fy * kSubpixels + fx, taps x taps each, row-major.
+// The fixed-point ones are rounded to kWeightBits and corrected on their largest weight so that
+// they sum to exactly kWeightOne: constant images stay constant.
+struct WeightTables {
+  std::vector<float> linear;
+  std::vector<float> cubic;
+  std::vector<std::int16_t> linear_fixed;
+  std::vector<std::int16_t> cubic_fixed;
+
+  WeightTables() {
+    Build(2, linear, linear_fixed);
+    Build(4, cubic, cubic_fixed);
+  }
+
+  static void Build(int taps, std::vector<float>& weights, std::vector<std::int16_t>& fixed) {
+    const int n = taps * taps;
+    weights.resize(static_cast<std::size_t>(kFractions) * n);
+    fixed.resize(weights.size());
+    double wx[4];
+    double wy[4];
+    for (int f = 0; f < kFractions; ++f) {
+      AxisWeights(taps, static_cast<double>(f % kSubpixels) / kSubpixels, wx);
+      AxisWeights(taps, static_cast<double>(f / kSubpixels) / kSubpixels, wy);
+      float* w = weights.data() + f * n;
+      std::int16_t* q = fixed.data() + f * n;
+      int sum = 0;
+      int largest = 0;
+      for (int j = 0; j < taps; ++j) {
+        for (int k = 0; k < taps; ++k) {
+          const double v = wy[j] * wx[k];
+          w[j * taps + k] = static_cast<float>(v);
+          q[j * taps + k] = static_cast<std::int16_t>(std::lround(v * kWeightOne));
+          sum += q[j * taps + k];
+          if (q[j * taps + k] > q[largest]) largest = j * taps + k;
+        }
+      }
+      q[largest] = static_cast<std::int16_t>(q[largest] + kWeightOne - sum);
+    }
+  }
+};
+
+const WeightTables& GetWeightTables() {
+  static const WeightTables tables;
+  return tables;
+}
+
+// Weights of taps x taps samples for T: float for float images, fixed point for uint8_t.
+template <typename T, int K>
+const auto* Weights() {
+  const WeightTables& tables = GetWeightTables();
+  if constexpr (std::is_same_v<T, float>) {
+    return K == 2 ? tables.linear.data() : tables.cubic.data();
+  } else {
+    return K == 2 ? tables.linear_fixed.data() : tables.cubic_fixed.data();
+  }
+}
+
+// Fixed-point position of a source coordinate: origin of the taps x taps neighbourhood and the
+// sub-pixel fraction, or the closest pixel for a single tap.
+void ToFixedPoint(double x, double y, int taps, std::int32_t* origin, std::uint16_t* fraction) {
+  x = x >= -kCoordinateLimit ? std::min(x, kCoordinateLimit) : -kCoordinateLimit;  // and NaN
+  y = y >= -kCoordinateLimit ? std::min(y, kCoordinateLimit) : -kCoordinateLimit;
+  if (taps == 1) {
+    origin[0] = static_cast<std::int32_t>(std::floor(x + 0.5));
+    origin[1] = static_cast<std::int32_t>(std::floor(y + 0.5));
+    *fraction = 0;
+    return;
+  }
+  // Adding 1.5 * 2^52 rounds to the nearest integer (ties to even) in the low bits of the
+  // mantissa, without the libm call of lrint
+  constexpr double kRound = 0x1.8p52;
+  const auto ix = static_cast<std::int64_t>((x * kSubpixels + kRound) - kRound);
+  const auto iy = static_cast<std::int64_t>((y * kSubpixels + kRound) - kRound);
+  const int back = taps / 2 - 1;
+  origin[0] = static_cast<std::int32_t>((ix >> 5) - back);
+  origin[1] = static_cast<std::int32_t>((iy >> 5) - back);
+  *fraction = static_cast<std::uint16_t>((iy & (kSubpixels - 1)) * kSubpixels +
+                                         (ix & (kSubpixels - 1)));
+}
+static_assert(kSubpixels == 1 << 5, "ToFixedPoint shifts by log2(kSubpixels)");
+
+// Calls fn(y0, y1) over bands of rows [0, rows), on pool when given. The result of a row never
+// depends on the band it falls in.
+template <typename Fn>
+void RunBands(int rows, ThreadPool* pool, Fn&& fn) {
+  if (pool == nullptr || pool->size() <= 1 || rows <= kMinBandRows) {
+    fn(0, rows);
+    return;
+  }
+  const int wanted_bands = 4 * static_cast<int>(pool->size());
+  const int band_rows = std::max(kMinBandRows, (rows + wanted_bands - 1) / wanted_bands);
+  pool->parallel_for(0, rows, band_rows, [&](std::size_t y0, std::size_t y1) {
+    fn(static_cast<int>(y0), static_cast<int>(y1));
+  });
+}
+
+template <typename T>
+T* ImageRow(void* data, std::size_t step, int y) {
+  return reinterpret_cast<T*>(static_cast<std::uint8_t*>(data) +
+                              static_cast<std::size_t>(y) * step);
+}
+
+template <typename T>
+const T* ImageRow(const void* data, std::size_t step, int y) {
+  return reinterpret_cast<const T*>(static_cast<const std::uint8_t*>(data) +
+                                    static_cast<std::size_t>(y) * step);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Resize: separable, one horizontal pass per source row and one vertical pass per output row.
+
+// Source taps and weights of every output position along one axis.
+struct Axis {
+  int taps = 0;
+  std::vector<int> index;
+  std::vector<float> weight;
+};
+
+Axis BuildAxis(int src_size, int dst_size, Interpolation interpolation) {
+  const double scale = static_cast<double>(src_size) / dst_size;
+  if (interpolation == Interpolation::Area && scale <= 1.0) interpolation = Interpolation::Linear;
+  Axis axis;
+  if (interpolation == Interpolation::Area) {
+    axis.taps = static_cast<int>(std::ceil(scale)) + 1;
+  } else {
+    axis.taps = Taps(interpolation);
+  }
+  const int k = axis.taps;
+  axis.index.resize(static_cast<std::size_t>(dst_size) * k);
+  axis.weight.resize(axis.index.size());
+  double w[4];
+  for (int i = 0; i < dst_size; ++i) {
+    int* index = axis.index.data() + static_cast<std::size_t>(i) * k;
+    float* weight = axis.weight.data() + static_cast<std::size_t>(i) * k;
+    if (interpolation == Interpolation::Nearest) {
+      index[0] = std::min(static_cast<int>((i + 0.5) * scale), src_size - 1);
+      weight[0] = 1.0f;
+    } else if (interpolation == Interpolation::Area) {
+      // Overlap of [i, i + 1) * scale with every source pixel it touches
+      const double begin = i * scale;
+      const double end = begin + scale;
+      const int first = static_cast<int>(std::floor(begin));
+      for (int t = 0; t < k; ++t) {
+        const double overlap =
+            std::min<double>(first + t + 1, end) - std::max<double>(first + t, begin);
+        index[t] = std::min(first + t, src_size - 1);
+        weight[t] = static_cast<float>(std::max(0.0, overlap) / scale);
+      }
+    } else {
+      const double x = (i + 0.5) * scale - 0.5;
+      const double x0 = std::floor(x);
+      AxisWeights(k, x - x0, w);
+      for (int t = 0; t < k; ++t) {
+        index[t] = std::clamp(static_cast<int>(x0) - (k / 2 - 1) + t, 0, src_size - 1);
+        weight[t] = static_cast<float>(w[t]);
+      }
+    }
+  }
+  return axis;
+}
+
+// Horizontal pass of one source row into dst_cols * C floats.
+template <typename T, int C>
+void ResizeRow(const void* row, const Axis& axis, int dst_cols, float* out) {
+  const T* src = static_cast<const T*>(row);
+  const int k = axis.taps;
+  for (int x = 0; x < dst_cols; ++x) {
+    const int* index = axis.index.data() + static_cast<std::size_t>(x) * k;
+    const float* weight = axis.weight.data() + static_cast<std::size_t>(x) * k;
+    float acc[C] = {};
+    for (int t = 0; t < k; ++t) {
+      const T* p = src + index[t] * C;
+      for (int c = 0; c < C; ++c) acc[c] += weight[t] * static_cast<float>(p[c]);
+    }
+    for (int c = 0; c < C; ++c) out[x * C + c] = acc[c];
+  }
+}
+
+using ResizeRowFn = void (*)(const void* row, const Axis& axis, int dst_cols, float* out);
+
+template <typename T>
+ResizeRowFn SelectResizeRow(int channels) {
+  switch (channels) {
+    case 1:
+      return &ResizeRow<T, 1>;
+    case 2:
+      return &ResizeRow<T, 2>;
+    case 3:
+      return &ResizeRow<T, 3>;
+    default:
+      return &ResizeRow<T, 4>;
+  }
+}
+
+void ResizeNearest(const detail::ResampleImage& image, const Axis& ax, const Axis& ay, int y0,
+                   int y1) {
+  const std::size_t pixel = static_cast<std::size_t>(image.channels) *
+                            (image.is_float ? sizeof(float) : sizeof(std::uint8_t));
+  for (int y = y0; y < y1; ++y) {
+    const std::uint8_t* src = ImageRow<std::uint8_t>(image.src, image.src_step, ay.index[y]);
+    std::uint8_t* dst = ImageRow<std::uint8_t>(image.dst, image.dst_step, y);
+    for (int x = 0; x < image.dst_cols; ++x) {
+      std::memcpy(dst + x * pixel, src + ax.index[x] * pixel, pixel);
+    }
+  }
+}
+
+// Output rows [y0, y1) with a ring of ay.taps horizontally resized source rows: source row r
+// lives in slot r % taps, so consecutive output rows reuse the rows they share.
+void ResizeSeparable(const detail::ResampleImage& image, const Axis& ax, const Axis& ay,
+                     ResizeRowFn resize_row, int y0, int y1) {
+  const detail::MatKernels& kernels = detail::GetMatKernels();
+  const int k = ay.taps;
+  const std::size_t n = static_cast<std::size_t>(image.dst_cols) * image.channels;
+
+  thread_local std::vector<float> scratch;
+  thread_local std::vector<int> slot_row;
+  thread_local std::vector<const float*> window;
+  scratch.resize(n * (k + 1));
+  slot_row.assign(k, -1);
+  window.resize(k);
+  float* ring = scratch.data();
+  float* line = ring + n * k;
+
+  for (int y = y0; y < y1; ++y) {
+    const int* index = ay.index.data() + static_cast<std::size_t>(y) * k;
+    for (int t = 0; t < k; ++t) {
+      const int r = index[t];
+      float* slot = ring + (r % k) * n;
+      if (slot_row[r % k] != r) {
+        resize_row(ImageRow<void>(image.src, image.src_step, r), ax, image.dst_cols, slot);
+        slot_row[r % k] = r;
+      }
+      window[t] = slot;
+    }
+    const float* weight = ay.weight.data() + static_cast<std::size_t>(y) * k;
+    if (image.is_float) {
+      kernels.filter_f32(window.data(), k, weight, 1, 0,
+                         ImageRow<float>(image.dst, image.dst_step, y), n);
+    } else {
+      kernels.filter_f32(window.data(), k, weight, 1, 0, line, n);
+      kernels.convert_f32_u8(line, ImageRow<std::uint8_t>(image.dst, image.dst_step, y), n, 1.0f,
+                             0.0f);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Remap and warps: every destination pixel samples a K x K neighbourhood at a fixed-point
+// position.
+
+struct Source {
+  const std::uint8_t* data;
+  std::size_t step;
+  int rows;
+  int cols;
+  BorderMode border;
+  float border_value;
+};
+
+template <typename T, int K>
+bool Inside(const Source& src, int ox, int oy) {
+  return ox >= 0 && oy >= 0 && ox <= src.cols - K && oy <= src.rows - K;
+}
+
+template <typename T, int C>
+void StorePixel(const float* acc, T* out) {
+  for (int c = 0; c < C; ++c) out[c] = acc[c];
+}
+
+template <typename T, int C>
+void StorePixel(const int* acc, T* out) {
+  for (int c = 0; c < C; ++c) {
+    out[c] = static_cast<T>(std::clamp((acc[c] + (1 << (kWeightBits - 1))) >> kWeightBits, 0, 255));
+  }
+}
+
+template <typename T, int C, int K, typename W>
+void SamplePixel(const Source& src, int ox, int oy, const W* weights, T* out) {
+  const bool constant = src.border == BorderMode::Constant;
+  if constexpr (K == 1) {
+    if (!Inside<T, 1>(src, ox, oy)) {
+      if (constant) {
+        std::fill_n(out, C, static_cast<T>(src.border_value));
+        return;
+      }
+      ox = detail::BorderIndex(ox, src.cols, src.border);
+      oy = detail::BorderIndex(oy, src.rows, src.border);
+    }
+    std::memcpy(out, reinterpret_cast<const T*>(src.data + oy * src.step) + ox * C, C * sizeof(T));
+  } else {
+    using Acc = std::conditional_t<std::is_same_v<T, float>, float, int>;
+    Acc acc[C] = {};
+    if (Inside<T, K>(src, ox, oy)) {
+      for (int j = 0; j < K; ++j) {
+        const T* p = reinterpret_cast<const T*>(src.data + (oy + j) * src.step) + ox * C;
+        for (int k = 0; k < K; ++k) {
+          for (int c = 0; c < C; ++c) acc[c] += weights[j * K + k] * p[k * C + c];
+        }
+      }
+    } else {
+      const Acc border = static_cast<Acc>(src.border_value);
+      for (int j = 0; j < K; ++j) {
+        int sy = oy + j;
+        const bool row_outside = sy < 0 || sy >= src.rows;
+        if (row_outside && constant) {
+          for (int k = 0; k < K; ++k) {
+            for (int c = 0; c < C; ++c) acc[c] += weights[j * K + k] * border;
+          }
+          continue;
+        }
+        sy = detail::BorderIndex(sy, src.rows, src.border);
+        const T* row = reinterpret_cast<const T*>(src.data + sy * src.step);
+        for (int k = 0; k < K; ++k) {
+          int sx = ox + k;
+          if (sx < 0 || sx >= src.cols) {
+            if (constant) {
+              for (int c = 0; c < C; ++c) acc[c] += weights[j * K + k] * border;
+              continue;
+            }
+            sx = detail::BorderIndex(sx, src.cols, src.border);
+          }
+          for (int c = 0; c < C; ++c) acc[c] += weights[j * K + k] * row[sx * C + c];
+        }
+      }
+    }
+    StorePixel<T, C>(acc, out);
+  }
+}
+
+template <typename T, int C, int K>
+void SampleSpan(const Source& src, const std::int32_t* origin, const std::uint16_t* fraction,
+                int n, void* dst) {
+  T* out = static_cast<T*>(dst);
+  if constexpr (K == 1) {
+    for (int i = 0; i < n; ++i) {
+      SamplePixel<T, C, 1, float>(src, origin[2 * i], origin[2 * i + 1], nullptr, out + i * C);
+    }
+  } else {
+    const auto* weights = Weights<T, K>();
+    constexpr int kArea = K * K;
+    if constexpr (std::is_same_v<T, std::uint8_t> && C == 4 && K == 2) {
+      // Runs of pixels whose 2x2 neighbourhood is inside the image go to the SIMD kernel
+      const detail::MatKernels& kernels = detail::GetMatKernels();
+      int i = 0;
+      while (i < n) {
+        int j = i;
+        while (j < n && Inside<T, 2>(src, origin[2 * j], origin[2 * j + 1])) ++j;
+        if (j > i) {
+          kernels.remap_linear_u8x4(src.data, src.step, origin + 2 * i, fraction + i, weights,
+                                    out + 4 * i, j - i);
+        }
+        if (j < n) {
+          SamplePixel<T, C, K>(src, origin[2 * j], origin[2 * j + 1],
+                               weights + fraction[j] * kArea, out + 4 * j);
+        }
+        i = j + 1;
+      }
+    } else {
+      for (int i = 0; i < n; ++i) {
+        SamplePixel<T, C, K>(src, origin[2 * i], origin[2 * i + 1], weights + fraction[i] * kArea,
+                             out + i * C);
+      }
+    }
+  }
+}
+
+using SampleSpanFn = void (*)(const Source& src, const std::int32_t* origin,
+                              const std::uint16_t* fraction, int n, void* dst);
+
+template <typename T, int C>
+SampleSpanFn SelectSampler(int taps) {
+  switch (taps) {
+    case 1:
+      return &SampleSpan<T, C, 1>;
+    case 2:
+      return &SampleSpan<T, C, 2>;
+    default:
+      return &SampleSpan<T, C, 4>;
+  }
+}
+
+template <typename T>
+SampleSpanFn SelectSampler(int channels, int taps) {
+  switch (channels) {
+    case 1:
+      return SelectSampler<T, 1>(taps);
+    case 2:
+      return SelectSampler<T, 2>(taps);
+    case 3:
+      return SelectSampler<T, 3>(taps);
+    default:
+      return SelectSampler<T, 4>(taps);
+  }
+}
+
+SampleSpanFn SelectSampler(const detail::ResampleImage& image, int taps) {
+  return image.is_float ? SelectSampler<float>(image.channels, taps)
+                        : SelectSampler<std::uint8_t>(image.channels, taps);
+}
+
+Source MakeSource(const detail::ResampleImage& image, BorderMode border, float border_value) {
+  if (!image.is_float && border == BorderMode::Constant) {
+    border_value = std::clamp(std::nearbyint(border_value), 0.0f, 255.0f);
+  }
+  return {static_cast<const std::uint8_t*>(image.src),
+          image.src_step,
+          image.src_rows,
+          image.src_cols,
+          border,
+          border_value};
+}
+
+std::size_t PixelBytes(const detail::ResampleImage& image) {
+  return static_cast<std::size_t>(image.channels) *
+         (image.is_float ? sizeof(float) : sizeof(std::uint8_t));
+}
+
+// Samples every destination pixel at map(x, y, &sx, &sy), in blocks of kWarpBlock pixels.
+template <typename Map>
+void Warp(const detail::ResampleImage& image, Interpolation interpolation, BorderMode border,
+          float border_value, ThreadPool* pool, Map&& map) {
+  if (image.dst_rows <= 0 || image.dst_cols <= 0) return;
+  const int taps = Taps(interpolation);
+  const Source src = MakeSource(image, border, border_value);
+  const SampleSpanFn sample = SelectSampler(image, taps);
+  const std::size_t pixel = PixelBytes(image);
+  RunBands(image.dst_rows, pool, [&](int y0, int y1) {
+    std::int32_t origin[2 * kWarpBlock];
+    std::uint16_t fraction[kWarpBlock];
+    for (int y = y0; y < y1; ++y) {
+      std::uint8_t* dst = ImageRow<std::uint8_t>(image.dst, image.dst_step, y);
+      for (int x0 = 0; x0 < image.dst_cols; x0 += kWarpBlock) {
+        const int n = std::min(kWarpBlock, image.dst_cols - x0);
+        for (int i = 0; i < n; ++i) {
+          double sx;
+          double sy;
+          map(x0 + i, y, &sx, &sy);
+          ToFixedPoint(sx, sy, taps, origin + 2 * i, fraction + i);
+        }
+        sample(src, origin, fraction, n, dst + x0 * pixel);
+      }
+    }
+  });
+}
+
+}  // namespace
+
+RemapTable::RemapTable(const MatView<float, 1>& map_x, const MatView<float, 1>& map_y,
+                       Interpolation interpolation)
+    : origin_(map_x.rows(), map_x.cols(), kMatUninitialized),
+      fraction_(map_x.rows(), map_x.cols(), kMatUninitialized),
+      interpolation_(interpolation) {
+  if (map_x.rows() != map_y.rows() || map_x.cols() != map_y.cols()) {
+    throw std::invalid_argument("RemapTable: map_x and map_y sizes differ");
+  }
+  const int taps = Taps(interpolation);
+  for (int r = 0; r < rows(); ++r) {
+    const float* x = map_x.row(r);
+    const float* y = map_y.row(r);
+    std::int32_t* origin = origin_.row(r);
+    std::uint16_t* fraction = fraction_.row(r);
+    for (int c = 0; c < cols(); ++c) ToFixedPoint(x[c], y[c], taps, origin + 2 * c, fraction + c);
+  }
+}
+
+namespace detail {
+
+void Resize(const ResampleImage& image, Interpolation interpolation, ThreadPool* pool) {
+  if (image.dst_rows <= 0 || image.dst_cols <= 0) return;
+  if (image.src_rows <= 0 || image.src_cols <= 0) {
+    throw std::invalid_argument("Resize: src is empty");
+  }
+  const Axis ax = BuildAxis(image.src_cols, image.dst_cols, interpolation);
+  const Axis ay = BuildAxis(image.src_rows, image.dst_rows, interpolation);
+  if (interpolation == Interpolation::Nearest) {
+    RunBands(image.dst_rows, pool, [&](int y0, int y1) { ResizeNearest(image, ax, ay, y0, y1); });
+    return;
+  }
+  const ResizeRowFn resize_row = image.is_float ? SelectResizeRow<float>(image.channels)
+                                                : SelectResizeRow<std::uint8_t>(image.channels);
+  RunBands(image.dst_rows, pool,
+           [&](int y0, int y1) { ResizeSeparable(image, ax, ay, resize_row, y0, y1); });
+}
+
+void WarpAffine(const ResampleImage& image, const std::array<double, 6>& m,
+                Interpolation interpolation, BorderMode border, float border_value,
+                ThreadPool* pool) {
+  Warp(image, interpolation, border, border_value, pool,
+       [&m](int x, int y, double* sx, double* sy) {
+         *sx = m[0] * x + m[1] * y + m[2];
+         *sy = m[3] * x + m[4] * y + m[5];
+       });
+}
+
+void WarpPerspective(const ResampleImage& image, const std::array<double, 9>& m,
+                     Interpolation interpolation, BorderMode border, float border_value,
+                     ThreadPool* pool) {
+  Warp(image, interpolation, border, border_value, pool,
+       [&m](int x, int y, double* sx, double* sy) {
+         const double w = m[6] * x + m[7] * y + m[8];
+         if (!(w > 0.0)) {
+           *sx = *sy = -kCoordinateLimit;
+           return;
+         }
+         *sx = (m[0] * x + m[1] * y + m[2]) / w;
+         *sy = (m[3] * x + m[4] * y + m[5]) / w;
+       });
+}
+
+void Remap(const ResampleImage& image, const RemapTable& table, BorderMode border,
+           float border_value, ThreadPool* pool) {
+  if (table.rows() != image.dst_rows || table.cols() != image.dst_cols) {
+    throw std::invalid_argument("Remap: table size differs from dst");
+  }
+  if (image.dst_rows <= 0 || image.dst_cols <= 0) return;
+  const Source src = MakeSource(image, border, border_value);
+  const SampleSpanFn sample = SelectSampler(image, Taps(table.interpolation()));
+  RunBands(image.dst_rows, pool, [&](int y0, int y1) {
+    for (int y = y0; y < y1; ++y) {
+      sample(src, table.origin().row(y), table.fraction().row(y), image.dst_cols,
+             ImageRow<void>(image.dst, image.dst_step, y));
+    }
+  });
+}
+
+}  // namespace detail
+
+std::array<double, 6> InvertAffine(const std::array<double, 6>& m) {
+  const double det = m[0] * m[4] - m[1] * m[3];
+  if (det == 0.0 || !std::isfinite(det)) {
+    throw std::invalid_argument("InvertAffine: matrix is singular");
+  }
+  const double a = m[4] / det;
+  const double b = -m[1] / det;
+  const double c = -m[3] / det;
+  const double d = m[0] / det;
+  return {a, b, -(a * m[2] + b * m[5]), c, d, -(c * m[2] + d * m[5])};
+}
+
+}  // namespace core
@@ -0,0 +1,25 @@
+#include "PlanarMat.h"
+
+#include "MatKernels.h"
+
+namespace core {
+namespace detail {
+
+void Deinterleave4(const uint8_t* src, uint8_t* const* planes, std::size_t n) {
+  GetMatKernels().deinterleave_u8x4(src, planes, n);
+}
+
+void Interleave4(const uint8_t* const* planes, uint8_t* dst, std::size_t n) {
+  GetMatKernels().interleave_u8x4(planes, dst, n);
+}
+
+void Deinterleave3(const float* src, float* const* planes, std::size_t n) {
+  GetMatKernels().deinterleave_f32x3(src, planes, n);
+}
+
+void Interleave3(const float* const* planes, float* dst, std::size_t n) {
+  GetMatKernels().interleave_f32x3(planes, dst, n);
+}
+
+}  // namespace detail
+}  // namespace core
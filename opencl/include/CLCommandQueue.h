@@ -1,12 +1,20 @@
 #pragma once
 
+#include <chrono>
+#include <string>
+#include <vector>
+
 #include "CLBuffer.h"
 #include "CLContext.h"
 #include "CLKernel.h"
+#include "CompletionPoller.h"
 
 namespace core {
 namespace opencl {
 
+// With tracing on, each call is a slice of the calling thread. On a queue created with
+// CL_QUEUE_PROFILING_ENABLE, kernels also appear with their device execution time on the "GPU
+// (OpenCL)" track once Submit() or Finish() sees them complete.
 class CLCommandQueue {
  public:
   CLCommandQueue(CLContext* context, const cl_command_queue_properties properties = 0);
@@ -25,8 +33,28 @@ class CLCommandQueue {
   cl_command_queue queue = nullptr;
 
  private:
+  struct TracedKernel {
+    cl_event event;
+    std::string name;
+    std::chrono::steady_clock::time_point enqueued;
+  };
+
+  // Emits the kernels that completed, or all of them once the queue is finished.
+  void TraceKernels(const bool finished);
+
   CLContext* context_ = nullptr;
+  cl_command_queue_properties properties_ = 0;
+  std::vector<TracedKernel> traced_kernels_;  // in submission order
 };
 
+// Whether the commands behind the event have finished; throws when they failed.
+bool IsComplete(cl_event event);
+
+// Awaitable resuming the coroutine on the poller's pool once the event is complete, for instance
+// the one returned by CLCommandQueue::Submit: co_await WaitAsync(poller, event);
+inline auto WaitAsync(CompletionPoller& poller, cl_event event) {
+  return poller.wait([event] { return IsComplete(event); });
+}
+
 }  // namespace opencl
 }  // namespace core
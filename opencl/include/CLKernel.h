@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdexcept>
+#include <string>
 #include <type_traits>
 
 #include "CLBuffer.h"
@@ -17,6 +18,7 @@ class CLKernel {
   ~CLKernel();
 
   cl_kernel kernel = nullptr;
+  std::string name;
 
   // Variadic setter: sets arguments sequentially starting from index 0
   // Enabled only when the first argument is not an integral type to avoid
@@ -58,6 +58,8 @@ typedef void* CORE_DYNLIB_HANDLE;
 #define clWaitForEvents           CL_GET_FUN(core::opencl::__clWaitForEvents)
 #define clGetEventProfilingInfo   CL_GET_FUN(core::opencl::__clGetEventProfilingInfo)
 #define clReleaseEvent            CL_GET_FUN(core::opencl::__clReleaseEvent)
+#define clRetainEvent             CL_GET_FUN(core::opencl::__clRetainEvent)
+#define clGetEventInfo            CL_GET_FUN(core::opencl::__clGetEventInfo)
 // clang-format on
 
 namespace core {
@@ -178,6 +180,12 @@ typedef cl_int (*PFN_CLGETEVENTPROFILINGINFO)(
 
 typedef cl_int (*PFN_CLRELEASEEVENT)(cl_event /* event */) CL_API_SUFFIX__VERSION_1_0;
 
+typedef cl_int (*PFN_CLRETAINEVENT)(cl_event /* event */) CL_API_SUFFIX__VERSION_1_0;
+
+typedef cl_int (*PFN_CLGETEVENTINFO)(cl_event /* event */, cl_event_info /* param_name */,
+                                     size_t /* param_value_size */, void* /* param_value */,
+                                     size_t* /* param_value_size_ret */) CL_API_SUFFIX__VERSION_1_0;
+
 // clang-format off
 extern PFN_CLGETPLATFORMIDS          __clGetPlatformIDs;
 extern PFN_CLGETDEVICEIDS            __clGetDeviceIDs;
@@ -205,6 +213,8 @@ extern PFN_CLGETPLATFORMINFO         __clGetPlatformInfo;
 extern PFN_CLWAITFOREVENTS           __clWaitForEvents;
 extern PFN_CLGETEVENTPROFILINGINFO   __clGetEventProfilingInfo;
 extern PFN_CLRELEASEEVENT            __clReleaseEvent;
+extern PFN_CLRETAINEVENT             __clRetainEvent;
+extern PFN_CLGETEVENTINFO            __clGetEventInfo;
 // clang-format on
 
 }  // namespace opencl
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// Perfetto events of the OpenCL backend in the "gpu" category, compiled out without
+// CORE_ENABLE_TRACE. Buffer memory and kernels still pending on a profiling queue are counter
+// tracks.
+#ifdef CORE_ENABLE_TRACE
+#include <atomic>
+#include <cstdint>
+
+#include "TraceGpu.h"
+#define CORE_OPENCL_TRACE_EVENT(name) TRACE_EVENT("gpu", name)
+#else
+#define CORE_OPENCL_TRACE_EVENT(name)
+#endif
+
+namespace core {
+namespace opencl {
+namespace detail {
+
+#ifdef CORE_ENABLE_TRACE
+inline void TraceBufferBytes(const std::ptrdiff_t delta) {
+  static std::atomic<int64_t> bytes{0};
+  TRACE_COUNTER("gpu", "OpenCL buffer memory", bytes.fetch_add(delta) + delta);
+}
+#else
+inline void TraceBufferBytes(const std::ptrdiff_t) {}
+#endif
+
+}  // namespace detail
+}  // namespace opencl
+}  // namespace core
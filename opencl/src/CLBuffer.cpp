@@ -1,6 +1,7 @@
 #include "CLBuffer.h"
 
 #include "CLLoader.h"
+#include "CLTrace.h"
 
 namespace core {
 namespace opencl {
@@ -13,12 +14,14 @@ CLBuffer::CLBuffer(CLContext* context, const size_t size, const cl_mem_flags fla
   if (err != CL_SUCCESS || !buffer) {
     throw std::runtime_error("clCreateBuffer failed");
   }
+  detail::TraceBufferBytes(static_cast<std::ptrdiff_t>(size));
 }
 
 CLBuffer::~CLBuffer() {
   if (buffer != nullptr) {
     clReleaseMemObject(buffer);
     buffer = nullptr;
+    detail::TraceBufferBytes(-static_cast<std::ptrdiff_t>(size));
   }
 }
 
@@ -1,14 +1,16 @@
 #include "CLCommandQueue.h"
 
 #include <stdexcept>
+#include <string>
 
 #include "CLLoader.h"
+#include "CLTrace.h"
 
 namespace core {
 namespace opencl {
 
 CLCommandQueue::CLCommandQueue(CLContext* context, const cl_command_queue_properties properties)
-    : context_(context) {
+    : context_(context), properties_(properties) {
   cl_int err = CL_SUCCESS;
   queue = clCreateCommandQueue(context_->context, context_->device, properties, &err);
   if (err != CL_SUCCESS || !queue) {
@@ -17,6 +19,7 @@ CLCommandQueue::CLCommandQueue(CLContext* context, const cl_command_queue_proper
 }
 
 CLCommandQueue::~CLCommandQueue() {
+  for (const TracedKernel& traced : traced_kernels_) clReleaseEvent(traced.event);
   if (queue != nullptr) {
     clReleaseCommandQueue(queue);
     queue = nullptr;
@@ -25,21 +28,42 @@ CLCommandQueue::~CLCommandQueue() {
 
 void CLCommandQueue::Submit(const CLKernel& kernel, const cl_int dim, const size_t* global_size,
                             const size_t* local_size, cl_event* event) {
+  CORE_OPENCL_TRACE_EVENT("clEnqueueNDRangeKernel");
+#ifdef CORE_ENABLE_TRACE
+  const bool trace_kernel =
+      (properties_ & CL_QUEUE_PROFILING_ENABLE) != 0 && TRACE_EVENT_CATEGORY_ENABLED("gpu");
+  cl_event traced_event = nullptr;
+  if (trace_kernel && event == nullptr) event = &traced_event;
+  const auto enqueued = std::chrono::steady_clock::now();
+#endif
   cl_int err = clEnqueueNDRangeKernel(queue, kernel.kernel, dim, nullptr, global_size, local_size,
                                       0, nullptr, event);
   if (err != CL_SUCCESS) {
     throw std::runtime_error("clEnqueueNDRangeKernel failed");
   }
+#ifdef CORE_ENABLE_TRACE
+  if (trace_kernel) {
+    // The caller's event keeps its reference; ours is released once traced
+    if (event != &traced_event) clRetainEvent(*event);
+    traced_kernels_.push_back({*event, kernel.name, enqueued});
+  }
+  TraceKernels(false);
+#endif
 }
 
 void CLCommandQueue::Finish() {
-  cl_int err = clFinish(queue);
-  if (err != CL_SUCCESS) {
-    throw std::runtime_error("clFinish failed");
+  {
+    CORE_OPENCL_TRACE_EVENT("clFinish");
+    cl_int err = clFinish(queue);
+    if (err != CL_SUCCESS) {
+      throw std::runtime_error("clFinish failed");
+    }
   }
+  TraceKernels(true);
 }
 
 void CLCommandQueue::ReadBuffer(const CLBuffer& buffer, void* dst, size_t bytes, size_t offset) {
+  CORE_OPENCL_TRACE_EVENT("clEnqueueReadBuffer");
   cl_int err =
       clEnqueueReadBuffer(queue, buffer.buffer, CL_TRUE, offset, bytes, dst, 0, nullptr, nullptr);
   if (err != CL_SUCCESS) {
@@ -47,5 +71,61 @@ void CLCommandQueue::ReadBuffer(const CLBuffer& buffer, void* dst, size_t bytes,
   }
 }
 
+void CLCommandQueue::TraceKernels(const bool finished) {
+#ifdef CORE_ENABLE_TRACE
+  if (traced_kernels_.empty()) return;
+  const perfetto::Track track = trace::GpuTrack(queue, "GPU (OpenCL)");
+  const trace::TraceClock clock;
+  // An in-order queue completes kernels in submission order: stop at the first one still running.
+  // A failed kernel has no profiling info and is dropped; Finish() or its event reports the error.
+  size_t done = 0;
+  for (; done < traced_kernels_.size(); ++done) {
+    const TracedKernel& traced = traced_kernels_[done];
+    cl_int status = CL_COMPLETE;
+    if (!finished) {
+      clGetEventInfo(traced.event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status,
+                     nullptr);
+      if (status > CL_COMPLETE) break;
+    }
+    cl_ulong times[3] = {};
+    const cl_profiling_info params[3] = {CL_PROFILING_COMMAND_QUEUED, CL_PROFILING_COMMAND_START,
+                                         CL_PROFILING_COMMAND_END};
+    bool profiled = true;
+    for (int i = 0; i < 3; ++i) {
+      profiled &= clGetEventProfilingInfo(traced.event, params[i], sizeof(cl_ulong), &times[i],
+                                          nullptr) == CL_SUCCESS;
+    }
+    if (profiled) {
+      // Device times are placed on the host clock relative to the kernel's enqueue
+      const auto host_time = [&traced, &times](cl_ulong time) {
+        return traced.enqueued + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                     std::chrono::nanoseconds(time - times[0]));
+      };
+      TRACE_EVENT_BEGIN("gpu", perfetto::DynamicString{traced.name}, track,
+                        clock.ToTraceTime(host_time(times[1])));
+      TRACE_EVENT_END("gpu", track, clock.ToTraceTime(host_time(times[2])));
+    }
+    clReleaseEvent(traced.event);
+  }
+  traced_kernels_.erase(traced_kernels_.begin(), traced_kernels_.begin() + done);
+  TRACE_COUNTER("gpu", "OpenCL kernels in flight", traced_kernels_.size());
+#else
+  (void)finished;
+#endif
+}
+
+bool IsComplete(cl_event event) {
+  cl_int status = CL_QUEUED;
+  cl_int err = clGetEventInfo(event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status,
+                              nullptr);
+  if (err != CL_SUCCESS) {
+    throw std::runtime_error("clGetEventInfo failed");
+  }
+  if (status < 0) {
+    throw std::runtime_error("OpenCL command failed: " + std::to_string(status));
+  }
+  return status == CL_COMPLETE;
+}
+
 }  // namespace opencl
 }  // namespace core
@@ -7,7 +7,7 @@
 namespace core {
 namespace opencl {
 
-CLKernel::CLKernel(CLProgram* program, const char* kernel_name) {
+CLKernel::CLKernel(CLProgram* program, const char* kernel_name) : name(kernel_name) {
   cl_int err = CL_SUCCESS;
   kernel = clCreateKernel(program->program, kernel_name, &err);
   if (err != CL_SUCCESS || !kernel) {
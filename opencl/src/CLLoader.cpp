@@ -37,6 +37,8 @@ PFN_CLGETPLATFORMINFO         __clGetPlatformInfo         = nullptr;
 PFN_CLWAITFOREVENTS           __clWaitForEvents           = nullptr;
 PFN_CLGETEVENTPROFILINGINFO   __clGetEventProfilingInfo   = nullptr;
 PFN_CLRELEASEEVENT            __clReleaseEvent            = nullptr;
+PFN_CLRETAINEVENT             __clRetainEvent             = nullptr;
+PFN_CLGETEVENTINFO            __clGetEventInfo            = nullptr;
 // clang-format on
 
 static void *dynamic_library_open_find(const char **paths) {
@@ -123,6 +125,8 @@ int cl_init() {
   __clWaitForEvents           = (PFN_CLWAITFOREVENTS)CORE_DYNLIB_IMPORT(module, "clWaitForEvents");
   __clGetEventProfilingInfo   = (PFN_CLGETEVENTPROFILINGINFO)CORE_DYNLIB_IMPORT(module, "clGetEventProfilingInfo");
   __clReleaseEvent            = (PFN_CLRELEASEEVENT)CORE_DYNLIB_IMPORT(module, "clReleaseEvent");
+  __clRetainEvent             = (PFN_CLRETAINEVENT)CORE_DYNLIB_IMPORT(module, "clRetainEvent");
+  __clGetEventInfo            = (PFN_CLGETEVENTINFO)CORE_DYNLIB_IMPORT(module, "clGetEventInfo");
   // clang-format on
 
   printf("OpenCL library loaded successfully.\n");
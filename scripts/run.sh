@@ -4,7 +4,7 @@ set -x
 
 usage() {
   cat <<EOF
-Usage: $0 [-target macos|arm64-v8a] [-test_module <name>] [-test_filter <Suite.Test>] [-enable_trace 0|1]
+Usage: $0 [-target macos|arm64-v8a] [-test_module <name>] [-test_filter <Suite.Test>] [-enable_trace 0|1] [-enable_profiler 0|1]
 
 Examples:
   $0 -target macos -test_module vulkan -test_filter ComputeGaussianBlur.test -enable_trace 1
@@ -18,6 +18,7 @@ target=macos
 test_module=""
 test_filter=""
 enable_trace=0 # Disable tracing by default
+enable_profiler=0 # Disable CORE_PROFILE_SCOPE zones by default
 
 device_path="/data/local/tmp/core"
 
@@ -29,6 +30,7 @@ while [[ $# -gt 0 ]]; do
     -test_module|--test_module) test_module="$2"; shift 2 ;;
     -test_filter|--test_filter) test_filter="$2"; shift 2 ;;
     -enable_trace|--enable_trace) enable_trace="$2"; shift 2 ;;
+    -enable_profiler|--enable_profiler) enable_profiler="$2"; shift 2 ;;
     *) echo "Unknown arg: $1"; usage; exit 1 ;;
   esac
 done
@@ -51,6 +53,9 @@ cmake_options=(-DCMAKE_BUILD_TYPE=Debug
 if [ "$enable_trace" = "1" ]; then
     cmake_options+=(-DENABLE_TRACE=1)
 fi
+if [ "$enable_profiler" = "1" ]; then
+    cmake_options+=(-DENABLE_PROFILER=1)
+fi
 
 if [ "$target" = "arm64-v8a" ] ; then
     cmake_options+=(-DCMAKE_TOOLCHAIN_FILE=$ANDROID_NDK_ROOT/build/cmake/android.toolchain.cmake
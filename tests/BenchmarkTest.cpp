@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+namespace core {
+namespace test {
+
+TEST(BenchmarkTest, Stats) {
+  const core::BenchmarkStats stats = core::benchmark_stats({5, 1, 4, 2, 3});
+  EXPECT_EQ(stats.count, 5u);
+  EXPECT_DOUBLE_EQ(stats.min, 1.0);
+  EXPECT_DOUBLE_EQ(stats.max, 5.0);
+  EXPECT_DOUBLE_EQ(stats.median, 3.0);
+  EXPECT_DOUBLE_EQ(stats.mean, 3.0);
+  EXPECT_DOUBLE_EQ(stats.mad, 1.0);
+  EXPECT_DOUBLE_EQ(stats.p90, 4.6);
+  EXPECT_DOUBLE_EQ(core::benchmark_percentile({10, 20}, 0.25), 12.5);
+  EXPECT_EQ(core::benchmark_stats({}).count, 0u);
+
+  // A preempted sample among steady ones is dropped; equal samples are all kept
+  std::vector<double> samples = {100, 101, 99, 100, 102, 98, 100, 5000};
+  EXPECT_EQ(core::reject_outliers(&samples, 3.5), 1u);
+  EXPECT_EQ(samples.size(), 7u);
+  std::vector<double> same = {7, 7, 7, 7, 50};
+  EXPECT_EQ(core::reject_outliers(&same, 3.5), 0u);
+  EXPECT_EQ(core::reject_outliers(&samples, 0.0), 0u);
+}
+
+TEST(BenchmarkTest, Run) {
+  std::atomic<int> calls{0};
+  core::BenchmarkOptions options;
+  options.warmup = std::chrono::nanoseconds(0);
+  options.samples = 5;
+  options.iterations = 3;
+  core::Benchmark counted("counted", [&calls] { calls.fetch_add(1); });
+  counted.bytes(1000).items(10, "pixels");
+  const core::BenchmarkResult result = counted.run(options);
+  EXPECT_EQ(calls.load(), 3 + 5 * 3);  // one warm-up batch, then the samples
+  EXPECT_EQ(result.iterations, 3u);
+  EXPECT_EQ(result.time.count + result.outliers, 5u);
+  EXPECT_GT(result.bytes_per_second(), 0.0);
+  EXPECT_DOUBLE_EQ(result.bytes_per_second() / result.items_per_second(), 100.0);
+
+  // Calibrated batches last about sample_time; functions may report their own time
+  options.iterations = 0;
+  options.sample_time = std::chrono::microseconds(100);
+  core::Benchmark timed("timed", [] { return std::chrono::nanoseconds(1000); });
+  const core::BenchmarkResult manual = timed.run(options);
+  EXPECT_EQ(manual.iterations, 100u);
+  EXPECT_DOUBLE_EQ(manual.time.median, 1000.0);
+  EXPECT_EQ(manual.outliers, 0u);
+}
+
+TEST(BenchmarkTest, Output) {
+  core::BenchmarkSuite suite;
+  suite.add("mat/add", [] { return std::chrono::nanoseconds(250); }).bytes(1 << 20);
+  suite.add("pool/post, \"quoted\"", [] { return std::chrono::nanoseconds(50); });
+  core::BenchmarkOptions options;
+  options.warmup = std::chrono::nanoseconds(0);
+  options.samples = 3;
+  options.iterations = 1;
+  std::ostringstream log;
+  const std::vector<core::BenchmarkResult> results = suite.run(options, "mat/", &log);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_NE(log.str().find("mat/add"), std::string::npos);
+  EXPECT_NE(log.str().find("GB/s"), std::string::npos);
+
+  // Benchmarks that cannot run, e.g. without a GPU, are logged and left out
+  suite.add("gpu/blur", []() -> void { throw std::runtime_error("no device"); });
+  log.str("");
+  EXPECT_EQ(suite.run(options, "gpu/", &log).size(), 0u);
+  EXPECT_EQ(log.str(), "gpu/blur skipped: no device\n");
+
+  std::ostringstream json;
+  core::write_benchmark_json(json, suite.run(options), {{"simd", "AVX2"}});
+  EXPECT_NE(json.str().find("\"simd\": \"AVX2\""), std::string::npos);
+  EXPECT_NE(json.str().find("\"name\": \"mat/add\", \"iterations\": 1, \"samples\": 3"),
+            std::string::npos);
+  EXPECT_NE(json.str().find("\"median_ns\": 250,"), std::string::npos);
+  EXPECT_NE(json.str().find("pool/post, \\\"quoted\\\""), std::string::npos);
+
+  std::ostringstream csv;
+  core::write_benchmark_csv(csv, results);
+  EXPECT_EQ(csv.str().substr(0, csv.str().find('\n')),
+            "name,iterations,samples,outliers,min_ns,median_ns,p90_ns,p99_ns,max_ns,mean_ns,"
+            "mad_ns,bytes_per_second,items_per_second,item_unit");
+  EXPECT_NE(csv.str().find("\nmat/add,1,3,0,250,250,250,250,250,250,0,4.194304e+12,0,\n"),
+            std::string::npos);
+}
+
+}  // namespace test
+}  // namespace core
@@ -11,6 +11,7 @@
 #include "CLLoader.h"
 #include "CLProgram.h"
 #include "Mat.h"
+#include "MatFilter.h"
 
 #if defined(__ANDROID__)
 #define SHADER_PATH "/data/local/tmp/core/tests/shaders/"
@@ -177,7 +178,7 @@ TEST(OpenCL, VecAddCLWrapper) {
 
 TEST(OpenCL, GaussianBlur) {
   // Prepare input and fill with random data
-  core::Mat<float, 1> src(4000, 3000);
+  core::Mat<float, 1> src(4000, 3000, core::kMatNoPadding);
   src.Random();
 
   // Initialize OpenCL
@@ -216,34 +217,14 @@ TEST(OpenCL, GaussianBlur) {
   printf("Kernel took %.3f ms\n", ms);
 
   // Read back output image
-  core::Mat<float, 1> dst(src.rows(), src.cols());
+  core::Mat<float, 1> dst(src.rows(), src.cols(), core::kMatUninitialized, core::kMatNoPadding);
   clqueue.ReadBuffer(output_buffer, dst.data(), src_size);
 
   // CPU reference implementation (3x3 Gaussian with clamping, same sigma)
-  auto gaussian = [](float x, float s) -> float { return std::expf(-(x * x) / (2.0f * s * s)); };
-  auto clampi = [](int v, int lo, int hi) -> int { return v < lo ? lo : (v > hi ? hi : v); };
-
-  core::Mat<float, 1> ref(src.rows(), src.cols());
+  core::Mat<float, 1> ref(src.rows(), src.cols(), core::kMatUninitialized);
   const int width = src.cols();
   const int height = src.rows();
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      float accum = 0.0f;
-      float wsum = 0.0f;
-      for (int dy = -radius; dy <= radius; ++dy) {
-        const int yy = clampi(y + dy, 0, height - 1);
-        const float wy = gaussian(static_cast<float>(dy), sigma);
-        for (int dx = -radius; dx <= radius; ++dx) {
-          const int xx = clampi(x + dx, 0, width - 1);
-          const float wx = gaussian(static_cast<float>(dx), sigma);
-          const float w = wx * wy;
-          accum += src(yy, xx)[0] * w;
-          wsum += w;
-        }
-      }
-      ref(y, x)[0] = (wsum > 0.0f) ? (accum / wsum) : src(y, x)[0];
-    }
-  }
+  core::GaussianBlur(src, ref, radius, sigma, core::BorderMode::Clamp);
 
   // Compare GPU and CPU results
   double max_abs_err = 0.0;
@@ -312,28 +293,8 @@ TEST(OpenCL, MapMemGaussianBlur) {
   clqueue.Finish();
 
   // CPU reference implementation (3x3 Gaussian with clamping, same sigma)
-  auto gaussian = [](float x, float s) -> float { return std::expf(-(x * x) / (2.0f * s * s)); };
-  auto clampi = [](int v, int lo, int hi) -> int { return v < lo ? lo : (v > hi ? hi : v); };
-
-  core::Mat<float, 1> ref(height, width);
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      float accum = 0.0f;
-      float wsum = 0.0f;
-      for (int dy = -radius; dy <= radius; ++dy) {
-        const int yy = clampi(y + dy, 0, height - 1);
-        const float wy = gaussian(static_cast<float>(dy), sigma);
-        for (int dx = -radius; dx <= radius; ++dx) {
-          const int xx = clampi(x + dx, 0, width - 1);
-          const float wx = gaussian(static_cast<float>(dx), sigma);
-          const float w = wx * wy;
-          accum += input_view(yy, xx)[0] * w;
-          wsum += w;
-        }
-      }
-      ref(y, x)[0] = (wsum > 0.0f) ? (accum / wsum) : input_view(y, x)[0];
-    }
-  }
+  core::Mat<float, 1> ref(height, width, core::kMatUninitialized);
+  core::GaussianBlur(input_view, ref, radius, sigma, core::BorderMode::Clamp);
 
   // Compare GPU and CPU results
   double max_abs_err = 0.0;
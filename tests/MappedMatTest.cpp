@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "MappedMat.h"
+#include "Mat.h"
+#include "MatOps.h"
+
+namespace core {
+namespace test {
+
+namespace {
+
+std::string TempPath(const char* name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+}  // namespace
+
+TEST(MappedMatTest, CreateAndOpen) {
+  const std::string path = TempPath("core_mapped_mat_test.cmat");
+  {
+    core::MappedMat<float, 3> mat = core::MappedMat<float, 3>::Create(path, 300, 200);
+    EXPECT_EQ(mat.mode(), core::MapMode::ReadWrite);
+    EXPECT_EQ(mat.step() % core::kMatRowAlign, 0u);
+    EXPECT_EQ(*mat(299, 199, 2), 0.0f);
+    for (int r = 0; r < mat.rows(); ++r) {
+      for (int c = 0; c < mat.cols(); ++c) *mat(r, c, 1) = static_cast<float>(r * 1000 + c);
+    }
+    mat.Sync();
+  }
+
+  const core::MappedMat<float, 3> ro = core::MappedMat<float, 3>::Open(path);
+  EXPECT_EQ(ro.mode(), core::MapMode::ReadOnly);
+  ASSERT_EQ(ro.rows(), 300);
+  ASSERT_EQ(ro.cols(), 200);
+  ro.Prefetch(100, 200);
+  EXPECT_EQ(*ro(123, 45, 1), 123045.0f);
+  EXPECT_EQ(*ro(299, 199, 1), 299199.0f);
+
+  // Works wherever a MatView does
+  core::Mat<float, 3> sum(50, 40);
+  core::Add(ro.Roi(10, 20, 40, 50), ro.Roi(10, 20, 40, 50), sum);
+  EXPECT_EQ(*sum(0, 0, 1), 2 * 20010.0f);
+
+  std::remove(path.c_str());
+}
+
+TEST(MappedMatTest, Modes) {
+  const std::string path = TempPath("core_mapped_mat_modes.cmat");
+  core::MappedMat<uint8_t, 1>::Create(path, 64, 64).Fill(7);
+
+  {
+    // Copy-on-write: private changes, the file is untouched
+    core::MappedMat<uint8_t, 1> cow =
+        core::MappedMat<uint8_t, 1>::Open(path, core::MapMode::CopyOnWrite);
+    cow.Fill(9);
+    EXPECT_EQ(*cow(5, 5), 9);
+  }
+  {
+    core::MappedMat<uint8_t, 1> rw =
+        core::MappedMat<uint8_t, 1>::Open(path, core::MapMode::ReadWrite);
+    EXPECT_EQ(*rw(5, 5), 7);
+    *rw(5, 5) = 42;
+  }
+  core::MappedMat<uint8_t, 1> ro = core::MappedMat<uint8_t, 1>::Open(path);
+  EXPECT_EQ(*ro(5, 5), 42);
+  EXPECT_EQ(*ro(5, 6), 7);
+
+  // Moves keep the mapping alive
+  core::MappedMat<uint8_t, 1> moved = std::move(ro);
+  EXPECT_EQ(ro.data(), nullptr);
+  EXPECT_EQ(*moved(5, 5), 42);
+
+  std::remove(path.c_str());
+}
+
+TEST(MappedMatTest, Errors) {
+  using MappedF32C1 = core::MappedMat<float, 1>;
+  using MappedF32C3 = core::MappedMat<float, 3>;
+  using MappedU8C1 = core::MappedMat<uint8_t, 1>;
+  const std::string path = TempPath("core_mapped_mat_errors.cmat");
+  MappedF32C1::Create(path, 8, 8);
+  EXPECT_THROW(MappedF32C3::Open(path), std::runtime_error);
+  EXPECT_THROW(MappedU8C1::Open(path), std::runtime_error);
+  EXPECT_NO_THROW(MappedF32C1::Open(path));
+
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "definitely not a mat header, but long enough to be read as one";
+  }
+  EXPECT_THROW(MappedF32C1::Open(path), std::runtime_error);
+
+  // A step whose product with rows wraps around 64 bits
+  MappedU8C1::Create(path, 2, 8);
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    const std::uint64_t step = std::uint64_t{1} << 63;
+    file.seekp(offsetof(core::MappedMatHeader, step));
+    file.write(reinterpret_cast<const char*>(&step), sizeof(step));
+  }
+  EXPECT_THROW(MappedU8C1::Open(path), std::runtime_error);
+  std::remove(path.c_str());
+  EXPECT_THROW(MappedF32C1::Open(path), std::runtime_error);
+}
+
+}  // namespace test
+}  // namespace core
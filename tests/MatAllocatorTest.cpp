@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "Mat.h"
+#include "MatAllocator.h"
+#include "MatOps.h"
+
+namespace core {
+namespace test {
+
+namespace {
+
+// One "frame" of a typical pipeline: a few large temporaries and a clone.
+void ProcessFrame(int rows, int cols) {
+  core::Mat<float, 3> a(rows, cols);
+  core::Mat<float, 3> b(rows, cols);
+  a.Fill(1.0f);
+  b.Fill(2.0f);
+  core::Mat<float, 3> sum(rows, cols);
+  core::Add(a, b, sum);
+  core::Mat<float, 3> copy = sum.clone();
+  core::Mat<uint8_t, 3> out(rows, cols);
+  core::ConvertTo(copy, out, 10.0f);
+  EXPECT_EQ(*out(rows - 1, cols - 1, 2), 30);
+}
+
+}  // namespace
+
+TEST(MatAllocatorTest, SizeClass) {
+  EXPECT_EQ(core::MatBufferPool::SizeClass(1), 4096u);
+  EXPECT_EQ(core::MatBufferPool::SizeClass(4096), 4096u);
+  EXPECT_EQ(core::MatBufferPool::SizeClass(4097), 5120u);
+  EXPECT_EQ(core::MatBufferPool::SizeClass(8192), 8192u);
+  for (std::size_t bytes = 1000; bytes < (1u << 26); bytes = bytes * 3 / 2 + 7) {
+    const std::size_t size = core::MatBufferPool::SizeClass(bytes);
+    EXPECT_GE(size, bytes);
+    EXPECT_LE(size, std::max<std::size_t>(4096, bytes + bytes / 4));
+  }
+}
+
+TEST(MatAllocatorTest, PoolSteadyState) {
+  core::MatBufferPool pool;
+  core::ScopedMatAllocator scope(&pool);
+
+  ProcessFrame(300, 400);  // warm-up
+  const core::MatHeapStats warm = core::GetMatHeapStats();
+  for (int frame = 0; frame < 10; ++frame) ProcessFrame(300, 400);
+  const core::MatHeapStats after = core::GetMatHeapStats();
+
+  EXPECT_EQ(after.allocations, warm.allocations);
+  EXPECT_EQ(after.deallocations, warm.deallocations);
+  const core::MatBufferPool::Stats stats = pool.stats();
+  EXPECT_EQ(stats.misses, 5u);
+  EXPECT_EQ(stats.hits, 50u);
+  EXPECT_EQ(stats.outstanding, 0u);
+
+  pool.Trim();
+  EXPECT_EQ(pool.stats().cached_bytes, 0u);
+  EXPECT_EQ(core::GetMatHeapStats().deallocations, warm.deallocations + 5);
+}
+
+TEST(MatAllocatorTest, PoolCap) {
+  core::MatBufferPool pool(8192);
+  {
+    core::Mat<uint8_t, 1> a(64, 64, core::kMatNoPadding, &pool);
+    core::Mat<uint8_t, 1> b(64, 64, core::kMatNoPadding, &pool);
+    core::Mat<uint8_t, 1> c(64, 64, core::kMatNoPadding, &pool);
+  }
+  // Only two 4 KiB buffers fit under the cap
+  EXPECT_EQ(pool.stats().cached_bytes, 8192u);
+}
+
+TEST(MatAllocatorTest, ArenaSteadyState) {
+  core::MatArena arena(1 << 20);
+  core::ScopedMatAllocator scope(&arena);
+
+  ProcessFrame(300, 400);  // warm-up: grows the arena to the frame's working set
+  arena.Reset();
+  const core::MatHeapStats warm = core::GetMatHeapStats();
+  const std::size_t chunks = arena.stats().chunks;
+  for (int frame = 0; frame < 10; ++frame) {
+    ProcessFrame(300, 400);
+    arena.Reset();
+  }
+  EXPECT_EQ(core::GetMatHeapStats().allocations, warm.allocations);
+  EXPECT_EQ(arena.stats().chunks, chunks);
+  EXPECT_GE(arena.stats().peak, 4u * 300 * 400 * 3 * sizeof(float));
+}
+
+TEST(MatAllocatorTest, ArenaResetWhileAlive) {
+  core::MatArena arena;
+  core::Mat<float, 1> alive(16, 16, core::kMatRowAlign, &arena);
+  EXPECT_THROW(arena.Reset(), std::runtime_error);
+  alive = core::Mat<float, 1>(16, 16);  // back on the heap
+  EXPECT_NO_THROW(arena.Reset());
+}
+
+TEST(MatAllocatorTest, DefaultAndCopies) {
+  core::MatBufferPool pool;
+  EXPECT_EQ(core::GetDefaultMatAllocator(), core::HeapMatAllocator::Instance());
+  {
+    core::ScopedMatAllocator scope(&pool);
+    core::Mat<int, 2> a(10, 10);
+    EXPECT_EQ(a.allocator(), &pool);
+    for (int i = 0; i < a.total(); ++i) EXPECT_EQ(a.data()[i], 0);
+
+    core::Mat<int, 2> heap(10, 10, core::kMatRowAlign, core::HeapMatAllocator::Instance());
+    heap.Fill(7);
+    core::Mat<int, 2> copy = heap;
+    EXPECT_EQ(copy.allocator(), core::HeapMatAllocator::Instance());
+
+    // Copy assignment between equal sized Mats of the same allocator reuses the buffer
+    const int* buffer = copy.data();
+    heap.Fill(9);
+    copy = heap;
+    EXPECT_EQ(copy.data(), buffer);
+    EXPECT_EQ(*copy(9, 9, 1), 9);
+
+    // Different allocator: takes over the source's
+    a = heap;
+    EXPECT_EQ(a.allocator(), core::HeapMatAllocator::Instance());
+    EXPECT_EQ(*a(3, 4, 0), 9);
+  }
+  EXPECT_EQ(core::GetDefaultMatAllocator(), core::HeapMatAllocator::Instance());
+  EXPECT_EQ(pool.stats().outstanding, 0u);
+}
+
+TEST(MatAllocatorTest, Uninitialized) {
+  core::MatBufferPool pool;
+  const float* buffer = nullptr;
+  {
+    core::Mat<float, 1> a(256, 256, core::kMatRowAlign, &pool);
+    a.Fill(5.0f);
+    buffer = a.data();
+  }
+  // The recycled buffer is handed out as is: no zero-fill
+  core::Mat<float, 1> b(256, 256, core::kMatUninitialized, core::kMatRowAlign, &pool);
+  ASSERT_EQ(b.data(), buffer);
+  EXPECT_EQ(*b(255, 255), 5.0f);
+  // The default constructor still zero-fills
+  b = core::Mat<float, 1>(256, 256, core::kMatRowAlign, &pool);
+  EXPECT_EQ(*b(255, 255), 0.0f);
+}
+
+TEST(MatAllocatorTest, HugePages) {
+  core::HugePageMatAllocator allocator;
+  const core::MatHeapStats before = core::GetMatHeapStats();
+  {
+    core::Mat<float, 1> big(3000, 4000, core::kMatUninitialized, core::kMatRowAlign, &allocator);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(big.data()) % core::kMatBufferAlign, 0u);
+    big.Fill(3.0f);
+    EXPECT_EQ(*big(2999, 3999), 3.0f);
+
+    core::Mat<float, 1> zeroed(2000, 2000, core::kMatRowAlign, &allocator);
+    EXPECT_EQ(*zeroed(1999, 1999), 0.0f);
+
+    // Below the threshold: plain heap
+    core::Mat<uint8_t, 1> small(16, 16, core::kMatRowAlign, &allocator);
+    EXPECT_EQ(*small(15, 15), 0);
+  }
+  const core::MatHeapStats after = core::GetMatHeapStats();
+  EXPECT_EQ(after.allocations - before.allocations, 3u);
+  EXPECT_EQ(after.bytes_in_use, before.bytes_in_use);
+
+  // Recycling huge-page buffers through a pool
+  core::MatBufferPool pool(std::numeric_limits<std::size_t>::max(), &allocator);
+  for (int i = 0; i < 3; ++i) {
+    core::Mat<float, 3> frame(1000, 1000, core::kMatUninitialized, core::kMatRowAlign, &pool);
+  }
+  EXPECT_EQ(pool.stats().misses, 1u);
+}
+
+}  // namespace test
+}  // namespace core
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Mat.h"
+#include "MatOps.h"
+#include "MatRandom.h"
+#include "MatReduce.h"
+#include "MatTestUtils.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+
+namespace core {
+namespace test {
+
+TEST(MatRandomTest, KnownAnswer) {
+  // Philox4x32-10 known answer of the Random123 reference: counter 0, key 0
+  const std::array<uint32_t, 4> expected = {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u};
+  ForEachIsa([&] { EXPECT_EQ(core::Philox4x32(0)(0), expected); });
+}
+
+TEST(MatRandomTest, Generate) {
+  const core::Philox4x32 gen(0x123456789abcdefull);
+  std::vector<uint32_t> ref(4 * 100);
+  for (uint64_t n = 0; n < 100; ++n) {
+    const std::array<uint32_t, 4> block = gen((uint64_t(1) << 32) - 50 + n);
+    std::copy(block.begin(), block.end(), ref.begin() + 4 * n);
+  }
+  ForEachIsa([&] {
+    // Every offset and length, across the 32-bit carry of the counter
+    const uint64_t base = ((uint64_t(1) << 32) - 50) * 4;
+    for (std::size_t first = 0; first < 9; ++first) {
+      for (std::size_t n : {0, 1, 3, 4, 5, 31, 32, 33, 200, 391}) {
+        std::vector<uint32_t> words(n);
+        gen.Generate(base + first, words.data(), n);
+        EXPECT_TRUE(std::equal(words.begin(), words.end(), ref.begin() + first));
+      }
+    }
+  });
+}
+
+TEST(MatRandomTest, Deterministic) {
+  core::ThreadPool pool(3);
+  core::Mat<float, 3> ref(301, 517);
+  ref.Random(42);
+  ForEachIsa([&] {
+    core::Mat<float, 3> serial(301, 517, core::kMatUninitialized);
+    serial.Random(42);
+    EXPECT_TRUE(SamePixels(serial, ref));
+    core::Mat<float, 3> parallel(301, 517, core::kMatUninitialized, core::kMatNoPadding);
+    parallel.Random(42, &pool);
+    EXPECT_TRUE(SamePixels(parallel, ref));
+  });
+  core::Mat<float, 3> other(301, 517);
+  other.Random(43);
+  EXPECT_FALSE(SamePixels(other, ref));
+
+  // A ROI gets the values of a Mat of its size
+  core::Mat<uint16_t, 2> small(10, 20);
+  small.Random(7);
+  core::Mat<uint16_t, 2> parent(30, 40);
+  core::MatView<uint16_t, 2> roi = parent.Roi(5, 3, 20, 10);
+  roi.Random(7);
+  EXPECT_TRUE(SamePixels(roi, small));
+  EXPECT_EQ(*parent(2, 5, 0), 0);
+}
+
+TEST(MatRandomTest, Distributions) {
+  core::Mat<float, 1> f(500, 1000);
+  f.Random(1);
+  const core::MeanStdDevResult<1> fs = core::MeanStdDev(f);
+  EXPECT_NEAR(fs.mean[0], 0.5, 2e-3);
+  EXPECT_NEAR(fs.stddev[0], std::sqrt(1.0 / 12.0), 2e-3);
+  const std::array<core::MinMaxLoc, 1> fm = core::MinMax(f);
+  EXPECT_GE(fm[0].min, 0.0);
+  EXPECT_LT(fm[0].max, 1.0);
+
+  core::Mat<double, 1> d(100, 1000);
+  d.Random(2);
+  EXPECT_NEAR(core::Mean(d)[0], 0.5, 5e-3);
+  EXPECT_GE(core::MinMax(d)[0].min, 0.0);
+  EXPECT_LT(core::MinMax(d)[0].max, 1.0);
+
+  core::Mat<uint8_t, 4> u(256, 1024);
+  u.Random(3);
+  const std::array<std::vector<uint64_t>, 4> hist = core::Histogram(u);
+  for (int ch = 0; ch < 4; ++ch) {
+    for (int v = 0; v < 256; ++v) {
+      // 1024 expected per bin, more than 6 sigma away would be a broken generator
+      EXPECT_NEAR(static_cast<double>(hist[ch][v]), 1024.0, 6 * 32.0);
+    }
+  }
+
+  core::Mat<int16_t, 1> s(100, 100);
+  s.Random(4);
+  const std::array<core::MinMaxLoc, 1> sm = core::MinMax(s);
+  EXPECT_GE(sm[0].min, 0.0);
+  EXPECT_GT(sm[0].max, 30000.0);
+
+  core::Mat<int64_t, 1> l(100, 100);
+  l.Random(5);
+  EXPECT_GE(core::MinMax(l)[0].min, 0.0);
+  EXPECT_GT(core::MinMax(l)[0].max, 9e18);
+}
+
+TEST(MatRandomTest, Performance) {
+  core::ThreadPool pool;
+  core::Mat<float, 1> src(3000, 4000, core::kMatUninitialized);
+  core::Timer timer;
+
+  timer.start();
+  src.Random(0);
+  timer.end();
+  printf("Random 12MP f32 (%s, 1 thread): %fms\n", core::SimdIsaName(core::GetSimdIsa()),
+         timer.time());
+
+  core::Mat<float, 1> parallel(3000, 4000, core::kMatUninitialized);
+  timer.start();
+  parallel.Random(0, &pool);
+  timer.end();
+  printf("Random 12MP f32 (%s, %zu threads): %fms\n", core::SimdIsaName(core::GetSimdIsa()),
+         pool.size(), timer.time());
+  EXPECT_TRUE(SamePixels(src, parallel));
+}
+
+}  // namespace test
+}  // namespace core
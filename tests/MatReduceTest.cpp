@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "Mat.h"
+#include "MatOps.h"
+#include "MatReduce.h"
+#include "MatTestUtils.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+
+namespace core {
+namespace test {
+
+namespace {
+
+// Sum, sum of magnitudes, mean and population stddev per channel in long double, the obvious way.
+template <typename T, int C>
+void ReferenceMoments(const core::MatView<T, C>& src, double* sum, double* l1, double* mean,
+                      double* stddev) {
+  const long double count = static_cast<long double>(src.rows()) * src.cols();
+  for (int ch = 0; ch < C; ++ch) {
+    long double s = 0;
+    long double a = 0;
+    for (int r = 0; r < src.rows(); ++r) {
+      for (int c = 0; c < src.cols(); ++c) {
+        s += *src(r, c, ch);
+        a += std::fabs(static_cast<long double>(*src(r, c, ch)));
+      }
+    }
+    long double var = 0;
+    for (int r = 0; r < src.rows(); ++r) {
+      for (int c = 0; c < src.cols(); ++c) {
+        const long double d = *src(r, c, ch) - s / count;
+        var += d * d;
+      }
+    }
+    sum[ch] = static_cast<double>(s);
+    l1[ch] = static_cast<double>(a);
+    mean[ch] = static_cast<double>(s / count);
+    stddev[ch] = static_cast<double>(std::sqrt(var / count));
+  }
+}
+
+template <typename T, int C>
+void CheckMoments(const core::MatView<T, C>& src, core::ThreadPool* pool) {
+  double sum[C];
+  double l1[C];
+  double mean[C];
+  double stddev[C];
+  ReferenceMoments(src, sum, l1, mean, stddev);
+  const double count = static_cast<double>(src.rows()) * src.cols();
+  const std::array<double, C> s = core::Sum(src);
+  const std::array<double, C> m = core::Mean(src);
+  const core::MeanStdDevResult<C> ms = core::MeanStdDev(src);
+  for (int ch = 0; ch < C; ++ch) {
+    // Within a float rounding of the magnitude of the data, whatever the image size
+    EXPECT_NEAR(s[ch], sum[ch], 1e-7 * l1[ch]);
+    EXPECT_NEAR(m[ch], mean[ch], 1e-7 * l1[ch] / count);
+    EXPECT_NEAR(ms.mean[ch], mean[ch], 1e-7 * l1[ch] / count);
+    EXPECT_NEAR(ms.stddev[ch], stddev[ch], 1e-6 * stddev[ch] + 1e-9);
+  }
+  // Bit-identical with a pool
+  EXPECT_EQ(core::Sum(src, pool), s);
+  const core::MeanStdDevResult<C> parallel = core::MeanStdDev(src, pool);
+  EXPECT_EQ(parallel.mean, ms.mean);
+  EXPECT_EQ(parallel.stddev, ms.stddev);
+}
+
+template <typename T, int C>
+void CheckMinMax(const core::MatView<T, C>& src, core::ThreadPool* pool) {
+  const std::array<core::MinMaxLoc, C> result = core::MinMax(src);
+  for (int ch = 0; ch < C; ++ch) {
+    core::MinMaxLoc ref{double(*src(0, 0, ch)), double(*src(0, 0, ch)), 0, 0, 0, 0};
+    for (int r = 0; r < src.rows(); ++r) {
+      for (int c = 0; c < src.cols(); ++c) {
+        const double v = *src(r, c, ch);
+        if (v < ref.min) ref = {v, ref.max, c, r, ref.max_x, ref.max_y};
+        if (v > ref.max) ref = {ref.min, v, ref.min_x, ref.min_y, c, r};
+      }
+    }
+    EXPECT_EQ(result[ch].min, ref.min);
+    EXPECT_EQ(result[ch].max, ref.max);
+    EXPECT_EQ(result[ch].min_x, ref.min_x);
+    EXPECT_EQ(result[ch].min_y, ref.min_y);
+    EXPECT_EQ(result[ch].max_x, ref.max_x);
+    EXPECT_EQ(result[ch].max_y, ref.max_y);
+  }
+  const std::array<core::MinMaxLoc, C> parallel = core::MinMax(src, pool);
+  for (int ch = 0; ch < C; ++ch) {
+    EXPECT_EQ(parallel[ch].min_x, result[ch].min_x);
+    EXPECT_EQ(parallel[ch].min_y, result[ch].min_y);
+    EXPECT_EQ(parallel[ch].max_x, result[ch].max_x);
+    EXPECT_EQ(parallel[ch].max_y, result[ch].max_y);
+  }
+}
+
+}  // namespace
+
+TEST(MatReduceTest, Float) {
+  core::ThreadPool pool(3);
+  core::Mat<float, 1> gray(517, 1031);
+  core::Mat<float, 3> rgb(301, 777);
+  core::Mat<float, 4> rgba(123, 345);
+  // Large offset, small spread: the naive single pass variance would cancel out
+  std::mt19937 gen(1);
+  FillRandom<float, 1>(gray, gen, 1000.0f, 1001.0f);
+  FillRandom<float, 3>(rgb, gen, -5.0f, 5.0f);
+  FillRandom<float, 4>(rgba, gen, 0.0f, 1.0f);
+  ForEachIsa([&] {
+    CheckMoments<float, 1>(gray, &pool);
+    CheckMoments<float, 3>(rgb, &pool);
+    CheckMoments<float, 4>(rgba, &pool);
+    CheckMoments<float, 3>(rgb.Roi(3, 7, 101, 55), &pool);
+    CheckMinMax<float, 1>(gray, &pool);
+    CheckMinMax<float, 3>(rgb, &pool);
+    CheckMinMax<float, 3>(rgb.Roi(1, 2, 5, 3), &pool);
+  });
+}
+
+TEST(MatReduceTest, Uint8) {
+  core::ThreadPool pool(2);
+  core::Mat<uint8_t, 1> gray(1001, 999);
+  core::Mat<uint8_t, 2> pairs(77, 1333);
+  core::Mat<uint8_t, 3> rgb(211, 303);
+  core::Mat<uint8_t, 4> rgba(640, 480);
+  std::mt19937 gen(4);
+  FillRandom<uint8_t, 1>(gray, gen, 0.0f, 256.0f);
+  FillRandom<uint8_t, 2>(pairs, gen, 10.0f, 200.0f);
+  FillRandom<uint8_t, 3>(rgb, gen, 0.0f, 256.0f);
+  FillRandom<uint8_t, 4>(rgba, gen, 0.0f, 256.0f);
+  // Extrema repeated: the first occurrence is reported
+  *gray(500, 10) = 0;
+  *gray(700, 3) = 0;
+  *gray(2, 998) = 255;
+  ForEachIsa([&] {
+    CheckMoments<uint8_t, 1>(gray, &pool);
+    CheckMoments<uint8_t, 2>(pairs, &pool);
+    CheckMoments<uint8_t, 3>(rgb, &pool);
+    CheckMoments<uint8_t, 4>(rgba.Roi(13, 17, 301, 200), &pool);
+    CheckMinMax<uint8_t, 1>(gray, &pool);
+    CheckMinMax<uint8_t, 2>(pairs, &pool);
+    CheckMinMax<uint8_t, 4>(rgba, &pool);
+  });
+}
+
+TEST(MatReduceTest, GenericTypes) {
+  core::Mat<int16_t, 2> mat(31, 17);
+  std::mt19937 gen(8);
+  FillRandom<int16_t, 2>(mat, gen, -3000.0f, 3000.0f);
+  CheckMoments<int16_t, 2>(mat, nullptr);
+  CheckMinMax<int16_t, 2>(mat, nullptr);
+  core::Mat<double, 1> empty(0, 5);
+  EXPECT_EQ(core::Sum(empty)[0], 0.0);
+  EXPECT_THROW(core::MinMax(empty), std::invalid_argument);
+  core::Mat<float, 1> empty_float(4, 0);
+  EXPECT_THROW(core::Mean(empty_float), std::invalid_argument);
+}
+
+TEST(MatReduceTest, Histogram) {
+  core::ThreadPool pool(4);
+  std::mt19937 gen(9);
+  core::Mat<uint8_t, 3> rgb(401, 333);
+  FillRandom<uint8_t, 3>(rgb, gen, 0.0f, 256.0f);
+  core::Mat<uint8_t, 1> gray(599, 701);
+  FillRandom<uint8_t, 1>(gray, gen, 0.0f, 256.0f);
+
+  const auto rgb_hist = core::Histogram(rgb);
+  const auto gray_hist = core::Histogram(gray, &pool);
+  std::vector<uint64_t> ref(3 * 256);
+  std::vector<uint64_t> gray_ref(256);
+  for (int r = 0; r < rgb.rows(); ++r) {
+    for (int c = 0; c < rgb.cols(); ++c) {
+      for (int ch = 0; ch < 3; ++ch) ++ref[ch * 256 + *rgb(r, c, ch)];
+    }
+  }
+  for (int r = 0; r < gray.rows(); ++r) {
+    for (int c = 0; c < gray.cols(); ++c) ++gray_ref[*gray(r, c)];
+  }
+  for (int v = 0; v < 256; ++v) {
+    for (int ch = 0; ch < 3; ++ch) EXPECT_EQ(rgb_hist[ch][v], ref[ch * 256 + v]);
+    EXPECT_EQ(gray_hist[0][v], gray_ref[v]);
+  }
+  EXPECT_EQ(core::Histogram(rgb, &pool), rgb_hist);
+
+  core::Mat<float, 2> values(2, 4);
+  const float data[] = {0.0f, -1.0f, 0.5f, 1.0f,  0.99f, 2.0f,   0.25f, NAN,
+                        1.0f, 0.74f, 0.0f, 0.75f, 0.26f, -0.1f, 0.5f,  0.49f};
+  for (int i = 0; i < 16; ++i) values.data()[i / 8 * values.step() / 4 + i % 8] = data[i];
+  const auto hist = core::Histogram(values, 4, 0.0f, 1.0f, &pool);
+  EXPECT_EQ(hist[0], (std::vector<uint64_t>{2, 2, 2, 2}));
+  EXPECT_EQ(hist[1], (std::vector<uint64_t>{0, 1, 1, 2}));
+  EXPECT_THROW(core::Histogram(values, 0, 0.0f, 1.0f), std::invalid_argument);
+  EXPECT_THROW(core::Histogram(values, 4, 1.0f, 1.0f), std::invalid_argument);
+}
+
+TEST(MatReduceTest, Performance) {
+  core::ThreadPool pool;
+  core::Mat<float, 1> src(3000, 4000);
+  src.Random();
+  core::Mat<uint8_t, 4> rgba(3000, 4000);
+  core::Timer timer;
+
+  for (core::ThreadPool* p : {static_cast<core::ThreadPool*>(nullptr), &pool}) {
+    const std::size_t threads = p ? p->size() : 1;
+    timer.start();
+    const core::MeanStdDevResult<1> ms = core::MeanStdDev(src, p);
+    timer.end();
+    printf("MeanStdDev 12MP f32 (%s, %zu threads): %fms\n", core::SimdIsaName(core::GetSimdIsa()),
+           threads, timer.time());
+    EXPECT_NEAR(ms.mean[0], 0.5, 1e-2);
+
+    timer.start();
+    const std::array<core::MinMaxLoc, 1> mm = core::MinMax(src, p);
+    timer.end();
+    printf("MinMax 12MP f32 (%s, %zu threads): %fms\n", core::SimdIsaName(core::GetSimdIsa()),
+           threads, timer.time());
+    EXPECT_LE(mm[0].min, mm[0].max);
+
+    timer.start();
+    const std::array<double, 4> sum = core::Sum(rgba, p);
+    timer.end();
+    printf("Sum 12MP rgba8 (%s, %zu threads): %fms\n", core::SimdIsaName(core::GetSimdIsa()),
+           threads, timer.time());
+    EXPECT_EQ(sum[3], 0.0);
+  }
+}
+
+}  // namespace test
+}  // namespace core
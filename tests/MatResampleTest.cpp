@@ -0,0 +1,355 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Mat.h"
+#include "MatOps.h"
+#include "MatResample.h"
+#include "MatTestUtils.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+
+namespace core {
+namespace test {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Keys cubic convolution kernel, piecewise form.
+double Keys(double d) {
+  const double a = -0.75;
+  d = std::fabs(d);
+  if (d <= 1.0) return ((a + 2.0) * d - (a + 3.0)) * d * d + 1.0;
+  if (d < 2.0) return ((a * d - 5.0 * a) * d + 8.0 * a) * d - 4.0 * a;
+  return 0.0;
+}
+
+// Channel ch of src sampled at (x, y) in double precision, the obvious way. With quantize the
+// position is first rounded to 1/32 pixel like the fixed-point tables.
+template <typename T, int C>
+double ReferenceSample(const core::MatView<T, C>& src, double x, double y, int ch,
+                       core::Interpolation interpolation, core::BorderMode border,
+                       float border_value, bool quantize = true) {
+  auto pixel = [&](int sx, int sy) -> double {
+    const bool inside = sx >= 0 && sx < src.cols() && sy >= 0 && sy < src.rows();
+    if (!inside && border == core::BorderMode::Constant) return border_value;
+    return *src(ReferenceBorder(sy, src.rows(), border), ReferenceBorder(sx, src.cols(), border),
+                ch);
+  };
+  if (interpolation == core::Interpolation::Nearest) {
+    return pixel(static_cast<int>(std::floor(x + 0.5)), static_cast<int>(std::floor(y + 0.5)));
+  }
+  if (quantize) {
+    x = std::nearbyint(x * 32.0) / 32.0;
+    y = std::nearbyint(y * 32.0) / 32.0;
+  }
+  const int x0 = static_cast<int>(std::floor(x));
+  const int y0 = static_cast<int>(std::floor(y));
+  const int reach = interpolation == core::Interpolation::Cubic ? 2 : 1;
+  double acc = 0.0;
+  for (int sy = y0 - reach + 1; sy <= y0 + reach; ++sy) {
+    for (int sx = x0 - reach + 1; sx <= x0 + reach; ++sx) {
+      const double wx = reach == 2 ? Keys(x - sx) : 1.0 - std::fabs(x - sx);
+      const double wy = reach == 2 ? Keys(y - sy) : 1.0 - std::fabs(y - sy);
+      acc += wx * wy * pixel(sx, sy);
+    }
+  }
+  return acc;
+}
+
+// Largest difference between dst and the reference sampling of src at map(x, y, &sx, &sy).
+template <typename T, int C, typename Map>
+double MaxSampleError(const core::MatView<T, C>& src, const core::MatView<T, C>& dst, Map&& map,
+                      core::Interpolation interpolation, core::BorderMode border,
+                      float border_value) {
+  double err = 0.0;
+  for (int y = 0; y < dst.rows(); ++y) {
+    for (int x = 0; x < dst.cols(); ++x) {
+      double sx;
+      double sy;
+      map(x, y, &sx, &sy);
+      for (int ch = 0; ch < C; ++ch) {
+        double ref = ReferenceSample(src, sx, sy, ch, interpolation, border, border_value);
+        if constexpr (std::is_same_v<T, std::uint8_t>) {
+          ref = std::clamp(std::floor(ref + 0.5), 0.0, 255.0);
+        }
+        err = std::max(err, std::fabs(*dst(y, x, ch) - ref));
+      }
+    }
+  }
+  return err;
+}
+
+template <typename T, int C>
+double MaxWarpError(const core::MatView<T, C>& src, const core::MatView<T, C>& dst,
+                    const std::array<double, 9>& m, core::Interpolation interpolation,
+                    core::BorderMode border, float border_value) {
+  auto map = [&m](int x, int y, double* sx, double* sy) {
+    const double w = m[6] * x + m[7] * y + m[8];
+    *sx = (m[0] * x + m[1] * y + m[2]) / w;
+    *sy = (m[3] * x + m[4] * y + m[5]) / w;
+  };
+  return MaxSampleError(src, dst, map, interpolation, border, border_value);
+}
+
+// Rotation by degrees about (cx, cy) combined with a scale, mapping destination to source.
+std::array<double, 6> Rotation(double degrees, double scale, double cx, double cy) {
+  const double c = std::cos(degrees * kPi / 180.0) * scale;
+  const double s = std::sin(degrees * kPi / 180.0) * scale;
+  return {c, -s, cx - c * cx + s * cy, s, c, cy - s * cx - c * cy};
+}
+
+std::array<double, 9> ToHomography(const std::array<double, 6>& m) {
+  return {m[0], m[1], m[2], m[3], m[4], m[5], 0.0, 0.0, 1.0};
+}
+
+const core::Interpolation kInterpolations[] = {
+    core::Interpolation::Nearest, core::Interpolation::Linear, core::Interpolation::Cubic};
+const core::BorderMode kBorders[] = {core::BorderMode::Clamp, core::BorderMode::Reflect,
+                                     core::BorderMode::Constant};
+
+}  // namespace
+
+TEST(MatResampleTest, WarpAffineFloat) {
+  core::ThreadPool pool(3);
+  core::Mat<float, 3> src(37, 53);
+  src.Random(1);
+  const std::array<double, 6> m = Rotation(20.0, 1.1, 26.0, 18.0);
+
+  ForEachIsa([&] {
+    for (core::Interpolation interpolation : kInterpolations) {
+      for (core::BorderMode border : kBorders) {
+        core::Mat<float, 3> serial(41, 60);
+        core::WarpAffine(src, serial, m, interpolation, border, 0.5f);
+        EXPECT_LT(MaxWarpError(src, serial, ToHomography(m), interpolation, border, 0.5f), 1e-5);
+
+        core::Mat<float, 3> parallel(41, 60);
+        core::WarpAffine(src, parallel, m, interpolation, border, 0.5f, &pool);
+        EXPECT_TRUE(SamePixels(parallel, serial));
+      }
+    }
+  });
+}
+
+TEST(MatResampleTest, WarpAffineUint8) {
+  core::ThreadPool pool(2);
+  core::Mat<uint8_t, 4> rgba(50, 70);
+  rgba.Random(2);
+  core::Mat<uint8_t, 1> gray(50, 70);
+  gray.Random(3);
+  const std::array<double, 6> m = Rotation(-33.0, 0.8, 30.0, 20.0);
+
+  ForEachIsa([&] {
+    for (core::Interpolation interpolation : kInterpolations) {
+      for (core::BorderMode border : kBorders) {
+        // 14-bit weights round differently from doubles by at most one step
+        core::Mat<uint8_t, 4> dst(64, 80);
+        core::WarpAffine(rgba, dst, m, interpolation, border, 200.0f);
+        EXPECT_LE(MaxWarpError(rgba, dst, ToHomography(m), interpolation, border, 200.0f), 1.0);
+
+        core::Mat<uint8_t, 4> parallel(64, 80);
+        core::WarpAffine(rgba, parallel, m, interpolation, border, 200.0f, &pool);
+        EXPECT_TRUE(SamePixels(parallel, dst));
+
+        core::Mat<uint8_t, 1> gray_dst(64, 80);
+        core::WarpAffine(gray, gray_dst, m, interpolation, border, 7.0f);
+        EXPECT_LE(MaxWarpError(gray, gray_dst, ToHomography(m), interpolation, border, 7.0f),
+                  1.0);
+      }
+    }
+  });
+}
+
+TEST(MatResampleTest, WarpPerspectiveAndRemap) {
+  core::Mat<float, 2> src(40, 40);
+  src.Random(4);
+  const std::array<double, 9> m = {0.9, 0.1, 2.0, -0.05, 1.1, 1.0, 0.002, -0.001, 1.0};
+  // The same transform as maps, rounded to float
+  core::Mat<float, 1> map_x(45, 45);
+  core::Mat<float, 1> map_y(45, 45);
+  for (int y = 0; y < 45; ++y) {
+    for (int x = 0; x < 45; ++x) {
+      const double w = m[6] * x + m[7] * y + m[8];
+      *map_x(y, x) = static_cast<float>((m[0] * x + m[1] * y + m[2]) / w);
+      *map_y(y, x) = static_cast<float>((m[3] * x + m[4] * y + m[5]) / w);
+    }
+  }
+
+  for (core::Interpolation interpolation : kInterpolations) {
+    core::Mat<float, 2> warped(45, 45);
+    core::WarpPerspective(src, warped, m, interpolation, core::BorderMode::Reflect);
+    EXPECT_LT(MaxWarpError(src, warped, m, interpolation, core::BorderMode::Reflect, 0.0f), 1e-5);
+
+    const core::RemapTable table(map_x, map_y, interpolation);
+    core::Mat<float, 2> remapped(45, 45);
+    core::Remap(src, remapped, table, core::BorderMode::Reflect);
+    auto map = [&](int x, int y, double* sx, double* sy) {
+      *sx = *map_x(y, x);
+      *sy = *map_y(y, x);
+    };
+    EXPECT_LT(MaxSampleError(src, remapped, map, interpolation, core::BorderMode::Reflect, 0.0f),
+              1e-5);
+    core::Mat<float, 2> one_off(45, 45);
+    core::Remap(src, one_off, map_x, map_y, interpolation, core::BorderMode::Reflect);
+    EXPECT_TRUE(SamePixels(one_off, remapped));
+  }
+
+  // Behind the projection center and NaN maps land outside the image
+  core::Mat<float, 2> dst(4, 4);
+  core::WarpPerspective(src, dst, {1, 0, 0, 0, 1, 0, 0, 0, -1}, core::Interpolation::Linear,
+                        core::BorderMode::Constant, 3.0f);
+  EXPECT_EQ(*dst(2, 2, 1), 3.0f);
+  core::Mat<float, 1> nan_map(4, 4);
+  nan_map.Fill(NAN);
+  core::Remap(src, dst, nan_map, nan_map, core::Interpolation::Cubic, core::BorderMode::Constant,
+              5.0f);
+  EXPECT_EQ(*dst(1, 3, 0), 5.0f);
+
+  core::Mat<float, 1> small(3, 4);
+  EXPECT_THROW(core::RemapTable(map_x, small), std::invalid_argument);
+  EXPECT_THROW(core::RemapTable(map_x, map_y, core::Interpolation::Area), std::invalid_argument);
+  EXPECT_THROW(core::Remap(src, dst, core::RemapTable(map_x, map_y)), std::invalid_argument);
+}
+
+TEST(MatResampleTest, Identity) {
+  core::Mat<uint8_t, 4> src(33, 65);
+  src.Random(5);
+  core::Mat<float, 3> srcf(33, 65);
+  srcf.Random(6);
+  const std::array<double, 6> identity = {1, 0, 0, 0, 1, 0};
+  ForEachIsa([&] {
+    for (core::Interpolation interpolation : kInterpolations) {
+      for (core::BorderMode border : kBorders) {
+        core::Mat<uint8_t, 4> dst(33, 65);
+        core::WarpAffine(src, dst, identity, interpolation, border);
+        EXPECT_TRUE(SamePixels(dst, src));
+        core::Mat<float, 3> dstf(33, 65);
+        core::WarpAffine(srcf, dstf, identity, interpolation, border);
+        EXPECT_TRUE(SamePixels(dstf, srcf));
+      }
+    }
+    core::Mat<uint8_t, 4> same_size(33, 65);
+    core::Resize(src, same_size, core::Interpolation::Cubic);
+    EXPECT_TRUE(SamePixels(same_size, src));
+  });
+}
+
+TEST(MatResampleTest, Resize) {
+  core::ThreadPool pool(3);
+  core::Mat<float, 2> src(30, 41);
+  src.Random(7);
+
+  ForEachIsa([&] {
+    for (core::Interpolation interpolation : kInterpolations) {
+      for (const std::array<int, 2> size : {std::array<int, 2>{45, 70}, {13, 17}, {30, 20}}) {
+        core::Mat<float, 2> dst(size[0], size[1]);
+        core::Resize(src, dst, interpolation);
+        const double sy = 30.0 / size[0];
+        const double sx = 41.0 / size[1];
+        double err = 0.0;
+        for (int y = 0; y < size[0]; ++y) {
+          for (int x = 0; x < size[1]; ++x) {
+            for (int ch = 0; ch < 2; ++ch) {
+              const double ref = ReferenceSample(src, (x + 0.5) * sx - 0.5, (y + 0.5) * sy - 0.5,
+                                                 ch, interpolation, core::BorderMode::Clamp, 0.0f,
+                                                 false);
+              err = std::max(err, std::fabs(*dst(y, x, ch) - ref));
+            }
+          }
+        }
+        EXPECT_LT(err, 1e-5);
+
+        core::Mat<float, 2> parallel(size[0], size[1]);
+        core::Resize(src, parallel, interpolation, &pool);
+        EXPECT_TRUE(SamePixels(parallel, dst));
+      }
+    }
+  });
+}
+
+TEST(MatResampleTest, ResizeArea) {
+  core::Mat<float, 1> src(40, 60);
+  src.Random(8);
+  // Integer factor: mean of the covered block
+  core::Mat<float, 1> dst(10, 20);
+  core::Resize(src, dst, core::Interpolation::Area);
+  double err = 0.0;
+  for (int y = 0; y < 10; ++y) {
+    for (int x = 0; x < 20; ++x) {
+      double sum = 0.0;
+      for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 3; ++i) sum += *src(4 * y + j, 3 * x + i);
+      }
+      err = std::max(err, std::fabs(*dst(y, x) - sum / 12.0));
+    }
+  }
+  EXPECT_LT(err, 1e-5);
+
+  // Any size keeps a constant image constant
+  core::Mat<uint8_t, 3> flat(97, 131);
+  flat.Fill(77);
+  for (core::Interpolation interpolation :
+       {core::Interpolation::Nearest, core::Interpolation::Linear, core::Interpolation::Cubic,
+        core::Interpolation::Area}) {
+    for (const std::array<int, 2> size : {std::array<int, 2>{13, 29}, {100, 250}, {40, 131}}) {
+      core::Mat<uint8_t, 3> out(size[0], size[1]);
+      core::Resize(flat, out, interpolation);
+      for (int y = 0; y < size[0]; ++y) {
+        for (int i = 0; i < size[1] * 3; ++i) ASSERT_EQ(out.row(y)[i], 77);
+      }
+    }
+  }
+  core::Mat<uint8_t, 3> empty(0, 0);
+  EXPECT_THROW(core::Resize(empty, flat), std::invalid_argument);
+}
+
+TEST(MatResampleTest, InvertAffine) {
+  const std::array<double, 6> m = Rotation(35.0, 1.7, 10.0, -4.0);
+  const std::array<double, 6> inv = core::InvertAffine(m);
+  for (const std::array<double, 2> p : {std::array<double, 2>{0, 0}, {3, 7}, {-20, 11}}) {
+    const double x = m[0] * p[0] + m[1] * p[1] + m[2];
+    const double y = m[3] * p[0] + m[4] * p[1] + m[5];
+    EXPECT_NEAR(inv[0] * x + inv[1] * y + inv[2], p[0], 1e-9);
+    EXPECT_NEAR(inv[3] * x + inv[4] * y + inv[5], p[1], 1e-9);
+  }
+  EXPECT_THROW(core::InvertAffine({1, 2, 0, 2, 4, 0}), std::invalid_argument);
+}
+
+TEST(MatResampleTest, Performance) {
+  core::ThreadPool pool;
+  core::Mat<uint8_t, 4> src(2160, 3840);
+  src.Random(9);
+  core::Mat<uint8_t, 4> dst(2160, 3840, core::kMatUninitialized);
+  const std::array<double, 6> m = Rotation(10.0, 1.0, 1920.0, 1080.0);
+  core::Timer timer;
+
+  timer.start();
+  core::WarpAffine(src, dst, m);
+  timer.end();
+  printf("WarpAffine bilinear 4K RGBA8 (%s, 1 thread): %fms\n",
+         core::SimdIsaName(core::GetSimdIsa()), timer.time());
+
+  core::Mat<uint8_t, 4> parallel(2160, 3840, core::kMatUninitialized);
+  timer.start();
+  core::WarpAffine(src, parallel, m, core::Interpolation::Linear, core::BorderMode::Constant, 0.0f,
+                   &pool);
+  timer.end();
+  printf("WarpAffine bilinear 4K RGBA8 (%s, %zu threads): %fms\n",
+         core::SimdIsaName(core::GetSimdIsa()), pool.size(), timer.time());
+  EXPECT_TRUE(SamePixels(parallel, dst));
+
+  core::Mat<uint8_t, 4> half(1080, 1920, core::kMatUninitialized);
+  timer.start();
+  core::Resize(src, half, core::Interpolation::Linear, &pool);
+  timer.end();
+  printf("Resize bilinear 4K -> 1080p RGBA8 (%s, %zu threads): %fms\n",
+         core::SimdIsaName(core::GetSimdIsa()), pool.size(), timer.time());
+}
+
+}  // namespace test
+}  // namespace core
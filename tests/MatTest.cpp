@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <vector>
+
 #include "Mat.h"
 
 namespace core {
@@ -30,10 +33,14 @@ TEST(MatTest2, test) {
 
   core::Mat<float, 3> mat_copy = mat.clone();
 
-  auto* ptr1 = mat.data();
-  auto* ptr2 = mat_copy.data();
-  for (int i = 0; i < mat.total(); ++i) {
-    EXPECT_EQ(ptr1[i], ptr2[i]);
+  EXPECT_NE(mat.data(), mat_copy.data());
+  EXPECT_EQ(mat.step(), mat_copy.step());
+  for (int r = 0; r < mat.rows(); ++r) {
+    for (int c = 0; c < mat.cols(); ++c) {
+      for (int ch = 0; ch < mat.channels(); ++ch) {
+        EXPECT_EQ(*mat(r, c, ch), *mat_copy(r, c, ch));
+      }
+    }
   }
 }
 
@@ -52,5 +59,59 @@ TEST(MatTest3, test) {
   }
 }
 
+TEST(MatStepTest, test) {
+  core::Mat<float, 3> mat(5, 7);
+  EXPECT_EQ(mat.step() % core::kMatRowAlign, 0u);
+  EXPECT_GE(mat.step(), 7 * 3 * sizeof(float));
+  EXPECT_FALSE(mat.isContinuous());
+  for (int r = 0; r < mat.rows(); ++r) {
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(mat.row(r)) % core::kMatRowAlign, 0u);
+  }
+
+  core::Mat<float, 3> packed(5, 7, core::kMatNoPadding);
+  EXPECT_EQ(packed.step(), 7 * 3 * sizeof(float));
+  EXPECT_TRUE(packed.isContinuous());
+
+  // Round trip through a tightly packed buffer
+  std::vector<float> flat(mat.total());
+  for (size_t i = 0; i < flat.size(); ++i) flat[i] = static_cast<float>(i);
+  mat.CopyFrom(flat.data());
+  EXPECT_EQ(*mat(1, 0, 0), 21.0f);
+  std::vector<float> out(mat.total());
+  mat.CopyTo(out.data());
+  EXPECT_EQ(flat, out);
+}
+
+TEST(MatRoiTest, test) {
+  core::Mat<int, 2> mat(6, 8);
+  for (int r = 0; r < mat.rows(); ++r) {
+    for (int c = 0; c < mat.cols(); ++c) {
+      *mat(r, c, 0) = r;
+      *mat(r, c, 1) = c;
+    }
+  }
+
+  core::MatView<int, 2> roi = mat.Roi(2, 1, 4, 3);
+  EXPECT_EQ(roi.rows(), 3);
+  EXPECT_EQ(roi.cols(), 4);
+  EXPECT_EQ(roi.step(), mat.step());
+  EXPECT_EQ(*roi(0, 0, 0), 1);
+  EXPECT_EQ(*roi(0, 0, 1), 2);
+  EXPECT_EQ(*roi(2, 3, 0), 3);
+  EXPECT_EQ(*roi(2, 3, 1), 5);
+
+  // Writes through the ROI land in the parent, nothing outside it is touched
+  roi.Fill(-1);
+  for (int r = 0; r < mat.rows(); ++r) {
+    for (int c = 0; c < mat.cols(); ++c) {
+      const bool inside = r >= 1 && r < 4 && c >= 2 && c < 6;
+      EXPECT_EQ(*mat(r, c, 0), inside ? -1 : r);
+    }
+  }
+
+  core::MatView<int, 2> nested = roi.Roi(1, 1, 2, 2);
+  EXPECT_EQ(nested(0, 0), mat(2, 3));
+}
+
 }  // namespace test
 }  // namespace core
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+
+#include "Mat.h"
+#include "MatFilter.h"
+#include "MatOps.h"
+
+namespace core {
+namespace test {
+
+// Fills mat with values drawn uniformly from [lo, hi), truncated to T.
+template <typename T, int C>
+void FillRandom(core::MatView<T, C> mat, std::mt19937& gen, float lo, float hi) {
+  std::uniform_real_distribution<float> dist(lo, hi);
+  for (int r = 0; r < mat.rows(); ++r) {
+    for (int i = 0; i < mat.cols() * C; ++i) mat.row(r)[i] = static_cast<T>(dist(gen));
+  }
+}
+
+template <typename T, int C>
+bool SamePixels(const core::MatView<T, C>& a, const core::MatView<T, C>& b) {
+  if (a.rows() != b.rows() || a.cols() != b.cols()) return false;
+  for (int r = 0; r < a.rows(); ++r) {
+    if (std::memcmp(a.row(r), b.row(r), a.row_bytes()) != 0) return false;
+  }
+  return true;
+}
+
+// Index i of a line of n pixels mapped back inside it, the obvious way. Constant borders are left
+// to the caller.
+inline int ReferenceBorder(int i, int n, core::BorderMode border) {
+  while (i < 0 || i >= n) {
+    if (border == core::BorderMode::Clamp || n == 1) return i < 0 ? 0 : n - 1;
+    i = i < 0 ? -i : 2 * (n - 1) - i;
+  }
+  return i;
+}
+
+// Runs fn once for every instruction set available on this machine.
+template <typename Fn>
+void ForEachIsa(Fn&& fn) {
+  const core::SimdIsa original = core::GetSimdIsa();
+  for (core::SimdIsa isa : {core::SimdIsa::Scalar, core::SimdIsa::SSE4, core::SimdIsa::AVX2,
+                            core::SimdIsa::NEON}) {
+    if (!core::SetSimdIsa(isa)) continue;
+    SCOPED_TRACE(core::SimdIsaName(isa));
+    fn();
+  }
+  core::SetSimdIsa(original);
+}
+
+}  // namespace test
+}  // namespace core
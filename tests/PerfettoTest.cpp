@@ -3,7 +3,9 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <stdexcept>
 #include <thread>
 
 #include "Trace.h"
@@ -45,4 +47,53 @@ TEST(Perfetto, test1) {
   trace->StopTracing();
 }
 
+TEST(Perfetto, streaming) {
+  core::trace::TraceOptions options;
+  options.buffer_size_kb = 0;
+  EXPECT_THROW(core::trace::Trace("test2.perf", options), std::invalid_argument);
+
+  options.streaming = true;
+  options.buffer_size_kb = 256;
+  options.file_write_period_ms = 100;
+  options.flush_period_ms = 100;
+  core::trace::Trace trace("test2.perf", options);
+  trace.InitializeTracing();
+  trace.StartTracing();
+  trace.SetTraceProcess("test2");
+
+  for (int i = 0; i < 10; ++i) {
+    TRACE_EVENT("rendering", "Frame", "index", i);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // Events reach the file while tracing, a file write period or so after the flush
+  trace.Flush();
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  auto streamed = std::filesystem::file_size("test2.perf");
+  while (streamed == 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    streamed = std::filesystem::file_size("test2.perf");
+  }
+  EXPECT_GT(streamed, 0u);
+
+  TRACE_EVENT_INSTANT("rendering", "Last");
+  trace.StopTracing();
+  EXPECT_GE(std::filesystem::file_size("test2.perf"), streamed);
+}
+
+TEST(Perfetto, lifetime) {
+  core::trace::TraceOptions options;
+  options.streaming = true;
+  core::trace::Trace trace("test3.perf", options);
+  trace.InitializeTracing();
+  trace.Flush();
+  EXPECT_THROW(trace.StopTracing(), std::runtime_error);
+  trace.StartTracing();
+  EXPECT_THROW(trace.StartTracing(), std::runtime_error);
+  trace.StopTracing();
+  // Restarted and left running: the destructor stops it and closes the file
+  trace.StartTracing();
+  TRACE_EVENT_INSTANT("rendering", "Unfinished");
+}
+
 #endif  // CORE_ENABLE_TRACE
\ No newline at end of file
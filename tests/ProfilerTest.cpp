@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Profiler.h"
+
+namespace core {
+namespace test {
+
+namespace {
+
+void Sleep(int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+}  // namespace
+
+TEST(ProfilerTest, CallTree) {
+  core::Profiler profiler;
+  profiler.set_thread_name("main");
+  {
+    core::ProfileZone update("update", profiler);
+    for (int i = 0; i < 3; ++i) {
+      core::ProfileZone physics("physics", profiler);
+      Sleep(2);
+    }
+    core::ProfileZone render("render", profiler);
+    Sleep(1);
+  }
+  std::thread worker([&profiler] {
+    profiler.set_thread_name("worker");
+    core::ProfileZone decode("decode", profiler);
+  });
+  worker.join();
+
+  const core::ProfileNode& frame = profiler.frame();
+  ASSERT_EQ(frame.children.size(), 2u);
+  const core::ProfileNode* update = frame.child("main")->child("update");
+  ASSERT_NE(update, nullptr);
+  EXPECT_EQ(update->calls, 1u);
+  ASSERT_EQ(update->children.size(), 2u);
+  const core::ProfileNode* physics = update->child("physics");
+  ASSERT_NE(physics, nullptr);
+  EXPECT_EQ(physics->calls, 3u);
+  EXPECT_GE(physics->inclusive, std::chrono::milliseconds(5));
+  EXPECT_GE(update->inclusive, physics->inclusive + update->child("render")->inclusive);
+  EXPECT_EQ(update->exclusive(),
+            update->inclusive - physics->inclusive - update->child("render")->inclusive);
+  EXPECT_NE(frame.child("worker")->child("decode"), nullptr);
+  EXPECT_GE(frame.inclusive, update->inclusive);
+
+  // A zone still open when the frame ends is reported, with its children, in the next frame
+  {
+    core::ProfileZone load("load", profiler);
+    { core::ProfileZone parse("parse", profiler); }
+    EXPECT_EQ(profiler.frame().children.size(), 0u);
+  }
+  const core::ProfileNode& next = profiler.frame();
+  ASSERT_NE(next.child("main")->child("load"), nullptr);
+  EXPECT_EQ(next.child("main")->child("load")->child("parse")->calls, 1u);
+
+  EXPECT_EQ(profiler.total().calls, 3u);
+  EXPECT_EQ(profiler.total().child("main")->child("update")->child("physics")->calls, 3u);
+  EXPECT_EQ(profiler.dropped(), 0u);
+  profiler.reset();
+  EXPECT_EQ(profiler.total().calls, 0u);
+}
+
+TEST(ProfilerTest, Report) {
+  core::Profiler profiler;
+  profiler.set_thread_name("main");
+  {
+    core::ProfileZone outer("outer", profiler);
+    core::ProfileZone inner("inner", profiler);
+    Sleep(1);
+  }
+  profiler.frame();
+
+  std::ostringstream folded;
+  core::write_profile_folded(folded, profiler.total());
+  EXPECT_NE(folded.str().find("main;outer;inner "), std::string::npos);
+  EXPECT_EQ(folded.str().find("frame"), std::string::npos);
+
+  const std::string report = core::format_profile(profiler.total());
+  EXPECT_NE(report.find("incl ms"), std::string::npos);
+  EXPECT_NE(report.find("\n  outer"), std::string::npos);
+  EXPECT_NE(report.find("\n    inner"), std::string::npos);
+}
+
+TEST(ProfilerTest, Overflow) {
+  EXPECT_THROW(core::Profiler(100), std::invalid_argument);
+
+  // Zones closed past the ring capacity between two frames are dropped, not blocked on
+  core::Profiler profiler(4);
+  for (int i = 0; i < 6; ++i) core::ProfileZone zone("tick", profiler);
+  EXPECT_EQ(profiler.dropped(), 2u);
+  EXPECT_EQ(profiler.frame().children[0].child("tick")->calls, 4u);
+  for (int i = 0; i < 4; ++i) core::ProfileZone zone("tick", profiler);
+  EXPECT_EQ(profiler.frame().children[0].child("tick")->calls, 4u);
+}
+
+TEST(ProfilerTest, Macros) {
+  core::Profiler::instance().reset();
+  {
+    CORE_PROFILE_SCOPE("scope");
+    CORE_PROFILE_SCOPE("nested");
+  }
+  const core::ProfileNode& frame = CORE_PROFILE_FRAME();
+  EXPECT_EQ(frame.name, "frame");
+#ifdef CORE_ENABLE_PROFILER
+  EXPECT_NE(frame.children[0].child("scope")->child("nested"), nullptr);
+#else
+  EXPECT_TRUE(frame.children.empty());
+#endif
+}
+
+}  // namespace test
+}  // namespace core
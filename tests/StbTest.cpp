@@ -29,16 +29,19 @@ TEST(StbTest, test) {
 
   std::cout << "Loaded image " << width << "x" << height << " channels=" << channels << std::endl;
 
-  core::Mat<uint8_t, 3> mat(height, width);
-
-  uint8_t* mat_ptr = mat.data();
-  for (int i = 0; i < width * height * channels; ++i) {
-    float val = static_cast<float>(img[i]);
-    mat_ptr[i] = static_cast<uint8_t>(std::clamp(val * 1.2f, 0.0f, 255.0f));
+  core::Mat<uint8_t, 3> mat(height, width, core::kMatUninitialized);
+
+  for (int y = 0; y < height; ++y) {
+    uint8_t* mat_ptr = mat.row(y);
+    const unsigned char* img_ptr = img + y * width * 3;
+    for (int i = 0; i < width * 3; ++i) {
+      float val = static_cast<float>(img_ptr[i]);
+      mat_ptr[i] = static_cast<uint8_t>(std::clamp(val * 1.2f, 0.0f, 255.0f));
+    }
   }
 
-  const bool write_status =
-      stbi_write_png(kOutputPath.c_str(), width, height, channels, mat.data(), width * channels);
+  const bool write_status = stbi_write_png(kOutputPath.c_str(), width, height, 3, mat.data(),
+                                           static_cast<int>(mat.step()));
 
   stbi_image_free(img);
 
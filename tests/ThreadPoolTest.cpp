@@ -1,14 +1,31 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <numeric>
+#include <optional>
 #include <random>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include "BoundedQueue.h"
+#include "CompletionPoller.h"
+#include "InlineTask.h"
+#include "Task.h"
+#include "TaskGraph.h"
 #include "ThreadPool.h"
 #include "Timer.h"
+#include "Topology.h"
+#include "WorkStealingDeque.h"
 
 namespace core {
 namespace test {
@@ -48,5 +65,1004 @@ TEST(ThreadPoolTest, test) {
   EXPECT_NEAR(total, check, 0.001f);
 }
 
+TEST(ThreadPoolTest, WorkStealingDeque) {
+  // The owner pushes and pops while thieves steal: every item comes out exactly once
+  constexpr int kItems = 200000;
+  core::detail::WorkStealingDeque<int> deque(4);
+  std::vector<std::atomic<int>> seen(kItems);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < 3; ++i) {
+    thieves.emplace_back([&] {
+      int item;
+      while (!done.load()) {
+        if (deque.steal(&item)) seen[item].fetch_add(1);
+      }
+    });
+  }
+  int item;
+  for (int i = 0; i < kItems; ++i) {
+    deque.push(i);
+    if (i % 3 == 0 && deque.pop(&item)) seen[item].fetch_add(1);
+  }
+  while (deque.pop(&item)) seen[item].fetch_add(1);
+  done.store(true);
+  for (auto& t : thieves) t.join();
+
+  EXPECT_TRUE(deque.empty());
+  int missing = 0;
+  for (auto& s : seen) missing += s.load() != 1;
+  EXPECT_EQ(missing, 0);
+
+  // LIFO for the owner, FIFO for thieves
+  deque.push(1);
+  deque.push(2);
+  deque.push(3);
+  EXPECT_TRUE(deque.steal(&item));
+  EXPECT_EQ(item, 1);
+  EXPECT_TRUE(deque.pop(&item));
+  EXPECT_EQ(item, 3);
+}
+
+TEST(ThreadPoolTest, ManySmallTasks) {
+  core::ThreadPool pool(4);
+  std::atomic<int> count{0};
+  Timer t;
+  t.start();
+  for (int i = 0; i < 100000; ++i) {
+    pool.submit([&count] { count.fetch_add(1, std::memory_order_relaxed); });
+  }
+  pool.wait_idle();
+  t.end();
+  printf("100000 tasks submitted from outside: %fms\n", t.time());
+  EXPECT_EQ(count.load(), 100000);
+}
+
+TEST(ThreadPoolTest, NestedSubmit) {
+  // Each task fans out from its worker; wait_idle covers the tasks spawned by tasks
+  core::ThreadPool pool(4);
+  std::atomic<int> count{0};
+  std::function<void(int)> spawn = [&](int depth) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    if (depth == 0) return;
+    for (int i = 0; i < 4; ++i) pool.submit(spawn, depth - 1);
+  };
+  Timer t;
+  t.start();
+  pool.submit(spawn, 7);
+  pool.wait_idle();
+  t.end();
+  printf("21845 tasks submitted from workers: %fms\n", t.time());
+  EXPECT_EQ(count.load(), (1 << 16) / 3);  // 1 + 4 + ... + 4^7
+}
+
+TEST(ThreadPoolTest, Shutdown) {
+  core::ThreadPool pool(2);
+  std::atomic<int> count{0};
+  for (int i = 0; i < 1000; ++i) pool.submit([&count] { count.fetch_add(1); });
+  auto failing = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+  pool.shutdown();
+  // Queued tasks still run
+  EXPECT_EQ(count.load(), 1000);
+  EXPECT_THROW(failing.get(), std::runtime_error);
+  EXPECT_THROW(pool.submit([] {}), std::runtime_error);
+  pool.wait_idle();
+}
+
+TEST(ThreadPoolTest, ParallelFor) {
+  core::ThreadPool pool(4);
+  for (std::size_t grain : {0, 1, 7, 1000, 5000}) {
+    std::vector<std::atomic<int>> hits(4321);
+    std::atomic<std::size_t> max_chunk{0};
+    pool.parallel_for(10, 4331, grain, [&](std::size_t b, std::size_t e) {
+      std::size_t seen = max_chunk.load();
+      while (e - b > seen && !max_chunk.compare_exchange_weak(seen, e - b)) {
+      }
+      for (std::size_t i = b; i < e; ++i) hits[i - 10].fetch_add(1);
+    });
+    int wrong = 0;
+    for (auto& h : hits) wrong += h.load() != 1;
+    EXPECT_EQ(wrong, 0) << "grain " << grain;
+    if (grain != 0) {
+      EXPECT_LE(max_chunk.load(), grain);
+    }
+  }
+
+  // Empty range, and a pool with a single worker still makes progress with the caller
+  pool.parallel_for(5, 5, 1, [](std::size_t, std::size_t) { FAIL(); });
+  core::ThreadPool single(1);
+  std::atomic<int> count{0};
+  single.parallel_for(0, 100, 1, [&](std::size_t b, std::size_t e) { count += int(e - b); });
+  EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPoolTest, ParallelForNested) {
+  // Inner loops run from worker threads: the callers take part, so nothing waits on a queue
+  core::ThreadPool pool(2);
+  std::atomic<int> count{0};
+  pool.parallel_for(0, 16, 1, [&](std::size_t, std::size_t) {
+    pool.parallel_for(0, 1000, 10, [&](std::size_t b, std::size_t e) { count += int(e - b); });
+  });
+  EXPECT_EQ(count.load(), 16000);
+
+  pool.submit([&] {
+        pool.parallel_for(0, 64, 1, [&](std::size_t, std::size_t) { count.fetch_add(1); });
+      })
+      .get();
+  EXPECT_EQ(count.load(), 16064);
+}
+
+TEST(ThreadPoolTest, ParallelForException) {
+  core::ThreadPool pool(3);
+  std::atomic<int> count{0};
+  EXPECT_THROW(pool.parallel_for(0, 1000, 1,
+                                 [&](std::size_t b, std::size_t) {
+                                   count.fetch_add(1);
+                                   if (b == 500) throw std::runtime_error("chunk failed");
+                                 }),
+               std::runtime_error);
+  EXPECT_LE(count.load(), 1000);
+  // The pool is still usable
+  std::atomic<int> after{0};
+  pool.parallel_for(0, 100, 1, [&](std::size_t, std::size_t) { after.fetch_add(1); });
+  EXPECT_EQ(after.load(), 100);
+}
+
+TEST(ThreadPoolTest, ParallelFor2d) {
+  core::ThreadPool pool(3);
+  const std::size_t rows = 123;
+  const std::size_t cols = 457;
+  std::vector<std::atomic<int>> hits(rows * cols);
+  pool.parallel_for_2d(rows, cols, 16, 64,
+                       [&](std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+                         EXPECT_LE(r1 - r0, 16u);
+                         EXPECT_LE(c1 - c0, 64u);
+                         for (std::size_t r = r0; r < r1; ++r) {
+                           for (std::size_t c = c0; c < c1; ++c) hits[r * cols + c].fetch_add(1);
+                         }
+                       });
+  int wrong = 0;
+  for (auto& h : hits) wrong += h.load() != 1;
+  EXPECT_EQ(wrong, 0);
+}
+
+TEST(ThreadPoolTest, ParallelForPerformance) {
+  core::ThreadPool pool;
+  std::vector<float> v(1 << 22, 1.0f);
+  auto scale = [&](std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i) v[i] = v[i] * 1.0001f + 0.5f;
+  };
+  Timer t;
+
+  t.start();
+  std::vector<std::future<void>> futures;
+  for (std::size_t b = 0; b < v.size(); b += 4096) {
+    futures.push_back(pool.submit(scale, b, b + 4096));
+  }
+  for (auto& f : futures) f.get();
+  t.end();
+  printf("1024 chunks through submit (%zu threads): %fms\n", pool.size(), t.time());
+
+  t.start();
+  pool.parallel_for(0, v.size(), 4096, scale);
+  t.end();
+  printf("1024 chunks through parallel_for (%zu threads): %fms\n", pool.size(), t.time());
+  EXPECT_NEAR(v[12345], (1.0f * 1.0001f + 0.5f) * 1.0001f + 0.5f, 1e-5f);
+}
+
+TEST(ThreadPoolTest, InlineTask) {
+  struct Counted {
+    explicit Counted(int* counter) : live(counter) { ++*live; }
+    Counted(Counted&& other) noexcept : live(other.live) { ++*live; }
+    ~Counted() { --*live; }
+    int* live;
+  };
+  int live = 0;
+  int calls = 0;
+  {
+    Counted counted(&live);
+    core::detail::InlineTask task([c = std::move(counted), &calls] { ++calls; });
+    static_assert(core::detail::InlineTask::fits_inline<decltype([] {})>());
+    core::detail::InlineTask moved(std::move(task));
+    EXPECT_FALSE(task);
+    moved();
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(live, 2);  // counted and the capture
+  }
+  EXPECT_EQ(live, 0);
+
+  // Captures too large for the inline storage go to the heap
+  std::array<char, 200> big{};
+  big[199] = 7;
+  int result = 0;
+  core::detail::InlineTask heap([big, &result] { result = big[199]; });
+  static_assert(!core::detail::InlineTask::fits_inline<decltype([big] { (void)big; })>());
+  core::detail::InlineTask other;
+  other = std::move(heap);
+  other();
+  EXPECT_EQ(result, 7);
+  other.reset();
+  EXPECT_FALSE(other);
+}
+
+TEST(ThreadPoolTest, Post) {
+  core::ThreadPool pool(3);
+  std::atomic<int> sum{0};
+  // Move-only captures, arguments, exceptions that must not take the worker down
+  auto value = std::make_unique<int>(5);
+  pool.post([v = std::move(value), &sum] { sum += *v; });
+  pool.post([&sum](int a, int b) { sum += a * b; }, 3, 4);
+  pool.post([] { throw std::runtime_error("dropped"); });
+  std::array<int, 64> big{};
+  big.fill(1);
+  pool.post([big, &sum] { sum += std::accumulate(big.begin(), big.end(), 0); });
+  pool.wait_idle();
+  EXPECT_EQ(sum.load(), 5 + 12 + 64);
+
+  // Posting from workers reuses their nodes
+  std::atomic<int> count{0};
+  pool.post([&] {
+    for (int i = 0; i < 10000; ++i) pool.post([&count] { count.fetch_add(1); });
+  });
+  pool.wait_idle();
+  EXPECT_EQ(count.load(), 10000);
+}
+
+TEST(ThreadPoolTest, PostPerformance) {
+  core::ThreadPool pool;
+  std::atomic<int> count{0};
+  Timer t;
+  for (int round = 0; round < 2; ++round) {
+    t.start();
+    for (int i = 0; i < 100000; ++i) pool.submit([&count] { count.fetch_add(1); });
+    pool.wait_idle();
+    t.end();
+    const double submit_ms = t.time();
+    t.start();
+    for (int i = 0; i < 100000; ++i) pool.post([&count] { count.fetch_add(1); });
+    pool.wait_idle();
+    t.end();
+    printf("100000 tasks (%zu threads): submit %fms, post %fms\n", pool.size(), submit_ms,
+           t.time());
+  }
+  EXPECT_EQ(count.load(), 400000);
+}
+
+TEST(ThreadPoolTest, TaskGraph) {
+  core::ThreadPool pool(3);
+  core::TaskGraph graph;
+  // Diamond a -> {b, c} -> d, then a fan-out of 200 nodes joined by e
+  std::atomic<int> step{0};
+  std::array<int, 5> at{};
+  auto mark = [&](int i) { return [&, i] { at[i] = step.fetch_add(1) + 1; }; };
+  const auto a = graph.add(mark(0));
+  const auto b = graph.add(mark(1));
+  const auto c = graph.add(mark(2));
+  const auto d = graph.add(mark(3));
+  graph.precede(a, b);
+  graph.precede(a, c);
+  graph.precede(b, d);
+  graph.precede(c, d);
+  std::atomic<int> fan{0};
+  std::atomic<int> fan_seen{-1};
+  const auto e = graph.add([&] { fan_seen = fan.load(); });
+  for (int i = 0; i < 200; ++i) {
+    const auto n = graph.add([&fan] { fan.fetch_add(1); });
+    graph.precede(d, n);
+    graph.precede(n, e);
+  }
+  // A chain hands each node to the next on the same thread
+  std::array<std::thread::id, 3> chain{};
+  auto c0 = graph.add([&] { chain[0] = std::this_thread::get_id(); });
+  auto c1 = graph.add([&] { chain[1] = std::this_thread::get_id(); });
+  auto c2 = graph.add([&] { chain[2] = std::this_thread::get_id(); });
+  graph.precede(c0, c1);
+  graph.precede(c1, c2);
+  EXPECT_EQ(graph.size(), 208u);
+
+  // The same graph runs frame after frame
+  for (int frame = 0; frame < 100; ++frame) {
+    step = 0;
+    fan = 0;
+    graph.run(pool);
+    EXPECT_EQ(at[0], 1);
+    EXPECT_TRUE((at[1] == 2 && at[2] == 3) || (at[1] == 3 && at[2] == 2));
+    EXPECT_EQ(at[3], 4);
+    EXPECT_EQ(fan_seen.load(), 200);
+    EXPECT_EQ(chain[0], chain[1]);
+    EXPECT_EQ(chain[1], chain[2]);
+  }
+}
+
+TEST(ThreadPoolTest, TaskGraphNested) {
+  // A graph run from the only worker of a pool: the worker helps instead of blocking
+  core::ThreadPool pool(1);
+  core::TaskGraph graph;
+  std::atomic<int> count{0};
+  const auto root = graph.add([] {});
+  const auto join = graph.add([&count] { count.fetch_add(100); });
+  for (int i = 0; i < 16; ++i) {
+    const auto n = graph.add([&count] { count.fetch_add(1); });
+    graph.precede(root, n);
+    graph.precede(n, join);
+  }
+  auto done = pool.submit([&] {
+    for (int i = 0; i < 10; ++i) graph.run(pool);
+  });
+  done.get();
+  EXPECT_EQ(count.load(), 10 * 116);
+}
+
+TEST(ThreadPoolTest, TaskGraphErrors) {
+  core::ThreadPool pool(2);
+  core::TaskGraph graph;
+  std::atomic<int> count{0};
+  const auto a = graph.add([&count] { count.fetch_add(1); });
+  const auto b = graph.add([] { throw std::runtime_error("node"); });
+  const auto c = graph.add([&count] { count.fetch_add(1); });
+  graph.precede(a, b);
+  graph.precede(b, c);
+  EXPECT_THROW(graph.run(pool), std::runtime_error);
+  EXPECT_EQ(count.load(), 1);  // c was skipped
+  EXPECT_THROW(graph.precede(a, a), std::invalid_argument);
+  EXPECT_THROW(graph.precede(a, 3), std::invalid_argument);
+
+  core::TaskGraph cycle;
+  const auto x = cycle.add([] {});
+  const auto y = cycle.add([] {});
+  const auto z = cycle.add([] {});
+  cycle.precede(x, y);
+  cycle.precede(y, z);
+  cycle.precede(z, y);
+  EXPECT_THROW(cycle.run(pool), std::invalid_argument);
+
+  // A stopped pool runs the graph on the caller
+  core::TaskGraph chain;
+  std::vector<int> order;
+  const auto p = chain.add([&order] { order.push_back(1); });
+  const auto q = chain.add([&order] { order.push_back(2); });
+  chain.precede(p, q);
+  pool.shutdown();
+  chain.run(pool);
+  EXPECT_EQ(order, (std::vector<int>{1, 2}));
+}
+
+TEST(ThreadPoolTest, Priorities) {
+  core::ThreadPool pool(1);
+  // Hold the only worker while the lanes fill up
+  std::atomic<bool> release{false};
+  pool.post([&release] {
+    while (!release.load()) std::this_thread::yield();
+  });
+  std::mutex m;
+  std::vector<int> order;
+  auto record = [&](int id) {
+    return [&, id] {
+      std::lock_guard<std::mutex> lk(m);
+      order.push_back(id);
+    };
+  };
+  for (int i = 0; i < 20; ++i) pool.post(core::TaskPriority::Background, record(300 + i));
+  for (int i = 0; i < 20; ++i) pool.post(record(200 + i));
+  const auto now = core::TaskOptions::Clock::now();
+  const auto ms = [now](int n) { return now + std::chrono::milliseconds(n); };
+  pool.post({core::TaskPriority::Realtime, ms(3)}, record(103));
+  pool.post(core::TaskPriority::Realtime, record(104));
+  pool.post({core::TaskPriority::Realtime, ms(1)}, record(101));
+  auto future = pool.submit({core::TaskPriority::Realtime, ms(2)}, [] { return 102; });
+  release = true;
+  EXPECT_EQ(future.get(), 102);
+  pool.wait_idle();
+
+  // Realtime by deadline, then normal, then background, each FIFO
+  ASSERT_EQ(order.size(), 43u);
+  EXPECT_EQ(order[0], 101);
+  EXPECT_EQ(order[1], 103);
+  EXPECT_EQ(order[2], 104);
+  for (int i = 0; i < 20; ++i) EXPECT_EQ(order[3 + i], 200 + i);
+  for (int i = 0; i < 20; ++i) EXPECT_EQ(order[23 + i], 300 + i);
+}
+
+TEST(ThreadPoolTest, PriorityStarvation) {
+  // A stream of normal tasks does not hold back a background task past its maximum wait
+  core::ThreadPool pool(1);
+  const auto start = core::TaskOptions::Clock::now();
+  std::atomic<bool> background_done{false};
+  std::atomic<int> normal_after{0};
+  pool.post(core::TaskPriority::Background, [&] { background_done = true; });
+  std::function<void()> chain = [&] {
+    if (background_done.load()) normal_after.fetch_add(1);
+    if (core::TaskOptions::Clock::now() - start < 10 * core::ThreadPool::kBackgroundMaxWait) {
+      pool.post(chain);
+    }
+  };
+  pool.post(chain);
+  pool.wait_idle();
+  EXPECT_TRUE(background_done.load());
+  EXPECT_GT(normal_after.load(), 0);
+
+  // A passed deadline promotes a background task right away
+  std::atomic<bool> release{false};
+  pool.post([&release] {
+    while (!release.load()) std::this_thread::yield();
+  });
+  std::vector<int> order;
+  pool.post([&order] { order.push_back(1); });
+  pool.post({core::TaskPriority::Background, core::TaskOptions::Clock::now()},
+            [&order] { order.push_back(0); });
+  release = true;
+  pool.wait_idle();
+  EXPECT_EQ(order, (std::vector<int>{0, 1}));
+}
+
+TEST(ThreadPoolTest, Topology) {
+  EXPECT_EQ(core::parse_cpu_list("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(core::parse_cpu_list("5"), (std::vector<int>{5}));
+  EXPECT_TRUE(core::parse_cpu_list("").empty());
+  EXPECT_THROW(core::parse_cpu_list("3-1"), std::invalid_argument);
+  EXPECT_THROW(core::parse_cpu_list("a"), std::invalid_argument);
+
+  // A fake sysfs tree: two nodes with CPUs, a memory-only one and unrelated entries
+  const auto root = std::filesystem::temp_directory_path() / "core_topology_test";
+  std::filesystem::remove_all(root);
+  const std::vector<std::pair<std::string, std::string>> files = {
+      {"node1", "4-7\n"}, {"node0", "0-3\n"}, {"node2", "\n"}, {"possible", "0-2\n"}};
+  for (const auto& [name, list] : files) {
+    std::filesystem::create_directories(root / name);
+    std::ofstream(root / name / "cpulist") << list;
+  }
+  const auto nodes = core::read_numa_topology(root.string());
+  std::filesystem::remove_all(root);
+  ASSERT_EQ(nodes.size(), 3u);
+  EXPECT_EQ(nodes[0].id, 0);
+  EXPECT_EQ(nodes[0].cpus, (std::vector<int>{0, 1, 2, 3}));
+  EXPECT_EQ(nodes[1].id, 1);
+  EXPECT_EQ(nodes[1].cpus, (std::vector<int>{4, 5, 6, 7}));
+  EXPECT_TRUE(nodes[2].cpus.empty());
+  EXPECT_TRUE(core::read_numa_topology((root / "missing").string()).empty());
+
+  const auto machine = core::probe_numa_topology();
+  ASSERT_FALSE(machine.empty());
+  for (const auto& node : machine) EXPECT_FALSE(node.cpus.empty());
+}
+
+TEST(ThreadPoolTest, NodeGroups) {
+  // Two groups on the CPUs this process has, 2:1, pinned and named
+  const auto machine = core::probe_numa_topology();
+  const int cpu = machine[0].cpus[0];
+  core::ThreadPoolOptions options;
+  options.thread_count = 3;
+  options.topology = {{0, {cpu, cpu}}, {1, {cpu}}};
+  options.pin_threads = true;
+  options.thread_name = "test-pool";
+  core::ThreadPool pool(options);
+  ASSERT_EQ(pool.nodes().size(), 2u);
+  EXPECT_EQ(pool.size(), 3u);
+  EXPECT_EQ(pool.current_node(), -1);
+
+  std::atomic<int> wrong{0};
+  std::array<std::atomic<int>, 2> ran{};
+  for (int i = 0; i < 1000; ++i) {
+    core::TaskOptions task;
+    task.node = i % 2;
+    pool.post(task, [&, node = i % 2] {
+      if (pool.current_node() != node) wrong.fetch_add(1);
+      ran[node].fetch_add(1);
+    });
+  }
+  // Routed from inside a worker of the other group too
+  core::TaskOptions to_node1;
+  to_node1.node = 1;
+  std::promise<int> seen;
+  pool.post([&] { pool.post(to_node1, [&] { seen.set_value(pool.current_node()); }); });
+  EXPECT_EQ(seen.get_future().get(), 1);
+  pool.wait_idle();
+  EXPECT_EQ(wrong.load(), 0);
+  EXPECT_EQ(ran[0].load(), 500);
+  EXPECT_EQ(ran[1].load(), 500);
+
+  to_node1.node = 2;
+  EXPECT_THROW(pool.post(to_node1, [] {}), std::invalid_argument);
+
+#if defined(__linux__)
+  auto name = pool.submit([] {
+    char buffer[16] = {};
+    pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+    return std::string(buffer);
+  });
+  EXPECT_EQ(name.get().rfind("test-pool-", 0), 0u);
+#endif
+}
+
+TEST(ThreadPoolTest, NodeGroupWakeups) {
+  // A task routed to a group wakes one sleeper of that group; the other group sleeps on
+  const int cpu = core::probe_numa_topology()[0].cpus[0];
+  core::ThreadPoolOptions options;
+  options.thread_count = 4;
+  options.topology = {{0, {cpu, cpu, cpu}}, {1, {cpu}}};
+  options.spin_budget = std::chrono::nanoseconds(0);
+  options.yield_count = 0;
+  core::ThreadPool pool(options);
+  auto all_parked = [&pool] {
+    const core::ThreadPoolStats stats = pool.stats();
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+      if (stats.workers[i].parks == 0) return false;
+    }
+    return true;
+  };
+  while (!all_parked()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  pool.reset_stats();
+
+  core::TaskOptions to_node1;
+  to_node1.node = 1;
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(pool.submit(to_node1, [&pool] { return pool.current_node(); }).get(), 1);
+  }
+  pool.wait_idle();
+  const core::ThreadPoolStats stats = pool.stats();
+  for (std::size_t i = 0; i < 3; ++i) EXPECT_EQ(stats.workers[i].parks, 0u) << i;
+  EXPECT_EQ(stats.workers[3].tasks, 20u);
+}
+
+TEST(ThreadPoolTest, SpinBudget) {
+  // The budget can be changed on a running pool
+  core::ThreadPool pool(2);
+  pool.set_spin_budget(std::chrono::nanoseconds(0));
+  std::atomic<int> count{0};
+  for (int i = 0; i < 1000; ++i) pool.post([&count] { count.fetch_add(1); });
+  pool.wait_idle();
+  EXPECT_EQ(count.load(), 1000);
+}
+
+TEST(ThreadPoolTest, SpinWakeups) {
+  // Submissions skip their wakeup while a worker polls; a burst posted then must still fan out
+  // to every worker rather than run on the poller and the one sleeper it wakes
+  core::ThreadPoolOptions options;
+  options.thread_count = 8;
+  options.spin_budget = std::chrono::milliseconds(50);
+  core::ThreadPool pool(options);
+  auto all_parked = [&pool] {
+    const core::ThreadPoolStats stats = pool.stats();
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+      if (stats.workers[i].parks == 0) return false;
+    }
+    return true;
+  };
+  while (!all_parked()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  pool.submit([] {}).get();  // one worker polls from now on
+
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+  for (int i = 0; i < 32; ++i) {
+    pool.post([&] {
+      const int now = running.fetch_add(1) + 1;
+      int seen = max_running.load();
+      while (now > seen && !max_running.compare_exchange_weak(seen, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      running.fetch_sub(1);
+    });
+  }
+  pool.wait_idle();
+  EXPECT_GE(max_running.load(), 6);
+}
+
+core::Task<int> Square(core::ThreadPool& pool, int x) {
+  co_await pool.schedule();
+  co_return x * x;
+}
+
+core::Task<int> Count(int n) {
+  // Synchronous chain of awaits, resumed through symmetric transfer
+  if (n == 0) co_return 0;
+  co_return 1 + co_await Count(n - 1);
+}
+
+core::Task<void> Fail(core::ThreadPool& pool) {
+  co_await pool.schedule();
+  throw std::runtime_error("coroutine");
+}
+
+TEST(ThreadPoolTest, Coroutines) {
+  core::ThreadPool pool(3);
+  const auto caller = std::this_thread::get_id();
+  auto hop = [&]() -> core::Task<bool> {
+    co_await pool.schedule();
+    co_return std::this_thread::get_id() != caller && pool.current_node() >= 0;
+  };
+  EXPECT_TRUE(core::sync_wait(hop()));
+  EXPECT_EQ(core::sync_wait(Square(pool, 7)), 49);
+  EXPECT_EQ(core::sync_wait(Count(1000)), 1000);
+  EXPECT_THROW(core::sync_wait(Fail(pool)), std::runtime_error);
+
+  auto chain = [&]() -> core::Task<int> {
+    const int a = co_await Square(pool, 3);
+    const int b = co_await Square(pool, a);
+    co_return b;
+  };
+  EXPECT_EQ(core::sync_wait(chain()), 81);
+
+  // when_all, heterogeneous and over a vector
+  std::atomic<int> side{0};
+  auto effect = [&]() -> core::Task<void> {
+    co_await pool.schedule();
+    side.fetch_add(1);
+  };
+  auto [x, y, z] = core::sync_wait(core::when_all(Square(pool, 2), effect(), Square(pool, 4)));
+  EXPECT_EQ(x, 4);
+  EXPECT_EQ(z, 16);
+  EXPECT_EQ(side.load(), 1);
+  (void)y;
+
+  std::vector<core::Task<int>> squares;
+  for (int i = 0; i < 100; ++i) squares.push_back(Square(pool, i));
+  const auto results = core::sync_wait(core::when_all(std::move(squares)));
+  ASSERT_EQ(results.size(), 100u);
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(results[static_cast<std::size_t>(i)], i * i);
+
+  std::vector<core::Task<void>> effects;
+  for (int i = 0; i < 50; ++i) effects.push_back(effect());
+  effects.push_back(Fail(pool));
+  EXPECT_THROW(core::sync_wait(core::when_all(std::move(effects))), std::runtime_error);
+  EXPECT_EQ(side.load(), 51);
+  EXPECT_TRUE(core::sync_wait(core::when_all()) == std::tuple<>());
+}
+
+TEST(ThreadPoolTest, CompletionPoller) {
+  // Stand-ins for GPU fences signaled by another thread
+  core::ThreadPool pool(2);
+  core::CompletionPoller poller(pool);
+  constexpr int kFrames = 16;
+  std::array<std::atomic<bool>, kFrames> signaled{};
+  auto frame = [&](int i) -> core::Task<int> {
+    co_await pool.schedule();
+    co_await poller.wait([&signaled, i] { return signaled[static_cast<std::size_t>(i)].load(); });
+    co_return i;
+  };
+  std::vector<core::Task<int>> frames;
+  for (int i = 0; i < kFrames; ++i) frames.push_back(frame(i));
+  std::thread gpu([&] {
+    for (int i = kFrames - 1; i >= 0; --i) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      signaled[static_cast<std::size_t>(i)] = true;
+    }
+  });
+  const auto done = core::sync_wait(core::when_all(std::move(frames)));
+  gpu.join();
+  for (int i = 0; i < kFrames; ++i) EXPECT_EQ(done[static_cast<std::size_t>(i)], i);
+  EXPECT_EQ(poller.pending(), 0u);
+
+  // A check that is already true does not suspend, a failing one throws in the coroutine
+  auto ready = [&]() -> core::Task<int> {
+    co_await poller.wait([] { return true; });
+    co_return 1;
+  };
+  EXPECT_EQ(core::sync_wait(ready()), 1);
+  int calls = 0;
+  auto lost = [&]() -> core::Task<void> {
+    co_await poller.wait([&calls]() -> bool {
+      if (++calls == 3) throw std::runtime_error("device lost");
+      return false;
+    });
+  };
+  EXPECT_THROW(core::sync_wait(lost()), std::runtime_error);
+  EXPECT_EQ(calls, 3);
+}
+
+TEST(ThreadPoolTest, Stats) {
+  core::ThreadPoolOptions options;
+  options.thread_count = 2;
+  options.latency_metrics = true;
+  core::ThreadPool pool(options);
+  std::atomic<int> sink{0};
+  for (int i = 0; i < 1000; ++i) {
+    pool.post([&sink] {
+      int x = 0;
+      for (int k = 0; k < 1000; ++k) x += k * k;
+      sink.fetch_add(x & 1);
+    });
+  }
+  pool.wait_idle();
+
+  core::ThreadPoolStats stats = pool.stats();
+  ASSERT_EQ(stats.workers.size(), 3u);
+  std::uint64_t tasks = 0;
+  for (const auto& worker : stats.workers) tasks += worker.tasks;
+  EXPECT_EQ(tasks, 1000u);
+  EXPECT_EQ(stats.queue_wait.count(), 1000u);
+  EXPECT_EQ(stats.run_time.count(), 1000u);
+  EXPECT_GT(stats.run_time.percentile(0.5).count(), 0);
+  EXPECT_LE(stats.run_time.percentile(0.5), stats.run_time.percentile(0.99));
+  EXPECT_EQ(stats.queued, 0u);
+  EXPECT_EQ(stats.pending, 0u);
+  EXPECT_GT(stats.utilization(), 0.0);
+  EXPECT_LE(stats.utilization(), 1.0);
+  printf("queue wait p50 %lldns p99 %lldns, run time p50 %lldns, utilization %.3f\n",
+         static_cast<long long>(stats.queue_wait.percentile(0.5).count()),
+         static_cast<long long>(stats.queue_wait.percentile(0.99).count()),
+         static_cast<long long>(stats.run_time.percentile(0.5).count()), stats.utilization());
+
+  // Queue depth while the workers are held, and tasks run by an outside thread
+  pool.reset_stats();
+  std::atomic<bool> release{false};
+  std::atomic<int> held{0};
+  for (int i = 0; i < 2; ++i) {
+    pool.post([&release, &held] {
+      held.fetch_add(1);
+      while (!release.load()) std::this_thread::yield();
+    });
+  }
+  while (held.load() < 2) std::this_thread::yield();
+  for (int i = 0; i < 10; ++i) pool.post([] {});
+  stats = pool.stats();
+  EXPECT_GE(stats.pending, 10u);
+  EXPECT_LE(stats.queued, stats.pending);
+  while (pool.run_pending_task()) {
+  }
+  release = true;
+  pool.wait_idle();
+  stats = pool.stats();
+  EXPECT_GE(stats.workers.back().tasks, 1u);
+  tasks = 0;
+  for (const auto& worker : stats.workers) tasks += worker.tasks;
+  EXPECT_EQ(tasks, 12u);
+
+  // Without latency metrics only the counters move
+  pool.set_latency_metrics(false);
+  pool.reset_stats();
+  pool.post([] {});
+  pool.wait_idle();
+  stats = pool.stats();
+  EXPECT_EQ(stats.workers[0].tasks + stats.workers[1].tasks, 1u);
+  EXPECT_EQ(stats.queue_wait.count(), 0u);
+  EXPECT_EQ(stats.run_time.count(), 0u);
+}
+
+TEST(ThreadPoolTest, BoundedQueue) {
+  EXPECT_THROW(core::BoundedQueue<int>(0), std::invalid_argument);
+
+  core::BoundedQueue<int> fail(3, core::OverflowPolicy::Fail);
+  EXPECT_EQ(fail.capacity(), 3u);
+  for (int i = 1; i <= 3; ++i) EXPECT_TRUE(fail.push(i));
+  EXPECT_FALSE(fail.push(4));
+  EXPECT_FALSE(fail.try_push(4));
+  EXPECT_EQ(fail.size(), 3u);
+  int value = 0;
+  ASSERT_TRUE(fail.try_pop(&value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(fail.push(4));
+  for (int expected = 2; expected <= 4; ++expected) {
+    ASSERT_TRUE(fail.try_pop(&value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_FALSE(fail.try_pop(&value));
+  EXPECT_TRUE(fail.empty());
+
+  core::BoundedQueue<int> drop(2, core::OverflowPolicy::DropOldest);
+  for (int i = 1; i <= 5; ++i) EXPECT_TRUE(drop.push(i));
+  EXPECT_EQ(drop.dropped(), 3u);
+  ASSERT_TRUE(drop.try_pop(&value));
+  EXPECT_EQ(value, 4);
+  ASSERT_TRUE(drop.try_pop(&value));
+  EXPECT_EQ(value, 5);
+
+  // Move-only items; the ones left are destroyed with the queue
+  core::BoundedQueue<std::unique_ptr<int>> owned(4, core::OverflowPolicy::DropOldest);
+  for (int i = 0; i < 6; ++i) owned.push(std::make_unique<int>(i));
+  std::unique_ptr<int> item;
+  ASSERT_TRUE(owned.try_pop(&item));
+  EXPECT_EQ(*item, 2);
+
+  // A blocked push completes once a consumer makes room
+  core::BoundedQueue<int> block(1);
+  EXPECT_TRUE(block.push(1));
+  std::atomic<bool> pushed{false};
+  std::thread producer([&] {
+    pushed = block.push(2);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_FALSE(pushed.load());
+  ASSERT_TRUE(block.pop(&value));
+  EXPECT_EQ(value, 1);
+  ASSERT_TRUE(block.pop(&value));
+  EXPECT_EQ(value, 2);
+  producer.join();
+  EXPECT_TRUE(pushed.load());
+
+  // close() wakes a blocked pop, which then drains what is left
+  std::thread consumer([&] {
+    int v = 0;
+    EXPECT_TRUE(block.pop(&v));
+    EXPECT_EQ(v, 3);
+    EXPECT_FALSE(block.pop(&v));
+  });
+  block.push(3);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  block.close();
+  consumer.join();
+  EXPECT_FALSE(block.push(4));
+  EXPECT_TRUE(block.closed());
+}
+
+TEST(ThreadPoolTest, BoundedQueueMpmc) {
+  constexpr int kProducers = 4;
+  constexpr int kConsumers = 4;
+  constexpr int kPerProducer = 20000;
+  core::BoundedQueue<int> queue(64);
+  std::vector<std::atomic<int>> seen(kProducers * kPerProducer);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&queue, p] {
+      for (int i = 0; i < kPerProducer; ++i) EXPECT_TRUE(queue.push(p * kPerProducer + i));
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&queue, &seen] {
+      for (int v; queue.pop(&v);) seen[static_cast<std::size_t>(v)].fetch_add(1);
+    });
+  }
+  for (int p = 0; p < kProducers; ++p) threads[static_cast<std::size_t>(p)].join();
+  queue.close();
+  for (std::size_t i = kProducers; i < threads.size(); ++i) threads[i].join();
+  for (const auto& count : seen) EXPECT_EQ(count.load(), 1);
+}
+
+TEST(ThreadPoolTest, Backpressure) {
+  // Holds the only worker so that the queue fills up
+  auto hold = [](core::ThreadPool& pool, std::atomic<bool>& release) {
+    std::atomic<bool> held{false};
+    pool.post([&release, &held] {
+      held = true;
+      while (!release.load()) std::this_thread::yield();
+    });
+    while (!held.load()) std::this_thread::yield();
+  };
+  core::ThreadPoolOptions options;
+  options.thread_count = 1;
+  options.queue_capacity = 4;
+  options.spin_budget = std::chrono::nanoseconds(0);
+
+  {
+    options.overflow = core::OverflowPolicy::Fail;
+    core::ThreadPool pool(options);
+    std::atomic<bool> release{false};
+    hold(pool, release);
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(pool.try_post([&ran] { ran.fetch_add(1); }));
+    EXPECT_FALSE(pool.try_post([&ran] { ran.fetch_add(1); }));
+    EXPECT_FALSE(pool.try_submit([] { return 1; }).has_value());
+    EXPECT_THROW(pool.post([] {}), std::runtime_error);
+    EXPECT_EQ(pool.stats().queued, 4u);
+    // Tasks of tasks are not bounded
+    release = true;
+    pool.wait_idle();
+    EXPECT_EQ(ran.load(), 4);
+    std::optional<std::future<int>> result = pool.try_submit([] { return 7; });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->get(), 7);
+  }
+
+  {
+    options.overflow = core::OverflowPolicy::DropOldest;
+    core::ThreadPool pool(options);
+    std::atomic<bool> release{false};
+    hold(pool, release);
+    std::future<int> first = pool.submit([] { return 1; });
+    std::vector<int> ran;
+    std::mutex m;
+    for (int i = 0; i < 6; ++i) {
+      pool.post([&ran, &m, i] {
+        std::lock_guard<std::mutex> lk(m);
+        ran.push_back(i);
+      });
+    }
+    release = true;
+    pool.wait_idle();
+    EXPECT_EQ(ran, (std::vector<int>{2, 3, 4, 5}));
+    EXPECT_EQ(pool.stats().dropped, 3u);
+    EXPECT_THROW(first.get(), std::future_error);
+  }
+
+  {
+    options.overflow = core::OverflowPolicy::Block;
+    core::ThreadPool pool(options);
+    std::atomic<bool> release{false};
+    hold(pool, release);
+    std::atomic<int> posted{0};
+    std::atomic<int> ran{0};
+    std::thread producer([&] {
+      for (int i = 0; i < 10; ++i) {
+        pool.post([&ran] { ran.fetch_add(1); });
+        posted.fetch_add(1);
+      }
+    });
+    while (posted.load() < 4) std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(posted.load(), 4);
+    release = true;
+    producer.join();
+    pool.wait_idle();
+    EXPECT_EQ(ran.load(), 10);
+  }
+}
+
+TEST(ThreadPoolTest, BackpressureContinuations) {
+  // TaskGraph nodes and coroutine resumptions are never dropped or refused by a full queue
+  core::ThreadPoolOptions options;
+  options.thread_count = 1;
+  options.queue_capacity = 2;
+  for (const core::OverflowPolicy policy :
+       {core::OverflowPolicy::DropOldest, core::OverflowPolicy::Fail}) {
+    options.overflow = policy;
+    core::ThreadPool pool(options);
+    core::TaskGraph graph;
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 8; ++i) graph.add([&ran] { ran.fetch_add(1); });
+    for (int run = 0; run < 10; ++run) EXPECT_NO_THROW(graph.run(pool));
+    EXPECT_EQ(ran.load(), 80);
+    EXPECT_EQ(pool.stats().dropped, 0u);
+  }
+
+  options.overflow = core::OverflowPolicy::DropOldest;
+  core::ThreadPool pool(options);
+  std::atomic<bool> release{false};
+  pool.post([&release] {
+    while (!release.load()) std::this_thread::yield();
+  });
+  while (pool.stats().queued != 0) std::this_thread::yield();
+  // The queue is full when the coroutines resume on the pool, and overflows after
+  for (int i = 0; i < 2; ++i) pool.post([] {});
+  std::vector<int> results;
+  std::thread waiter([&] {
+    std::vector<core::Task<int>> squares;
+    for (int i = 0; i < 8; ++i) squares.push_back(Square(pool, i));
+    results = core::sync_wait(core::when_all(std::move(squares)));
+  });
+  while (pool.stats().queued < 10) std::this_thread::yield();
+  for (int i = 0; i < 3; ++i) pool.post([] {});
+  release = true;
+  waiter.join();
+  pool.wait_idle();
+  ASSERT_EQ(results.size(), 8u);
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(results[static_cast<std::size_t>(i)], i * i);
+  EXPECT_EQ(pool.stats().dropped, 3u);
+}
+
+TEST(ThreadPoolTest, BackpressureParallelFor) {
+  // parallel_for from outside the pool neither evicts queued tasks nor waits for room: the caller
+  // runs the chunks the full queue has no room for
+  core::ThreadPoolOptions options;
+  options.thread_count = 1;
+  options.queue_capacity = 2;
+  options.spin_budget = std::chrono::nanoseconds(0);
+  for (const core::OverflowPolicy policy :
+       {core::OverflowPolicy::DropOldest, core::OverflowPolicy::Block}) {
+    options.overflow = policy;
+    core::ThreadPool pool(options);
+    std::atomic<bool> release{false};
+    std::atomic<bool> held{false};
+    pool.post([&release, &held] {
+      held = true;
+      while (!release.load()) std::this_thread::yield();
+    });
+    while (!held.load()) std::this_thread::yield();
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 2; ++i) pool.post([&ran] { ran.fetch_add(1); });
+    std::atomic<int> chunks{0};
+    pool.parallel_for(0, 4, 1, [&chunks](std::size_t, std::size_t) { chunks.fetch_add(1); });
+    EXPECT_EQ(chunks.load(), 4);
+    std::atomic<int> tiles{0};
+    pool.parallel_for_2d(4, 4, 2, 2, [&tiles](std::size_t, std::size_t, std::size_t,
+                                              std::size_t) { tiles.fetch_add(1); });
+    EXPECT_EQ(tiles.load(), 4);
+    release = true;
+    pool.wait_idle();
+    EXPECT_EQ(ran.load(), 2);
+    EXPECT_EQ(pool.stats().dropped, 0u);
+  }
+}
+
 }  // namespace test
 }  // namespace core
\ No newline at end of file
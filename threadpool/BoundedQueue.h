@@ -0,0 +1,201 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace core {
+
+// What a push does when the queue is full.
+enum class OverflowPolicy {
+  Block,      // wait until a consumer makes room
+  Fail,       // return false, or throw from ThreadPool::post()
+  DropOldest  // discard the oldest item to make room
+};
+
+// Bounded multi-producer multi-consumer queue on a ring of `capacity` cells (D. Vyukov's
+// algorithm): every cell carries a sequence number telling producers and consumers whose turn it
+// is, so a push or pop is one CAS on the shared position plus one store, without locks. Memory is
+// allocated once, up front, and never grows: the queue holds at most `capacity` items. Sequence
+// numbers count in steps of two, 2 * pos for a cell free to push at position pos and
+// 2 * pos + 1 once written, which keeps the states apart even for a single cell.
+//
+// Blocking push() and pop() sleep on C++20 atomic waits; the other side only notifies when a
+// thread is actually waiting. Pushes that start after close() fail, and pop() returns false
+// once the queue is closed and empty.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::Block)
+      : capacity_(capacity), policy_(policy) {
+    if (capacity == 0) throw std::invalid_argument("BoundedQueue: capacity must be positive");
+    cells_ = std::make_unique<Cell[]>(capacity);
+    for (std::size_t i = 0; i < capacity; ++i) {
+      cells_[i].sequence.store(2 * i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  ~BoundedQueue() {
+    while (take([](T&&) {})) {
+    }
+  }
+
+  // Adds an item, or fails when the queue is full; never blocks.
+  template <class U>
+  bool try_push(U&& value) {
+    if (closed_.load(std::memory_order_relaxed)) return false;
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos % capacity_];
+      const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(2 * pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;  // the cell still holds the item from one lap ago
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (static_cast<void*>(cell->storage)) T(std::forward<U>(value));
+    cell->sequence.store(2 * pos + 1, std::memory_order_release);
+    signal(pushes_, pop_waiters_);
+    return true;
+  }
+
+  // Adds an item according to the policy: Block waits for room, Fail returns false when full,
+  // DropOldest evicts items until this one fits. Returns false when the queue is closed.
+  template <class U>
+  bool push(U&& value) {
+    switch (policy_) {
+      case OverflowPolicy::Fail:
+        return try_push(std::forward<U>(value));
+      case OverflowPolicy::DropOldest:
+        // A failed try_push() leaves value untouched, so it can be forwarded again
+        while (!try_push(std::forward<U>(value))) {
+          if (closed_.load(std::memory_order_relaxed)) return false;
+          if (take([](T&&) {})) dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+      case OverflowPolicy::Block:
+        break;
+    }
+    return wait_for(pops_, push_waiters_, [&] { return try_push(std::forward<U>(value)); });
+  }
+
+  // Takes the oldest item, or fails when the queue is empty; never blocks.
+  bool try_pop(T* item) {
+    return take([item](T&& value) { *item = std::move(value); });
+  }
+
+  // Takes the oldest item, waiting for one; returns false once the queue is closed and empty.
+  bool pop(T* item) {
+    return wait_for(pushes_, pop_waiters_, [&] { return try_pop(item); });
+  }
+
+  // Makes later pushes fail and wakes every waiting thread.
+  void close() {
+    closed_.store(true, std::memory_order_seq_cst);
+    for (std::atomic<std::uint32_t>* events : {&pushes_, &pops_}) {
+      events->fetch_add(1, std::memory_order_seq_cst);
+      events->notify_all();
+    }
+  }
+
+  bool closed() const noexcept { return closed_.load(std::memory_order_relaxed); }
+
+  // Number of items; approximate while other threads push or pop.
+  std::size_t size() const noexcept {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool empty() const noexcept { return size() == 0; }
+  std::size_t capacity() const noexcept { return capacity_; }
+  OverflowPolicy policy() const noexcept { return policy_; }
+
+  // Items evicted by DropOldest pushes so far.
+  std::uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<std::size_t> sequence{0};
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  // Moves the oldest item into sink and destroys it in the cell.
+  template <class Sink>
+  bool take(Sink&& sink) {
+    std::size_t pos = head_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos % capacity_];
+      const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(2 * pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;  // not written yet
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    T* value = std::launder(reinterpret_cast<T*>(cell->storage));
+    sink(std::move(*value));
+    value->~T();
+    cell->sequence.store(2 * (pos + capacity_), std::memory_order_release);
+    signal(pops_, push_waiters_);
+    return true;
+  }
+
+  // Wakes the threads waiting for the push or pop just made, if there are any. The fence pairs
+  // with the one in wait_for(): either the waiter's retry sees this operation or this sees the
+  // waiter, so the uncontended path touches no shared counter.
+  static void signal(std::atomic<std::uint32_t>& events, std::atomic<std::uint32_t>& waiters) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0) return;
+    events.fetch_add(1, std::memory_order_seq_cst);
+    events.notify_all();
+  }
+
+  // Retries attempt() until it succeeds or the queue is closed, sleeping on `events` between
+  // tries. A closed queue still gets one last attempt, so pop() drains it.
+  template <class Attempt>
+  bool wait_for(std::atomic<std::uint32_t>& events, std::atomic<std::uint32_t>& waiters,
+                Attempt&& attempt) {
+    if (attempt()) return true;
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool done = false;
+    for (;;) {
+      const std::uint32_t seen = events.load(std::memory_order_seq_cst);
+      if ((done = attempt()) || closed_.load(std::memory_order_seq_cst)) break;
+      events.wait(seen, std::memory_order_seq_cst);
+    }
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return done || attempt();
+  }
+
+  const std::size_t capacity_;
+  const OverflowPolicy policy_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<std::size_t> tail_{0};  // next position to push
+  alignas(64) std::atomic<std::size_t> head_{0};  // next position to pop
+  alignas(64) std::atomic<std::uint32_t> pushes_{0};
+  std::atomic<std::uint32_t> pop_waiters_{0};
+  alignas(64) std::atomic<std::uint32_t> pops_{0};
+  std::atomic<std::uint32_t> push_waiters_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<bool> closed_{false};
+};
+
+}  // namespace core
@@ -0,0 +1,149 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace core {
+
+// Turns completion checks that can only be polled, such as a GPU fence or event, into
+// awaitables. One waiter thread polls every pending check each interval and resumes the awaiting
+// coroutines on the pool once their check passes, so an in-flight frame holds no thread:
+//
+//   co_await poller.wait([&] { return fence.IsSignaled(); });
+//
+// An exception thrown by a check is rethrown in the coroutine waiting on it. Coroutines still
+// waiting when the poller is destroyed are resumed with a std::runtime_error.
+class CompletionPoller {
+ public:
+  explicit CompletionPoller(ThreadPool& pool,
+                            std::chrono::microseconds interval = std::chrono::microseconds(50))
+      : pool_(pool), interval_(interval), thread_([this] { run(); }) {}
+
+  CompletionPoller(const CompletionPoller&) = delete;
+  CompletionPoller& operator=(const CompletionPoller&) = delete;
+
+  ~CompletionPoller() {
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    for (Waiter* waiter : waiting_) {
+      waiter->error = std::make_exception_ptr(std::runtime_error("CompletionPoller destroyed"));
+      resume(waiter->handle);
+    }
+  }
+
+  // Awaitable that completes once ready() returns true; ready() runs on the waiter thread, except
+  // for one first call on the awaiting thread that skips the suspension when already done.
+  template <class Ready>
+  auto wait(Ready&& ready) {
+    struct Awaiter : Waiter {
+      bool await_ready() {
+        try {
+          return this->ready();
+        } catch (...) {
+          this->error = std::current_exception();
+          return true;
+        }
+      }
+      void await_suspend(std::coroutine_handle<> h) {
+        this->handle = h;
+        poller->add(this);
+      }
+      void await_resume() const {
+        if (this->error) std::rethrow_exception(this->error);
+      }
+      CompletionPoller* poller = nullptr;
+    };
+    Awaiter awaiter;
+    awaiter.ready = std::forward<Ready>(ready);
+    awaiter.poller = this;
+    return awaiter;
+  }
+
+  // Number of coroutines waiting.
+  std::size_t pending() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return waiting_.size() + polling_;
+  }
+
+ private:
+  struct Waiter {
+    std::function<bool()> ready;
+    std::coroutine_handle<> handle;
+    std::exception_ptr error;
+  };
+
+  void add(Waiter* waiter) {
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      waiting_.push_back(waiter);
+    }
+    cv_.notify_one();
+  }
+
+  // On a worker; inline when the pool no longer accepts tasks.
+  void resume(std::coroutine_handle<> h) {
+    try {
+      pool_.post_continuation({}, [h] { h.resume(); });
+    } catch (const std::runtime_error&) {
+      h.resume();
+    }
+  }
+
+  void run() {
+    std::vector<Waiter*> batch;
+    std::unique_lock<std::mutex> lk(m_);
+    while (!stop_) {
+      if (waiting_.empty()) {
+        cv_.wait(lk, [this] { return stop_ || !waiting_.empty(); });
+        continue;
+      }
+      batch.swap(waiting_);
+      polling_ = batch.size();
+      lk.unlock();
+      std::size_t kept = 0;
+      for (Waiter* waiter : batch) {
+        bool done = true;
+        try {
+          done = waiter->ready();
+        } catch (...) {
+          waiter->error = std::current_exception();
+        }
+        if (done) {
+          resume(waiter->handle);
+        } else {
+          batch[kept++] = waiter;
+        }
+      }
+      batch.resize(kept);
+      lk.lock();
+      waiting_.insert(waiting_.end(), batch.begin(), batch.end());
+      polling_ = 0;
+      batch.clear();
+      if (!waiting_.empty()) cv_.wait_for(lk, interval_, [this] { return stop_; });
+    }
+  }
+
+  ThreadPool& pool_;
+  const std::chrono::microseconds interval_;
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  std::vector<Waiter*> waiting_;  // guarded by m_
+  std::size_t polling_ = 0;       // taken out of waiting_ for the current round, guarded by m_
+  bool stop_ = false;             // guarded by m_
+  std::thread thread_;
+};
+
+}  // namespace core
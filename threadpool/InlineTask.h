@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace core {
+namespace detail {
+
+// Move-only void() callable with inline storage. Callables of up to kInlineSize bytes with a
+// non-throwing move constructor are stored in place; larger ones fall back to one heap
+// allocation. Unlike std::function it accepts move-only callables and never copies.
+class InlineTask {
+ public:
+  static constexpr std::size_t kInlineSize = 64 - sizeof(void*);
+
+  template <class F>
+  static constexpr bool fits_inline() {
+    using Fn = std::decay_t<F>;
+    return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(void*) &&
+           std::is_nothrow_move_constructible_v<Fn>;
+  }
+
+  InlineTask() = default;
+
+  template <class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineTask>>>
+  explicit InlineTask(F&& f) {
+    emplace(std::forward<F>(f));
+  }
+
+  InlineTask(InlineTask&& other) noexcept { move_from(other); }
+
+  InlineTask& operator=(InlineTask&& other) noexcept {
+    if (this != &other) {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+
+  InlineTask(const InlineTask&) = delete;
+  InlineTask& operator=(const InlineTask&) = delete;
+
+  ~InlineTask() { reset(); }
+
+  template <class F>
+  void emplace(F&& f) {
+    using Fn = std::decay_t<F>;
+    reset();
+    if constexpr (fits_inline<Fn>()) {
+      ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+      ops_ = &kInlineOps<Fn>;
+    } else {
+      ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+      ops_ = &kHeapOps<Fn>;
+    }
+  }
+
+  void reset() noexcept {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  void operator()() { ops_->invoke(storage_); }
+
+ private:
+  struct Ops {
+    void (*invoke)(void* storage);
+    void (*relocate)(void* dst, void* src) noexcept;  // move-construct dst, destroy src
+    void (*destroy)(void* storage) noexcept;
+  };
+
+  template <class Fn>
+  static constexpr Ops kInlineOps = {
+      [](void* s) { (*std::launder(static_cast<Fn*>(s)))(); },
+      [](void* dst, void* src) noexcept {
+        Fn* from = std::launder(static_cast<Fn*>(src));
+        ::new (dst) Fn(std::move(*from));
+        from->~Fn();
+      },
+      [](void* s) noexcept { std::launder(static_cast<Fn*>(s))->~Fn(); },
+  };
+
+  template <class Fn>
+  static constexpr Ops kHeapOps = {
+      [](void* s) { (**std::launder(static_cast<Fn**>(s)))(); },
+      [](void* dst, void* src) noexcept { ::new (dst) Fn*(*std::launder(static_cast<Fn**>(src))); },
+      [](void* s) noexcept { delete *std::launder(static_cast<Fn**>(s)); },
+  };
+
+  void move_from(InlineTask& other) noexcept {
+    if (other.ops_ != nullptr) {
+      other.ops_->relocate(storage_, other.storage_);
+      ops_ = other.ops_;
+      other.ops_ = nullptr;
+    }
+  }
+
+  alignas(void*) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace detail
+}  // namespace core
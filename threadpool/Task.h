@@ -0,0 +1,291 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace core {
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+  // Resumes the awaiting coroutine by symmetric transfer, so that long chains of co_await
+  // neither grow the stack nor go through the scheduler.
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+      return h.promise().continuation;
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { error = std::current_exception(); }
+
+  std::coroutine_handle<> continuation = std::noop_coroutine();
+  std::exception_ptr error;
+};
+
+template <class T>
+struct TaskPromise : TaskPromiseBase {
+  Task<T> get_return_object() noexcept;
+
+  template <class U>
+  void return_value(U&& v) {
+    value.emplace(std::forward<U>(v));
+  }
+
+  T result() {
+    if (error) std::rethrow_exception(error);
+    return std::move(*value);
+  }
+
+  std::optional<T> value;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+  Task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+  void result() const {
+    if (error) std::rethrow_exception(error);
+  }
+};
+
+}  // namespace detail
+
+// Lazily started coroutine producing a T. Nothing runs until the task is awaited; the awaiting
+// coroutine is then suspended and resumed, by symmetric transfer, on the thread that finishes the
+// task. Exceptions propagate to the awaiter. Use sync_wait() to wait from plain code and
+// ThreadPool::schedule() to move onto a worker:
+//
+//   core::Task<int> Frame(core::ThreadPool& pool) {
+//     co_await pool.schedule();
+//     co_return Work();
+//   }
+template <class T>
+class [[nodiscard]] Task {
+ public:
+  using promise_type = detail::TaskPromise<T>;
+
+  Task() = default;
+  explicit Task(std::coroutine_handle<promise_type> h) noexcept : handle_(h) {}
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  bool valid() const noexcept { return static_cast<bool>(handle_); }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      bool await_ready() const noexcept { return handle.done(); }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+      T await_resume() { return handle.promise().result(); }
+      std::coroutine_handle<promise_type> handle;
+    };
+    return Awaiter{handle_};
+  }
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <class T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Coroutine started by start() that calls on_done once suspended at its final point, from which
+// on its owner may destroy it. Runs the helpers of sync_wait() and when_all().
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() noexcept {
+      return Detached{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    auto final_suspend() const noexcept {
+      struct Awaiter {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+          return h.promise().on_done(h.promise().context);
+        }
+        void await_resume() const noexcept {}
+      };
+      return Awaiter{};
+    }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }  // helpers catch everything
+
+    std::coroutine_handle<> (*on_done)(void* context) = nullptr;
+    void* context = nullptr;
+  };
+
+  explicit Detached(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+  Detached(Detached&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+  Detached& operator=(Detached&&) = delete;
+  ~Detached() {
+    if (handle) handle.destroy();
+  }
+
+  void start(std::coroutine_handle<> (*done)(void*), void* context) {
+    handle.promise().on_done = done;
+    handle.promise().context = context;
+    handle.resume();
+  }
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+template <class T>
+using NonVoid = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+// Awaits a task and stores its value or exception.
+template <class T>
+Detached await_into(Task<T>& task, std::optional<NonVoid<T>>& value, std::exception_ptr& error) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(task);
+      value.emplace();
+    } else {
+      value.emplace(co_await std::move(task));
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+}
+
+// Counts down the helpers of a when_all() plus the awaiting coroutine itself, so whichever
+// arrives last resumes the awaiter.
+struct WhenAllLatch {
+  explicit WhenAllLatch(std::size_t helpers) : count(helpers + 1) {}
+
+  static std::coroutine_handle<> arrive(void* context) noexcept {
+    auto* latch = static_cast<WhenAllLatch*>(context);
+    if (latch->count.fetch_sub(1, std::memory_order_acq_rel) == 1) return latch->awaiting;
+    return std::noop_coroutine();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> h) noexcept {
+    awaiting = h;
+    return count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+  void await_resume() const noexcept {}
+
+  std::atomic<std::size_t> count;
+  std::coroutine_handle<> awaiting;
+};
+
+}  // namespace detail
+
+// Blocks the calling thread until the task is done and returns its value or rethrows its
+// exception. Must not be called from a coroutine running on the pool it waits for.
+template <class T>
+T sync_wait(Task<T> task) {
+  struct State {
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+  } state;
+  std::optional<detail::NonVoid<T>> value;
+  std::exception_ptr error;
+  detail::Detached helper = detail::await_into(task, value, error);
+  helper.start(
+      [](void* context) -> std::coroutine_handle<> {
+        auto* s = static_cast<State*>(context);
+        std::lock_guard<std::mutex> lk(s->m);
+        s->done = true;
+        s->cv.notify_all();
+        return std::noop_coroutine();
+      },
+      &state);
+  {
+    std::unique_lock<std::mutex> lk(state.m);
+    state.cv.wait(lk, [&state] { return state.done; });
+  }
+  if (error) std::rethrow_exception(error);
+  if constexpr (!std::is_void_v<T>) return std::move(*value);
+}
+
+// Runs the tasks concurrently and completes when all have: each is started in turn on the
+// calling thread and runs until it first suspends, e.g. on ThreadPool::schedule(). Results come
+// back in order, std::monostate standing for void. If tasks throw, the first one's exception in
+// argument order is rethrown once all are done.
+template <class... Ts>
+Task<std::tuple<detail::NonVoid<Ts>...>> when_all(Task<Ts>... tasks) {
+  std::tuple<std::optional<detail::NonVoid<Ts>>...> values;
+  std::exception_ptr errors[sizeof...(Ts) + 1];
+  detail::WhenAllLatch latch(sizeof...(Ts));
+  std::vector<detail::Detached> helpers;
+  helpers.reserve(sizeof...(Ts));
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (helpers.push_back(detail::await_into(tasks, std::get<I>(values), errors[I])), ...);
+  }(std::index_sequence_for<Ts...>{});
+  for (auto& helper : helpers) helper.start(&detail::WhenAllLatch::arrive, &latch);
+  co_await latch;
+  for (const auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  co_return std::apply([](auto&... v) { return std::make_tuple(std::move(*v)...); }, values);
+}
+
+// when_all() over a run-time number of tasks of one type.
+template <class T>
+Task<std::conditional_t<std::is_void_v<T>, void, std::vector<detail::NonVoid<T>>>> when_all(
+    std::vector<Task<T>> tasks) {
+  std::vector<std::optional<detail::NonVoid<T>>> values(tasks.size());
+  std::vector<std::exception_ptr> errors(tasks.size());
+  detail::WhenAllLatch latch(tasks.size());
+  std::vector<detail::Detached> helpers;
+  helpers.reserve(tasks.size());
+  for (std::size_t i = 0; i < tasks.size(); ++i) {
+    helpers.push_back(detail::await_into(tasks[i], values[i], errors[i]));
+  }
+  for (auto& helper : helpers) helper.start(&detail::WhenAllLatch::arrive, &latch);
+  co_await latch;
+  for (const auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  if constexpr (std::is_void_v<T>) {
+    co_return;
+  } else {
+    std::vector<T> results;
+    results.reserve(values.size());
+    for (auto& value : values) results.push_back(std::move(*value));
+    co_return results;
+  }
+}
+
+}  // namespace core
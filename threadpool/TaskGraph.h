@@ -0,0 +1,177 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "InlineTask.h"
+#include "ThreadPool.h"
+
+namespace core {
+
+// Dependency graph of tasks run on a ThreadPool. Nodes are built once and the graph is run as
+// many times as needed, e.g. once per frame: a run only resets one atomic dependency counter per
+// node. When a node finishes it decrements the counters of its successors; the first successor
+// that becomes ready runs right away on the same thread, while its inputs are still in cache, the
+// others are posted to the pool. A graph must not be changed or run twice concurrently.
+class TaskGraph {
+ public:
+  using NodeId = std::size_t;
+
+  TaskGraph() = default;
+  TaskGraph(const TaskGraph&) = delete;
+  TaskGraph& operator=(const TaskGraph&) = delete;
+
+  // Adds a node running fn() on every run.
+  template <class F>
+  NodeId add(F&& fn) {
+    auto node = std::make_unique<Node>();
+    node->fn.emplace(std::forward<F>(fn));
+    nodes_.push_back(std::move(node));
+    order_.clear();
+    return nodes_.size() - 1;
+  }
+
+  // Makes `after` wait for `before`. Fan-out and fan-in are several edges from or to one node.
+  void precede(NodeId before, NodeId after) {
+    if (before >= nodes_.size() || after >= nodes_.size() || before == after) {
+      throw std::invalid_argument("TaskGraph::precede: invalid nodes");
+    }
+    nodes_[before]->successors.push_back(after);
+    ++nodes_[after]->dependencies;
+    order_.clear();
+  }
+
+  std::size_t size() const noexcept { return nodes_.size(); }
+
+  // Runs every node once and blocks until all are done. The calling thread takes part: it runs
+  // the first root and, while waiting, other queued tasks of the pool, so run() may be called
+  // from inside a pool task. After a node throws, the nodes not yet started are skipped and the
+  // first exception is rethrown. A stopped pool runs the graph on the caller in dependency order.
+  void run(ThreadPool& pool) {
+    if (nodes_.empty()) return;
+    if (order_.empty()) sort();
+    failed_.store(false, std::memory_order_relaxed);
+    error_ = nullptr;
+    if (pool.size() == 0) {
+      for (NodeId id : order_) invoke(*nodes_[id]);
+    } else {
+      pool_ = &pool;
+      done_ = false;
+      posted_ = 0;
+      remaining_.store(nodes_.size(), std::memory_order_relaxed);
+      for (const auto& node : nodes_) {
+        node->pending.store(node->dependencies, std::memory_order_relaxed);
+      }
+      // order_ starts with the roots
+      for (std::size_t i = 1; i < roots_; ++i) {
+        pool.post_continuation({}, [this, id = order_[i]] { execute(id); });
+      }
+      execute(order_[0]);
+      // Help until nothing is queued, then sleep until the last node is done or another one is
+      // posted, which the workers may not get to if they are all blocked as well, e.g. in nested
+      // runs. A node posted while helping is seen through posted_ and keeps the caller awake.
+      std::unique_lock<std::mutex> lk(done_m_);
+      while (!done_) {
+        const std::size_t posted = posted_;
+        lk.unlock();
+        while (remaining_.load(std::memory_order_acquire) != 0 && pool.run_pending_task()) {
+        }
+        lk.lock();
+        done_cv_.wait(lk, [&] { return done_ || posted_ != posted; });
+      }
+      pool_ = nullptr;
+    }
+    if (error_) std::rethrow_exception(error_);
+  }
+
+ private:
+  struct Node {
+    detail::InlineTask fn;
+    std::vector<NodeId> successors;
+    std::size_t dependencies = 0;
+    std::atomic<std::size_t> pending{0};  // unfinished dependencies in the current run
+  };
+
+  // Topological order by Kahn's algorithm, roots first; rejects cycles.
+  void sort() {
+    std::vector<std::size_t> indegree(nodes_.size());
+    for (std::size_t i = 0; i < nodes_.size(); ++i) indegree[i] = nodes_[i]->dependencies;
+    std::vector<NodeId> order;
+    order.reserve(nodes_.size());
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+      if (indegree[i] == 0) order.push_back(i);
+    }
+    const std::size_t roots = order.size();
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      for (NodeId s : nodes_[order[i]]->successors) {
+        if (--indegree[s] == 0) order.push_back(s);
+      }
+    }
+    if (order.size() != nodes_.size()) {
+      throw std::invalid_argument("TaskGraph::run: the graph has a cycle");
+    }
+    order_ = std::move(order);
+    roots_ = roots;
+  }
+
+  void invoke(Node& node) {
+    if (failed_.load(std::memory_order_relaxed)) return;
+    try {
+      node.fn();
+    } catch (...) {
+      if (!failed_.exchange(true)) error_ = std::current_exception();
+    }
+  }
+
+  // Runs a ready node, then keeps going with the first successor it made ready.
+  void execute(NodeId id) {
+    while (id != kNone) {
+      Node& node = *nodes_[id];
+      invoke(node);
+      id = kNone;
+      for (NodeId s : node.successors) {
+        if (nodes_[s]->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+        if (id == kNone) {
+          id = s;
+        } else {
+          pool_->post_continuation({}, [this, s] { execute(s); });
+          {
+            std::lock_guard<std::mutex> lk(done_m_);
+            ++posted_;
+          }
+          done_cv_.notify_one();
+        }
+      }
+      // Successors are accounted for before this node is, so remaining_ reaches zero only after
+      // the last node; past that point the graph may be destroyed by the caller of run()
+      if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lk(done_m_);
+        done_ = true;
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  static constexpr NodeId kNone = ~NodeId{0};
+
+  std::vector<std::unique_ptr<Node>> nodes_;
+  std::vector<NodeId> order_;  // empty until the next run after a change
+  std::size_t roots_ = 0;
+
+  ThreadPool* pool_ = nullptr;
+  std::atomic<std::size_t> remaining_{0};
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;  // written by the thread that set failed_
+  std::mutex done_m_;
+  std::condition_variable done_cv_;
+  bool done_ = false;       // guarded by done_m_
+  std::size_t posted_ = 0;  // nodes posted by execute(), guarded by done_m_
+};
+
+}  // namespace core
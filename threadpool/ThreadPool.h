@@ -1,123 +1,1068 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <coroutine>
 #include <cstddef>
-#include <deque>
-#include <functional>
+#include <cstdint>
+#include <exception>
 #include <future>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#include "BoundedQueue.h"
+#include "InlineTask.h"
+#include "ThreadPoolStats.h"
+#include "Topology.h"
+#include "WorkStealingDeque.h"
+
+#ifdef CORE_ENABLE_TRACE
+#include "TraceCategory.h"
+#define CORE_THREADPOOL_TRACE_EVENT(name) TRACE_EVENT("threadpool", name)
+#define CORE_THREADPOOL_TRACE_COUNTER(name, value) TRACE_COUNTER("threadpool", name, value)
+#else
+#define CORE_THREADPOOL_TRACE_EVENT(name)
+#define CORE_THREADPOOL_TRACE_COUNTER(name, value)
+#endif
+
 namespace core {
 
+class CompletionPoller;
+class TaskGraph;
+
+// Scheduling classes, see ThreadPool.
+enum class TaskPriority { Realtime, Normal, Background };
+
+struct TaskOptions {
+  using Clock = std::chrono::steady_clock;
+
+  TaskOptions() = default;
+  // Implicit, so that post(TaskPriority::Background, fn) reads naturally
+  TaskOptions(TaskPriority p, Clock::time_point d = Clock::time_point::max())
+      : priority(p), deadline(d) {}
+
+  TaskPriority priority = TaskPriority::Normal;
+  // Realtime and background tasks with earlier deadlines run first; no deadline sorts last.
+  // Normal tasks ignore it.
+  Clock::time_point deadline = Clock::time_point::max();
+  // Normal tasks only: run on a worker of this node group, an index into ThreadPool::nodes(), so
+  // that the task works on memory local to that NUMA node. -1 lets any worker run it.
+  int node = -1;
+};
+
+struct ThreadPoolOptions {
+  std::size_t thread_count = 0;  // 0: one worker per CPU of the topology
+  // CPUs to run on, grouped per NUMA node; empty probes the machine with probe_numa_topology().
+  // A custom list of nodes also picks the CPUs workers are pinned to.
+  std::vector<NumaNode> topology;
+  bool pin_threads = false;  // pin each worker to one CPU of its node, best effort
+  // Workers are named "<thread_name>-<index>", cut to the 15 characters Linux allows; empty
+  // leaves the names alone.
+  std::string thread_name = "core-worker";
+  // Idle policy: a worker that runs out of tasks polls for new ones for spin_budget, pausing the
+  // CPU between polls, then yields yield_count times, then parks. Submissions skip the wakeup
+  // while a worker is polling, and a worker that finds a task after idling wakes a sleeper if
+  // more are queued. Spinning trades CPU time for wakeup latency; 0 and 0 park at once.
+  std::chrono::nanoseconds spin_budget = std::chrono::microseconds(20);
+  std::uint32_t yield_count = 4;
+  // Time every task for the queue-wait and run-time histograms and the busy time of
+  // ThreadPool::stats(): two clock reads per task more. The plain counters are always on.
+  bool latency_metrics = false;
+  // Bound on the normal tasks queued by threads outside the pool, e.g. a camera callback, so that
+  // producers outrunning the workers cannot grow memory without limit; 0 leaves it unbounded.
+  // overflow picks what post() and submit() do when the queue is full, try_post() and
+  // try_submit() fail instead. Tasks submitted by tasks go to the workers' own deques and are
+  // never bounded, so a full queue cannot deadlock the pool; priority and node lanes neither.
+  // Nor are the pool's own continuations, TaskGraph nodes and coroutine resumptions, which must
+  // not be dropped or refused once the work they continue was accepted.
+  std::size_t queue_capacity = 0;
+  OverflowPolicy overflow = OverflowPolicy::Block;
+};
+
+namespace detail {
+
+// Spin-wait hint: lets the sibling hyperthread run and saves power.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+}  // namespace detail
+
+// Work-stealing thread pool. Every worker owns a Chase-Lev deque: tasks submitted from a worker
+// go to its own deque and are run newest first while they are hot in cache, idle workers steal
+// the oldest tasks of random victims. Tasks submitted from other threads go through a shared
+// injection queue, optionally a lock-free BoundedQueue that applies backpressure. Idle workers
+// poll for new tasks for a short spin budget, then park one at a time: a submission wakes at most
+// one sleeper, and none while a worker is still polling, and woken workers pass the wakeup on
+// while work is left. Tasks live in recycled nodes with inline storage for their closure (see
+// post()).
+//
+// Tasks come in three priorities. Normal tasks use the deques above. Realtime tasks go to a shared
+// lane, earliest deadline first, that every worker checks before anything else, so they wait for
+// at most the tasks already running and never behind queued normal or background work.
+// Background tasks go to a shared lane checked only when no other work is found; a background
+// task that has waited kBackgroundMaxWait, or whose deadline has passed, is run ahead of normal
+// work so the lane cannot starve.
+//
+// Workers are split into groups, one per NUMA node, in proportion to the CPUs of each node. Idle
+// workers steal from their own group first, optionally run pinned to a CPU of their node, and
+// tasks can be routed to a group (TaskOptions::node) to keep them next to their data.
 class ThreadPool {
+  template <class F>
+  static constexpr bool is_options = std::is_same_v<std::decay_t<F>, TaskOptions> ||
+                                     std::is_same_v<std::decay_t<F>, TaskPriority>;
+
  public:
+  // How long a queued background task may be passed over by normal work.
+  static constexpr std::chrono::milliseconds kBackgroundMaxWait{20};
+
   explicit ThreadPool(std::size_t thread_count = std::thread::hardware_concurrency()
                                                      ? std::thread::hardware_concurrency()
-                                                     : 4) {
+                                                     : 4)
+      : ThreadPool(options_for(thread_count)) {}
+
+  explicit ThreadPool(const ThreadPoolOptions& options)
+      : overflow_(options.overflow),
+        nodes_(options.topology.empty() ? probe_numa_topology() : options.topology),
+        pin_threads_(options.pin_threads),
+        thread_name_(options.thread_name),
+        spin_budget_ns_(options.spin_budget.count()),
+        yield_count_(options.yield_count),
+        latency_metrics_(options.latency_metrics),
+        stats_start_(std::chrono::steady_clock::now()) {
+    std::size_t cpus = 0;
+    for (const NumaNode& node : nodes_) cpus += node.cpus.size();
+    if (cpus == 0) throw std::invalid_argument("ThreadPool: topology without CPUs");
+    const std::size_t thread_count = options.thread_count != 0 ? options.thread_count : cpus;
+    if (options.queue_capacity != 0) {
+      // Always blocking: push_bounded() applies the overflow policy itself
+      bounded_ = std::make_unique<BoundedQueue<Task*>>(options.queue_capacity);
+    }
+
+    // Workers per node in proportion to its CPUs, the remainder going to the first nodes
+    node_workers_.resize(nodes_.size());
+    std::size_t assigned = 0;
+    for (std::size_t k = 0; k < nodes_.size(); ++k) {
+      node_workers_[k] = thread_count * nodes_[k].cpus.size() / cpus;
+      assigned += node_workers_[k];
+    }
+    for (std::size_t k = 0; assigned < thread_count; k = (k + 1) % nodes_.size()) {
+      if (!nodes_[k].cpus.empty()) {
+        ++node_workers_[k];
+        ++assigned;
+      }
+    }
+
+    queues_.reserve(thread_count);
+    for (std::size_t k = 0; k < nodes_.size(); ++k) {
+      node_lanes_.push_back(std::make_unique<Lane>());
+      park_groups_.push_back(std::make_unique<ParkGroup>());
+      for (std::size_t j = 0; j < node_workers_[k]; ++j) {
+        auto worker = std::make_unique<Worker>(queues_.size());
+        worker->node = k;
+        worker->cpu = nodes_[k].cpus[j % nodes_[k].cpus.size()];
+        queues_.push_back(std::move(worker));
+      }
+    }
+    baseline_.workers.resize(queues_.size() + 1);
     workers_.reserve(thread_count);
     for (std::size_t i = 0; i < thread_count; ++i) {
-      workers_.emplace_back([this] { worker_loop(); });
+      workers_.emplace_back([this, i] {
+        configure_thread(*queues_[i]);
+        worker_loop(*queues_[i]);
+      });
     }
   }
 
   ThreadPool(const ThreadPool&) = delete;
   ThreadPool& operator=(const ThreadPool&) = delete;
 
-  ~ThreadPool() { shutdown(); }
+  ~ThreadPool() {
+    shutdown();
+    for (const auto& worker : queues_) delete_nodes(worker->free_nodes);
+    delete_nodes(shared_nodes_);
+  }
+
+  // Runs f(args...) on a worker, fire-and-forget: there is no future and exceptions escaping f
+  // are dropped. Closures of up to detail::InlineTask::kInlineSize bytes are stored in recycled
+  // task nodes, so once the pool is warm posting them performs no heap allocation.
+  template <class F, class... Args, class = std::enable_if_t<!is_options<F>>>
+  void post(F&& f, Args&&... args) {
+    post(TaskOptions{}, std::forward<F>(f), std::forward<Args>(args)...);
+  }
 
+  // post() with a priority and deadline, e.g. post(TaskPriority::Background, fn).
   template <class F, class... Args>
+  void post(const TaskOptions& options, F&& f, Args&&... args) {
+    post_task(options, false, std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  // post() that returns false rather than wait, throw or drop a task when the bounded queue is
+  // full, see ThreadPoolOptions::queue_capacity. Always succeeds on an unbounded pool.
+  template <class F, class... Args, class = std::enable_if_t<!is_options<F>>>
+  bool try_post(F&& f, Args&&... args) {
+    return post_task(TaskOptions{}, true, std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  template <class F, class... Args>
+  bool try_post(const TaskOptions& options, F&& f, Args&&... args) {
+    return post_task(options, true, std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  template <class F, class... Args, class = std::enable_if_t<!is_options<F>>>
   auto submit(F&& f, Args&&... args)
       -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
-    using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+    return submit(TaskOptions{}, std::forward<F>(f), std::forward<Args>(args)...);
+  }
 
-    auto task_fn =
-        [fn = std::decay_t<F>(std::forward<F>(f)),
-         tup = std::make_tuple(std::decay_t<Args>(std::forward<Args>(args))...)]() mutable -> R {
-      return std::apply(std::move(fn), std::move(tup));
+  template <class F, class... Args>
+  auto submit(const TaskOptions& options, F&& f, Args&&... args)
+      -> std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+    return *submit_task(options, false, std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  // submit() that returns no future when the bounded queue is full, like try_post().
+  template <class F, class... Args, class = std::enable_if_t<!is_options<F>>>
+  auto try_submit(F&& f, Args&&... args)
+      -> std::optional<std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>> {
+    return submit_task(TaskOptions{}, true, std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  template <class F, class... Args>
+  auto try_submit(const TaskOptions& options, F&& f, Args&&... args)
+      -> std::optional<std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>> {
+    return submit_task(options, true, std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  // Awaitable that moves the awaiting coroutine onto a worker: `co_await pool.schedule();`. The
+  // options pick the priority of the task that resumes it.
+  auto schedule(const TaskOptions& options = {}) {
+    struct Awaiter {
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) {
+        pool->post_continuation(options, [h] { h.resume(); });
+      }
+      void await_resume() const noexcept {}
+      ThreadPool* pool;
+      TaskOptions options;
     };
+    return Awaiter{this, options};
+  }
 
-    auto ptask = std::make_shared<std::packaged_task<R()>>(std::move(task_fn));
-    std::future<R> fut = ptask->get_future();
+  // Calls fn(chunk_begin, chunk_end) over [begin, end) cut into chunks of grain indices, the last
+  // one possibly shorter; grain 0 picks about 8 chunks per thread. Chunks are handed out
+  // dynamically to the workers and to the calling thread, which takes part: this blocks without
+  // futures, and may be called from inside a task. The chunk boundaries depend only on begin,
+  // end and grain. The first exception thrown by fn is rethrown once the running chunks are done;
+  // the chunks not yet started are skipped.
+  template <class F>
+  void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, F&& fn) {
+    if (end <= begin) return;
+    const std::size_t n = end - begin;
+    if (grain == 0) grain = std::max<std::size_t>(1, n / (8 * (size() + 1)));
+    const std::size_t chunks = n / grain + (n % grain != 0);
+    auto chunk = [&](std::size_t i) {
+      const std::size_t b = begin + i * grain;
+      fn(b, b + std::min(grain, end - b));
+    };
+    run_chunks(chunks, chunk);
+  }
 
-    {
-      std::lock_guard<std::mutex> lk(m_);
-      if (!accepting_) throw std::runtime_error("ThreadPool: submit on a stopped pool");
-      tasks_.emplace_back([ptask]() mutable { (*ptask)(); });
-    }
-    cv_.notify_one();
-    return fut;
+  // 2D version over tiles of tile_rows x tile_cols: fn(row_begin, row_end, col_begin, col_end).
+  // Tiles are handed out in row-major order.
+  template <class F>
+  void parallel_for_2d(std::size_t rows, std::size_t cols, std::size_t tile_rows,
+                       std::size_t tile_cols, F&& fn) {
+    if (rows == 0 || cols == 0) return;
+    tile_rows = std::max<std::size_t>(1, tile_rows);
+    tile_cols = std::max<std::size_t>(1, tile_cols);
+    const std::size_t tiles_x = cols / tile_cols + (cols % tile_cols != 0);
+    const std::size_t tiles_y = rows / tile_rows + (rows % tile_rows != 0);
+    auto tile = [&](std::size_t i) {
+      const std::size_t r = i / tiles_x * tile_rows;
+      const std::size_t c = i % tiles_x * tile_cols;
+      fn(r, r + std::min(tile_rows, rows - r), c, c + std::min(tile_cols, cols - c));
+    };
+    run_chunks(tiles_x * tiles_y, tile);
   }
 
+  // Blocks until every submitted task, including the ones they submit, has finished.
   void wait_idle() {
-    std::unique_lock<std::mutex> lk(m_);
-    idle_cv_.wait(lk, [this] { return tasks_.empty() && active_ == 0; });
+    std::unique_lock<std::mutex> lk(idle_m_);
+    idle_cv_.wait(lk, [this] { return pending_.load(std::memory_order_acquire) == 0; });
   }
 
+  // Stops accepting tasks, runs the queued ones and joins the workers.
   void shutdown() {
     std::vector<std::thread> to_join;
     {
       std::lock_guard<std::mutex> lk(m_);
-      if (!accepting_) return;
-      accepting_ = false;
+      if (!accepting_.load(std::memory_order_relaxed)) return;
+      accepting_.store(false, std::memory_order_seq_cst);
       to_join.swap(workers_);  // move out so we can release lock while joining
     }
-    cv_.notify_all();  // wake workers
+    {
+      std::lock_guard<std::mutex> lk(park_m_);
+      for (const auto& group : park_groups_) group->cv.notify_all();  // wake workers
+    }
 
     for (auto& t : to_join) {
       if (t.joinable()) t.join();
     }
+  }
 
-    // After joins, all workers are gone; signal idle in case anyone waits.
-    {
-      std::lock_guard<std::mutex> lk(m_);
-      if (tasks_.empty() && active_ == 0) idle_cv_.notify_all();
-    }
+  // Runs one queued task on the calling thread, if there is one, and returns whether it did. A
+  // thread that blocks on work of this pool can call it to help instead of sleeping. Tasks are
+  // picked in the order the workers use.
+  bool run_pending_task() {
+    Worker* worker = current_worker();
+    Task* task = find_task(worker);
+    if (task == nullptr) return false;
+    run_task(worker, task);
+    return true;
   }
 
   std::size_t size() const noexcept { return workers_.size(); }
 
+  // Changes ThreadPoolOptions::spin_budget; workers pick it up the next time they go idle.
+  void set_spin_budget(std::chrono::nanoseconds budget) {
+    spin_budget_ns_.store(budget.count(), std::memory_order_relaxed);
+  }
+
+  // Counters since construction or the last reset_stats(). Reading them does not stop the
+  // workers, so the values are a consistent snapshot only when the pool is idle.
+  ThreadPoolStats stats() const {
+    ThreadPoolStats stats = read_stats();
+    std::lock_guard<std::mutex> lk(stats_m_);
+    for (std::size_t i = 0; i < stats.workers.size(); ++i) {
+      ThreadPoolStats::Worker& worker = stats.workers[i];
+      const ThreadPoolStats::Worker& base = baseline_.workers[i];
+      worker.tasks -= base.tasks;
+      worker.steals -= base.steals;
+      worker.parks -= base.parks;
+      worker.busy -= base.busy;
+    }
+    for (std::size_t i = 0; i < ThreadPoolStats::Histogram::kBuckets; ++i) {
+      stats.queue_wait.counts[i] -= baseline_.queue_wait.counts[i];
+      stats.run_time.counts[i] -= baseline_.run_time.counts[i];
+    }
+    stats.dropped -= baseline_.dropped;
+    stats.elapsed = std::chrono::steady_clock::now() - stats_start_;
+    return stats;
+  }
+
+  void reset_stats() {
+    ThreadPoolStats baseline = read_stats();
+    std::lock_guard<std::mutex> lk(stats_m_);
+    baseline_ = std::move(baseline);
+    stats_start_ = std::chrono::steady_clock::now();
+  }
+
+  // Turns ThreadPoolOptions::latency_metrics on or off for the tasks submitted from now on.
+  void set_latency_metrics(bool enabled) {
+    latency_metrics_.store(enabled, std::memory_order_relaxed);
+  }
+
+  // The node groups, in the order of TaskOptions::node.
+  const std::vector<NumaNode>& nodes() const noexcept { return nodes_; }
+
+  // The node group of the worker running on the calling thread, or -1 outside the pool.
+  int current_node() const {
+    const Worker* worker = current_worker();
+    return worker != nullptr ? static_cast<int>(worker->node) : -1;
+  }
+
  private:
-  void worker_loop() {
-    for (;;) {
-      std::function<void()> task;
+  friend class CompletionPoller;
+  friend class TaskGraph;
 
-      {
-        std::unique_lock<std::mutex> lk(m_);
-        cv_.wait(lk, [this] { return !tasks_.empty() || !accepting_; });
+  static ThreadPoolOptions options_for(std::size_t thread_count) {
+    ThreadPoolOptions options;
+    options.thread_count = thread_count;
+    return options;
+  }
+
+  template <class F, class... Args>
+  bool post_task(const TaskOptions& options, bool try_only, F&& f, Args&&... args) {
+    if constexpr (sizeof...(Args) == 0) {
+      return enqueue(options, std::forward<F>(f), try_only);
+    } else {
+      return enqueue(
+          options,
+          [fn = std::decay_t<F>(std::forward<F>(f)),
+           tup = std::make_tuple(std::decay_t<Args>(std::forward<Args>(args))...)]() mutable {
+            std::apply(std::move(fn), std::move(tup));
+          },
+          try_only);
+    }
+  }
+
+  template <class F, class... Args>
+  auto submit_task(const TaskOptions& options, bool try_only, F&& f, Args&&... args)
+      -> std::optional<std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>> {
+    using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
 
-        if (!accepting_ && tasks_.empty()) break;
+    auto task_fn =
+        [fn = std::decay_t<F>(std::forward<F>(f)),
+         tup = std::make_tuple(std::decay_t<Args>(std::forward<Args>(args))...)]() mutable -> R {
+      return std::apply(std::move(fn), std::move(tup));
+    };
 
-        task = std::move(tasks_.front());
-        tasks_.pop_front();
-        ++active_;
+    auto ptask = std::make_shared<std::packaged_task<R()>>(std::move(task_fn));
+    std::future<R> fut = ptask->get_future();
+    if (!enqueue(options, [ptask]() mutable { (*ptask)(); }, try_only)) return std::nullopt;
+    return fut;
+  }
+
+  // post() for the pool's own continuations, see ThreadPoolOptions::queue_capacity: from outside
+  // threads they go to the unbounded injection queue whatever the overflow policy.
+  template <class F>
+  void post_continuation(const TaskOptions& options, F&& fn) {
+    enqueue(options, std::forward<F>(fn), false, true);
+  }
+
+  struct Task {
+    Task* next = nullptr;  // free list or queue link
+    // Lane order: the deadline, or for background tasks the time they are due to run
+    TaskOptions::Clock::time_point due;
+    std::int64_t enqueued_ns = 0;  // submission time with latency metrics on, else 0
+    detail::InlineTask fn;
+  };
+
+  // Shared queue of one priority, sorted by Task::due and FIFO among equal ones. Pushing at the
+  // tail, the common case of tasks without deadlines, is O(1).
+  struct Lane {
+    void push(Task* task) {
+      std::lock_guard<std::mutex> lk(m);
+      if (tail == nullptr || tail->due <= task->due) {
+        task->next = nullptr;
+        (tail != nullptr ? tail->next : head) = task;
+        tail = task;
+      } else {
+        Task** link = &head;
+        while ((*link)->due <= task->due) link = &(*link)->next;
+        task->next = *link;
+        *link = task;
       }
+      count.fetch_add(1, std::memory_order_relaxed);
+      head_due.store(head->due.time_since_epoch().count(), std::memory_order_relaxed);
+    }
 
-      try {
-        task();
-      } catch (...) { /* packaged_task handles exceptions */
+    Task* pop() {
+      if (count.load(std::memory_order_relaxed) == 0) return nullptr;
+      std::lock_guard<std::mutex> lk(m);
+      Task* task = head;
+      if (task == nullptr) return nullptr;
+      head = task->next;
+      if (head == nullptr) tail = nullptr;
+      count.fetch_sub(1, std::memory_order_relaxed);
+      if (head != nullptr) head_due.store(head->due.time_since_epoch().count(),
+                                          std::memory_order_relaxed);
+      return task;
+    }
+
+    // Whether the first task is due, without taking the lock.
+    bool overdue() const {
+      return count.load(std::memory_order_relaxed) != 0 &&
+             head_due.load(std::memory_order_relaxed) <=
+                 TaskOptions::Clock::now().time_since_epoch().count();
+    }
+
+    std::mutex m;
+    Task* head = nullptr;  // guarded by m
+    Task* tail = nullptr;  // guarded by m
+    std::atomic<std::size_t> count{0};
+    std::atomic<TaskOptions::Clock::rep> head_due{0};
+  };
+
+  // Parked workers of one node group. A wakeup is handed to one sleeper, which takes it back when
+  // it leaves park(); the count is guarded by park_m_.
+  struct ParkGroup {
+    std::condition_variable cv;
+    std::atomic<std::size_t> sleepers{0};
+    std::size_t wakeups = 0;
+  };
+
+  // Free nodes move between a worker's private list and the shared one in batches.
+  static constexpr std::size_t kNodeBatch = 64;
+
+  // Chunks [0, chunks) of a parallel_for, shared between the caller and the helper tasks. Helpers
+  // that start after the last chunk was handed out return without touching the chunk function,
+  // which lives on the caller's stack.
+  struct ParallelJob {
+    explicit ParallelJob(std::size_t n) : chunks(n) {}
+
+    void run() {
+      for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+        if (!failed.load(std::memory_order_relaxed)) {
+          try {
+            call(fn, i);
+          } catch (...) {
+            if (!failed.exchange(true)) error = std::current_exception();
+          }
+        }
+        if (finished.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) finished.notify_all();
+      }
+    }
+
+    const std::size_t chunks;
+    void* fn = nullptr;
+    void (*call)(void* fn, std::size_t chunk) = nullptr;
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> finished{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;  // written by the thread that set failed
+  };
+
+  template <class ChunkFn>
+  void run_chunks(std::size_t chunks, ChunkFn& chunk_fn) {
+    const std::size_t helpers = std::min(size(), chunks - 1);
+    if (helpers == 0) {
+      for (std::size_t i = 0; i < chunks; ++i) chunk_fn(i);
+      return;
+    }
+    auto job = std::make_shared<ParallelJob>(chunks);
+    job->fn = &chunk_fn;
+    job->call = [](void* fn, std::size_t i) { (*static_cast<ChunkFn*>(fn))(i); };
+    // Helpers only take free room in a bounded queue: they neither evict nor wait behind the
+    // caller's own tasks
+    try {
+      for (std::size_t i = 0; i < helpers; ++i) {
+        if (!enqueue({}, [job] { job->run(); }, true)) break;
       }
+    } catch (const std::runtime_error&) {
+      // Stopped pool
+    }
+    // The caller runs what the helpers did not get
+    job->run();
+    for (std::size_t f; (f = job->finished.load(std::memory_order_acquire)) != chunks;) {
+      job->finished.wait(f, std::memory_order_acquire);
+    }
+    if (job->error) std::rethrow_exception(job->error);
+  }
+
+  struct Worker {
+    explicit Worker(std::size_t i)
+        : index(i), rng(static_cast<std::uint32_t>(i) * 0x9e3779b9u + 1) {}
+
+    detail::WorkStealingDeque<Task*> deque;
+    std::size_t index;
+    std::size_t node = 0;  // group index into nodes_
+    int cpu = -1;
+    std::uint32_t rng;  // xorshift state for victim selection
+    Task* free_nodes = nullptr;  // owner only
+    std::size_t free_count = 0;
+    detail::WorkerMetrics metrics;
+  };
 
-      // NEW: notify whenever the pool is idle
+  // The worker of this pool running on the calling thread, if any.
+  Worker* current_worker() const {
+    const WorkerContext& context = worker_context();
+    return context.pool == this ? context.worker : nullptr;
+  }
+
+  struct WorkerContext {
+    const ThreadPool* pool = nullptr;
+    Worker* worker = nullptr;
+  };
+
+  static WorkerContext& worker_context() {
+    thread_local WorkerContext context;
+    return context;
+  }
+
+  // Queues fn; returns false only when try_only is set and the bounded queue is full. Continuations
+  // bypass the bounded queue.
+  template <class F>
+  bool enqueue(const TaskOptions& options, F&& fn, bool try_only = false,
+               bool continuation = false) {
+    const bool routed = options.priority == TaskPriority::Normal && options.node >= 0;
+    if (routed && static_cast<std::size_t>(options.node) >= nodes_.size()) {
+      throw std::invalid_argument("ThreadPool: no node group " + std::to_string(options.node));
+    }
+    Worker* worker = current_worker();
+    Task* task = acquire_node(worker);
+    try {
+      task->fn.emplace(std::forward<F>(fn));
+    } catch (...) {
+      release_node(worker, task);
+      throw;
+    }
+    task->enqueued_ns = latency_metrics_.load(std::memory_order_relaxed) ? now_ns() : 0;
+    [[maybe_unused]] const std::size_t pending = pending_.fetch_add(1, std::memory_order_relaxed);
+    CORE_THREADPOOL_TRACE_COUNTER("ThreadPool pending", pending + 1);
+    if (routed && node_workers_[static_cast<std::size_t>(options.node)] != 0) {
+      // Under m_ even from a worker: the group's workers may be the only ones to drain the lane
       {
         std::lock_guard<std::mutex> lk(m_);
-        --active_;
-        if (tasks_.empty() && active_ == 0) idle_cv_.notify_all();
+        if (!accepting_.load(std::memory_order_relaxed)) {
+          finish_rejected(worker, task);
+          throw std::runtime_error("ThreadPool: submit on a stopped pool");
+        }
+        task->due = options.deadline;
+        node_lanes_[static_cast<std::size_t>(options.node)]->push(task);
       }
+      wake_group(static_cast<std::size_t>(options.node));
+      return true;
     }
+    if (options.priority != TaskPriority::Normal) {
+      // Other threads check accepting_ under m_, like shutdown(); a worker drains its own pushes
+      std::unique_lock<std::mutex> lk(m_, std::defer_lock);
+      if (worker == nullptr) lk.lock();
+      if (!accepting_.load(std::memory_order_relaxed)) {
+        finish_rejected(worker, task);
+        throw std::runtime_error("ThreadPool: submit on a stopped pool");
+      }
+      if (options.priority == TaskPriority::Realtime) {
+        task->due = options.deadline;
+        realtime_.push(task);
+      } else {
+        const auto latest = TaskOptions::Clock::now() + kBackgroundMaxWait;
+        task->due = std::min(options.deadline, latest);
+        background_.push(task);
+      }
+    } else if (worker != nullptr) {
+      if (!accepting_.load(std::memory_order_relaxed)) {
+        finish_rejected(worker, task);
+        throw std::runtime_error("ThreadPool: submit on a stopped pool");
+      }
+      worker->deque.push(task);
+    } else if (bounded_ != nullptr && !continuation) {
+      if (!push_bounded(task, try_only)) return false;
+    } else {
+      std::lock_guard<std::mutex> lk(m_);
+      if (!accepting_.load(std::memory_order_relaxed)) {
+        finish_rejected(worker, task);
+        throw std::runtime_error("ThreadPool: submit on a stopped pool");
+      }
+      task->next = nullptr;
+      (injected_tail_ != nullptr ? injected_tail_->next : injected_head_) = task;
+      injected_tail_ = task;
+      injected_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake_one();
+    return true;
   }
 
-  mutable std::mutex m_;
-  std::condition_variable cv_;
-  std::condition_variable idle_cv_;
-  std::deque<std::function<void()>> tasks_;
+  // Pushes a task of an outside thread to the bounded queue, applying the overflow policy unless
+  // try_only. The queue takes no lock, so pushing_ stands in for m_: workers do not exit while a
+  // push that passed the accepting_ check is under way, see park().
+  bool push_bounded(Task* task, bool try_only) {
+    pushing_.fetch_add(1, std::memory_order_seq_cst);
+    if (!accepting_.load(std::memory_order_seq_cst)) {
+      pushing_.fetch_sub(1, std::memory_order_seq_cst);
+      finish_rejected(nullptr, task);
+      throw std::runtime_error("ThreadPool: submit on a stopped pool");
+    }
+    bool pushed = bounded_->try_push(task);
+    if (!pushed && !try_only) {
+      switch (overflow_) {
+        case OverflowPolicy::Block:
+          pushed = bounded_->push(task);
+          break;
+        case OverflowPolicy::Fail:
+          pushing_.fetch_sub(1, std::memory_order_seq_cst);
+          finish_rejected(nullptr, task);
+          throw std::runtime_error("ThreadPool: task queue full");
+        case OverflowPolicy::DropOldest:
+          while (!(pushed = bounded_->try_push(task))) {
+            Task* oldest = nullptr;
+            if (!bounded_->try_pop(&oldest)) continue;
+            // Never run: a submit() future reports std::future_errc::broken_promise
+            release_node(nullptr, oldest);
+            task_done();
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+          }
+          break;
+      }
+    }
+    pushing_.fetch_sub(1, std::memory_order_seq_cst);
+    if (!pushed) finish_rejected(nullptr, task);
+    return pushed;
+  }
+
+  // Names the calling worker thread and pins it to its CPU, both best effort.
+  void configure_thread(const Worker& worker) const {
+    if (!thread_name_.empty()) {
+      std::string name = thread_name_ + "-" + std::to_string(worker.index);
+      if (name.size() > 15) name.resize(15);
+#if defined(__linux__)
+      pthread_setname_np(pthread_self(), name.c_str());
+#elif defined(__APPLE__)
+      pthread_setname_np(name.c_str());
+#endif
+    }
+#if defined(__linux__)
+    if (pin_threads_ && worker.cpu >= 0 && worker.cpu < CPU_SETSIZE) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(static_cast<std::size_t>(worker.cpu), &set);
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+  }
+
+  void finish_rejected(Worker* worker, Task* task) {
+    release_node(worker, task);
+    task_done();
+  }
+
+  // A free node from the worker's own list, refilled from the shared list in batches; external
+  // threads take nodes from the shared list. Allocates only when both are empty.
+  Task* acquire_node(Worker* worker) {
+    if (worker != nullptr) {
+      if (worker->free_nodes == nullptr) {
+        std::lock_guard<std::mutex> lk(nodes_m_);
+        for (std::size_t i = 0; i < kNodeBatch && shared_nodes_ != nullptr; ++i) {
+          Task* node = shared_nodes_;
+          shared_nodes_ = node->next;
+          node->next = worker->free_nodes;
+          worker->free_nodes = node;
+          ++worker->free_count;
+        }
+      }
+      if (Task* node = worker->free_nodes; node != nullptr) {
+        worker->free_nodes = node->next;
+        --worker->free_count;
+        return node;
+      }
+    } else {
+      std::lock_guard<std::mutex> lk(nodes_m_);
+      if (Task* node = shared_nodes_; node != nullptr) {
+        shared_nodes_ = node->next;
+        return node;
+      }
+    }
+    return new Task;
+  }
+
+  // Returns a node whose callable was destroyed. Workers keep up to two batches and hand the
+  // surplus back, so nodes flow from the workers that run tasks to the threads that post them.
+  void release_node(Worker* worker, Task* node) {
+    node->fn.reset();
+    if (worker == nullptr) {
+      std::lock_guard<std::mutex> lk(nodes_m_);
+      node->next = shared_nodes_;
+      shared_nodes_ = node;
+      return;
+    }
+    node->next = worker->free_nodes;
+    worker->free_nodes = node;
+    if (++worker->free_count <= 2 * kNodeBatch) return;
+    Task* first = worker->free_nodes;
+    Task* last = first;
+    for (std::size_t i = 1; i < kNodeBatch; ++i) last = last->next;
+    worker->free_nodes = last->next;
+    worker->free_count -= kNodeBatch;
+    std::lock_guard<std::mutex> lk(nodes_m_);
+    last->next = shared_nodes_;
+    shared_nodes_ = first;
+  }
+
+  static void delete_nodes(Task* node) {
+    while (node != nullptr) delete std::exchange(node, node->next);
+  }
+
+  void task_done() {
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lk(idle_m_);
+      idle_cv_.notify_all();
+    }
+  }
+
+  // Wakes one parked worker, if any, preferring the submitting worker's node group. The seq_cst
+  // fence pairs with the one in park(): either the parking worker sees the new task or this sees
+  // the sleeper.
+  // A polling worker will find the task by itself: the same fence orders the push before the
+  // spinners_ check against the spinner's decrement before it parks.
+  void wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (spinners_.load(std::memory_order_relaxed) != 0) return;
+    const Worker* worker = current_worker();
+    wake_sleeper(worker != nullptr ? worker->node : 0);
+  }
+
+  // Wakes one parked worker regardless of pollers, trying node group `first` first.
+  void wake_sleeper(std::size_t first) {
+    if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+    std::lock_guard<std::mutex> lk(park_m_);
+    for (std::size_t k = 0; k < park_groups_.size(); ++k) {
+      if (notify_group(*park_groups_[(first + k) % park_groups_.size()])) return;
+    }
+  }
+
+  // Wakes one parked worker of a node group for a task routed to its lane; only the group's
+  // workers can run it.
+  void wake_group(std::size_t node) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ParkGroup& group = *park_groups_[node];
+    if (group.sleepers.load(std::memory_order_relaxed) == 0) return;
+    std::lock_guard<std::mutex> lk(park_m_);
+    notify_group(group);
+  }
+
+  // Under park_m_: hands a wakeup to a sleeper of the group not woken yet, if there is one.
+  static bool notify_group(ParkGroup& group) {
+    if (group.wakeups >= group.sleepers.load(std::memory_order_relaxed)) return false;
+    ++group.wakeups;
+    group.cv.notify_one();
+    return true;
+  }
+
+  // Continuations first, they complete work already under way, then the bounded queue.
+  Task* pop_injected() {
+    Task* task = nullptr;
+    if (injected_count_.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lk(m_);
+      if ((task = injected_head_) != nullptr) {
+        injected_head_ = task->next;
+        if (injected_head_ == nullptr) injected_tail_ = nullptr;
+        injected_count_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+    return bounded_ != nullptr && bounded_->try_pop(&task) ? task : nullptr;
+  }
+
+  // Steals from a random victim other than self, trying the workers of its own node group
+  // first; threads outside the pool pass nullptr and scan the deques in order.
+  Task* steal(Worker* self) {
+    const std::size_t n = queues_.size();
+    std::size_t first = 0;
+    if (self != nullptr) {
+      if (n < 2) return nullptr;
+      self->rng ^= self->rng << 13;
+      self->rng ^= self->rng >> 17;
+      self->rng ^= self->rng << 5;
+      first = self->rng % n;
+    }
+    Task* task = nullptr;
+    const int passes = self != nullptr && nodes_.size() > 1 ? 2 : 1;
+    for (int pass = 0; pass < passes; ++pass) {
+      for (std::size_t i = 0; i < n; ++i) {
+        Worker& victim = *queues_[(first + i) % n];
+        if (&victim == self) continue;
+        if (passes == 2 && (victim.node == self->node) != (pass == 0)) continue;
+        if (victim.deque.steal(&task)) {
+          detail::WorkerMetrics& metrics = self != nullptr ? self->metrics : external_metrics_;
+          metrics.add(metrics.steals, 1);
+          return task;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  // Realtime lane, overdue background task, own deque, node group lane, injection queue, victims,
+  // background lane. Threads outside the pool pass nullptr.
+  Task* find_task(Worker* self) {
+    Task* task = realtime_.pop();
+    if (task == nullptr && background_.overdue()) task = background_.pop();
+    if (task != nullptr) return task;
+    if (self != nullptr) {
+      if (self->deque.pop(&task)) return task;
+      if ((task = node_lanes_[self->node]->pop()) != nullptr) return task;
+    }
+    if ((task = pop_injected()) != nullptr) return task;
+    if ((task = steal(self)) != nullptr) return task;
+    return background_.pop();
+  }
+
+  void run_task(Worker* worker, Task* task) {
+    detail::WorkerMetrics& metrics = worker != nullptr ? worker->metrics : external_metrics_;
+    const std::int64_t enqueued = task->enqueued_ns;
+    const std::int64_t start = enqueued != 0 ? now_ns() : 0;
+    {
+      CORE_THREADPOOL_TRACE_EVENT("ThreadPool::task");
+      try {
+        task->fn();
+      } catch (...) { /* packaged_task handles exceptions, post() drops them */
+      }
+    }
+    if (enqueued != 0) {
+      const std::int64_t end = now_ns();
+      metrics.record(metrics.wait_ns, start - enqueued);
+      metrics.record(metrics.run_ns, end - start);
+      metrics.add(metrics.busy_ns, static_cast<std::uint64_t>(end - start));
+    }
+    metrics.add(metrics.tasks, 1);
+    release_node(worker, task);
+    task_done();
+  }
+
+  static std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  ThreadPoolStats read_stats() const {
+    ThreadPoolStats stats;
+    stats.workers.resize(queues_.size() + 1);
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      queues_[i]->metrics.read(&stats.workers[i], &stats.queue_wait, &stats.run_time);
+      stats.queued += queues_[i]->deque.size();
+    }
+    external_metrics_.read(&stats.workers.back(), &stats.queue_wait, &stats.run_time);
+    stats.queued += injected_count_.load(std::memory_order_relaxed) +
+                    realtime_.count.load(std::memory_order_relaxed) +
+                    background_.count.load(std::memory_order_relaxed);
+    for (const auto& lane : node_lanes_) {
+      stats.queued += lane->count.load(std::memory_order_relaxed);
+    }
+    if (bounded_ != nullptr) stats.queued += bounded_->size();
+    stats.pending = pending_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  // Work the worker could run: lanes of other node groups do not count.
+  bool has_work(const Worker& self) const {
+    if (injected_count_.load(std::memory_order_relaxed) != 0) return true;
+    if (bounded_ != nullptr && !bounded_->empty()) return true;
+    if (node_lanes_[self.node]->count.load(std::memory_order_relaxed) != 0) return true;
+    if (realtime_.count.load(std::memory_order_relaxed) != 0) return true;
+    if (background_.count.load(std::memory_order_relaxed) != 0) return true;
+    for (const auto& worker : queues_) {
+      if (!worker->deque.empty()) return true;
+    }
+    return false;
+  }
+
+  // Returns false when the worker should exit: the pool is stopping and no work is left.
+  bool park(Worker& self) {
+    // Each node group sleeps on its own condition variable, so that a task routed to a group
+    // wakes one of its workers, not every sleeper of the pool
+    ParkGroup& group = *park_groups_[self.node];
+    group.sleepers.fetch_add(1, std::memory_order_relaxed);
+    sleepers_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (has_work(self)) {
+      sleepers_.fetch_sub(1, std::memory_order_relaxed);
+      group.sleepers.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    self.metrics.add(self.metrics.parks, 1);
+    CORE_THREADPOOL_TRACE_EVENT("ThreadPool::park");
+    std::unique_lock<std::mutex> lk(park_m_);
+    group.cv.wait(lk, [&] {
+      return group.wakeups > 0 || !accepting_.load(std::memory_order_relaxed);
+    });
+    if (group.wakeups > 0) --group.wakeups;
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    group.sleepers.fetch_sub(1, std::memory_order_relaxed);
+    lk.unlock();
+    // seq_cst like push_bounded(): either the push sees the pool stopped or this sees it under
+    // way, and waits for its task
+    if (accepting_.load(std::memory_order_seq_cst)) return true;
+    return pushing_.load(std::memory_order_seq_cst) != 0 || has_work(self);
+  }
+
+  // Polls for a task for the spin budget, then between yields; nullptr means park.
+  Task* spin(Worker& self) {
+    using Clock = std::chrono::steady_clock;
+    const auto budget = std::chrono::nanoseconds(spin_budget_ns_.load(std::memory_order_relaxed));
+    if (budget.count() <= 0 && yield_count_ == 0) return nullptr;
+    spinners_.fetch_add(1, std::memory_order_seq_cst);
+    Task* task = nullptr;
+    const auto end = Clock::now() + budget;
+    for (std::uint32_t i = 0; task == nullptr && accepting_.load(std::memory_order_relaxed);
+         ++i) {
+      if (i % 16 == 15 && Clock::now() >= end) break;
+      for (int k = 0; k < 8; ++k) detail::cpu_relax();
+      task = find_task(&self);
+    }
+    for (std::uint32_t i = 0; task == nullptr && i < yield_count_; ++i) {
+      std::this_thread::yield();
+      task = find_task(&self);
+    }
+    spinners_.fetch_sub(1, std::memory_order_seq_cst);
+    return task;
+  }
+
+  void worker_loop(Worker& self) {
+    worker_context() = {this, &self};
+    bool idle = false;  // polled or parked since the last task
+    for (;;) {
+      Task* task = find_task(&self);
+      if (task == nullptr) {
+        task = spin(self);
+        idle = true;
+      }
+      if (task != nullptr) {
+        // Submissions made while a worker polled skipped their wakeup, and a burst wakes one
+        // sleeper at a time: a worker picking up work after idling passes the wakeup on while
+        // more is queued, so the burst fans out to every worker
+        if (idle) {
+          idle = false;
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if (has_work(self)) wake_sleeper(self.node);
+        }
+        run_task(&self, task);
+        continue;
+      }
+      if (!park(self)) break;
+    }
+    worker_context() = {};
+  }
+
+  mutable std::mutex m_;  // guards the injection queue and workers_
+  Task* injected_head_ = nullptr;
+  Task* injected_tail_ = nullptr;
+  std::atomic<std::size_t> injected_count_{0};
+  // Takes the outside threads' tasks when bounded; the list above then holds continuations
+  std::unique_ptr<BoundedQueue<Task*>> bounded_;
+  const OverflowPolicy overflow_;
+  std::atomic<std::size_t> pushing_{0};  // push_bounded() calls past the accepting_ check
+  std::atomic<std::uint64_t> dropped_{0};
+  std::vector<std::unique_ptr<Worker>> queues_;
+  Lane realtime_;
+  Lane background_;
+
+  std::vector<NumaNode> nodes_;
+  std::vector<std::size_t> node_workers_;
+  std::vector<std::unique_ptr<Lane>> node_lanes_;
+  std::vector<std::unique_ptr<ParkGroup>> park_groups_;  // one per node group
+  bool pin_threads_;
+  std::string thread_name_;
+  std::atomic<std::chrono::nanoseconds::rep> spin_budget_ns_;
+  const std::uint32_t yield_count_;
+  std::atomic<std::size_t> spinners_{0};  // workers polling in spin()
+
+  std::atomic<bool> latency_metrics_;
+  detail::WorkerMetrics external_metrics_{true};  // tasks run by threads outside the pool
+  mutable std::mutex stats_m_;
+  ThreadPoolStats baseline_;  // guarded by stats_m_, subtracted from read_stats()
+  std::chrono::steady_clock::time_point stats_start_;  // guarded by stats_m_
   std::vector<std::thread> workers_;
+  std::atomic<bool> accepting_{true};
 
-  bool accepting_ = true;   // guarded by m_
-  std::size_t active_ = 0;  // guarded by m_
+  std::mutex nodes_m_;
+  Task* shared_nodes_ = nullptr;  // guarded by nodes_m_
+
+  std::mutex park_m_;
+  std::atomic<std::size_t> sleepers_{0};  // parked workers of all groups
+
+  std::mutex idle_m_;
+  std::condition_variable idle_cv_;
+  std::atomic<std::size_t> pending_{0};  // queued + running tasks
 };
 
-}  // namespace core
\ No newline at end of file
+}  // namespace core
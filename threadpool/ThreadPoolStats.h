@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace core {
+
+// Snapshot of ThreadPool::stats(). Counters cover the time since the pool was created or
+// reset_stats() was last called.
+struct ThreadPoolStats {
+  // Durations in power-of-two buckets: bucket 0 holds 0 ns, bucket i > 0 [2^(i-1), 2^i) ns.
+  struct Histogram {
+    static constexpr std::size_t kBuckets = 40;
+
+    std::uint64_t count() const {
+      std::uint64_t n = 0;
+      for (std::uint64_t c : counts) n += c;
+      return n;
+    }
+
+    // Upper bound of the bucket holding quantile q in [0, 1]; zero when empty.
+    std::chrono::nanoseconds percentile(double q) const {
+      const std::uint64_t n = count();
+      if (n == 0) return std::chrono::nanoseconds(0);
+      const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(n - 1));
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen > rank) return std::chrono::nanoseconds(i == 0 ? 0 : std::int64_t{1} << i);
+      }
+      return std::chrono::nanoseconds(std::int64_t{1} << kBuckets);
+    }
+
+    std::array<std::uint64_t, kBuckets> counts{};
+  };
+
+  struct Worker {
+    std::uint64_t tasks = 0;   // tasks run
+    std::uint64_t steals = 0;  // of which taken from another worker's deque
+    std::uint64_t parks = 0;   // times the worker went to sleep
+    std::chrono::nanoseconds busy{0};  // time spent running tasks, with latency metrics on
+  };
+
+  // Fraction of the elapsed time the workers spent running tasks, with latency metrics on.
+  double utilization() const {
+    if (workers.size() < 2 || elapsed.count() <= 0) return 0.0;
+    std::chrono::nanoseconds busy{0};
+    for (std::size_t i = 0; i + 1 < workers.size(); ++i) busy += workers[i].busy;
+    return static_cast<double>(busy.count()) /
+           (static_cast<double>(elapsed.count()) * static_cast<double>(workers.size() - 1));
+  }
+
+  // One entry per worker, then one for the tasks run by other threads through
+  // ThreadPool::run_pending_task().
+  std::vector<Worker> workers;
+  Histogram queue_wait;  // submission to start, with latency metrics on
+  Histogram run_time;    // start to end, with latency metrics on
+  std::size_t queued = 0;   // tasks waiting when the snapshot was taken
+  std::size_t pending = 0;  // queued plus running
+  std::uint64_t dropped = 0;  // tasks discarded by OverflowPolicy::DropOldest
+  std::chrono::nanoseconds elapsed{0};
+};
+
+namespace detail {
+
+// Counters of one worker, on cache lines of their own. A worker updates its block with plain
+// loads and stores, the block shared by outside threads with atomic increments; readers may see
+// values a few tasks old.
+struct alignas(64) WorkerMetrics {
+  explicit WorkerMetrics(bool shared_block = false) : shared(shared_block) {}
+
+  void add(std::atomic<std::uint64_t>& counter, std::uint64_t n) {
+    if (shared) {
+      counter.fetch_add(n, std::memory_order_relaxed);
+    } else {
+      counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+  }
+
+  void record(std::array<std::atomic<std::uint64_t>, ThreadPoolStats::Histogram::kBuckets>& h,
+              std::int64_t ns) {
+    const auto value = static_cast<std::uint64_t>(ns > 0 ? ns : 0);
+    const std::size_t bucket = std::min<std::size_t>(std::bit_width(value), h.size() - 1);
+    add(h[bucket], 1);
+  }
+
+  void read(ThreadPoolStats::Worker* worker, ThreadPoolStats::Histogram* wait,
+            ThreadPoolStats::Histogram* run) const {
+    worker->tasks = tasks.load(std::memory_order_relaxed);
+    worker->steals = steals.load(std::memory_order_relaxed);
+    worker->parks = parks.load(std::memory_order_relaxed);
+    worker->busy = std::chrono::nanoseconds(busy_ns.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < ThreadPoolStats::Histogram::kBuckets; ++i) {
+      wait->counts[i] += wait_ns[i].load(std::memory_order_relaxed);
+      run->counts[i] += run_ns[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  const bool shared;
+  std::atomic<std::uint64_t> tasks{0};
+  std::atomic<std::uint64_t> steals{0};
+  std::atomic<std::uint64_t> parks{0};
+  std::atomic<std::uint64_t> busy_ns{0};
+  std::array<std::atomic<std::uint64_t>, ThreadPoolStats::Histogram::kBuckets> wait_ns{};
+  std::array<std::atomic<std::uint64_t>, ThreadPoolStats::Histogram::kBuckets> run_ns{};
+};
+
+}  // namespace detail
+}  // namespace core
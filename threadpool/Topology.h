@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace core {
+
+// CPUs of one NUMA node. id is the kernel's node number.
+struct NumaNode {
+  int id = 0;
+  std::vector<int> cpus;
+};
+
+// Parses a Linux cpulist such as "0-3,8,10-11" into sorted CPU numbers.
+inline std::vector<int> parse_cpu_list(const std::string& list) {
+  std::vector<int> cpus;
+  std::size_t pos = 0;
+  auto number = [&]() {
+    std::size_t end = pos;
+    while (end < list.size() && list[end] >= '0' && list[end] <= '9') ++end;
+    if (end == pos) throw std::invalid_argument("parse_cpu_list: malformed list '" + list + "'");
+    const int value = std::stoi(list.substr(pos, end - pos));
+    pos = end;
+    return value;
+  };
+  while (pos < list.size() && list[pos] != '\n') {
+    const int first = number();
+    int last = first;
+    if (pos < list.size() && list[pos] == '-') {
+      ++pos;
+      last = number();
+    }
+    if (last < first) throw std::invalid_argument("parse_cpu_list: malformed list '" + list + "'");
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    if (pos < list.size() && list[pos] == ',') ++pos;
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+// Reads node<N>/cpulist under a sysfs node directory. Nodes are sorted by id; memory-only nodes
+// have no CPUs. Returns nothing when the directory does not exist.
+inline std::vector<NumaNode> read_numa_topology(const std::string& sysfs_root) {
+  std::vector<NumaNode> nodes;
+  std::error_code ec;
+  for (std::filesystem::directory_iterator it(sysfs_root, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    const std::string name = it->path().filename().string();
+    if (name.size() < 5 || name.compare(0, 4, "node") != 0 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos) {
+      continue;
+    }
+    std::ifstream file(it->path() / "cpulist");
+    std::string list;
+    if (!file || !std::getline(file, list)) continue;
+    NumaNode node;
+    node.id = std::stoi(name.substr(4));
+    node.cpus = parse_cpu_list(list);
+    nodes.push_back(std::move(node));
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+  return nodes;
+}
+
+// The NUMA layout of this machine restricted to the CPUs this process may run on (taskset,
+// cgroups), without nodes left empty. Without sysfs, e.g. on macOS, a single node 0 with CPUs 0
+// to hardware_concurrency-1.
+inline std::vector<NumaNode> probe_numa_topology() {
+  std::vector<NumaNode> nodes = read_numa_topology("/sys/devices/system/node");
+#if defined(__linux__)
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    for (NumaNode& node : nodes) {
+      std::erase_if(node.cpus, [&](int cpu) {
+        return cpu >= CPU_SETSIZE || !CPU_ISSET(static_cast<std::size_t>(cpu), &allowed);
+      });
+    }
+  }
+#endif
+  std::erase_if(nodes, [](const NumaNode& node) { return node.cpus.empty(); });
+  if (nodes.empty()) {
+    NumaNode node;
+    const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned cpu = 0; cpu < count; ++cpu) node.cpus.push_back(static_cast<int>(cpu));
+    nodes.push_back(std::move(node));
+  }
+  return nodes;
+}
+
+}  // namespace core
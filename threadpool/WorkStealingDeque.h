@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace core {
+namespace detail {
+
+// Chase-Lev work-stealing deque ("Dynamic circular work-stealing deque", SPAA 2005), with the
+// memory orderings of Le et al., "Correct and efficient work-stealing for weak memory models"
+// (PPoPP 2013). One owner thread pushes and pops at the bottom (LIFO), any thread steals from the
+// top (FIFO). The buffer grows when full; replaced buffers stay alive until the deque is
+// destroyed because a thief may still be reading them.
+template <typename T>
+class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "WorkStealingDeque holds trivially copyable items");
+
+ public:
+  explicit WorkStealingDeque(std::size_t capacity = 256) {
+    std::size_t size = 1;
+    while (size < capacity) size <<= 1;
+    buffers_.push_back(std::make_unique<Buffer>(size));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  // Owner only.
+  void push(T item) {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t t = top_.load(std::memory_order_acquire);
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<std::int64_t>(buffer->mask)) buffer = grow(buffer, t, b);
+    buffer->put(b, item);
+    // A release store rather than the paper's release fence: same code on x86 and ARMv8, and
+    // visible to ThreadSanitizer
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  // Owner only. Takes the most recently pushed item.
+  bool pop(T* item) {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    *item = buffer->get(b);
+    if (t == b) {
+      // Last item: race the thieves for it
+      const bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. Takes the oldest item; fails when empty or when another thread won the race.
+  bool steal(T* item) {
+    std::int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return false;
+    const T x = buffer_.load(std::memory_order_acquire)->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    *item = x;
+    return true;
+  }
+
+  // Any thread; a snapshot that may be stale by the time it returns.
+  bool empty() const {
+    const std::int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return bottom_.load(std::memory_order_acquire) <= t;
+  }
+
+  std::size_t size() const {
+    const std::int64_t t = top_.load(std::memory_order_acquire);
+    const std::int64_t b = bottom_.load(std::memory_order_acquire);
+    return b > t ? static_cast<std::size_t>(b - t) : 0;
+  }
+
+ private:
+  struct Buffer {
+    explicit Buffer(std::size_t size) : mask(size - 1), items(new std::atomic<T>[size]) {}
+
+    T get(std::int64_t i) const {
+      return items[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+    }
+    void put(std::int64_t i, T item) {
+      items[static_cast<std::size_t>(i) & mask].store(item, std::memory_order_relaxed);
+    }
+
+    std::size_t mask;
+    std::unique_ptr<std::atomic<T>[]> items;
+  };
+
+  Buffer* grow(Buffer* old, std::int64_t t, std::int64_t b) {
+    buffers_.push_back(std::make_unique<Buffer>(2 * (old->mask + 1)));
+    Buffer* buffer = buffers_.back().get();
+    for (std::int64_t i = t; i < b; ++i) buffer->put(i, old->get(i));
+    buffer_.store(buffer, std::memory_order_release);
+    return buffer;
+  }
+
+  // top_ and bottom_ on separate cache lines: thieves hammer the first, the owner the second
+  alignas(64) std::atomic<std::int64_t> top_{0};
+  alignas(64) std::atomic<std::int64_t> bottom_{0};
+  alignas(64) std::atomic<Buffer*> buffer_{nullptr};
+  std::vector<std::unique_ptr<Buffer>> buffers_;  // owner only
+};
+
+}  // namespace detail
+}  // namespace core
@@ -0,0 +1,344 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Timer.h"
+
+namespace core {
+
+struct BenchmarkOptions {
+  // Untimed run before the samples, to warm caches, page in buffers, let the CPU and GPU clocks
+  // ramp up and drivers compile pipelines. It also calibrates the iteration count.
+  std::chrono::nanoseconds warmup = std::chrono::milliseconds(100);
+  std::size_t samples = 30;
+  // A sample runs the benchmark enough times in a row to last about sample_time, so that short
+  // kernels are not drowned in clock overhead; times are reported per iteration.
+  std::chrono::nanoseconds sample_time = std::chrono::milliseconds(10);
+  std::size_t iterations = 0;  // fixed iterations per sample; 0 calibrates from sample_time
+  // Samples whose modified z-score |x - median| / (1.4826 MAD) exceeds this are dropped as
+  // outliers, e.g. a preempted run; 0 keeps every sample.
+  double outlier_threshold = 3.5;
+};
+
+// Summary of per-iteration times in nanoseconds.
+struct BenchmarkStats {
+  std::size_t count = 0;
+  double min = 0.0;
+  double median = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+  double mean = 0.0;
+  double mad = 0.0;  // median absolute deviation from the median
+};
+
+// Quantile q in [0, 1] of sorted values, interpolating linearly between neighbours.
+inline double benchmark_percentile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty()) return 0.0;
+  const double pos = std::clamp(q, 0.0, 1.0) * static_cast<double>(sorted.size() - 1);
+  const auto lo = static_cast<std::size_t>(pos);
+  const std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+}
+
+inline BenchmarkStats benchmark_stats(std::vector<double> values) {
+  BenchmarkStats stats;
+  if (values.empty()) return stats;
+  std::sort(values.begin(), values.end());
+  stats.count = values.size();
+  stats.min = values.front();
+  stats.max = values.back();
+  stats.median = benchmark_percentile(values, 0.5);
+  stats.p90 = benchmark_percentile(values, 0.9);
+  stats.p99 = benchmark_percentile(values, 0.99);
+  double sum = 0.0;
+  for (double v : values) sum += v;
+  stats.mean = sum / static_cast<double>(values.size());
+  std::vector<double> deviations;
+  deviations.reserve(values.size());
+  for (double v : values) deviations.push_back(std::abs(v - stats.median));
+  std::sort(deviations.begin(), deviations.end());
+  stats.mad = benchmark_percentile(deviations, 0.5);
+  return stats;
+}
+
+// Removes the values whose modified z-score exceeds threshold and returns how many. Nothing is
+// removed when threshold is 0 or when more than half of the values are equal (MAD of 0).
+inline std::size_t reject_outliers(std::vector<double>* values, double threshold) {
+  if (threshold <= 0.0 || values->size() < 3) return 0;
+  const BenchmarkStats stats = benchmark_stats(*values);
+  if (stats.mad <= 0.0) return 0;
+  const double limit = threshold * 1.4826 * stats.mad;
+  const std::size_t before = values->size();
+  std::erase_if(*values, [&](double v) { return std::abs(v - stats.median) > limit; });
+  return before - values->size();
+}
+
+struct BenchmarkResult {
+  std::string name;
+  std::size_t iterations = 0;  // per sample
+  std::size_t outliers = 0;    // samples dropped before computing time
+  BenchmarkStats time;         // nanoseconds per iteration
+  std::uint64_t bytes = 0;     // processed per iteration, 0 when not set
+  std::uint64_t items = 0;     // processed per iteration, 0 when not set
+  std::string item_unit;       // e.g. "pixels"
+
+  // Throughput at the median time.
+  double bytes_per_second() const { return per_second(bytes); }
+  double items_per_second() const { return per_second(items); }
+
+ private:
+  double per_second(std::uint64_t n) const {
+    return n != 0 && time.median > 0.0 ? static_cast<double>(n) * 1e9 / time.median : 0.0;
+  }
+};
+
+// Keeps the compiler from discarding a result that the benchmark does not otherwise use.
+template <class T>
+inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// One named measurement. fn runs a single iteration and must finish the work it measures, e.g.
+// wait for the GPU. It may instead return std::chrono::nanoseconds, its own measurement of the
+// iteration such as the span between GPU timestamps, which then replaces the wall time.
+class Benchmark {
+ public:
+  // Batch size bound for very fast functions.
+  static constexpr std::size_t kMaxIterations = std::size_t{1} << 30;
+
+  template <class F>
+  Benchmark(std::string name, F&& fn) : name_(std::move(name)) {
+    if constexpr (std::is_convertible_v<std::invoke_result_t<F&>, std::chrono::nanoseconds>) {
+      timed_fn_ = std::forward<F>(fn);
+    } else {
+      fn_ = std::forward<F>(fn);
+    }
+  }
+
+  // Work per iteration, for the throughput columns.
+  Benchmark& bytes(std::uint64_t per_iteration) {
+    bytes_ = per_iteration;
+    return *this;
+  }
+
+  Benchmark& items(std::uint64_t per_iteration, std::string unit = "items") {
+    items_ = per_iteration;
+    item_unit_ = std::move(unit);
+    return *this;
+  }
+
+  const std::string& name() const { return name_; }
+
+  BenchmarkResult run(const BenchmarkOptions& options = {}) const {
+    const double sample_ns = static_cast<double>(options.sample_time.count());
+    const double warmup_ns = static_cast<double>(options.warmup.count());
+    std::size_t n = options.iterations != 0 ? options.iterations : 1;
+    // Warm-up in batches that double until one lasts a sample; a single batch when warmup is 0
+    double elapsed = 0.0;
+    double per_iteration = 0.0;
+    do {
+      const double t = run_batch(n);
+      elapsed += t;
+      per_iteration = t / static_cast<double>(n);
+      if (options.iterations == 0 && t < sample_ns && n < kMaxIterations) n *= 2;
+    } while (elapsed < warmup_ns);
+    if (options.iterations == 0) {
+      const double wanted = std::ceil(sample_ns / std::max(per_iteration, 1.0));
+      n = static_cast<std::size_t>(std::clamp(wanted, 1.0, static_cast<double>(kMaxIterations)));
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.samples);
+    for (std::size_t i = 0; i < options.samples; ++i) {
+      samples.push_back(run_batch(n) / static_cast<double>(n));
+    }
+
+    BenchmarkResult result;
+    result.name = name_;
+    result.iterations = n;
+    result.outliers = reject_outliers(&samples, options.outlier_threshold);
+    result.time = benchmark_stats(std::move(samples));
+    result.bytes = bytes_;
+    result.items = items_;
+    result.item_unit = item_unit_;
+    return result;
+  }
+
+ private:
+  // Nanoseconds taken by n iterations.
+  double run_batch(std::size_t n) const {
+    if (timed_fn_) {
+      std::chrono::nanoseconds total{0};
+      for (std::size_t i = 0; i < n; ++i) total += timed_fn_();
+      return static_cast<double>(total.count());
+    }
+    Timer timer;
+    timer.start();
+    for (std::size_t i = 0; i < n; ++i) fn_();
+    timer.end();
+    return timer.time() * 1e6;
+  }
+
+  std::string name_;
+  std::function<void()> fn_;
+  std::function<std::chrono::nanoseconds()> timed_fn_;
+  std::uint64_t bytes_ = 0;
+  std::uint64_t items_ = 0;
+  std::string item_unit_;
+};
+
+// One human-readable line: median, spread and throughput.
+inline std::string format_benchmark_result(const BenchmarkResult& r) {
+  char line[512];
+  int len = std::snprintf(line, sizeof(line),
+                          "%-48s median %12.1fns  p90 %12.1fns  min %12.1fns  mad %5.1f%%  "
+                          "x%zu (%zu outliers)",
+                          r.name.c_str(), r.time.median, r.time.p90, r.time.min,
+                          r.time.median > 0.0 ? 100.0 * r.time.mad / r.time.median : 0.0,
+                          r.iterations, r.outliers);
+  std::string text(line, static_cast<std::size_t>(std::max(len, 0)));
+  if (r.bytes != 0) {
+    len = std::snprintf(line, sizeof(line), "  %.2f GB/s", r.bytes_per_second() * 1e-9);
+    text.append(line, static_cast<std::size_t>(std::max(len, 0)));
+  }
+  if (r.items != 0) {
+    len = std::snprintf(line, sizeof(line), "  %.2f M%s/s", r.items_per_second() * 1e-6,
+                        r.item_unit.c_str());
+    text.append(line, static_cast<std::size_t>(std::max(len, 0)));
+  }
+  return text;
+}
+
+// Registry of benchmarks run by name, e.g. by the core-bench tool.
+class BenchmarkSuite {
+ public:
+  template <class F>
+  Benchmark& add(std::string name, F&& fn) {
+    return benchmarks_.emplace_back(std::move(name), std::forward<F>(fn));
+  }
+
+  const std::deque<Benchmark>& benchmarks() const { return benchmarks_; }
+
+  // Runs the benchmarks whose name contains filter, in registration order, printing one line per
+  // result to log when given. A benchmark that throws, e.g. for lack of a GPU, is skipped.
+  std::vector<BenchmarkResult> run(const BenchmarkOptions& options, const std::string& filter = "",
+                                   std::ostream* log = nullptr) const {
+    std::vector<BenchmarkResult> results;
+    for (const Benchmark& benchmark : benchmarks_) {
+      if (benchmark.name().find(filter) == std::string::npos) continue;
+      try {
+        results.push_back(benchmark.run(options));
+      } catch (const std::exception& e) {
+        if (log != nullptr) *log << benchmark.name() << " skipped: " << e.what() << std::endl;
+        continue;
+      }
+      if (log != nullptr) *log << format_benchmark_result(results.back()) << std::endl;
+    }
+    return results;
+  }
+
+ private:
+  std::deque<Benchmark> benchmarks_;  // stable references for add()
+};
+
+namespace detail {
+
+inline std::string benchmark_number(double v) {
+  char text[32];
+  const int len = std::snprintf(text, sizeof(text), "%.9g", std::isfinite(v) ? v : 0.0);
+  return std::string(text, static_cast<std::size_t>(std::max(len, 0)));
+}
+
+inline std::string benchmark_json_string(const std::string& s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+      out += escaped;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+inline std::string benchmark_csv_field(const std::string& s) {
+  if (s.find_first_of(",\"\n") == std::string::npos) return s;
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"') out += '"';
+    out += c;
+  }
+  return out + "\"";
+}
+
+}  // namespace detail
+
+// Writes results as {"context": {...}, "benchmarks": [...]}, times in nanoseconds, for CI to
+// compare runs. context records the machine and build, e.g. {"simd": "AVX2"}.
+inline void write_benchmark_json(std::ostream& out, const std::vector<BenchmarkResult>& results,
+                                 const std::map<std::string, std::string>& context = {}) {
+  using detail::benchmark_json_string;
+  using detail::benchmark_number;
+  out << "{\n  \"context\": {";
+  const char* separator = "\n";
+  for (const auto& [key, value] : context) {
+    out << separator << "    " << benchmark_json_string(key) << ": "
+        << benchmark_json_string(value);
+    separator = ",\n";
+  }
+  out << (context.empty() ? "},\n" : "\n  },\n") << "  \"benchmarks\": [";
+  separator = "\n";
+  for (const BenchmarkResult& r : results) {
+    out << separator << "    {\"name\": " << benchmark_json_string(r.name)
+        << ", \"iterations\": " << r.iterations << ", \"samples\": " << r.time.count
+        << ", \"outliers\": " << r.outliers << ", \"min_ns\": " << benchmark_number(r.time.min)
+        << ", \"median_ns\": " << benchmark_number(r.time.median)
+        << ", \"p90_ns\": " << benchmark_number(r.time.p90)
+        << ", \"p99_ns\": " << benchmark_number(r.time.p99)
+        << ", \"max_ns\": " << benchmark_number(r.time.max)
+        << ", \"mean_ns\": " << benchmark_number(r.time.mean)
+        << ", \"mad_ns\": " << benchmark_number(r.time.mad)
+        << ", \"bytes_per_second\": " << benchmark_number(r.bytes_per_second())
+        << ", \"items_per_second\": " << benchmark_number(r.items_per_second())
+        << ", \"item_unit\": " << benchmark_json_string(r.item_unit) << "}";
+    separator = ",\n";
+  }
+  out << (results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+// Writes results as CSV with a header row, times in nanoseconds.
+inline void write_benchmark_csv(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+  using detail::benchmark_number;
+  out << "name,iterations,samples,outliers,min_ns,median_ns,p90_ns,p99_ns,max_ns,mean_ns,mad_ns,"
+         "bytes_per_second,items_per_second,item_unit\n";
+  for (const BenchmarkResult& r : results) {
+    out << detail::benchmark_csv_field(r.name) << ',' << r.iterations << ',' << r.time.count << ','
+        << r.outliers << ',' << benchmark_number(r.time.min) << ','
+        << benchmark_number(r.time.median) << ',' << benchmark_number(r.time.p90) << ','
+        << benchmark_number(r.time.p99) << ',' << benchmark_number(r.time.max) << ','
+        << benchmark_number(r.time.mean) << ',' << benchmark_number(r.time.mad) << ','
+        << benchmark_number(r.bytes_per_second()) << ','
+        << benchmark_number(r.items_per_second()) << ','
+        << detail::benchmark_csv_field(r.item_unit) << '\n';
+  }
+}
+
+}  // namespace core
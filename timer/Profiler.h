@@ -0,0 +1,423 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Scoped zones for code where a Perfetto session is too heavy:
+//
+//   void Update() {
+//     CORE_PROFILE_SCOPE("update");
+//     ...
+//   }
+//   ...
+//   const core::ProfileNode& frame = CORE_PROFILE_FRAME();
+//
+// Zones go to per-thread rings without locks. Profiler::frame() drains the rings into a call tree
+// with inclusive and exclusive times, per thread. Without CORE_ENABLE_PROFILER (cmake
+// -DENABLE_PROFILER=1, set on targets that link timer) the zones compile to nothing and
+// CORE_PROFILE_FRAME() returns an empty frame.
+#ifdef CORE_ENABLE_PROFILER
+#define CORE_PROFILE_CONCAT_(a, b) a##b
+#define CORE_PROFILE_CONCAT(a, b) CORE_PROFILE_CONCAT_(a, b)
+#define CORE_PROFILE_SCOPE(name) \
+  ::core::ProfileZone CORE_PROFILE_CONCAT(core_profile_zone_, __LINE__)(name)
+#define CORE_PROFILE_FRAME() ::core::Profiler::instance().frame()
+#define CORE_PROFILE_THREAD_NAME(name) ::core::Profiler::instance().set_thread_name(name)
+#else
+#define CORE_PROFILE_SCOPE(name)
+#define CORE_PROFILE_FRAME() ::core::detail::empty_profile_frame()
+#define CORE_PROFILE_THREAD_NAME(name)
+#endif
+
+namespace core {
+
+// A zone in the call tree: its calls and time, summed over every path that reached it.
+struct ProfileNode {
+  std::string name;
+  std::uint64_t calls = 0;
+  std::chrono::nanoseconds inclusive{0};
+  std::vector<ProfileNode> children;
+
+  // Time spent in the zone itself, outside of its children.
+  std::chrono::nanoseconds exclusive() const {
+    std::chrono::nanoseconds time = inclusive;
+    for (const ProfileNode& child : children) time -= child.inclusive;
+    return std::max(time, std::chrono::nanoseconds(0));
+  }
+
+  // Child named name, or nullptr.
+  const ProfileNode* child(std::string_view child_name) const {
+    for (const ProfileNode& node : children) {
+      if (node.name == child_name) return &node;
+    }
+    return nullptr;
+  }
+
+  ProfileNode& add_child(std::string_view child_name) {
+    for (ProfileNode& node : children) {
+      if (node.name == child_name) return node;
+    }
+    ProfileNode& node = children.emplace_back();
+    node.name = child_name;
+    return node;
+  }
+
+  // Adds the calls and times of other, a tree of the same root, to this one.
+  void merge(const ProfileNode& other) {
+    calls += other.calls;
+    inclusive += other.inclusive;
+    for (const ProfileNode& node : other.children) add_child(node.name).merge(node);
+  }
+};
+
+namespace detail {
+
+#if defined(__x86_64__) || defined(__i386__)
+// The TSC is a few cycles to read against tens of ns for steady_clock; Profiler converts it to
+// ns against steady_clock, which assumes an invariant TSC as on every x86 CPU of the last decade.
+inline std::uint64_t profiler_ticks() { return __rdtsc(); }
+inline constexpr bool kProfilerTicksAreNs = false;
+#else
+inline std::uint64_t profiler_ticks() {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+}
+inline constexpr bool kProfilerTicksAreNs = true;
+#endif
+
+// What CORE_PROFILE_FRAME() returns when the profiler is compiled out.
+inline const ProfileNode& empty_profile_frame() {
+  static const ProfileNode frame = [] {
+    ProfileNode node;
+    node.name = "frame";
+    return node;
+  }();
+  return frame;
+}
+
+// A closed zone. The name must outlive the profiler, string literals do.
+struct ProfileEvent {
+  const char* name;
+  std::uint64_t begin;
+  std::uint64_t end;
+  std::uint32_t depth;
+};
+
+// Ring of closed zones of one thread: the thread pushes, Profiler::frame() pops. When the ring is
+// full the zone is counted as dropped rather than blocking the thread.
+class ProfileRing {
+ public:
+  explicit ProfileRing(std::size_t capacity) : mask_(capacity - 1), events_(capacity) {}
+
+  void push(const ProfileEvent& event) {
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) > mask_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    events_[head & mask_] = event;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  // Appends the pushed events to out, oldest first.
+  void pop_all(std::vector<ProfileEvent>* out) {
+    const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    for (std::uint64_t i = tail; i != head; ++i) out->push_back(events_[i & mask_]);
+    tail_.store(head, std::memory_order_release);
+  }
+
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  const std::uint64_t mask_;
+  std::vector<ProfileEvent> events_;
+  alignas(64) std::atomic<std::uint64_t> head_{0};  // written by the owning thread
+  alignas(64) std::atomic<std::uint64_t> tail_{0};  // written by the collector
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+// Per-thread state of one profiler.
+struct ProfileThread {
+  ProfileThread(std::size_t capacity, std::string thread_name)
+      : ring(capacity), name(std::move(thread_name)) {}
+
+  ProfileRing ring;
+  std::uint32_t depth = 0;  // open zones, owning thread only
+  std::atomic<bool> exited{false};
+
+  // Collector only, under Profiler::mutex_
+  std::string name;
+  std::vector<ProfileEvent> pending;  // zones whose enclosing root zone is still open
+};
+
+}  // namespace detail
+
+class Profiler {
+ public:
+  static constexpr std::size_t kDefaultRingCapacity = 1 << 14;
+
+  // ring_capacity, a power of two, bounds the zones a thread can close between two frames.
+  explicit Profiler(std::size_t ring_capacity = kDefaultRingCapacity)
+      : capacity_(ring_capacity),
+        id_(next_id().fetch_add(1, std::memory_order_relaxed)),
+        tick0_(detail::profiler_ticks()),
+        time0_(std::chrono::steady_clock::now()),
+        frame_tick_(tick0_) {
+    if (ring_capacity == 0 || (ring_capacity & (ring_capacity - 1)) != 0) {
+      throw std::invalid_argument("Profiler: ring capacity must be a power of two");
+    }
+    root_.name = frame_.name = "frame";
+  }
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // The profiler used by the CORE_PROFILE_* macros.
+  static Profiler& instance() {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  // Names the calling thread in the reports; threads default to "thread <n>".
+  void set_thread_name(std::string name) {
+    detail::ProfileThread* thread = this_thread();
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread->name = std::move(name);
+  }
+
+  // Drains the zones closed since the last call into a tree of frame -> thread -> zones, adds it
+  // to total() and returns it. The frame's time is the time since the last call. Zones still
+  // open, and those nested in them, go to the next frame.
+  const ProfileNode& frame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double ns_per_tick = this->ns_per_tick();
+    const std::uint64_t tick = detail::profiler_ticks();
+    frame_.children.clear();
+    frame_.calls = 1;
+    frame_.inclusive = to_ns(tick - frame_tick_, ns_per_tick);
+    frame_tick_ = tick;
+    for (auto it = threads_.begin(); it != threads_.end();) {
+      detail::ProfileThread& thread = **it;
+      const bool exited = thread.exited.load(std::memory_order_acquire);
+      thread.ring.pop_all(&thread.pending);
+      collect(&thread, ns_per_tick);
+      trim(&thread);
+      if (exited) {
+        dropped_ += thread.ring.dropped() + thread.pending.size();
+        it = threads_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    root_.merge(frame_);
+    return frame_;
+  }
+
+  // The tree returned by the last frame().
+  const ProfileNode& last_frame() const { return frame_; }
+
+  // Every frame since construction or reset(); root().calls is the number of frames.
+  const ProfileNode& total() const { return root_; }
+
+  // Zones lost to full rings.
+  std::uint64_t dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::uint64_t dropped = dropped_;
+    for (const auto& thread : threads_) dropped += thread->ring.dropped();
+    return dropped;
+  }
+
+  // Discards the zones recorded so far and the totals.
+  void reset() {
+    frame();
+    std::lock_guard<std::mutex> lock(mutex_);
+    root_ = ProfileNode();
+    frame_ = ProfileNode();
+    root_.name = frame_.name = "frame";
+  }
+
+ private:
+  friend class ProfileZone;
+
+  static std::atomic<std::uint64_t>& next_id() {
+    static std::atomic<std::uint64_t> id{0};
+    return id;
+  }
+
+  // Threads own a reference to their state in each profiler they used, and mark it exited when
+  // they end so that frame() can release it after draining it.
+  struct ThreadStates {
+    ~ThreadStates() {
+      for (auto& state : states) state.second->exited.store(true, std::memory_order_release);
+    }
+
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<detail::ProfileThread>>> states;
+  };
+
+  detail::ProfileThread* this_thread() {
+    thread_local ThreadStates local;
+    if (!local.states.empty() && local.states.back().first == id_) {
+      return local.states.back().second.get();
+    }
+    for (auto& state : local.states) {
+      if (state.first == id_) {
+        std::swap(state, local.states.back());
+        return local.states.back().second.get();
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto thread = std::make_shared<detail::ProfileThread>(
+        capacity_, "thread " + std::to_string(thread_count_++));
+    threads_.push_back(thread);
+    local.states.emplace_back(id_, std::move(thread));
+    return local.states.back().second.get();
+  }
+
+  double ns_per_tick() const {
+    if constexpr (detail::kProfilerTicksAreNs) return 1.0;
+    const std::uint64_t ticks = detail::profiler_ticks() - tick0_;
+    const auto time = std::chrono::steady_clock::now() - time0_;
+    if (ticks == 0) return 1.0;
+    return static_cast<double>(std::chrono::nanoseconds(time).count()) /
+           static_cast<double>(ticks);
+  }
+
+  static std::chrono::nanoseconds to_ns(std::uint64_t ticks, double ns_per_tick) {
+    return std::chrono::nanoseconds(
+        static_cast<std::int64_t>(static_cast<double>(ticks) * ns_per_tick));
+  }
+
+  // Adds the complete root zones among the pending events to the frame. Events arrive in the
+  // order the zones closed, children before their parent, so walking them backwards visits every
+  // zone before its children.
+  void collect(detail::ProfileThread* thread, double ns_per_tick) {
+    std::vector<detail::ProfileEvent>& events = thread->pending;
+    std::size_t complete = events.size();
+    while (complete > 0 && events[complete - 1].depth != 0) --complete;
+    if (complete == 0) return;
+
+    ProfileNode& thread_node = frame_.add_child(thread->name);
+    thread_node.calls = 1;
+    std::vector<ProfileNode*> stack;  // stack[d]: the open zone at depth d
+    for (std::size_t i = complete; i-- > 0;) {
+      const detail::ProfileEvent& event = events[i];
+      const std::chrono::nanoseconds time = to_ns(event.end - event.begin, ns_per_tick);
+      // A parent lost to a full ring leaves its children under the closest ancestor
+      stack.resize(std::min<std::size_t>(event.depth, stack.size()));
+      ProfileNode& parent = stack.empty() ? thread_node : *stack.back();
+      ProfileNode& node = parent.add_child(event.name);
+      node.calls += 1;
+      node.inclusive += time;
+      if (event.depth == 0) thread_node.inclusive += time;
+      stack.push_back(&node);
+    }
+    events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(complete));
+  }
+
+  // Zones nested in a root zone that stays open across many frames, say a thread's main loop,
+  // would pile up: past a ring's worth they are dropped.
+  void trim(detail::ProfileThread* thread) {
+    if (thread->pending.size() <= capacity_) return;
+    dropped_ += thread->pending.size();
+    thread->pending.clear();
+  }
+
+  const std::size_t capacity_;
+  const std::uint64_t id_;
+  const std::uint64_t tick0_;
+  const std::chrono::steady_clock::time_point time0_;
+  std::uint64_t frame_tick_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<detail::ProfileThread>> threads_;
+  std::size_t thread_count_ = 0;
+  std::uint64_t dropped_ = 0;  // of threads already released
+  ProfileNode frame_;
+  ProfileNode root_;
+};
+
+// Records the time from construction to destruction as a zone named name, nested in the zones
+// open on the same thread. Use through CORE_PROFILE_SCOPE.
+class ProfileZone {
+ public:
+  explicit ProfileZone(const char* name, Profiler& profiler = Profiler::instance())
+      : thread_(profiler.this_thread()), name_(name), depth_(thread_->depth++) {
+    begin_ = detail::profiler_ticks();
+  }
+
+  ~ProfileZone() {
+    const std::uint64_t end = detail::profiler_ticks();
+    thread_->depth = depth_;
+    thread_->ring.push({name_, begin_, end, depth_});
+  }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+ private:
+  detail::ProfileThread* thread_;
+  const char* name_;
+  std::uint32_t depth_;
+  std::uint64_t begin_ = 0;
+};
+
+namespace detail {
+
+inline void write_profile_folded(std::ostream& out, const ProfileNode& node,
+                                 const std::string& stack) {
+  const std::string path = stack.empty() ? node.name : stack + ";" + node.name;
+  const std::chrono::nanoseconds self = node.exclusive();
+  if (self.count() > 0) out << path << ' ' << self.count() << '\n';
+  for (const ProfileNode& child : node.children) write_profile_folded(out, child, path);
+}
+
+inline void format_profile(std::string* out, const ProfileNode& node, int indent, double frames) {
+  char line[160];
+  const int name_width = std::max(1, 48 - indent);
+  std::snprintf(line, sizeof(line), "%*s%-*.*s %12.3f %12.3f %10.1f\n", indent, "", name_width,
+                name_width, node.name.c_str(),
+                std::chrono::duration<double, std::milli>(node.inclusive).count() / frames,
+                std::chrono::duration<double, std::milli>(node.exclusive()).count() / frames,
+                static_cast<double>(node.calls) / frames);
+  *out += line;
+  for (const ProfileNode& child : node.children) format_profile(out, child, indent + 2, frames);
+}
+
+}  // namespace detail
+
+// Writes one "thread;zone;child <exclusive ns>" line per zone, the folded stack format read by
+// flamegraph.pl, speedscope and similar tools. The frame root itself is left out.
+inline void write_profile_folded(std::ostream& out, const ProfileNode& frame) {
+  for (const ProfileNode& thread : frame.children) detail::write_profile_folded(out, thread, "");
+}
+
+// Indented call tree with inclusive and exclusive ms and calls, averaged over frame.calls frames:
+// pass Profiler::total() for averages per frame, or a single frame.
+inline std::string format_profile(const ProfileNode& frame) {
+  const double frames = static_cast<double>(std::max<std::uint64_t>(frame.calls, 1));
+  char header[160];
+  std::snprintf(header, sizeof(header), "%-48s %12s %12s %10s\n", "zone (per frame)", "incl ms",
+                "excl ms", "calls");
+  std::string out = header;
+  for (const ProfileNode& thread : frame.children) detail::format_profile(&out, thread, 0, frames);
+  return out;
+}
+
+}  // namespace core
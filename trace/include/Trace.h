@@ -1,23 +1,55 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include "TraceCategory.h"
 
 namespace core {
 namespace trace {
 
+// What the trace buffer does once full: overwrite the oldest events, keeping the most recent
+// ones, or drop new events, keeping the start of the capture.
+enum class TraceFillPolicy { RingBuffer, Discard };
+
+struct TraceOptions {
+  // Write into the trace file while tracing rather than from memory in StopTracing(). The buffer
+  // then only holds the events of one file_write_period_ms, so captures can run for hours.
+  bool streaming = false;
+  uint32_t buffer_size_kb = 1024;
+  TraceFillPolicy fill_policy = TraceFillPolicy::RingBuffer;
+  // Streaming: how often the buffer is drained into the file; Perfetto's minimum is 100 ms.
+  uint32_t file_write_period_ms = 2500;
+  // Streaming: tracing stops once the file reaches this size, 0 for no limit.
+  uint64_t max_file_size_bytes = 0;
+  // How often the threads' pending events are committed to the buffer, 0 to commit them only when
+  // their chunks fill up and in StopTracing(). Without it a quiet thread's last events reach a
+  // streamed file late, or not at all if the process dies.
+  uint32_t flush_period_ms = 0;
+};
+
 class Trace {
  public:
-  Trace(const std::string& trace_file);
+  Trace(const std::string& trace_file, const TraceOptions& options = {});
+  // Stops a session still running, e.g. after an exception; the file is then left incomplete.
+  ~Trace();
 
   void InitializeTracing();
+  // Throws std::runtime_error when already tracing; a stopped trace can be started again.
   void StartTracing();
+  // Commits the events recorded so far to the buffer, and to the file when streaming. Does
+  // nothing when not tracing.
+  void Flush();
   void StopTracing();
   void SetTraceProcess(const std::string& process_name);
 
  private:
-  std::unique_ptr<perfetto::TracingSession> tracing_session_;
+  std::unique_ptr<perfetto::TracingSession> tracing_session_;  // set while tracing
   std::string trace_file_;
+  TraceOptions options_;
+  int trace_fd_ = -1;  // streaming output, open while tracing
 };
 
 }  // namespace trace
-}  // namespace core
\ No newline at end of file
+}  // namespace core
@@ -4,6 +4,9 @@
 
 PERFETTO_DEFINE_CATEGORIES(
     perfetto::Category("rendering").SetDescription("Rendering and graphics events"),
+    perfetto::Category("threadpool").SetDescription("ThreadPool tasks, parking and queue depth"),
+    perfetto::Category("gpu").SetDescription(
+        "Vulkan and OpenCL submissions, waits, copies, GPU execution and device memory"),
     perfetto::Category("network.debug").SetTags("debug").SetDescription("Verbose network events"),
     perfetto::Category("audio.latency")
         .SetTags("verbose")
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "TraceCategory.h"
+
+namespace core {
+namespace trace {
+
+// Track for work executed on a device, listed under the process next to its threads. id tells
+// devices or queues apart; the name is set on first use.
+inline perfetto::Track GpuTrack(const void* id, const std::string& name) {
+  const perfetto::Track track(reinterpret_cast<uint64_t>(id));
+  static std::mutex mutex;
+  static std::unordered_set<uint64_t> named;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (named.insert(track.uuid).second) {
+    perfetto::protos::gen::TrackDescriptor desc = track.Serialize();
+    desc.set_name(name);
+    perfetto::TrackEvent::SetTrackDescriptor(track, desc);
+  }
+  return track;
+}
+
+// Maps steady_clock time points, as measured for GPU work after the fact, to the trace clock for
+// events with explicit timestamps. Both clocks are read back to back once, so intervals converted
+// by one TraceClock keep their order.
+class TraceClock {
+ public:
+  TraceClock()
+      : steady_(std::chrono::steady_clock::now()),
+        trace_(perfetto::TrackEvent::GetTraceTimeNs()) {}
+
+  uint64_t ToTraceTime(const std::chrono::steady_clock::time_point time) const {
+    const auto offset = std::chrono::duration_cast<std::chrono::nanoseconds>(time - steady_);
+    return trace_ + static_cast<uint64_t>(offset.count());
+  }
+
+ private:
+  std::chrono::steady_clock::time_point steady_;
+  uint64_t trace_;
+};
+
+}  // namespace trace
+}  // namespace core
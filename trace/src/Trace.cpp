@@ -1,11 +1,27 @@
 #include "Trace.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace core {
 namespace trace {
 
-Trace::Trace(const std::string& trace_file) : trace_file_(trace_file) {}
+Trace::Trace(const std::string& trace_file, const TraceOptions& options)
+    : trace_file_(trace_file), options_(options) {
+  if (options_.buffer_size_kb == 0) {
+    throw std::invalid_argument("Trace buffer size must be positive");
+  }
+}
+
+Trace::~Trace() {
+  if (tracing_session_ != nullptr) tracing_session_->StopBlocking();
+  if (trace_fd_ >= 0) close(trace_fd_);
+}
 
 void Trace::InitializeTracing() {
   perfetto::TracingInitArgs args;
@@ -15,20 +31,54 @@ void Trace::InitializeTracing() {
 }
 
 void Trace::StartTracing() {
+  if (tracing_session_ != nullptr) {
+    throw std::runtime_error("Tracing into " + trace_file_ + " already started");
+  }
   perfetto::TraceConfig cfg;
-  cfg.add_buffers()->set_size_kb(1024);
+  auto* buffer = cfg.add_buffers();
+  buffer->set_size_kb(options_.buffer_size_kb);
+  buffer->set_fill_policy(options_.fill_policy == TraceFillPolicy::RingBuffer
+                              ? perfetto::TraceConfig::BufferConfig::RING_BUFFER
+                              : perfetto::TraceConfig::BufferConfig::DISCARD);
+  if (options_.flush_period_ms > 0) cfg.set_flush_period_ms(options_.flush_period_ms);
+  if (options_.streaming) {
+    cfg.set_write_into_file(true);
+    cfg.set_file_write_period_ms(options_.file_write_period_ms);
+    if (options_.max_file_size_bytes > 0) {
+      cfg.set_max_file_size_bytes(options_.max_file_size_bytes);
+    }
+  }
+
   auto* ds_cfg = cfg.add_data_sources()->mutable_config();
   ds_cfg->set_name("track_event");
   perfetto::protos::gen::TrackEventConfig te_cfg;
   te_cfg.add_disabled_categories("*");
   te_cfg.add_enabled_categories("rendering");
+  te_cfg.add_enabled_categories("threadpool");
+  te_cfg.add_enabled_categories("gpu");
   ds_cfg->set_track_event_config_raw(te_cfg.SerializeAsString());
 
+  if (options_.streaming) {
+    trace_fd_ = open(trace_file_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (trace_fd_ < 0) {
+      throw std::runtime_error("Failed to open trace file " + trace_file_);
+    }
+  }
   tracing_session_ = perfetto::Tracing::NewTrace();
-  tracing_session_->Setup(cfg);
+  if (options_.streaming) {
+    tracing_session_->Setup(cfg, trace_fd_);
+  } else {
+    tracing_session_->Setup(cfg);
+  }
   tracing_session_->StartBlocking();
 }
 
+void Trace::Flush() {
+  if (tracing_session_ == nullptr) return;
+  perfetto::TrackEvent::Flush();
+  tracing_session_->FlushBlocking();
+}
+
 void Trace::SetTraceProcess(const std::string& process_name) {
   perfetto::ProcessTrack process_track = perfetto::ProcessTrack::Current();
   perfetto::protos::gen::TrackDescriptor desc = process_track.Serialize();
@@ -37,22 +87,31 @@ void Trace::SetTraceProcess(const std::string& process_name) {
 }
 
 void Trace::StopTracing() {
+  if (tracing_session_ == nullptr) {
+    throw std::runtime_error("Tracing into " + trace_file_ + " not started");
+  }
   // Make sure the last event is closed for this example.
   perfetto::TrackEvent::Flush();
 
-  // Stop tracing and read the trace data.
   tracing_session_->StopBlocking();
-  std::vector<char> trace_data(tracing_session_->ReadTraceBlocking());
+  // Released on return, so that the session can be started again
+  std::unique_ptr<perfetto::TracingSession> session = std::move(tracing_session_);
+  if (trace_fd_ >= 0) {
+    // Streaming: the service has written the rest of the buffer into the file on stop
+    close(trace_fd_);
+    trace_fd_ = -1;
+    PERFETTO_LOG("Trace streamed into %s file.", trace_file_.c_str());
+    return;
+  }
 
-  // Write the result into a file.
-  // Note: To save memory with longer traces, you can tell Perfetto to write
-  // directly into a file by passing a file descriptor into Setup() above.
+  // Read the trace data and write the result into a file.
+  std::vector<char> trace_data(session->ReadTraceBlocking());
   std::ofstream output;
   output.open(trace_file_.c_str(), std::ios::out | std::ios::binary);
-  output.write(&trace_data[0], std::streamsize(trace_data.size()));
+  output.write(trace_data.data(), std::streamsize(trace_data.size()));
   output.close();
   PERFETTO_LOG("Trace written in %s file.", trace_file_.c_str());
 }
 
 }  // namespace trace
-}  // namespace core
\ No newline at end of file
+}  // namespace core
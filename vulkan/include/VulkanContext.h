@@ -59,6 +59,10 @@ class VulkanContext {
   VkDevice logical_device;
   VkPhysicalDevice physical_device;
   float timestamp_period;
+  // Meaningful low bits of the queue's timestamps; the values wrap past them
+  uint32_t timestamp_valid_bits = 64;
+  // VK_EXT_calibrated_timestamps is enabled, see VulkanProfiler
+  bool calibrated_timestamps = false;
 
  private:
   bool enable_validation_layers_;
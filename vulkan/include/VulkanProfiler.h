@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Profiler.h"
+#include "VulkanContext.h"
+#include "VulkanQueryPool.h"
+
+namespace core {
+namespace vulkan {
+
+// A GPU scope of a harvested frame. Times are on the host's steady_clock, the clock of Timer and
+// of the CPU profiler, so GPU work lines up with the CPU zones that submitted it.
+struct VulkanProfilerScope {
+  const char* name;
+  uint32_t depth;
+  std::chrono::steady_clock::time_point begin;
+  std::chrono::steady_clock::time_point end;
+
+  std::chrono::nanoseconds duration() const { return end - begin; }
+};
+
+struct VulkanProfilerFrame {
+  uint64_t index = 0;                       // BeginFrame() calls before this frame
+  std::vector<VulkanProfilerScope> scopes;  // in recording order
+  ProfileNode tree;                         // the scopes nested under a node named "gpu"
+};
+
+// Named GPU scopes from timestamp queries:
+//
+//   profiler.BeginFrame(command);
+//   {
+//     VulkanProfileScope scope(profiler, command, "blur");
+//     blur.Run(command);
+//   }
+//   profiler.EndFrame();
+//   ... submit command ...
+//   for (const VulkanProfilerFrame& frame : profiler.Collect()) ...
+//
+// Each of frames_in_flight frames records into query pools of its own, so results are read a few
+// frames later without VK_QUERY_RESULT_WAIT_BIT; frames_in_flight must be at least the number of
+// frames the application keeps in flight. A frame whose results are still pending when its slot
+// comes round again is dropped and counted. Query pools grow by kQueriesPerPool; a pool added in
+// a frame is reset where the scope begins, so the first frame to outgrow the pools must begin
+// that scope outside of a render pass, later frames reset it in BeginFrame().
+//
+// Device ticks are mapped to host time with VK_EXT_calibrated_timestamps when the device and the
+// host clock allow it, recalibrating on every Collect(). Otherwise Calibrate() times a timestamp
+// submission from the host, within half the submission's round trip.
+class VulkanProfiler {
+ public:
+  static constexpr uint32_t kQueriesPerPool = 256;
+
+  explicit VulkanProfiler(VulkanContext* context, const uint32_t frames_in_flight = 3);
+
+  // Starts the next frame on a command buffer in the recording state, outside of a render pass.
+  void BeginFrame(const VkCommandBuffer command);
+  // Returns the scope to pass to EndScope().
+  uint32_t BeginScope(const VkCommandBuffer command, const char* name,
+                      VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+  void EndScope(const VkCommandBuffer command, const uint32_t scope,
+                VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+  void EndFrame();
+
+  // Frames whose results are available, oldest first; never waits for the device.
+  std::vector<VulkanProfilerFrame> Collect();
+
+  void Calibrate();
+  std::chrono::steady_clock::time_point ToHostTime(const uint64_t timestamp) const;
+
+  // Whether VK_EXT_calibrated_timestamps is used.
+  bool calibrated_timestamps() const { return get_calibrated_timestamps_ != nullptr; }
+  uint64_t dropped_frames() const { return dropped_frames_; }
+
+ private:
+  struct Scope {
+    const char* name;
+    uint32_t depth;
+    uint32_t begin_query;
+    uint32_t end_query;
+  };
+
+  struct Frame {
+    std::vector<std::unique_ptr<VulkanQueryPool>> pools;
+    std::vector<Scope> scopes;
+    uint32_t queries = 0;  // written this frame
+    uint64_t index = 0;
+    bool pending = false;  // ended and not yet harvested
+  };
+
+  uint32_t WriteTimestamp(const VkCommandBuffer command, VkPipelineStageFlagBits stage);
+  bool Harvest(Frame& frame, std::vector<VulkanProfilerFrame>* frames);
+  void LoadCalibratedTimestamps();
+  void CalibrateWithSubmission();
+
+  VulkanContext* context_ = nullptr;
+  std::vector<Frame> frames_;
+  Frame* recording_ = nullptr;
+  uint64_t frame_count_ = 0;
+  uint32_t open_scopes_ = 0;
+  uint64_t dropped_frames_ = 0;
+  std::vector<VulkanProfilerFrame> harvested_;  // by BeginFrame(), for the next Collect()
+
+  PFN_vkGetCalibratedTimestampsEXT get_calibrated_timestamps_ = nullptr;
+  uint64_t calibration_timestamp_ = 0;
+  std::chrono::steady_clock::time_point calibration_time_;
+};
+
+// Scope from construction to destruction, see VulkanProfiler.
+class VulkanProfileScope {
+ public:
+  VulkanProfileScope(VulkanProfiler& profiler, const VkCommandBuffer command, const char* name)
+      : profiler_(profiler), command_(command), scope_(profiler.BeginScope(command, name)) {}
+  ~VulkanProfileScope() { profiler_.EndScope(command_, scope_); }
+
+  VulkanProfileScope(const VulkanProfileScope&) = delete;
+  VulkanProfileScope& operator=(const VulkanProfileScope&) = delete;
+
+ private:
+  VulkanProfiler& profiler_;
+  VkCommandBuffer command_;
+  uint32_t scope_;
+};
+
+}  // namespace vulkan
+}  // namespace core
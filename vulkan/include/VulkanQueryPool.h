@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 #include "VulkanContext.h"
 
 namespace core {
@@ -7,15 +9,27 @@ namespace vulkan {
 
 class VulkanQueryPool {
  public:
-  VulkanQueryPool(VulkanContext* context, const VkQueryType query_type);
+  VulkanQueryPool(VulkanContext* context, const VkQueryType query_type,
+                  const uint32_t query_count = 2);
   ~VulkanQueryPool();
 
   void Reset(const VkCommandBuffer command);
+  void Reset(const VkCommandBuffer command, uint32_t first, uint32_t count);
   void Query(const VkCommandBuffer command, uint32_t query,
              VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
-  void GetQueryResults();
+
+  // Reads the results without waiting for the device: call once the fence of the submission is
+  // signaled, or poll. Returns false, leaving the results not yet available unchanged, while any
+  // query is pending.
+  bool GetQueryResults();
+  bool GetQueryResults(uint32_t first, uint32_t count);
 
   std::vector<uint64_t> GetTimeStamps() const { return timestamps_; }
+  const std::vector<uint64_t>& timestamps() const { return timestamps_; }
+  uint32_t QueryCount() const { return static_cast<uint32_t>(timestamps_.size()); }
+
+  // Device time between the timestamps of two queries, after GetQueryResults().
+  std::chrono::nanoseconds GetElapsed(uint32_t begin, uint32_t end) const;
 
  private:
   VulkanContext* context_ = nullptr;
@@ -24,5 +38,14 @@ class VulkanQueryPool {
 
   std::vector<uint64_t> timestamps_;
 };
+
+// Device ticks from begin to end, modulo the queue's timestampValidBits.
+inline uint64_t TimestampTicks(const VulkanContext& context, uint64_t begin, uint64_t end) {
+  const uint64_t mask = context.timestamp_valid_bits >= 64
+                            ? ~uint64_t{0}
+                            : (uint64_t{1} << context.timestamp_valid_bits) - 1;
+  return (end - begin) & mask;
+}
+
 }  // namespace vulkan
-}  // namespace core
\ No newline at end of file
+}  // namespace core
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "CompletionPoller.h"
 #include "VulkanContext.h"
 
 namespace core {
@@ -12,6 +13,12 @@ class VulkanFence {
 
   void Reset();
 
+  // Blocks in vkWaitForFences; returns false on timeout.
+  bool Wait(const uint64_t timeout = UINT64_MAX) const;
+
+  // Non-blocking vkGetFenceStatus; throws on errors such as a lost device.
+  bool IsSignaled() const;
+
   VkFence fence = VK_NULL_HANDLE;
 
  private:
@@ -29,5 +36,11 @@ class VulkanSemaphore {
   VulkanContext* context_ = nullptr;
 };
 
+// Awaitable resuming the coroutine on the poller's pool once the fence is signaled, without a
+// thread blocked in vkWaitForFences: co_await WaitAsync(poller, fence);
+inline auto WaitAsync(CompletionPoller& poller, const VulkanFence& fence) {
+  return poller.wait([&fence] { return fence.IsSignaled(); });
+}
+
 }  // namespace vulkan
 }  // namespace core
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// Perfetto events of the Vulkan backend in the "gpu" category, compiled out without
+// CORE_ENABLE_TRACE. Device memory and submissions still pending on a fence are counter tracks.
+#ifdef CORE_ENABLE_TRACE
+#include "TraceGpu.h"
+#define CORE_VULKAN_TRACE_EVENT(name) TRACE_EVENT("gpu", name)
+#else
+#define CORE_VULKAN_TRACE_EVENT(name)
+#endif
+
+namespace core {
+namespace vulkan {
+namespace detail {
+
+#ifdef CORE_ENABLE_TRACE
+void TraceMemoryAllocated(const VkDeviceMemory memory, const VkDeviceSize size);
+void TraceMemoryFreed(const VkDeviceMemory memory);
+// A submission signaling fence is in flight until the fence is seen signaled or is reset.
+void TraceSubmitted(const VkFence fence);
+void TraceCompleted(const VkFence fence);
+#else
+inline void TraceMemoryAllocated(const VkDeviceMemory, const VkDeviceSize) {}
+inline void TraceMemoryFreed(const VkDeviceMemory) {}
+inline void TraceSubmitted(const VkFence) {}
+inline void TraceCompleted(const VkFence) {}
+#endif
+
+}  // namespace detail
+}  // namespace vulkan
+}  // namespace core
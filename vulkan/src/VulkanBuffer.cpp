@@ -1,6 +1,7 @@
 #include "VulkanBuffer.h"
 
 #include "VulkanImage.h"
+#include "VulkanTrace.h"
 
 namespace core {
 namespace vulkan {
@@ -26,6 +27,7 @@ VulkanBuffer::VulkanBuffer(VulkanContext* context, const VkDeviceSize size,
       context_->FindMemoryType(mem_requirements.memoryTypeBits, properties);
 
   VK_CHECK(vkAllocateMemory(context_->logical_device, &alloc_info, nullptr, &buffer_memory_));
+  detail::TraceMemoryAllocated(buffer_memory_, alloc_info.allocationSize);
 
   VK_CHECK(vkBindBufferMemory(context_->logical_device, buffer, buffer_memory_, 0));
 }
@@ -35,6 +37,7 @@ VulkanBuffer::~VulkanBuffer() {
     vkDestroyBuffer(context_->logical_device, buffer, nullptr);
   }
   if (context_ && buffer_memory_ != VK_NULL_HANDLE) {
+    detail::TraceMemoryFreed(buffer_memory_);
     vkFreeMemory(context_->logical_device, buffer_memory_, nullptr);
   }
 }
@@ -44,6 +47,7 @@ VulkanBuffer& VulkanBuffer::operator=(VulkanBuffer&& rhs) {
     vkDestroyBuffer(context_->logical_device, buffer, nullptr);
   }
   if (context_ && buffer_memory_ != VK_NULL_HANDLE) {
+    detail::TraceMemoryFreed(buffer_memory_);
     vkFreeMemory(context_->logical_device, buffer_memory_, nullptr);
   }
 
@@ -64,6 +68,7 @@ void VulkanBuffer::CopyToBuffer(VulkanBuffer& dst_buffer) {
   if (buffer_size_ != dst_buffer.Size()) {
     throw std::runtime_error("Buffer sizes do not match for copy");
   }
+  CORE_VULKAN_TRACE_EVENT("VulkanBuffer::CopyToBuffer");
 
   const auto command_buffer = VulkanCommandBuffer::BeginOneTimeCommands(context_);
   VkBufferCopy copy_region{};
@@ -74,6 +79,7 @@ void VulkanBuffer::CopyToBuffer(VulkanBuffer& dst_buffer) {
 
 void VulkanBuffer::CopyToImage(VulkanImage& dst_image, const uint32_t width, const uint32_t height,
                                const uint32_t layers) {
+  CORE_VULKAN_TRACE_EVENT("VulkanBuffer::CopyToImage");
   const auto command_buffer = VulkanCommandBuffer::BeginOneTimeCommands(context_);
 
   std::vector<VkBufferImageCopy> regions(layers);
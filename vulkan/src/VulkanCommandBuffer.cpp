@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+#include "VulkanTrace.h"
+
 namespace core {
 namespace vulkan {
 
@@ -70,6 +72,7 @@ VulkanCommandBuffer::~VulkanCommandBuffer() {
 }
 
 void VulkanCommandBuffer::Submit(const VkFence& fence, VkSubmitInfo& submit_info) const {
+  CORE_VULKAN_TRACE_EVENT("vkQueueSubmit");
   VK_CHECK(vkEndCommandBuffer(command_buffer_));
 
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -79,6 +82,7 @@ void VulkanCommandBuffer::Submit(const VkFence& fence, VkSubmitInfo& submit_info
   VkQueue queue = queue_family_type_ == QueueFamilyType::Compute ? context_->compute_queue()
                                                                  : context_->graphics_queue();
   VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, fence));
+  detail::TraceSubmitted(fence);
 }
 
 void VulkanCommandBuffer::Submit(const VkFence& fence, VkSubmitInfo&& submit_info) const {
@@ -86,6 +90,7 @@ void VulkanCommandBuffer::Submit(const VkFence& fence, VkSubmitInfo&& submit_inf
 }
 
 void VulkanCommandBuffer::Submit(const VkFence& fence) const {
+  CORE_VULKAN_TRACE_EVENT("vkQueueSubmit");
   vkEndCommandBuffer(command_buffer_);
 
   VkSubmitInfo submit_info{};
@@ -97,6 +102,7 @@ void VulkanCommandBuffer::Submit(const VkFence& fence) const {
                              ? context_->compute_queue()
                              : context_->graphics_queue(),
                          1, &submit_info, fence));
+  detail::TraceSubmitted(fence);
 }
 
 void VulkanCommandBuffer::Reset() { VK_CHECK(vkResetCommandBuffer(command_buffer_, 0)); }
@@ -116,7 +122,7 @@ void VulkanCommandBuffer::EndOneTimeCommands() const {
   VulkanFence fence(context_);
   fence.Reset();
   Submit(fence.fence);
-  vkWaitForFences(context_->logical_device, 1, &fence.fence, VK_TRUE, UINT64_MAX);
+  fence.Wait();
 }
 
 }  // namespace vulkan
@@ -2,6 +2,8 @@
 
 #include <fstream>
 
+#include "VulkanTrace.h"
+
 namespace core {
 namespace vulkan {
 
@@ -12,6 +14,7 @@ VulkanCompute::~VulkanCompute() {
 }
 
 void VulkanCompute::CreatePipeline() {
+  CORE_VULKAN_TRACE_EVENT("VulkanCompute::CreatePipeline");
   const auto shader_code = LoadShaderCode();
   const VkShaderModule shader_module = CreateShaderModule(shader_code);
 
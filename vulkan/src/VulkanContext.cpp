@@ -1,5 +1,7 @@
 #include "VulkanContext.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <unordered_set>
@@ -240,6 +242,15 @@ void VulkanContext::PickPhysicalDevice(const QueueFamilyType queue_family_type)
     std::runtime_error("timestamp is 0");
   }
   timestamp_period = period;
+
+  uint32_t family_count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, nullptr);
+  std::vector<VkQueueFamilyProperties> families(family_count);
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, families.data());
+  const uint32_t family = queue_family_type == QueueFamilyType::Compute
+                              ? queue_family_indices_.compute_family.value()
+                              : queue_family_indices_.graphics_family.value();
+  timestamp_valid_bits = families[family].timestampValidBits;
 }
 
 void VulkanContext::FindQueueFamilies(VkPhysicalDevice device,
@@ -330,6 +341,10 @@ void VulkanContext::CreateLogicalDevice(const float queuePriority) {
   device_create_info.pNext = &dyn;
 
   const auto extensions = GetRequiredDeviceExtensions();
+  calibrated_timestamps =
+      std::any_of(extensions.begin(), extensions.end(), [](const char* extension) {
+        return std::strcmp(extension, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0;
+      });
   device_create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
   device_create_info.ppEnabledExtensionNames = extensions.data();
 
@@ -388,6 +403,11 @@ std::vector<const char*> VulkanContext::GetRequiredDeviceExtensions() const {
     }
   }
 
+  // Optional extensions, enabled when supported
+  if (availableExtensions.count(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) != 0) {
+    extensions.emplace_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+  }
+
   return extensions;
 }
 
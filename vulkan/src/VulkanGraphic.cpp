@@ -1,5 +1,7 @@
 #include "VulkanGraphic.h"
 
+#include "VulkanTrace.h"
+
 namespace core {
 namespace vulkan {
 
@@ -15,6 +17,7 @@ VulkanGraphic::VulkanGraphic(VulkanContext* context,
       msaa_samples_(msaa_samples) {}
 
 void VulkanGraphic::CreatePipeline() {
+  CORE_VULKAN_TRACE_EVENT("VulkanGraphic::CreatePipeline");
   // 1. shader stage
   const auto vertex_shader_module = CreateShaderModule(LoadVertexShader());
   const auto fragment_shader_module = CreateShaderModule(LoadFragmentShader());
@@ -1,6 +1,7 @@
 #include "VulkanImage.h"
 
 #include "VulkanBuffer.h"
+#include "VulkanTrace.h"
 
 namespace core {
 namespace vulkan {
@@ -47,6 +48,7 @@ VulkanImage::VulkanImage(VulkanContext* context, const uint32_t width, const uin
       context_->FindMemoryType(mem_requirements.memoryTypeBits, properties);
 
   VK_CHECK(vkAllocateMemory(context_->logical_device, &alloc_info, nullptr, &image_memory));
+  detail::TraceMemoryAllocated(image_memory, alloc_info.allocationSize);
 
   vkBindImageMemory(context_->logical_device, image, image_memory, 0);
 
@@ -84,6 +86,7 @@ VulkanImage::~VulkanImage() {
     vkDestroyImage(context_->logical_device, image, nullptr);
   }
   if (context_ && image_memory != VK_NULL_HANDLE) {
+    detail::TraceMemoryFreed(image_memory);
     vkFreeMemory(context_->logical_device, image_memory, nullptr);
   }
 }
@@ -96,6 +99,7 @@ VulkanImage& VulkanImage::operator=(VulkanImage&& rhs) {
     vkDestroyImage(context_->logical_device, image, nullptr);
   }
   if (context_ && image_memory != VK_NULL_HANDLE) {
+    detail::TraceMemoryFreed(image_memory);
     vkFreeMemory(context_->logical_device, image_memory, nullptr);
   }
 
@@ -0,0 +1,267 @@
+#include "VulkanProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "VulkanCommandBuffer.h"
+#include "VulkanSync.h"
+#include "VulkanTrace.h"
+
+namespace core {
+namespace vulkan {
+
+namespace {
+
+constexpr uint32_t kNoQuery = std::numeric_limits<uint32_t>::max();
+
+// Host time domain that reads the same clock as std::chrono::steady_clock, if any.
+#if defined(__linux__) || defined(__ANDROID__)
+constexpr bool kHasHostTimeDomain = true;
+constexpr VkTimeDomainEXT kHostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#else
+constexpr bool kHasHostTimeDomain = false;
+constexpr VkTimeDomainEXT kHostTimeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+#endif
+
+#ifdef CORE_ENABLE_TRACE
+// Scopes of a frame as slices of the context's GPU track, each ended before the next scope at
+// its depth or above begins.
+void TraceFrame(const VulkanContext* context, const VulkanProfilerFrame& frame) {
+  const perfetto::Track track = trace::GpuTrack(context, "GPU (Vulkan)");
+  const trace::TraceClock clock;
+  std::vector<const VulkanProfilerScope*> open;
+  const auto end_until = [&](size_t depth) {
+    for (; open.size() > depth; open.pop_back()) {
+      TRACE_EVENT_END("gpu", track, clock.ToTraceTime(open.back()->end));
+    }
+  };
+  for (const VulkanProfilerScope& scope : frame.scopes) {
+    end_until(std::min<size_t>(scope.depth, open.size()));
+    TRACE_EVENT_BEGIN("gpu", perfetto::StaticString{scope.name}, track,
+                      clock.ToTraceTime(scope.begin), "frame", frame.index);
+    open.push_back(&scope);
+  }
+  end_until(0);
+}
+#endif
+
+}  // namespace
+
+VulkanProfiler::VulkanProfiler(VulkanContext* context, const uint32_t frames_in_flight)
+    : context_(context), frames_(frames_in_flight) {
+  if (frames_in_flight == 0) {
+    throw std::invalid_argument("VulkanProfiler needs at least one frame in flight");
+  }
+  if (context_->timestamp_valid_bits == 0) {
+    throw std::runtime_error("The queue does not support timestamps");
+  }
+  LoadCalibratedTimestamps();
+  Calibrate();
+}
+
+void VulkanProfiler::BeginFrame(const VkCommandBuffer command) {
+  if (recording_ != nullptr) {
+    throw std::logic_error("VulkanProfiler::BeginFrame called twice without EndFrame");
+  }
+  Frame& frame = frames_[frame_count_ % frames_.size()];
+  if (frame.pending) {
+    if (!Harvest(frame, &harvested_)) ++dropped_frames_;
+    frame.pending = false;
+  }
+  for (const auto& pool : frame.pools) pool->Reset(command);
+  frame.scopes.clear();
+  frame.queries = 0;
+  frame.index = frame_count_++;
+  recording_ = &frame;
+  open_scopes_ = 0;
+}
+
+uint32_t VulkanProfiler::BeginScope(const VkCommandBuffer command, const char* name,
+                                    VkPipelineStageFlagBits stage) {
+  if (recording_ == nullptr) {
+    throw std::logic_error("VulkanProfiler::BeginScope called outside of a frame");
+  }
+  const uint32_t query = WriteTimestamp(command, stage);
+  recording_->scopes.push_back({name, open_scopes_++, query, kNoQuery});
+  return static_cast<uint32_t>(recording_->scopes.size() - 1);
+}
+
+void VulkanProfiler::EndScope(const VkCommandBuffer command, const uint32_t scope,
+                              VkPipelineStageFlagBits stage) {
+  if (recording_ == nullptr || scope >= recording_->scopes.size() ||
+      recording_->scopes[scope].end_query != kNoQuery) {
+    throw std::logic_error("VulkanProfiler::EndScope called without a matching BeginScope");
+  }
+  recording_->scopes[scope].end_query = WriteTimestamp(command, stage);
+  --open_scopes_;
+}
+
+void VulkanProfiler::EndFrame() {
+  if (recording_ == nullptr) {
+    throw std::logic_error("VulkanProfiler::EndFrame called without BeginFrame");
+  }
+  recording_->pending = true;
+  recording_ = nullptr;
+}
+
+std::vector<VulkanProfilerFrame> VulkanProfiler::Collect() {
+  if (calibrated_timestamps()) Calibrate();
+
+  std::vector<Frame*> pending;
+  for (Frame& frame : frames_) {
+    if (frame.pending) pending.push_back(&frame);
+  }
+  std::sort(pending.begin(), pending.end(),
+            [](const Frame* a, const Frame* b) { return a->index < b->index; });
+
+  // Frames complete in submission order: stop at the first one still on the device
+  std::vector<VulkanProfilerFrame> frames = std::move(harvested_);
+  harvested_.clear();
+  for (Frame* frame : pending) {
+    if (!Harvest(*frame, &frames)) break;
+    frame->pending = false;
+  }
+  return frames;
+}
+
+void VulkanProfiler::Calibrate() {
+  if (!calibrated_timestamps()) {
+    CalibrateWithSubmission();
+    return;
+  }
+  VkCalibratedTimestampInfoEXT infos[2]{};
+  infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+  infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[1].timeDomain = kHostTimeDomain;
+  uint64_t timestamps[2] = {};
+  uint64_t max_deviation = 0;
+  VK_CHECK(get_calibrated_timestamps_(context_->logical_device, 2, infos, timestamps,
+                                      &max_deviation));
+  calibration_timestamp_ = timestamps[0];
+  // CLOCK_MONOTONIC in ns, the clock behind steady_clock on these platforms
+  calibration_time_ = std::chrono::steady_clock::time_point(
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::nanoseconds(timestamps[1])));
+}
+
+std::chrono::steady_clock::time_point VulkanProfiler::ToHostTime(const uint64_t timestamp) const {
+  // Signed distance from the calibration point, modulo the valid bits
+  const uint32_t bits = context_->timestamp_valid_bits;
+  int64_t ticks = static_cast<int64_t>(timestamp - calibration_timestamp_);
+  if (bits < 64) {
+    const uint64_t delta = TimestampTicks(*context_, calibration_timestamp_, timestamp);
+    const uint64_t range = uint64_t{1} << bits;
+    ticks = delta >= range / 2 ? -static_cast<int64_t>(range - delta)
+                               : static_cast<int64_t>(delta);
+  }
+  const auto offset = std::chrono::nanoseconds(
+      std::llround(static_cast<double>(ticks) * context_->timestamp_period));
+  return calibration_time_ +
+         std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset);
+}
+
+uint32_t VulkanProfiler::WriteTimestamp(const VkCommandBuffer command,
+                                        VkPipelineStageFlagBits stage) {
+  const uint32_t query = recording_->queries++;
+  const uint32_t pool = query / kQueriesPerPool;
+  if (pool == recording_->pools.size()) {
+    recording_->pools.push_back(
+        std::make_unique<VulkanQueryPool>(context_, VK_QUERY_TYPE_TIMESTAMP, kQueriesPerPool));
+    recording_->pools.back()->Reset(command);
+  }
+  recording_->pools[pool]->Query(command, query % kQueriesPerPool, stage);
+  return query;
+}
+
+bool VulkanProfiler::Harvest(Frame& frame, std::vector<VulkanProfilerFrame>* frames) {
+  for (uint32_t pool = 0; pool * kQueriesPerPool < frame.queries; ++pool) {
+    const uint32_t count = std::min(kQueriesPerPool, frame.queries - pool * kQueriesPerPool);
+    if (!frame.pools[pool]->GetQueryResults(0, count)) return false;
+  }
+  const auto timestamp = [&frame](uint32_t query) {
+    return frame.pools[query / kQueriesPerPool]->timestamps()[query % kQueriesPerPool];
+  };
+
+  VulkanProfilerFrame& result = frames->emplace_back();
+  result.index = frame.index;
+  result.tree.name = "gpu";
+  result.tree.calls = 1;
+  std::vector<ProfileNode*> stack;  // stack[d]: the open scope at depth d
+  for (const Scope& scope : frame.scopes) {
+    if (scope.end_query == kNoQuery) continue;  // never ended
+    const VulkanProfilerScope& gpu_scope = result.scopes.emplace_back(
+        VulkanProfilerScope{scope.name, scope.depth, ToHostTime(timestamp(scope.begin_query)),
+                            ToHostTime(timestamp(scope.end_query))});
+    // Scopes are recorded parent first; one that was never ended leaves its children to the
+    // closest ancestor
+    stack.resize(std::min<size_t>(scope.depth, stack.size()));
+    ProfileNode& parent = stack.empty() ? result.tree : *stack.back();
+    ProfileNode& node = parent.add_child(scope.name);
+    node.calls += 1;
+    node.inclusive += gpu_scope.duration();
+    if (scope.depth == 0) result.tree.inclusive += gpu_scope.duration();
+    stack.push_back(&node);
+  }
+#ifdef CORE_ENABLE_TRACE
+  TraceFrame(context_, result);
+#endif
+  return true;
+}
+
+void VulkanProfiler::LoadCalibratedTimestamps() {
+  if (!context_->calibrated_timestamps || !kHasHostTimeDomain) return;
+
+  auto get_domains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+      vkGetInstanceProcAddr(context_->instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+  if (get_domains == nullptr) return;
+  uint32_t count = 0;
+  VK_CHECK(get_domains(context_->physical_device, &count, nullptr));
+  std::vector<VkTimeDomainEXT> domains(count);
+  VK_CHECK(get_domains(context_->physical_device, &count, domains.data()));
+  const auto supports = [&domains](VkTimeDomainEXT domain) {
+    return std::find(domains.begin(), domains.end(), domain) != domains.end();
+  };
+  if (!supports(VK_TIME_DOMAIN_DEVICE_EXT) || !supports(kHostTimeDomain)) return;
+
+  get_calibrated_timestamps_ = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+      vkGetDeviceProcAddr(context_->logical_device, "vkGetCalibratedTimestampsEXT"));
+}
+
+void VulkanProfiler::CalibrateWithSubmission() {
+  VulkanCommandBuffer command_buffer(context_);
+  VulkanFence fence(context_);
+  VulkanQueryPool query_pool(context_, VK_QUERY_TYPE_TIMESTAMP, 1);
+
+  // The timestamp is written between submission and the fence; keep the tightest of a few tries
+  auto best = std::chrono::steady_clock::duration::max();
+  for (int attempt = 0; attempt < 5; ++attempt) {
+    fence.Reset();
+    command_buffer.Reset();
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(command_buffer.buffer(), &begin_info));
+    query_pool.Reset(command_buffer.buffer());
+    query_pool.Query(command_buffer.buffer(), 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+    const auto submitted = std::chrono::steady_clock::now();
+    command_buffer.Submit(fence.fence);
+    fence.Wait();
+    const auto completed = std::chrono::steady_clock::now();
+    if (!query_pool.GetQueryResults()) continue;
+
+    if (completed - submitted < best) {
+      best = completed - submitted;
+      calibration_timestamp_ = query_pool.timestamps()[0];
+      calibration_time_ = submitted + best / 2;
+    }
+  }
+  if (best == std::chrono::steady_clock::duration::max()) {
+    throw std::runtime_error("VulkanProfiler: failed to read a calibration timestamp");
+  }
+}
+
+}  // namespace vulkan
+}  // namespace core
@@ -3,16 +3,19 @@
 namespace core {
 namespace vulkan {
 
-VulkanQueryPool::VulkanQueryPool(VulkanContext* context, const VkQueryType query_type)
-    : context_(context), query_type_(query_type), timestamps_(2) {
+VulkanQueryPool::VulkanQueryPool(VulkanContext* context, const VkQueryType query_type,
+                                 const uint32_t query_count)
+    : context_(context), query_type_(query_type), timestamps_(query_count) {
+  if (query_type_ != VK_QUERY_TYPE_TIMESTAMP) {
+    throw std::runtime_error("Query type is not supported");
+  }
+  if (query_count == 0) {
+    throw std::invalid_argument("VulkanQueryPool needs at least one query");
+  }
   VkQueryPoolCreateInfo pool_info{};
   pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
   pool_info.queryType = query_type_;
-  if (query_type_ == VK_QUERY_TYPE_TIMESTAMP) {
-    pool_info.queryCount = 2;
-  } else {
-    std::runtime_error("Query type is not supported");
-  }
+  pool_info.queryCount = query_count;
   VK_CHECK(vkCreateQueryPool(context_->logical_device, &pool_info, nullptr, &query_pool_));
 }
 
@@ -20,32 +23,43 @@ VulkanQueryPool::~VulkanQueryPool() {
   vkDestroyQueryPool(context_->logical_device, query_pool_, nullptr);
 }
 
-void VulkanQueryPool::Reset(const VkCommandBuffer command) {
-  if (query_type_ == VK_QUERY_TYPE_TIMESTAMP) {
-    vkCmdResetQueryPool(command, query_pool_, 0, timestamps_.size());
-  } else {
-    std::runtime_error("Query type is not supported");
+void VulkanQueryPool::Reset(const VkCommandBuffer command) { Reset(command, 0, QueryCount()); }
+
+void VulkanQueryPool::Reset(const VkCommandBuffer command, uint32_t first, uint32_t count) {
+  if (first + count > QueryCount()) {
+    throw std::out_of_range("VulkanQueryPool: reset range is out of bounds");
   }
+  vkCmdResetQueryPool(command, query_pool_, first, count);
 }
 
 void VulkanQueryPool::Query(const VkCommandBuffer command, uint32_t query,
                             VkPipelineStageFlagBits stage) {
-  if (query_type_ == VK_QUERY_TYPE_TIMESTAMP) {
-    vkCmdWriteTimestamp(command, stage, query_pool_, query);
-  } else {
-    std::runtime_error("Query type is not supported");
+  if (query >= QueryCount()) {
+    throw std::out_of_range("VulkanQueryPool: query index is out of bounds");
   }
+  vkCmdWriteTimestamp(command, stage, query_pool_, query);
 }
 
-void VulkanQueryPool::GetQueryResults() {
-  if (query_type_ == VK_QUERY_TYPE_TIMESTAMP) {
-    vkGetQueryPoolResults(context_->logical_device, query_pool_, 0, timestamps_.size(),
-                          timestamps_.size() * sizeof(uint64_t), timestamps_.data(),
-                          sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-  } else {
-    std::runtime_error("Query type is not supported");
+bool VulkanQueryPool::GetQueryResults() { return GetQueryResults(0, QueryCount()); }
+
+bool VulkanQueryPool::GetQueryResults(uint32_t first, uint32_t count) {
+  if (first + count > QueryCount()) {
+    throw std::out_of_range("VulkanQueryPool: result range is out of bounds");
   }
+  // No VK_QUERY_RESULT_WAIT_BIT: a pending query must not stall the calling thread
+  const VkResult result = vkGetQueryPoolResults(
+      context_->logical_device, query_pool_, first, count, count * sizeof(uint64_t),
+      timestamps_.data() + first, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  if (result == VK_NOT_READY) return false;
+  VK_CHECK(result);
+  return true;
+}
+
+std::chrono::nanoseconds VulkanQueryPool::GetElapsed(uint32_t begin, uint32_t end) const {
+  const uint64_t ticks = TimestampTicks(*context_, timestamps_.at(begin), timestamps_.at(end));
+  return std::chrono::nanoseconds(
+      static_cast<int64_t>(static_cast<double>(ticks) * context_->timestamp_period));
 }
 
 }  // namespace vulkan
-}  // namespace core
\ No newline at end of file
+}  // namespace core
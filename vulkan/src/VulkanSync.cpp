@@ -1,5 +1,7 @@
 #include "VulkanSync.h"
 
+#include "VulkanTrace.h"
+
 namespace core {
 namespace vulkan {
 
@@ -11,9 +13,32 @@ VulkanFence::VulkanFence(VulkanContext* context) : context_(context) {
   VK_CHECK(vkCreateFence(context_->logical_device, &fence_info, nullptr, &fence));
 }
 
-VulkanFence::~VulkanFence() { vkDestroyFence(context_->logical_device, fence, nullptr); }
+VulkanFence::~VulkanFence() {
+  detail::TraceCompleted(fence);
+  vkDestroyFence(context_->logical_device, fence, nullptr);
+}
+
+void VulkanFence::Reset() {
+  detail::TraceCompleted(fence);
+  VK_CHECK(vkResetFences(context_->logical_device, 1, &fence));
+}
 
-void VulkanFence::Reset() { VK_CHECK(vkResetFences(context_->logical_device, 1, &fence)); }
+bool VulkanFence::Wait(const uint64_t timeout) const {
+  CORE_VULKAN_TRACE_EVENT("vkWaitForFences");
+  const VkResult status = vkWaitForFences(context_->logical_device, 1, &fence, VK_TRUE, timeout);
+  if (status == VK_TIMEOUT) return false;
+  VK_CHECK(status);
+  detail::TraceCompleted(fence);
+  return true;
+}
+
+bool VulkanFence::IsSignaled() const {
+  const VkResult status = vkGetFenceStatus(context_->logical_device, fence);
+  if (status == VK_NOT_READY) return false;
+  VK_CHECK(status);
+  detail::TraceCompleted(fence);
+  return true;
+}
 
 VulkanSemaphore::VulkanSemaphore(VulkanContext* context) : context_(context) {
   VkSemaphoreCreateInfo semaphore_info{};
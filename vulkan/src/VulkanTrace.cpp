@@ -0,0 +1,68 @@
+#include "VulkanTrace.h"
+
+#ifdef CORE_ENABLE_TRACE
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace core {
+namespace vulkan {
+namespace detail {
+
+namespace {
+
+struct TraceState {
+  std::mutex mutex;
+  std::unordered_map<VkDeviceMemory, VkDeviceSize> allocations;
+  VkDeviceSize allocated = 0;
+  std::unordered_set<VkFence> in_flight;
+};
+
+TraceState& State() {
+  static TraceState state;
+  return state;
+}
+
+}  // namespace
+
+void TraceMemoryAllocated(const VkDeviceMemory memory, const VkDeviceSize size) {
+  TraceState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.allocations[memory] = size;
+  state.allocated += size;
+  TRACE_COUNTER("gpu", "Vulkan device memory", state.allocated);
+}
+
+void TraceMemoryFreed(const VkDeviceMemory memory) {
+  TraceState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  const auto it = state.allocations.find(memory);
+  if (it == state.allocations.end()) return;
+  state.allocated -= it->second;
+  state.allocations.erase(it);
+  TRACE_COUNTER("gpu", "Vulkan device memory", state.allocated);
+}
+
+void TraceSubmitted(const VkFence fence) {
+  if (fence == VK_NULL_HANDLE) return;
+  TraceState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (state.in_flight.insert(fence).second) {
+    TRACE_COUNTER("gpu", "Vulkan submissions in flight", state.in_flight.size());
+  }
+}
+
+void TraceCompleted(const VkFence fence) {
+  TraceState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (state.in_flight.erase(fence) != 0) {
+    TRACE_COUNTER("gpu", "Vulkan submissions in flight", state.in_flight.size());
+  }
+}
+
+}  // namespace detail
+}  // namespace vulkan
+}  // namespace core
+
+#endif  // CORE_ENABLE_TRACE
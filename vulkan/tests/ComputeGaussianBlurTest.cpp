@@ -4,12 +4,10 @@
 
 #include "ComputeGaussianBlur.h"
 #include "Mat.h"
-#include "Timer.h"
 #include "VulkanBuffer.h"
 #include "VulkanCommandBuffer.h"
 #include "VulkanContext.h"
 #include "VulkanImage.h"
-#include "VulkanQueryPool.h"
 #include "VulkanSync.h"
 #include "VulkanUtils.h"
 
@@ -23,10 +21,8 @@ TEST(ComputeGaussianBlur, test) {
   context.Init();
   core::vulkan::VulkanCommandBuffer command_buffer(&context);
   core::vulkan::VulkanFence fence(&context);
-  core::vulkan::VulkanQueryPool query_pool(&context, VK_QUERY_TYPE_TIMESTAMP);
-  core::Mat<float, 1> mat(3000, 4000);
+  core::Mat<float, 1> mat(3000, 4000, core::kMatUninitialized);
   mat.Fill(1);
-  core::Timer timer;
   const VkDeviceSize buffer_size = mat.rows() * mat.cols() * sizeof(float);
 
   // Create buffers
@@ -38,17 +34,13 @@ TEST(ComputeGaussianBlur, test) {
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
   // Fill buffers
-  input_buffer.MapData(
-      [&mat](void* data) { memcpy(data, mat.data(), mat.total() * sizeof(float)); });
+  input_buffer.MapData([&mat](void* data) { mat.CopyTo(data); });
 
-  // Create and run compute sum pipeline
-  timer.start();
+  // Create and run compute blur pipeline
   std::unique_ptr<core::vulkan::ComputeGaussianBlur> compute_blur =
       std::make_unique<core::vulkan::ComputeGaussianBlur>(&context, input_buffer, dst_buffer,
                                                           mat.cols(), mat.rows());
   compute_blur->Init();
-  timer.end();
-  printf("Create compute blur pipeline: %fms\n", timer.time());
 
   fence.Reset();
 
@@ -57,24 +49,15 @@ TEST(ComputeGaussianBlur, test) {
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
   vkBeginCommandBuffer(command_buffer.buffer(), &begin_info);
-  query_pool.Reset(command_buffer.buffer());
-  query_pool.Query(command_buffer.buffer(), 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
   compute_blur->Run(command_buffer.buffer());
-  query_pool.Query(command_buffer.buffer(), 1, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
   VkSubmitInfo submit_info{};
   command_buffer.Submit(fence.fence, submit_info);
 
-  vkWaitForFences(context.logical_device, 1, &fence.fence, VK_TRUE, UINT64_MAX);
+  fence.Wait();
 
-  query_pool.GetQueryResults();
-  const auto timestamps = query_pool.GetTimeStamps();
-  const auto runtime_ms = (timestamps[1] - timestamps[0]) * (context.timestamp_period / 1000000.0);
-  printf("GPU time: %fms\n", runtime_ms);
-
-  core::Mat<float, 1> mat_blur(3000, 4000);
+  core::Mat<float, 1> mat_blur(3000, 4000, core::kMatUninitialized);
   std::vector<float> gaussian_kernel = {0.0625f, 0.125f,  0.0625f, 0.125f, 0.25f,
                                         0.125f,  0.0625f, 0.125f,  0.0625f};
-  timer.start();
   for (int row = 0; row < mat.rows(); ++row) {
     for (int col = 0; col < mat.cols(); ++col) {
       if (row == 0 || row == (mat.rows() - 1) || col == 0 || col == (mat.cols() - 1)) {
@@ -92,13 +75,10 @@ TEST(ComputeGaussianBlur, test) {
       *mat_blur(row, col) = sum;
     }
   }
-  timer.end();
-  printf("CPU time: %fms\n", timer.time());
 
   // check data
-  core::Mat<float, 1> blur_cpu(3000, 4000);
-  dst_buffer.MapData(
-      [&blur_cpu](void* data) { memcpy(blur_cpu.data(), data, sizeof(float) * blur_cpu.total()); });
+  core::Mat<float, 1> blur_cpu(3000, 4000, core::kMatUninitialized);
+  dst_buffer.MapData([&blur_cpu](void* data) { blur_cpu.CopyFrom(data); });
 
   for (int row = 0; row < blur_cpu.rows(); ++row) {
     for (int col = 0; col < blur_cpu.cols(); ++col) {
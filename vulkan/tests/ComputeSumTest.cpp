@@ -2,12 +2,10 @@
 
 #include "ComputeSum.h"
 #include "Mat.h"
-#include "Timer.h"
 #include "VulkanBuffer.h"
 #include "VulkanCommandBuffer.h"
 #include "VulkanContext.h"
 #include "VulkanImage.h"
-#include "VulkanQueryPool.h"
 #include "VulkanSync.h"
 #include "VulkanUtils.h"
 
@@ -21,10 +19,8 @@ TEST(ComputeSum, test) {
   context.Init();
   core::vulkan::VulkanCommandBuffer command_buffer(&context);
   core::vulkan::VulkanFence fence(&context);
-  core::vulkan::VulkanQueryPool query_pool(&context, VK_QUERY_TYPE_TIMESTAMP);
   core::Mat<int, 1> mat(6000, 6000);
   mat.Fill(3);
-  core::Timer t;
   const VkDeviceSize buffer_size = mat.rows() * mat.cols() * sizeof(int);
 
   // Create buffers
@@ -36,7 +32,7 @@ TEST(ComputeSum, test) {
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
   // Fill buffers
-  input_buffer.MapData([&mat](void* data) { memcpy(data, mat.data(), mat.total() * sizeof(int)); });
+  input_buffer.MapData([&mat](void* data) { mat.CopyTo(data); });
   sum_buffer.MapData([](void* data) {
     int zero = 0;
     memcpy(data, &zero, sizeof(int));
@@ -55,35 +51,15 @@ TEST(ComputeSum, test) {
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
   vkBeginCommandBuffer(command_buffer.buffer(), &begin_info);
-  query_pool.Reset(command_buffer.buffer());
-  query_pool.Query(command_buffer.buffer(), 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
   compute_sum->Run(command_buffer.buffer());
-  query_pool.Query(command_buffer.buffer(), 1, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
   VkSubmitInfo submit_info{};
   command_buffer.Submit(fence.fence, submit_info);
 
-  vkWaitForFences(context.logical_device, 1, &fence.fence, VK_TRUE, UINT64_MAX);
+  fence.Wait();
 
   // Check data
   int result = 0;
   sum_buffer.MapData([&result](void* data) { memcpy(&result, data, sizeof(int)); });
-  printf("GPU Result: %d\n", result);
-
-  query_pool.GetQueryResults();
-  const auto timestamps = query_pool.GetTimeStamps();
-  const auto runtime_ms = (timestamps[1] - timestamps[0]) * (context.timestamp_period / 1000000.0);
-  printf("GPU time: %fms\n", runtime_ms);
-
-  int cpu_sum = 0;
-  t.start();
-  for (int row = 0; row < mat.rows(); ++row) {
-    for (int col = 0; col < mat.cols(); ++col) {
-      cpu_sum += *mat(row, col);
-    }
-  }
-  t.end();
-  printf("CPU Result: %d, run time: %fms\n", cpu_sum, t.time());
-
   EXPECT_EQ(result, mat.rows() * mat.cols() * 3);
 }
 
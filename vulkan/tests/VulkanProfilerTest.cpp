@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "ComputeSum.h"
+#include "Mat.h"
+#include "VulkanBuffer.h"
+#include "VulkanCommandBuffer.h"
+#include "VulkanContext.h"
+#include "VulkanProfiler.h"
+#include "VulkanSync.h"
+
+namespace core {
+namespace test {
+
+TEST(VulkanProfiler, test) {
+  // Setup Vulkan
+  core::vulkan::VulkanContext context(true, core::vulkan::QueueFamilyType::Compute, nullptr);
+  context.Init();
+  core::vulkan::VulkanCommandBuffer command_buffer(&context);
+  core::vulkan::VulkanFence fence(&context);
+  core::vulkan::VulkanProfiler profiler(&context, 2);
+  printf("Calibrated timestamps: %d\n", profiler.calibrated_timestamps());
+
+  core::Mat<int, 1> mat(2000, 2000);
+  mat.Fill(1);
+  const VkDeviceSize buffer_size = mat.rows() * mat.cols() * sizeof(int);
+  core::vulkan::VulkanBuffer input_buffer(
+      &context, buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  core::vulkan::VulkanBuffer sum_buffer(
+      &context, sizeof(int), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  input_buffer.MapData([&mat](void* data) { mat.CopyTo(data); });
+  core::vulkan::ComputeSum compute_sum(&context, input_buffer, sum_buffer, mat.cols(), mat.rows());
+  compute_sum.Init();
+
+  // One frame: a scope holding two dispatches, plus more scopes than one query pool holds
+  fence.Reset();
+  vkResetCommandBuffer(command_buffer.buffer(), 0);
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  vkBeginCommandBuffer(command_buffer.buffer(), &begin_info);
+  profiler.BeginFrame(command_buffer.buffer());
+  {
+    core::vulkan::VulkanProfileScope frame_scope(profiler, command_buffer.buffer(), "sum");
+    for (int i = 0; i < 2; ++i) {
+      core::vulkan::VulkanProfileScope scope(profiler, command_buffer.buffer(), "dispatch");
+      compute_sum.Run(command_buffer.buffer());
+    }
+  }
+  for (uint32_t i = 0; i < core::vulkan::VulkanProfiler::kQueriesPerPool; ++i) {
+    core::vulkan::VulkanProfileScope scope(profiler, command_buffer.buffer(), "empty");
+  }
+  profiler.EndFrame();
+
+  const auto submitted = std::chrono::steady_clock::now();
+  command_buffer.Submit(fence.fence);
+  fence.Wait();
+  const auto completed = std::chrono::steady_clock::now();
+
+  const std::vector<core::vulkan::VulkanProfilerFrame> frames = profiler.Collect();
+  ASSERT_EQ(frames.size(), 1u);
+  const core::vulkan::VulkanProfilerFrame& frame = frames[0];
+  EXPECT_EQ(frame.index, 0u);
+  ASSERT_EQ(frame.scopes.size(), 3u + core::vulkan::VulkanProfiler::kQueriesPerPool);
+  EXPECT_EQ(frame.scopes[1].depth, 1u);
+  EXPECT_LE(frame.scopes[0].begin, frame.scopes[1].begin);
+  EXPECT_GE(frame.scopes[0].end, frame.scopes[2].end);
+
+  const core::ProfileNode* dispatch = frame.tree.child("sum")->child("dispatch");
+  ASSERT_NE(dispatch, nullptr);
+  EXPECT_EQ(dispatch->calls, 2u);
+  EXPECT_GT(dispatch->inclusive.count(), 0);
+  printf("GPU sum: %f ms\n",
+         std::chrono::duration<double, std::milli>(frame.tree.child("sum")->inclusive).count());
+
+  // GPU scopes lie on the host timeline between submission and completion, within calibration
+  const auto slack = std::chrono::milliseconds(2);
+  EXPECT_GE(frame.scopes[0].begin, submitted - slack);
+  EXPECT_LE(frame.scopes[0].end, completed + slack);
+
+  EXPECT_TRUE(profiler.Collect().empty());
+  EXPECT_EQ(profiler.dropped_frames(), 0u);
+}
+
+}  // namespace test
+}  // namespace core